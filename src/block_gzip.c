@@ -0,0 +1,461 @@
+#include "block_gzip.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "log.h"
+
+// Operating system field of the members, 255 is unknown
+#define BGZ_OS_UNKNOWN 255
+
+/**
+ * \brief Block of data compressed or decompressed by a worker
+ */
+typedef struct BlockJob {
+    const unsigned char *data;
+    unsigned char *dest;
+    uint64_t len;
+    // Member of the block and its offset in the file when it is read
+    unsigned char *member;
+    uint64_t memberSize;
+    uint64_t offset;
+} BlockJob;
+
+/**
+ * \brief Arguments of a worker of bgzWriteBlocks or bgzReadBlocks
+ *
+ * The worker processes the jobs first, first + step, first + 2 * step...
+ */
+typedef struct BlockArgs {
+    BlockJob *jobs;
+    uint64_t nbJobs;
+    uint64_t first;
+    uint64_t step;
+    int level;
+    int fd;
+    bool failed;
+} BlockArgs;
+
+bool bgzCompress(const void *data, uint64_t len, int level, char id1, char id2,
+    const void *subfield, uint16_t subfieldLen, unsigned char **member, uint64_t *memberSize) {
+    assert(data || len == 0);
+    assert(member);
+    assert(memberSize);
+
+    if (len > BGZ_MAX_BLOCK || subfieldLen > BGZ_MAX_SUBFIELD || level < 0 || level > 9) {
+        return false;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // 16 is added to the window bits for writing a gzip header
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    bool result = false;
+    unsigned char *extra = NULL;
+    unsigned char *dest = NULL;
+
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    header.os = BGZ_OS_UNKNOWN;
+
+    if (subfield) {
+        if ((extra = malloc(4 + subfieldLen)) == NULL) {
+            goto EXIT;
+        }
+
+        extra[0] = id1;
+        extra[1] = id2;
+        extra[2] = subfieldLen & 0xff;
+        extra[3] = subfieldLen >> 8;
+        memcpy(extra + 4, subfield, subfieldLen);
+
+        header.extra = extra;
+        header.extra_len = 4 + subfieldLen;
+    }
+
+    if (deflateSetHeader(&stream, &header) != Z_OK) {
+        goto EXIT;
+    }
+
+    // The bound includes the gzip header since it is set
+    uLong bound = deflateBound(&stream, len);
+
+    if ((dest = malloc(bound)) == NULL) {
+        goto EXIT;
+    }
+
+    stream.next_in = (unsigned char*) data;
+    stream.avail_in = len;
+    stream.next_out = dest;
+    stream.avail_out = bound;
+
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+        goto EXIT;
+    }
+
+    *member = dest;
+    *memberSize = stream.total_out;
+    dest = NULL;
+
+    result = true;
+
+EXIT:
+    deflateEnd(&stream);
+    free(extra);
+    free(dest);
+
+    return result;
+}
+
+bool bgzDecompress(const unsigned char *member, uint64_t memberSize, void *data, uint64_t len) {
+    assert(member);
+    assert(data || len == 0);
+
+    if (len > BGZ_MAX_BLOCK || memberSize > UINT32_MAX) {
+        return false;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        return false;
+    }
+
+    // zlib needs an output buffer, even for an empty member
+    unsigned char empty;
+
+    stream.next_in = (unsigned char*) member;
+    stream.avail_in = memberSize;
+    stream.next_out = (len > 0) ? data : &empty;
+    stream.avail_out = len;
+
+    // The checksum is verified at the end of the member
+    int status = inflate(&stream, Z_FINISH);
+    bool result = status == Z_STREAM_END && stream.total_out == len && stream.avail_in == 0;
+
+    inflateEnd(&stream);
+
+    return result;
+}
+
+uint32_t bgzDataSize(const unsigned char *member, uint64_t memberSize) {
+    assert(member);
+
+    if (memberSize < BGZ_HEADER_SIZE + 8) {
+        return 0;
+    }
+
+    // The trailer ends with the size of the data, in little endian order
+    const unsigned char *size = member + memberSize - 4;
+
+    return (uint32_t) size[0] | ((uint32_t) size[1] << 8) | ((uint32_t) size[2] << 16) | ((uint32_t) size[3] << 24);
+}
+
+bool bgzFindSubfield(const unsigned char *member, uint64_t len, char id1, char id2,
+    const unsigned char **subfield, uint16_t *subfieldLen) {
+    assert(member);
+    assert(subfield);
+    assert(subfieldLen);
+
+    // Magic bytes, deflate method and FEXTRA flag
+    if (len < BGZ_HEADER_SIZE + 2 || member[0] != 0x1f || member[1] != 0x8b
+        || member[2] != Z_DEFLATED || !(member[3] & 0x4)) {
+        return false;
+    }
+
+    uint64_t extraLen = member[10] | ((uint16_t) member[11] << 8);
+    const unsigned char *extra = member + BGZ_HEADER_SIZE + 2;
+
+    if (len < BGZ_HEADER_SIZE + 2 + extraLen) {
+        return false;
+    }
+
+    for (uint64_t i = 0;i + 4 <= extraLen;) {
+        uint16_t size = extra[i + 2] | ((uint16_t) extra[i + 3] << 8);
+
+        if (i + 4 + size > extraLen) {
+            return false;
+        }
+
+        if (extra[i] == (unsigned char) id1 && extra[i + 1] == (unsigned char) id2) {
+            *subfield = extra + i + 4;
+            *subfieldLen = size;
+            return true;
+        }
+
+        i += 4 + size;
+    }
+
+    return false;
+}
+
+/**
+ * \brief Compresses the jobs of a worker of bgzWriteBlocks
+ *
+ * @param voidArgs a pointer to a BlockArgs structure
+ * @return NULL
+ */
+static void *compressWorker(void *voidArgs) {
+    BlockArgs *args = voidArgs;
+
+    for (uint64_t i = args->first;i < args->nbJobs;i += args->step) {
+        BlockJob *job = args->jobs + i;
+
+        if (!bgzCompress(job->data, job->len, args->level, 0, 0, NULL, 0, &job->member, &job->memberSize)) {
+            args->failed = true;
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Reads the whole member of a job from a file descriptor
+ *
+ * @param fd a file descriptor opened in reading mode
+ * @param job the job whose member is read, its member must store memberSize bytes
+ * @return true if the member was read, otherwise false
+ */
+static bool readMember(int fd, BlockJob *job) {
+    uint64_t done = 0;
+
+    while (done < job->memberSize) {
+        ssize_t r = pread(fd, job->member + done, job->memberSize - done, job->offset + done);
+
+        if (r <= 0) {
+            return false;
+        }
+
+        done += r;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Decompresses the jobs of a worker of bgzReadBlocks
+ *
+ * @param voidArgs a pointer to a BlockArgs structure
+ * @return NULL
+ */
+static void *decompressWorker(void *voidArgs) {
+    BlockArgs *args = voidArgs;
+
+    unsigned char *buffer = NULL;
+    uint64_t capacity = 0;
+
+    for (uint64_t i = args->first;i < args->nbJobs && !args->failed;i += args->step) {
+        BlockJob *job = args->jobs + i;
+
+        // The buffer of the members is shared by the jobs of the worker
+        if (job->memberSize > capacity) {
+            unsigned char *larger = realloc(buffer, job->memberSize);
+
+            if (!larger) {
+                args->failed = true;
+                break;
+            }
+
+            buffer = larger;
+            capacity = job->memberSize;
+        }
+
+        job->member = buffer;
+
+        if (!readMember(args->fd, job) || !bgzDecompress(job->member, job->memberSize, job->dest, job->len)) {
+            args->failed = true;
+        }
+
+        job->member = NULL;
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+/**
+ * \brief Runs workers on the jobs
+ *
+ * The calling thread is one of the workers.
+ *
+ * @param worker function of the workers
+ * @param jobs jobs of the workers
+ * @param nbJobs number of jobs
+ * @param nbThreads number of workers
+ * @param level compression level given to the workers
+ * @param fd file descriptor given to the workers
+ * @return true if no worker failed, otherwise false
+ */
+static bool runWorkers(void *(*worker)(void*), BlockJob *jobs, uint64_t nbJobs, int nbThreads, int level, int fd) {
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+
+    if ((uint64_t) nbThreads > nbJobs) {
+        nbThreads = (nbJobs > 0) ? nbJobs : 1;
+    }
+
+    BlockArgs *args = malloc(sizeof(*args) * nbThreads);
+    pthread_t *threads = malloc(sizeof(*threads) * nbThreads);
+    int started = 1;
+
+    if (!args || !threads) {
+        log_error("Allocation error of the block workers");
+        free(args);
+        free(threads);
+        return false;
+    }
+
+    for (int i = 0;i < nbThreads;i++) {
+        args[i] = (BlockArgs) {
+            .jobs = jobs, .nbJobs = nbJobs, .first = i, .step = nbThreads,
+            .level = level, .fd = fd, .failed = false
+        };
+    }
+
+    for (;started < nbThreads;started++) {
+        if (pthread_create(threads + started, NULL, worker, args + started) != 0) {
+            log_error("Unable to start a block worker");
+            break;
+        }
+    }
+
+    // The jobs of the workers that could not be started are done by the calling thread
+    for (int i = started;i < nbThreads;i++) {
+        worker(args + i);
+    }
+
+    worker(args);
+
+    bool failed = false;
+
+    for (int i = 1;i < started;i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0;i < nbThreads;i++) {
+        failed |= args[i].failed;
+    }
+
+    free(args);
+    free(threads);
+    return !failed;
+}
+
+bool bgzWriteBlocks(FILE *fp, const void *data, uint64_t len, uint64_t blockSize, int level,
+    int nbThreads, uint64_t *sizes) {
+    assert(fp);
+    assert(data || len == 0);
+    assert(sizes);
+
+    if (blockSize == 0 || blockSize > BGZ_MAX_BLOCK) {
+        return false;
+    }
+
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+
+    uint64_t nbBlocks = (len + blockSize - 1) / blockSize;
+
+    // Only a few blocks per thread are kept in memory before being written
+    uint64_t batchSize = (uint64_t) nbThreads * 4;
+
+    if (batchSize > nbBlocks) {
+        batchSize = (nbBlocks > 0) ? nbBlocks : 1;
+    }
+
+    BlockJob *jobs = calloc(batchSize, sizeof(*jobs));
+
+    if (!jobs) {
+        log_error("Allocation error of the blocks");
+        return false;
+    }
+
+    const unsigned char *bytes = data;
+    bool result = true;
+
+    for (uint64_t first = 0;first < nbBlocks && result;first += batchSize) {
+        uint64_t nbJobs = (nbBlocks - first < batchSize) ? nbBlocks - first : batchSize;
+
+        for (uint64_t i = 0;i < nbJobs;i++) {
+            uint64_t start = (first + i) * blockSize;
+
+            jobs[i].data = bytes + start;
+            jobs[i].len = (len - start < blockSize) ? len - start : blockSize;
+            jobs[i].member = NULL;
+        }
+
+        if (!runWorkers(compressWorker, jobs, nbJobs, nbThreads, level, -1)) {
+            log_error("Unable to compress a block");
+            result = false;
+        }
+
+        for (uint64_t i = 0;i < nbJobs;i++) {
+            if (result && fwrite(jobs[i].member, 1, jobs[i].memberSize, fp) != jobs[i].memberSize) {
+                log_error("Unable to write a block");
+                result = false;
+            }
+
+            sizes[first + i] = jobs[i].memberSize;
+            free(jobs[i].member);
+        }
+    }
+
+    free(jobs);
+
+    return result;
+}
+
+bool bgzReadBlocks(FILE *fp, uint64_t offset, void *data, uint64_t len, uint64_t blockSize,
+    const uint64_t *sizes, int nbThreads) {
+    assert(fp);
+    assert(data || len == 0);
+    assert(sizes);
+
+    if (blockSize == 0 || blockSize > BGZ_MAX_BLOCK) {
+        return false;
+    }
+
+    uint64_t nbBlocks = (len + blockSize - 1) / blockSize;
+    BlockJob *jobs = calloc(nbBlocks > 0 ? nbBlocks : 1, sizeof(*jobs));
+
+    if (!jobs) {
+        log_error("Allocation error of the blocks");
+        return false;
+    }
+
+    unsigned char *bytes = data;
+
+    for (uint64_t i = 0;i < nbBlocks;i++) {
+        uint64_t start = i * blockSize;
+
+        jobs[i].dest = bytes + start;
+        jobs[i].len = (len - start < blockSize) ? len - start : blockSize;
+        jobs[i].memberSize = sizes[i];
+        jobs[i].offset = offset;
+
+        offset += sizes[i];
+    }
+
+    bool result = runWorkers(decompressWorker, jobs, nbBlocks, nbThreads, 0, fileno(fp));
+
+    if (!result) {
+        log_error("Unable to decompress a block");
+    }
+
+    free(jobs);
+
+    return result;
+}
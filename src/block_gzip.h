@@ -0,0 +1,141 @@
+#ifndef BLOCK_GZIP_H
+#define BLOCK_GZIP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * \brief Size (in bytes) of the fixed fields that start a gzip member
+ *
+ * The 2 bytes of the extra field length follow them when the member has an extra field.
+ */
+#define BGZ_HEADER_SIZE 10
+
+/**
+ * \brief Maximum size (in bytes) of the data of a subfield of the extra field
+ *
+ * The extra field has at most 65535 bytes, each subfield starts with 4 bytes.
+ */
+#define BGZ_MAX_SUBFIELD 65531
+
+/**
+ * \brief Maximum size (in bytes) of the data of a member
+ *
+ * zlib compresses at most UINT_MAX bytes at once and the gzip
+ * trailer stores the size of the data on 4 bytes.
+ */
+#define BGZ_MAX_BLOCK UINT32_MAX
+
+/**
+ * \brief Compresses data into one gzip member
+ *
+ * The members written by this module can be concatenated : the result is a gzip
+ * file whose data is the concatenation of the data of the members, that can
+ * be read by gzread. A member can also be decompressed on its own (see bgzDecompress),
+ * so the blocks of a file can be decompressed in parallel.
+ *
+ * The optional subfield is written into the extra field of the member, with the
+ * identifiers id1 and id2. Its data can be changed in the written file as long as its
+ * size stays the same : the extra field is not a part of the checksum of the member.
+ * The subfield data starts BGZ_HEADER_SIZE + 6 bytes after the start of the member.
+ *
+ * If the data is too large or if an allocation error occured, then false will be returned.
+ *
+ * @param data data of the member
+ * @param len size of the data (in bytes), at most BGZ_MAX_BLOCK
+ * @param level compression level, between 0 and 9
+ * @param id1 first identifier of the subfield
+ * @param id2 second identifier of the subfield
+ * @param subfield data of the subfield, NULL if the member has no extra field
+ * @param subfieldLen size of the subfield data, at most BGZ_MAX_SUBFIELD
+ * @param member destination of the member, allocated with malloc
+ * @param memberSize destination of the size of the member (in bytes)
+ * @return true if the data was compressed, otherwise false
+ */
+bool bgzCompress(const void *data, uint64_t len, int level, char id1, char id2,
+    const void *subfield, uint16_t subfieldLen, unsigned char **member, uint64_t *memberSize);
+
+/**
+ * \brief Decompresses a gzip member
+ *
+ * The member must contain exactly len bytes of data and its checksum must be
+ * valid, otherwise false will be returned.
+ *
+ * @param member first byte of the member
+ * @param memberSize size of the member (in bytes)
+ * @param data destination of the data
+ * @param len size of the data (in bytes), at most BGZ_MAX_BLOCK
+ * @return true if the member was decompressed, otherwise false
+ */
+bool bgzDecompress(const unsigned char *member, uint64_t memberSize, void *data, uint64_t len);
+
+/**
+ * \brief Gets the size of the data of a gzip member
+ *
+ * The size is read from the trailer of the member, so it is only
+ * correct for data smaller than 4 GB.
+ *
+ * @param member first byte of the member
+ * @param memberSize size of the member (in bytes)
+ * @return the size of the data (in bytes) or 0 if the member is too short
+ */
+uint32_t bgzDataSize(const unsigned char *member, uint64_t memberSize);
+
+/**
+ * \brief Finds a subfield in the extra field of a gzip member
+ *
+ * Only the first BGZ_HEADER_SIZE bytes of the member and its extra
+ * field are read.
+ *
+ * @param member first bytes of the member
+ * @param len number of bytes of the member
+ * @param id1 first identifier of the subfield
+ * @param id2 second identifier of the subfield
+ * @param subfield destination of a pointer to the subfield data
+ * @param subfieldLen destination of the size of the subfield data
+ * @return true if the member has the subfield, otherwise false
+ */
+bool bgzFindSubfield(const unsigned char *member, uint64_t len, char id1, char id2,
+    const unsigned char **subfield, uint16_t *subfieldLen);
+
+/**
+ * \brief Compresses data into several members written into a file
+ *
+ * The data is split into blocks of blockSize bytes, the last one may be shorter.
+ * Each block is compressed into its own member without extra field (see bgzCompress),
+ * up to nbThreads blocks are compressed at the same time. The members are written
+ * in the order of the blocks and the size of the member of the block i is stored in sizes[i].
+ *
+ * @param fp a pointer to a file opened in binary writing mode
+ * @param data data to compress
+ * @param len size of the data (in bytes)
+ * @param blockSize size of a block (in bytes), between 1 and BGZ_MAX_BLOCK
+ * @param level compression level, between 0 and 9
+ * @param nbThreads number of threads compressing the blocks
+ * @param sizes destination of the sizes of the members, one per block
+ * @return true if all blocks were written, otherwise false
+ */
+bool bgzWriteBlocks(FILE *fp, const void *data, uint64_t len, uint64_t blockSize, int level,
+    int nbThreads, uint64_t *sizes);
+
+/**
+ * \brief Decompresses the members written by bgzWriteBlocks
+ *
+ * The members are read from their offset in the file, the file position is not used.
+ * Up to nbThreads members are decompressed at the same time, directly into
+ * the destination.
+ *
+ * @param fp a pointer to a file opened in binary reading mode
+ * @param offset offset of the first member in the file
+ * @param data destination of the data
+ * @param len size of the data (in bytes)
+ * @param blockSize size of a block (in bytes), between 1 and BGZ_MAX_BLOCK
+ * @param sizes sizes of the members, one per block
+ * @param nbThreads number of threads decompressing the blocks
+ * @return true if all blocks were decompressed, otherwise false
+ */
+bool bgzReadBlocks(FILE *fp, uint64_t offset, void *data, uint64_t len, uint64_t blockSize,
+    const uint64_t *sizes, int nbThreads);
+
+#endif // BLOCK_GZIP_H
@@ -1,12 +1,22 @@
 #include "bloom_filter.h"
 
+#include "fast_hash.h"
 #include "log.h"
 #include "murmur3.h"
+#include "numa.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+
+#define BF_MULTI_SEED 0x90b45d39fb6da1faULL
+#define BF_MULTI_SHIFT 27
+
+// Allocation of the bits of the created filters (see BloomAllocation)
+static int g_allocation = BF_ALLOC_DEFAULT;
 
 /**
  * \brief Gets the bit position associated to the given hash
@@ -14,15 +24,17 @@
  * hash is a pointer to a uint32_t value. It could have several values (more than 32 bits).
  * The parameter len represents this number.
  * 
+ * This is the computation of the BF_ADDRESSING_MODULO addressing.
+ * 
  * @param hash pointer to the first hash value
  * @param len number of values
- * @param n size of the filter (in bytes)
+ * @param n number of positions
  * @return index of a bit
  */
-static long getPositionFromHash(uint32_t *hash, size_t len, long n) {
+static uint64_t getPositionFromHash(uint32_t *hash, size_t len, uint64_t n) {
     assert(hash);
 
-    long pos = 0;
+    uint64_t pos = 0;
 
     for (size_t i = 0;i < len;i++) {
         pos = (pos + hash[i]) % n;
@@ -31,22 +43,265 @@ static long getPositionFromHash(uint32_t *hash, size_t len, long n) {
     return pos;
 }
 
-BloomFilter *bfCreate(long n, int8_t k) {
-    if (k <= 0) {
-        return NULL;
+/**
+ * \brief Maps a 64 bits hash to a position between 0 and n (excluded)
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param hash a 64 bits hash
+ * @param n number of positions
+ * @return a position
+ */
+static inline uint64_t getPosition(BloomFilter *bf, uint64_t hash, uint64_t n) {
+    if (bfAddressing(bf) == BF_ADDRESSING_MODULO) {
+        // The hash is split into 2 unsigned 32 bits integers
+        uint32_t values[2] = { (uint32_t) hash, (uint32_t) (hash >> 32) };
+
+        return getPositionFromHash(values, 2, n);
     }
 
-    char *data = calloc(n, sizeof(*data));
+    // The high bits of the hash are used, they are uniformly
+    // distributed over the n positions
+    return (uint64_t) (((unsigned __int128) hash * n) >> 64);
+}
 
-    if (!data) {
-        log_error("Filter internal array allocation error");
-        return NULL;
+/**
+ * \brief Derives a second hash from a 64 bits hash
+ * 
+ * The hash is multiplied by a constant and its high bits are
+ * mixed into the low ones, like the multiple hashing scheme of ntHash.
+ * 
+ * @param hash a 64 bits hash
+ * @return a second hash
+ */
+static uint64_t getSecondHash(uint64_t hash) {
+    uint64_t value = hash * BF_MULTI_SEED;
+
+    return value ^ (value >> BF_MULTI_SHIFT);
+}
+
+/**
+ * \brief Computes the two hashes of the double hashing of a value
+ * 
+ * The value is hashed by the hash function of the filter (see BloomHashFunction).
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param value value to hash
+ * @param valSize size of the value (in bytes)
+ * @param hash destination of the two hashes
+ */
+static inline void hashValue(BloomFilter *bf, const void *value, int valSize, uint64_t *hash) {
+    if (bfHashFunction(bf) == BF_FUNCTION_FAST) {
+        uint64_t h1;
+
+        // A value of 8 bytes is only mixed, a packed kmer for instance
+        if (valSize == sizeof(uint64_t)) {
+            uint64_t packed;
+            memcpy(&packed, value, sizeof(packed));
+
+            h1 = fastHashMix64(packed);
+        }
+        else {
+            h1 = fastHash64(value, valSize, 0);
+        }
+
+        hash[0] = h1;
+        hash[1] = getSecondHash(h1);
+        return;
+    }
+
+    // The two halves of the 128 bits hash are used
+    // as the two hashs of the double hashing
+    MurmurHash3_x64_128(value, valSize, 0, hash);
+}
+
+/**
+ * \brief Gets the index of the block of a blocked filter associated to the given hash
+ * 
+ * @param bf a pointer to a Bloom filter structure with the BF_LAYOUT_BLOCKED layout
+ * @param hash a 64 bits hash
+ * @return index of the block
+ */
+static inline uint64_t getBlockIndex(BloomFilter *bf, uint64_t hash) {
+    uint64_t nbBlocks = bfSize(bf) / BF_BLOCK_SIZE;
+
+    // Blocked graphs saved before the version 3 select
+    // the block with the remainder of the whole hash
+    if (bfAddressing(bf) == BF_ADDRESSING_MODULO) {
+        return hash % nbBlocks;
     }
 
+    return getPosition(bf, hash, nbBlocks);
+}
+
+/**
+ * \brief Gets the block of a blocked filter associated to the given hash
+ * 
+ * @param bf a pointer to a Bloom filter structure with the BF_LAYOUT_BLOCKED layout
+ * @param hash a 64 bits hash
+ * @return pointer to the first byte of the block
+ */
+static char *getBlock(BloomFilter *bf, uint64_t hash) {
+    return bf->data + getBlockIndex(bf, hash) * BF_BLOCK_SIZE;
+}
+
+/**
+ * \brief Sets the bit at index i of an array
+ * 
+ * When the update is atomic, several threads can set bits
+ * of the same byte at the same time without losing one of them.
+ * 
+ * @param data pointer to the first byte of the array
+ * @param i index of the bit
+ * @param atomic true if the byte must be updated atomically
+ */
+static inline void setBit(char *data, uint64_t i, bool atomic) {
+    char mask = 1 << (i % 8);
+
+    if (atomic) {
+        __atomic_fetch_or(data + i / 8, mask, __ATOMIC_RELAXED);
+    }
+    else {
+        data[i / 8] |= mask;
+    }
+}
+
+/**
+ * \brief Sets the bits of all hash functions
+ * 
+ * The hash of the i-th function is h1 + i * h2 (Kirsch-Mitzenmacher double hashing).
+ * 
+ * With the BF_LAYOUT_BLOCKED layout, h1 selects a block and the bits
+ * of each function in this block are derived from the two halves of h2.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param h1 first hash of the value
+ * @param h2 second hash of the value
+ * @param atomic true if the bits must be set atomically
+ * @return true if all bits were set, otherwise false
+ */
+static bool addProbes(BloomFilter *bf, uint64_t h1, uint64_t h2, bool atomic) {
+    if (bfLayout(bf) == BF_LAYOUT_BLOCKED) {
+        char *block = getBlock(bf, h1);
+        uint32_t probe = (uint32_t) h2;
+        uint32_t step = (uint32_t) (h2 >> 32) | 1;
+
+        for (int i = 0;i < bfNbHashs(bf);i++) {
+            setBit(block, probe % BF_BLOCK_BITS, atomic);
+
+            probe += step;
+        }
+
+        return true;
+    }
+
+    uint64_t probe = h1;
+
+    for (int i = 0;i < bfNbHashs(bf);i++) {
+        // The position is always less than the size of the filter
+        setBit(bf->data, getPosition(bf, probe, bfBitSize(bf)), atomic);
+
+        probe += h2;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Prefetches the bytes of all hash functions
+ * 
+ * The positions are the ones of addProbes and containsProbes.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param h1 first hash of the value
+ * @param h2 second hash of the value
+ */
+static inline void prefetchProbes(BloomFilter *bf, uint64_t h1, uint64_t h2) {
+    if (bfLayout(bf) == BF_LAYOUT_BLOCKED) {
+        // All bits are in the same cache line
+        __builtin_prefetch(getBlock(bf, h1));
+        return;
+    }
+
+    uint64_t probe = h1;
+
+    for (int i = 0;i < bfNbHashs(bf);i++) {
+        __builtin_prefetch(bf->data + getPosition(bf, probe, bfBitSize(bf)) / 8);
+
+        probe += h2;
+    }
+}
+
+/**
+ * \brief Checks the bits of all hash functions
+ * 
+ * See addProbes for the hash of each function.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param h1 first hash of the value
+ * @param h2 second hash of the value
+ * @return true if all bits are set, otherwise false
+ */
+static bool containsProbes(BloomFilter *bf, uint64_t h1, uint64_t h2) {
+    if (bfLayout(bf) == BF_LAYOUT_BLOCKED) {
+        char *block = getBlock(bf, h1);
+        uint32_t probe = (uint32_t) h2;
+        uint32_t step = (uint32_t) (h2 >> 32) | 1;
+
+        for (int i = 0;i < bfNbHashs(bf);i++) {
+            uint32_t pos = probe % BF_BLOCK_BITS;
+
+            if (!((block[pos / 8] >> (pos % 8)) & 0x1)) {
+                return false;
+            }
+
+            probe += step;
+        }
+
+        return true;
+    }
+
+    uint64_t probe = h1;
+
+    for (int i = 0;i < bfNbHashs(bf);i++) {
+        uint64_t pos = getPosition(bf, probe, bfBitSize(bf));
+
+        if (!bfGetBit(bf, pos, NULL)) {
+            return false;
+        }
+
+        probe += h2;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Checks the parameters of a new filter
+ */
+static bool validParameters(long n, int8_t k, BloomLayout layout) {
+    if (k <= 0 || n <= 0) {
+        return false;
+    }
+
+    // A blocked filter must have at least one block
+    return layout != BF_LAYOUT_BLOCKED || n >= BF_BLOCK_SIZE;
+}
+
+/**
+ * \brief Creates a filter structure around its bits
+ * 
+ * The data is not owned by the filter.
+ * 
+ * @param data bits of the filter, aligned on BF_BLOCK_SIZE bytes
+ * @param n size of the filter (in bytes)
+ * @param k number of hash functions
+ * @param layout layout of the bits in the filter
+ * @return a pointer to an allocated BloomFilter structure
+ */
+static BloomFilter *wrapData(char *data, long n, int8_t k, BloomLayout layout) {
     BloomFilter *bf = malloc(sizeof(*bf));
 
     if (!bf) {
-        free(data);
         log_error("Filter allocation error");
         return NULL;
     }
@@ -54,13 +309,193 @@ BloomFilter *bfCreate(long n, int8_t k) {
     bf->data = data;
     bf->nbhashs = k;
     bf->size = n;
+    bf->bitSize = (uint64_t) n * 8;
+    bf->hashScheme = BF_HASH_DOUBLE;
+    bf->hashFunction = BF_FUNCTION_MURMUR3;
+    bf->layout = layout;
+    bf->addressing = BF_ADDRESSING_FASTRANGE;
+    bf->ownsData = false;
+    bf->mappedSize = 0;
 
     return bf;
 }
 
+/**
+ * \brief Maps zeroed memory for the bits of a filter
+ *
+ * The memory is placed according to the allocation flags (see BloomAllocation).
+ * If the huge pages or the interleaving are not available, then the bits use
+ * normal pages or are not interleaved : only a warning is logged.
+ *
+ * @param size size of the mapping (in bytes), a multiple of BF_HUGE_PAGE_SIZE
+ * @param flags combination of BloomAllocation values
+ * @return the mapped memory or NULL if it could not be mapped
+ */
+static char *mapData(size_t size, int flags) {
+    void *data = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (flags & BF_ALLOC_HUGETLB) {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (data == MAP_FAILED) {
+            log_warn("No reserved huge pages for the filter, using transparent huge pages");
+            flags |= BF_ALLOC_HUGE_PAGES;
+        }
+    }
+#else
+    if (flags & BF_ALLOC_HUGETLB) {
+        flags |= BF_ALLOC_HUGE_PAGES;
+    }
+#endif
+
+    if (data == MAP_FAILED) {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (data == MAP_FAILED) {
+            return NULL;
+        }
+
+#ifdef MADV_HUGEPAGE
+        if ((flags & BF_ALLOC_HUGE_PAGES) && madvise(data, size, MADV_HUGEPAGE) != 0) {
+            log_warn("Transparent huge pages are not available for the filter");
+        }
+#endif
+    }
+
+    // The pages are not used yet, they will be placed on the nodes when they are first written
+    if ((flags & BF_ALLOC_INTERLEAVE) && !numaInterleave(data, size)) {
+        log_warn("Unable to interleave the filter on the NUMA nodes");
+    }
+
+    return data;
+}
+
+/**
+ * \brief Creates a new Bloom filter with the given layout
+ * 
+ * The internal array is aligned on a cache line, it is allocated
+ * according to the flags given to bfSetAllocation.
+ * 
+ * @param n size of the filter (in bytes)
+ * @param k number of hash functions
+ * @param layout layout of the bits in the filter
+ * @return a pointer to an allocated BloomFilter structure
+ */
+static BloomFilter *createFilter(long n, int8_t k, BloomLayout layout) {
+    if (!validParameters(n, k, layout)) {
+        return NULL;
+    }
+
+    int flags = g_allocation;
+    size_t mappedSize = 0;
+    char *data;
+
+    if (flags != BF_ALLOC_DEFAULT) {
+        // The mapped memory is zeroed, its size is a multiple of the huge pages
+        mappedSize = ((size_t) n + BF_HUGE_PAGE_SIZE - 1) / BF_HUGE_PAGE_SIZE * BF_HUGE_PAGE_SIZE;
+        data = mapData(mappedSize, flags);
+    }
+    else {
+        // The allocated size must be a multiple of the alignment
+        size_t allocSize = (n + BF_BLOCK_SIZE - 1) / BF_BLOCK_SIZE * BF_BLOCK_SIZE;
+        data = aligned_alloc(BF_BLOCK_SIZE, allocSize);
+
+        if (data) {
+            memset(data, 0, allocSize);
+        }
+    }
+
+    if (!data) {
+        log_error("Filter internal array allocation error");
+        return NULL;
+    }
+
+    BloomFilter *bf = wrapData(data, n, k, layout);
+
+    if (!bf) {
+        if (mappedSize > 0) {
+            munmap(data, mappedSize);
+        }
+        else {
+            free(data);
+        }
+
+        return NULL;
+    }
+
+    bf->ownsData = true;
+    bf->mappedSize = mappedSize;
+
+    return bf;
+}
+
+void bfSetAllocation(int flags) {
+    g_allocation = flags;
+}
+
+BloomFilter *bfCreate(long n, int8_t k) {
+    return createFilter(n, k, BF_LAYOUT_STANDARD);
+}
+
+BloomFilter *bfCreateBlocked(long n, int8_t k) {
+    return createFilter(n, k, BF_LAYOUT_BLOCKED);
+}
+
+BloomFilter *bfCreateFromData(char *data, long n, int8_t k, BloomLayout layout) {
+    assert(data);
+
+    if (!validParameters(n, k, layout) || (uintptr_t) data % BF_BLOCK_SIZE != 0) {
+        return NULL;
+    }
+
+    return wrapData(data, n, k, layout);
+}
+
+bool bfOptimalParameters(uint64_t n, double fpr, long maxSize, long *size, int8_t *nbHashs) {
+    assert(size);
+    assert(nbHashs);
+
+    if (!(fpr > 0 && fpr < 1)) {
+        return false;
+    }
+
+    double values = (n > 0) ? n : 1;
+
+    // m = -n ln(p) / ln(2)^2
+    double bits = ceil(-values * log(fpr) / (M_LN2 * M_LN2));
+
+    if (maxSize > 0 && bits > (double) maxSize * 8) {
+        bits = (double) maxSize * 8;
+    }
+
+    // k = m / n ln(2)
+    double hashs = round(bits / values * M_LN2);
+
+    *size = (long) ceil(bits / 8);
+    *nbHashs = (hashs < 1) ? 1 : (hashs > INT8_MAX) ? INT8_MAX : (int8_t) hashs;
+
+    return true;
+}
+
+double bfFalsePositiveRate(uint64_t n, uint64_t bitSize, int nbHashs) {
+    if (bitSize == 0) {
+        return 1;
+    }
+
+    // (1 - e^(-kn/m))^k
+    return pow(1 - exp(-(double) nbHashs * n / bitSize), nbHashs);
+}
+
 void bfDelete(BloomFilter *bf) {
     if (bf) {
-        free(bf->data);
+        if (bf->ownsData && bf->mappedSize > 0) {
+            munmap(bf->data, bf->mappedSize);
+        }
+        else if (bf->ownsData) {
+            free(bf->data);
+        }
+
         free(bf);
     }
 }
@@ -72,10 +507,28 @@ void bfFill(BloomFilter *bf, int8_t *bytes) {
     memcpy(bf->data, bytes, bfSize(bf));
 }
 
+bool bfUnion(BloomFilter *bf, const BloomFilter *other) {
+    assert(bf);
+    assert(other);
+
+    if (bfSize(bf) != bfSize(other) || bfBitSize(bf) != bfBitSize(other)
+        || bfNbHashs(bf) != bfNbHashs(other) || bfHashScheme(bf) != bfHashScheme(other)
+        || bfHashFunction(bf) != bfHashFunction(other)
+        || bfLayout(bf) != bfLayout(other) || bfAddressing(bf) != bfAddressing(other)) {
+        return false;
+    }
+
+    for (long i = 0;i < bfSize(bf);i++) {
+        bf->data[i] |= other->data[i];
+    }
+
+    return true;
+}
+
 char bfGetBit(BloomFilter *bf, long long i, int *pError) {
     assert(bf);
 
-    if (i < 0 || i >= bfSize(bf) * 8) {
+    if (i < 0 || (uint64_t) i >= bfBitSize(bf)) {
         if (pError) {
             *pError = 1;
         }
@@ -97,7 +550,7 @@ char bfGetBit(BloomFilter *bf, long long i, int *pError) {
 bool bfSetBit(BloomFilter *bf, long long i) {
     assert(bf);
 
-    if (i >= bfSize(bf) * 8) {
+    if (i < 0 || (uint64_t) i >= bfBitSize(bf)) {
         return false;
     }
 
@@ -120,22 +573,29 @@ bool bfAdd(BloomFilter *bf, void *value, int valSize) {
         return false;
     }
 
-    uint32_t hash[4];
+    if (bfHashScheme(bf) == BF_HASH_SEEDED) {
+        uint32_t hash[4];
 
-    for (int i = 0;i < bfNbHashs(bf);i++) {
-        // The hash is 128 bits long, we store it in an array
-        // of 4 unsigned 32 bits integers
-        MurmurHash3_x64_128(value, valSize, i, hash);
+        for (int i = 0;i < bfNbHashs(bf);i++) {
+            // The hash is 128 bits long, we store it in an array
+            // of 4 unsigned 32 bits integers
+            MurmurHash3_x64_128(value, valSize, i, hash);
 
-        // Retreives bit position for this hash
-        long pos = getPositionFromHash(hash, 4, bfSize(bf));
+            // Retreives bit position for this hash
+            uint64_t pos = getPositionFromHash(hash, 4, bfBitSize(bf));
 
-        if (!bfSetBit(bf, pos)) {
-            return false;
+            if (!bfSetBit(bf, pos)) {
+                return false;
+            }
         }
+
+        return true;
     }
 
-    return true;
+    uint64_t hash[2];
+    hashValue(bf, value, valSize, hash);
+
+    return addProbes(bf, hash[0], hash[1], false);
 }
 
 bool bfContains(BloomFilter *bf, void *value, int valSize) {
@@ -146,25 +606,108 @@ bool bfContains(BloomFilter *bf, void *value, int valSize) {
         return false;
     }
 
-    uint32_t hash[4];
-    int error;
+    if (bfHashScheme(bf) == BF_HASH_SEEDED) {
+        uint32_t hash[4];
+        int error;
 
-    for (int i = 0;i < bfNbHashs(bf);i++) {
-        MurmurHash3_x64_128(value, valSize, i, hash);
+        for (int i = 0;i < bfNbHashs(bf);i++) {
+            MurmurHash3_x64_128(value, valSize, i, hash);
 
-        long pos = getPositionFromHash(hash, 4, bfSize(bf));
+            uint64_t pos = getPositionFromHash(hash, 4, bfBitSize(bf));
 
-        char b = bfGetBit(bf, pos, &error);
+            char b = bfGetBit(bf, pos, &error);
 
-        if (error != 0) {
-            log_error("bfContains : Error while trying to get a bit value %d", error);
-            return false;
+            if (error != 0) {
+                log_error("bfContains : Error while trying to get a bit value %d", error);
+                return false;
+            }
+
+            if (!b) {
+                return false;
+            }
         }
 
-        if (!b) {
-            return false;
+        return true;
+    }
+
+    uint64_t hash[2];
+    hashValue(bf, value, valSize, hash);
+
+    return containsProbes(bf, hash[0], hash[1]);
+}
+
+bool bfAddHash(BloomFilter *bf, uint64_t hash) {
+    assert(bf);
+
+    return addProbes(bf, hash, getSecondHash(hash), false);
+}
+
+bool bfAddHashConcurrent(BloomFilter *bf, uint64_t hash) {
+    assert(bf);
+
+    return addProbes(bf, hash, getSecondHash(hash), true);
+}
+
+uint64_t bfHashBlock(BloomFilter *bf, uint64_t hash) {
+    assert(bf);
+    assert(bfLayout(bf) == BF_LAYOUT_BLOCKED);
+
+    return getBlockIndex(bf, hash);
+}
+
+void bfHashBits(BloomFilter *bf, uint64_t hash, uint64_t *bits) {
+    assert(bf);
+    assert(bits);
+
+    // Same positions as addProbes
+    uint64_t h2 = getSecondHash(hash);
+
+    if (bfLayout(bf) == BF_LAYOUT_BLOCKED) {
+        uint64_t first = bfHashBlock(bf, hash) * BF_BLOCK_BITS;
+        uint32_t probe = (uint32_t) h2;
+        uint32_t step = (uint32_t) (h2 >> 32) | 1;
+
+        for (int i = 0;i < bfNbHashs(bf);i++) {
+            bits[i] = first + probe % BF_BLOCK_BITS;
+
+            probe += step;
         }
+
+        return;
     }
 
-    return true;
+    uint64_t probe = hash;
+
+    for (int i = 0;i < bfNbHashs(bf);i++) {
+        bits[i] = getPosition(bf, probe, bfBitSize(bf));
+
+        probe += h2;
+    }
+}
+
+bool bfContainsHash(BloomFilter *bf, uint64_t hash) {
+    assert(bf);
+
+    return containsProbes(bf, hash, getSecondHash(hash));
+}
+
+int bfContainsHashBatch(BloomFilter *bf, const uint64_t *hashes, int n, bool *results) {
+    assert(bf);
+    assert(hashes);
+    assert(results);
+
+    // The bytes of all values are requested before the first test,
+    // so their cache misses overlap
+    for (int i = 0;i < n;i++) {
+        prefetchProbes(bf, hashes[i], getSecondHash(hashes[i]));
+    }
+
+    int nbFound = 0;
+
+    for (int i = 0;i < n;i++) {
+        results[i] = containsProbes(bf, hashes[i], getSecondHash(hashes[i]));
+        nbFound += results[i];
+    }
+
+    return nbFound;
 }
@@ -2,16 +2,130 @@
 #define BLOOM_FILTER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/**
+ * \brief Ways of computing the hash of each hash function
+ */
+typedef enum BloomHashScheme {
+    // One MurmurHash3 call with a different seed per hash function,
+    // used by graphs saved without a format version
+    BF_HASH_SEEDED = 0,
+
+    // One MurmurHash3 call, the hash of the i-th function is h1 + i * h2
+    BF_HASH_DOUBLE = 1
+} BloomHashScheme;
+
+/**
+ * \brief Hash functions of the values of the filter
+ */
+typedef enum BloomHashFunction {
+    // MurmurHash3 for the values given as bytes, the kmers of a graph
+    // are hashed by ntHash (see KmerHash)
+    BF_FUNCTION_MURMUR3 = 0,
+
+    // An integer mixer for the values of 8 bytes, such as packed kmers, and wyhash
+    // for the other ones (see fast_hash.h). The kmers of a graph are hashed
+    // by mixing their canonical packed form (see KMER_HASH_MIX)
+    BF_FUNCTION_FAST = 1
+} BloomHashFunction;
+
+/**
+ * \brief Ways of placing the bits of a value in the filter
+ */
+typedef enum BloomLayout {
+    // Each hash function selects a bit anywhere in the filter
+    BF_LAYOUT_STANDARD = 0,
+
+    // All bits of a value are in one block of BF_BLOCK_SIZE bytes,
+    // so a lookup only touches one cache line
+    BF_LAYOUT_BLOCKED = 1
+} BloomLayout;
+
+/**
+ * \brief Size (in bytes) of a block of a blocked filter, it is the size of a cache line
+ */
+#define BF_BLOCK_SIZE 64
+#define BF_BLOCK_BITS (BF_BLOCK_SIZE * 8)
+
+/**
+ * \brief Ways of turning a hash into a position (a bit or a block) in the filter
+ */
+typedef enum BloomAddressing {
+    // The position is the remainder of the hash divided by the number of positions,
+    // used by graphs saved before the version 3
+    BF_ADDRESSING_MODULO = 0,
+
+    // The position is the high half of the product of the hash
+    // and the number of positions (no division)
+    BF_ADDRESSING_FASTRANGE = 1
+} BloomAddressing;
+
+/**
+ * \brief Ways of allocating the bits of the filters created by bfCreate and bfCreateBlocked
+ *
+ * The values are flags, they can be combined. With a flag, the bits are mapped
+ * instead of being allocated on the heap and their size is rounded up to BF_HUGE_PAGE_SIZE.
+ */
+typedef enum BloomAllocation {
+    // The bits are allocated on the heap
+    BF_ALLOC_DEFAULT = 0,
+
+    // The bits use transparent huge pages if the kernel supports them :
+    // the random accesses of the lookups miss the TLB less often
+    BF_ALLOC_HUGE_PAGES = 1,
+
+    // The bits use the huge pages reserved by the administrator (MAP_HUGETLB),
+    // or transparent huge pages if there is none left
+    BF_ALLOC_HUGETLB = 2,
+
+    // The pages of the bits are interleaved on all NUMA nodes (see numaInterleave)
+    BF_ALLOC_INTERLEAVE = 4
+} BloomAllocation;
+
+/**
+ * \brief Size (in bytes) of a huge page
+ */
+#define BF_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 typedef struct BloomFilter {
     char *data;
     long size;
+    uint64_t bitSize;
     int8_t nbhashs;
+    BloomHashScheme hashScheme;
+    BloomHashFunction hashFunction;
+    BloomLayout layout;
+    BloomAddressing addressing;
+    // False if the data is not released with the filter (see bfCreateFromData)
+    bool ownsData;
+    // Size of the mapping of the data, 0 if it was allocated on the heap
+    size_t mappedSize;
 } BloomFilter;
 
 #define bfNbHashs(bf) ((bf)->nbhashs)
 
+/**
+ * \brief Gets the hash scheme (see BloomHashScheme) of the filter
+ */
+#define bfHashScheme(bf) ((bf)->hashScheme)
+
+/**
+ * \brief Gets the hash function (see BloomHashFunction) of the filter
+ */
+#define bfHashFunction(bf) ((bf)->hashFunction)
+
+/**
+ * \brief Gets the layout (see BloomLayout) of the filter
+ */
+#define bfLayout(bf) ((bf)->layout)
+
+/**
+ * \brief Gets the addressing (see BloomAddressing) of the filter
+ */
+#define bfAddressing(bf) ((bf)->addressing)
+
 /**
  * \brief Gets the size (in bytes) of the filter
  */
@@ -19,8 +133,21 @@ typedef struct BloomFilter {
 
 /**
  * \brief Gets the size (in bits) of the filter
+ * 
+ * It is the number of bits that the hash functions can address,
+ * the filter has enough bytes to store them.
  */
-#define bfBitSize(bf) ((bf)->size * 8)
+#define bfBitSize(bf) ((bf)->bitSize)
+
+/**
+ * \brief Sets how the bits of the next created filters are allocated
+ *
+ * The flags are BloomAllocation values, BF_ALLOC_DEFAULT by default.
+ * They do not change the bits of the filters, only their placement in memory.
+ *
+ * @param flags combination of BloomAllocation values
+ */
+void bfSetAllocation(int flags);
 
 /**
  * \brief Creates a new Bloom filter
@@ -35,12 +162,85 @@ typedef struct BloomFilter {
  * This function returns NULL when the parameters are not
  * valid or a memory allocation error occured.
  * 
+ * The filter uses the BF_HASH_DOUBLE hash scheme, the BF_FUNCTION_MURMUR3 hash function,
+ * the BF_LAYOUT_STANDARD layout and the BF_ADDRESSING_FASTRANGE addressing.
+ * All its bits can be used.
+ * 
  * @param n size of the filter (in bytes)
  * @param k number of hash functions
  * @return a pointer to an allocated BloomFilter structure
  */
 BloomFilter *bfCreate(long n, int8_t k);
 
+/**
+ * \brief Creates a new Bloom filter that uses existing bits
+ * 
+ * The data is not copied and it is not released by bfDelete, it must stay
+ * valid until the filter is deleted. It must be aligned on BF_BLOCK_SIZE bytes
+ * and store n bytes. A filter of read only data, like a mapped file,
+ * can only be queried.
+ * 
+ * This function returns NULL when the parameters are not valid (see bfCreate
+ * and bfCreateBlocked) or a memory allocation error occured.
+ * 
+ * The filter uses the BF_HASH_DOUBLE hash scheme, the BF_FUNCTION_MURMUR3 hash function
+ * and the BF_ADDRESSING_FASTRANGE addressing. All its bits can be used.
+ * 
+ * @param data bits of the filter
+ * @param n size of the filter (in bytes)
+ * @param k number of hash functions
+ * @param layout layout of the filter
+ * @return a pointer to an allocated BloomFilter structure
+ */
+BloomFilter *bfCreateFromData(char *data, long n, int8_t k, BloomLayout layout);
+
+/**
+ * \brief Computes the size and the number of hash functions of a filter
+ * 
+ * The size is the smallest one that gives the false positive rate fpr with
+ * n values, and the number of hash functions is the one that minimizes
+ * the false positive rate with this size.
+ * 
+ * If maxSize is strictely positive, then the size will not be greater than maxSize
+ * (the false positive rate will be higher).
+ * 
+ * False will be returned if fpr is not between 0 and 1 (excluded).
+ * 
+ * @param n expected number of distinct values
+ * @param fpr target false positive rate
+ * @param maxSize maximum size of the filter (in bytes), 0 for no limit
+ * @param size destination of the size (in bytes)
+ * @param nbHashs destination of the number of hash functions
+ * @return true if the parameters were computed, otherwise false
+ */
+bool bfOptimalParameters(uint64_t n, double fpr, long maxSize, long *size, int8_t *nbHashs);
+
+/**
+ * \brief Computes the expected false positive rate of a filter
+ * 
+ * @param n number of distinct values in the filter
+ * @param bitSize size of the filter (in bits)
+ * @param nbHashs number of hash functions
+ * @return the probability that an absent value is found in the filter
+ */
+double bfFalsePositiveRate(uint64_t n, uint64_t bitSize, int nbHashs);
+
+/**
+ * \brief Creates a new blocked Bloom filter
+ * 
+ * This function behaves like bfCreate, the created filter
+ * uses the BF_LAYOUT_BLOCKED layout : all bits of a value are set
+ * in the same block of BF_BLOCK_SIZE bytes.
+ * 
+ * The filter size must be greater or equal to BF_BLOCK_SIZE. If it is not
+ * a multiple of BF_BLOCK_SIZE then the last bytes will not be used.
+ * 
+ * @param n size of the filter (in bytes)
+ * @param k number of hash functions
+ * @return a pointer to an allocated BloomFilter structure
+ */
+BloomFilter *bfCreateBlocked(long n, int8_t k);
+
 /**
  * \brief Frees the allocated memory for the given Bloom filter structure
  * 
@@ -59,6 +259,20 @@ void bfDelete(BloomFilter *bf);
  */
 void bfFill(BloomFilter *bf, int8_t *bytes);
 
+/**
+ * \brief Adds all values of another filter into the filter
+ * 
+ * The filters must have the same size, hash functions, hash scheme, hash function,
+ * layout and addressing, otherwise false will be returned and the filter is not changed.
+ * The bits of the other filter are then added to the filter : it contains the values of both
+ * filters, exactly like a filter where the values of both filters were inserted.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param other a pointer to the filter whose values are added
+ * @return true if the values were added, otherwise false
+ */
+bool bfUnion(BloomFilter *bf, const BloomFilter *other);
+
 /**
  * \brief Gets the bit value at index i
  * 
@@ -91,7 +305,9 @@ bool bfSetBit(BloomFilter *bf, long long i);
  * \brief Insert a new value into the filter
  * 
  * This value will be hashed with n hash functions, each result
- * corresponds to one bit in the filter.
+ * corresponds to one bit in the filter. With the BF_HASH_DOUBLE scheme,
+ * the value is only hashed once, by the hash function of the filter (see BloomHashFunction),
+ * and the n results are derived from it. The BF_HASH_SEEDED scheme always uses MurmurHash3.
  * 
  * The size parameter must be strictely positive.
  * 
@@ -112,7 +328,7 @@ bool bfAdd(BloomFilter *bf, void *value, int valSize);
  * 
  * The value will be hashed with n functions : if one hash does not
  * correspond to a positive bit in the filter then false will
- * be returned.
+ * be returned. The value is hashed like bfAdd does.
  * 
  * @param bf a pointer to a Bloom filter structure
  * @param value value that could be in the filter
@@ -121,4 +337,85 @@ bool bfAdd(BloomFilter *bf, void *value, int valSize);
  */
 bool bfContains(BloomFilter *bf, void *value, int valSize);
 
+/**
+ * \brief Inserts a value into the filter from its hash
+ * 
+ * The hash must have been computed by the caller, for instance
+ * with a rolling hash function. A second hash is derived from it
+ * and the hash of each function is computed with double hashing,
+ * whatever the hash scheme of the filter.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param hash a 64 bits hash of the value
+ * @return true if the value was correctly added, otherwise false
+ */
+bool bfAddHash(BloomFilter *bf, uint64_t hash);
+
+/**
+ * \brief Inserts a value into the filter from its hash, from several threads
+ * 
+ * This function behaves like bfAddHash but its bits are set with
+ * atomic operations : several threads can insert values into the
+ * same filter at the same time, without any lock. Since setting a bit
+ * twice has no effect, the filter does not depend on the insertion order.
+ * 
+ * The filter must not be read during the insertions.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param hash a 64 bits hash of the value
+ * @return true if the value was correctly added, otherwise false
+ */
+bool bfAddHashConcurrent(BloomFilter *bf, uint64_t hash);
+
+/**
+ * \brief Gets the block of a blocked filter that contains the bits of a value
+ * 
+ * The block is the one updated by bfAddHash with the same hash.
+ * 
+ * @param bf a pointer to a Bloom filter structure with the BF_LAYOUT_BLOCKED layout
+ * @param hash a 64 bits hash of the value
+ * @return index of the block, less than bfSize / BF_BLOCK_SIZE
+ */
+uint64_t bfHashBlock(BloomFilter *bf, uint64_t hash);
+
+/**
+ * \brief Gets the bits of a value from its hash
+ * 
+ * The bits are the ones set by bfAddHash with the same hash : setting them
+ * with bfSetBit gives the same filter. The bits of a blocked filter are indexes
+ * in the whole filter, not in their block.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param hash a 64 bits hash of the value
+ * @param bits array that will store bfNbHashs bits
+ */
+void bfHashBits(BloomFilter *bf, uint64_t hash, uint64_t *bits);
+
+/**
+ * \brief Checks if the filter contains a value from its hash
+ * 
+ * The hash must have been computed with the same function
+ * as the one given to bfAddHash.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param hash a 64 bits hash of the value
+ * @return true if the filter contains the value, otherwise false
+ */
+bool bfContainsHash(BloomFilter *bf, uint64_t hash);
+
+/**
+ * \brief Checks if the filter contains several values from their hashes
+ * 
+ * This function gives the same results as n calls to bfContainsHash,
+ * but the bytes of all values are prefetched before testing the first one :
+ * the memory accesses of the values are done in parallel.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param hashes array of n hashes
+ * @param n number of values
+ * @param results array that will store n results, true if the filter contains the value
+ * @return number of values contained by the filter
+ */
+int bfContainsHashBatch(BloomFilter *bf, const uint64_t *hashes, int n, bool *results);
+
 #endif // BLOOM_FILTER_H
@@ -1,11 +1,19 @@
 #include "bloom_filter.h"
+#include "count_min.h"
+#include "dbg_buckets.h"
+#include "dbg_io.h"
+#include "dbg_partition.h"
 #include "de_bruijn_graph.h"
 #include "fasta.h"
+#include "kmer.h"
+#include "kmer_hash.h"
 #include "log.h"
+#include "numa.h"
 #include "string_utils.h"
 
 #include <errno.h>
 #include <getopt.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,13 +22,34 @@
 #include <zlib.h>
 
 void help(char *prog) {
-    printf("Usage: %s [--output output_file] [--graph output_graph_file] [--kmer-size size] [--bloom-size size] [--bloom-hash hash] fasta_file\n\n", prog);
+    printf("Usage: %s [--output output_file] [--graph output_graph_file] [--kmer-size size] [--bloom-size size] [--bloom-hash hash] [--bloom-fpr rate] [--bloom-max-size size] [--bloom-blocked] [--no-false-positives] [--exact] [--min-abundance n] [--mapped] [--compression-level n] [--graph-only] [--input-graph file] [--huge-pages] [--hugetlb] [--numa-interleave] [--pin-threads] [--partitioned-build] [--dedupe-kmers] [--max-memory size] [--tmp-dir dir] [--fast-hash] [--no-canonical] [--threads n] fasta_file\n\n", prog);
 
     printf("--output output_file -> path to a file for storing compressed reads\n");
     printf("--graph output_graph_file -> path to a file for storing the graph\n");
-    printf("--kmer-size size -> size of a kmer\n");
-    printf("--bloom-size size -> size of the Bloom filter\n");
-    printf("--bloom-hash hash -> number of hash functions\n\n");
+    printf("--kmer-size size -> size of a kmer, up to %d (%d with --exact, --dedupe-kmers or --max-memory, whose kmers are packed on 64 bits)\n", KMER128_MAX_SIZE, KMER_MAX_SIZE);
+    printf("--bloom-size size -> size of the Bloom filter (computed from the number of distinct kmers by default)\n");
+    printf("--bloom-hash hash -> number of hash functions (computed from the size of the filter by default)\n");
+    printf("--bloom-fpr rate -> target false positive rate of the computed filter (default 0.01)\n");
+    printf("--bloom-max-size size -> maximum size of the computed filter\n");
+    printf("--bloom-blocked -> stores all bits of a kmer in the same cache line of the Bloom filter\n");
+    printf("--no-false-positives -> does not store the critical false positives of the filter in the graph\n");
+    printf("--exact -> stores the kmers in a sorted array instead of a Bloom filter, the graph is larger but has no false positives\n");
+    printf("--min-abundance n -> only stores the kmers seen at least n times in the graph, the other ones are written as literals (default 1)\n");
+    printf("--mapped -> saves an uncompressed graph that the decompressor maps in memory instead of loading it (default extension graph)\n");
+    printf("--compression-level n -> compression level of the graph, between 0 and 9 (default 9)\n");
+    printf("--graph-only -> only saves the graph of the file without its false positives, for a part of a larger file (see fasta_graph_merge)\n");
+    printf("--input-graph file -> compresses the file with the kmers of an existing graph instead of creating it, its false positives are computed again\n");
+    printf("--huge-pages -> backs the Bloom filter with transparent huge pages, its lookups miss the TLB less often\n");
+    printf("--hugetlb -> backs the Bloom filter with the huge pages reserved by the administrator (transparent ones if none is left)\n");
+    printf("--numa-interleave -> interleaves the pages of the Bloom filter on all NUMA nodes\n");
+    printf("--pin-threads -> pins each thread that creates the graph on one processor, spread on all NUMA nodes\n");
+    printf("--partitioned-build -> fills the Bloom filter one cache-sized part at a time, faster for filters much larger than the caches\n");
+    printf("--dedupe-kmers -> collects the distinct kmers before inserting each one once into the Bloom filter, which is sized from their exact number (8 bytes per distinct kmer)\n");
+    printf("--max-memory size -> counts the kmers exactly in temporary files, each one is counted with at most size bytes of memory\n");
+    printf("--tmp-dir dir -> directory of the temporary files of --max-memory (default /tmp)\n");
+    printf("--fast-hash -> hashes the kmers with an integer mixer instead of ntHash, stored in the graph (kmers of at most %d bases)\n", KMER_MAX_SIZE);
+    printf("--no-canonical -> strand-specific graph, a kmer and its reverse complement are distinct kmers (stranded RNA or amplicon reads)\n");
+    printf("--threads n -> number of threads used to create and compress the graph\n\n");
 }
 
 int main(int argc, char **argv) {
@@ -31,6 +60,27 @@ int main(int argc, char **argv) {
         { "kmer-size", required_argument, NULL, 3 },
         { "bloom-size", required_argument, NULL, 4 },
         { "bloom-hash", required_argument, NULL, 5 },
+        { "bloom-blocked", no_argument, NULL, 6 },
+        { "threads", required_argument, NULL, 7 },
+        { "bloom-fpr", required_argument, NULL, 8 },
+        { "bloom-max-size", required_argument, NULL, 9 },
+        { "no-false-positives", no_argument, NULL, 10 },
+        { "exact", no_argument, NULL, 11 },
+        { "min-abundance", required_argument, NULL, 12 },
+        { "mapped", no_argument, NULL, 13 },
+        { "compression-level", required_argument, NULL, 14 },
+        { "graph-only", no_argument, NULL, 15 },
+        { "input-graph", required_argument, NULL, 16 },
+        { "huge-pages", no_argument, NULL, 17 },
+        { "hugetlb", no_argument, NULL, 18 },
+        { "numa-interleave", no_argument, NULL, 19 },
+        { "pin-threads", no_argument, NULL, 20 },
+        { "partitioned-build", no_argument, NULL, 21 },
+        { "dedupe-kmers", no_argument, NULL, 22 },
+        { "max-memory", required_argument, NULL, 23 },
+        { "tmp-dir", required_argument, NULL, 24 },
+        { "fast-hash", no_argument, NULL, 25 },
+        { "no-canonical", no_argument, NULL, 26 },
         { 0, 0, 0, 0 }
     };
 
@@ -38,11 +88,31 @@ int main(int argc, char **argv) {
     char graphOutputFile[255] = { '\0' };
 
     int kmerSize = 20;
-    int64_t filterSize = 10000000;
-    int bfHash = 7;
+    // The filter is sized from the input when its size is not given
+    int64_t filterSize = 0;
+    int bfHash = 0;
+    double bfFpr = 0.01;
+    int64_t bfMaxSize = 0;
+    bool bfBlocked = false;
+    int nbThreads = 1;
+    bool falsePositives = true;
+    bool exact = false;
+    int minAbundance = 1;
+    bool mapped = false;
+    int compressionLevel = 9;
+    bool graphOnly = false;
+    char inputGraphFile[255] = { '\0' };
+    int allocation = BF_ALLOC_DEFAULT;
+    bool pinThreads = false;
+    bool partitioned = false;
+    bool dedupe = false;
+    int64_t maxMemory = 0;
+    char tmpDir[255] = { '\0' };
+    bool fastHash = false;
+    bool canonical = true;
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "?1:2:3:4:5:", options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "?1:2:3:4:5:67:8:9:", options, NULL)) != -1) {
         switch (opt) {
             case '?':
                 help(argv[0]);
@@ -59,8 +129,8 @@ int main(int argc, char **argv) {
             case 3: {
                 int8_t value = atoi8(optarg);
 
-                if (value <= 0) {
-                    fprintf(stderr, "Invalid kmer size\n");
+                if (value <= 0 || value > KMER128_MAX_SIZE) {
+                    fprintf(stderr, "Invalid kmer size, it must be between 1 and %d\n", KMER128_MAX_SIZE);
                     return EXIT_FAILURE;
                 }
 
@@ -91,6 +161,140 @@ int main(int argc, char **argv) {
                 bfHash = value;
                 break;
             }
+
+            case 6:
+                bfBlocked = true;
+                break;
+
+            case 7: {
+                int value = atoi(optarg);
+
+                if (value <= 0) {
+                    fprintf(stderr, "Invalid number of threads\n");
+                    return EXIT_FAILURE;
+                }
+
+                nbThreads = value;
+                break;
+            }
+
+            case 8: {
+                char *end = NULL;
+                double value = strtod(optarg, &end);
+
+                if (*end != '\0' || !(value > 0 && value < 1)) {
+                    fprintf(stderr, "Invalid false positive rate, it must be between 0 and 1\n");
+                    return EXIT_FAILURE;
+                }
+
+                bfFpr = value;
+                break;
+            }
+
+            case 9: {
+                int64_t value = atoi64(optarg);
+
+                if (value <= 0) {
+                    fprintf(stderr, "Invalid Bloom filter maximum size\n");
+                    return EXIT_FAILURE;
+                }
+
+                bfMaxSize = value;
+                break;
+            }
+
+            case 10:
+                falsePositives = false;
+                break;
+
+            case 11:
+                exact = true;
+                break;
+
+            case 12: {
+                int value = atoi(optarg);
+
+                if (value <= 0 || value > CMS_MAX_COUNT) {
+                    fprintf(stderr, "Invalid minimum abundance, it must be between 1 and %d\n", CMS_MAX_COUNT);
+                    return EXIT_FAILURE;
+                }
+
+                minAbundance = value;
+                break;
+            }
+
+            case 13:
+                mapped = true;
+                break;
+
+            case 14: {
+                char *end;
+                long value = strtol(optarg, &end, 10);
+
+                if (*optarg == '\0' || *end != '\0' || value < 0 || value > 9) {
+                    fprintf(stderr, "Invalid compression level, it must be between 0 and 9\n");
+                    return EXIT_FAILURE;
+                }
+
+                compressionLevel = value;
+                break;
+            }
+
+            case 15:
+                graphOnly = true;
+                break;
+
+            case 16:
+                strncpy(inputGraphFile, optarg, 255);
+                break;
+
+            case 17:
+                allocation |= BF_ALLOC_HUGE_PAGES;
+                break;
+
+            case 18:
+                allocation |= BF_ALLOC_HUGETLB;
+                break;
+
+            case 19:
+                allocation |= BF_ALLOC_INTERLEAVE;
+                break;
+
+            case 20:
+                pinThreads = true;
+                break;
+
+            case 21:
+                partitioned = true;
+                break;
+
+            case 22:
+                dedupe = true;
+                break;
+
+            case 23: {
+                int64_t value = atoi64(optarg);
+
+                if (value <= 0) {
+                    fprintf(stderr, "Invalid maximum memory\n");
+                    return EXIT_FAILURE;
+                }
+
+                maxMemory = value;
+                break;
+            }
+
+            case 24:
+                strncpy(tmpDir, optarg, 255);
+                break;
+
+            case 25:
+                fastHash = true;
+                break;
+
+            case 26:
+                canonical = false;
+                break;
             
             default:
                 fprintf(stderr, "Unknown option\n\n");
@@ -99,6 +303,18 @@ int main(int argc, char **argv) {
         }
     }
 
+    // Only the hashes of longer kmers are stored in a Bloom filter
+    if (kmerSize > KMER_MAX_SIZE && (exact || dedupe || maxMemory > 0)) {
+        fprintf(stderr, "Invalid kmer size, it must be at most %d with --exact, --dedupe-kmers or --max-memory\n", KMER_MAX_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    // The mixed kmers are packed on 64 bits
+    if (kmerSize > KMER_MAX_SIZE && fastHash) {
+        fprintf(stderr, "Invalid kmer size, it must be at most %d with --fast-hash\n", KMER_MAX_SIZE);
+        return EXIT_FAILURE;
+    }
+
     if (optind >= argc) {
         fprintf(stderr, "Missing path to a fasta file\n\n");
         help(argv[0]);
@@ -120,7 +336,10 @@ int main(int argc, char **argv) {
     }
 
     // Generates an output graph filename if the user did not specified one
-    if (*graphOutputFile == '\0' && pathExtension(inputFilePath, pathLen, "graph.gz", 8, graphOutputFile, 255) == 0) {
+    const char *graphExtension = mapped ? "graph" : "graph.gz";
+
+    if (*graphOutputFile == '\0'
+        && pathExtension(inputFilePath, pathLen, graphExtension, strlen(graphExtension), graphOutputFile, 255) == 0) {
         fprintf(stderr, "The given path is too long\n");
         return EXIT_FAILURE;
     }
@@ -128,7 +347,13 @@ int main(int argc, char **argv) {
     // Informs the user of paths and parameters that will be used
     log_info("Compressed fasta path : %s", outputFile);
     log_info("Graph path : %s", graphOutputFile);
-    log_info("Parameters : kmer-size=%d filter-size=%d filter-hash=%d", kmerSize, filterSize, bfHash);
+    log_info("Parameters : kmer-size=%d filter-size=%" PRId64 " filter-hash=%d filter-fpr=%g filter-max-size=%" PRId64 " filter-blocked=%d exact=%d min-abundance=%d mapped=%d compression-level=%d graph-only=%d allocation=%d pin-threads=%d partitioned-build=%d dedupe-kmers=%d max-memory=%" PRId64 " fast-hash=%d canonical=%d threads=%d",
+        kmerSize, filterSize, bfHash, bfFpr, bfMaxSize, bfBlocked, exact, minAbundance, mapped, compressionLevel, graphOnly, allocation, pinThreads, partitioned, dedupe, maxMemory, fastHash, canonical, nbThreads);
+
+    bfSetAllocation(allocation);
+    numaSetPinning(pinThreads);
+    kmerHashUseFunction(fastHash ? KMER_HASH_MIX : KMER_HASH_NTHASH);
+    kmerUseCanonical(canonical);
 
     int resultStatus = EXIT_FAILURE;
 
@@ -137,41 +362,264 @@ int main(int argc, char **argv) {
     FILE *inFp = NULL;
     FILE *outFp = NULL;
     BloomFilter *bf = NULL;
+    CountMinSketch *counts = NULL;
+    KmerSet *distinctKmers = NULL;
+    DBGBuckets *buckets = NULL;
+    DeBruijnGraph *graph = NULL;
 
     if ((inFp = fopen(inputFilePath, "r")) == NULL) {
         perror("Unable to open input file");
         return EXIT_FAILURE;
     }
 
-    // Creates a new Bloom Filter with default parameters
-    if ((bf = bfCreate(filterSize, bfHash)) == NULL) {
-        log_error("Unable to create a new Bloom filter");
-        goto EXIT;
+    // The kmers of an existing graph are used, for instance a graph merged from parts of the file
+    if (*inputGraphFile != '\0') {
+        log_info("Loading graph %s", inputGraphFile);
+        if ((graph = openDBG(inputGraphFile, nbThreads)) == NULL) {
+            log_error("Unable to load graph from %s", inputGraphFile);
+            goto EXIT;
+        }
+
+        // The kmers are hashed and canonicalized like the ones of the graph
+        kmerSize = graph->k;
+        useDBGKmerMode(graph);
+        log_info("Done : kmer-size=%d", kmerSize);
     }
 
-    log_info("Creating De Bruijn graph");
-    if (!createDBG(bf, inFp, kmerSize)) {
-        log_error("Unable to fill the graph with the given file");
-        goto EXIT;
+    uint64_t nbKmers = 0;
+
+    // The distinct kmers size the filter and the sketch of the counts, the filter
+    // of deduplicated or bucketed kmers is sized from their exact number
+    if (maxMemory == 0 && ((!graph && !exact && filterSize == 0 && !dedupe) || minAbundance > 1)) {
+        log_info("Estimating the number of distinct kmers");
+        if (!estimateDBGKmers(inFp, kmerSize, &nbKmers)) {
+            log_error("Unable to count the kmers of the given file");
+            goto EXIT;
+        }
+
+        fseek(inFp, 0, SEEK_SET);
+        log_info("Done : %" PRIu64 " distinct kmers", nbKmers);
     }
-    log_info("Done.");
 
-    gzFile graphOut = NULL;
-    if ((graphOut = gzopen(graphOutputFile, "wb9")) == NULL) {
-        log_error("Unable to create the output file");
-        log_error(strerror(errno));
-        goto EXIT;
+    // Only the solid kmers are stored in the graph
+    if (maxMemory == 0 && minAbundance > 1) {
+        log_info("Counting the kmers");
+        if ((counts = countDBGKmers(inFp, kmerSize, nbKmers, minAbundance, &nbKmers)) == NULL) {
+            log_error("Unable to count the kmers of the given file");
+            goto EXIT;
+        }
+
+        fseek(inFp, 0, SEEK_SET);
+        log_info("Done : %" PRIu64 " solid kmers", nbKmers);
     }
 
-    log_info("Saving graph to ...");
-    if (!saveDBG(bf, graphOut)) {
-        log_error("save failed");
-        gzclose(graphOut);
-        goto EXIT;
+    // The kmers are counted exactly with a bounded memory, the buckets are also
+    // used for the false positives of an existing graph
+    if (maxMemory > 0) {
+        log_info("Splitting the kmers into buckets");
+        if ((buckets = bucketDBGKmers(inFp, kmerSize, maxMemory, (*tmpDir != '\0') ? tmpDir : NULL)) == NULL) {
+            log_error("Unable to split the kmers of the given file");
+            goto EXIT;
+        }
+
+        fseek(inFp, 0, SEEK_SET);
+        log_info("Done : %d buckets", buckets->nbBuckets);
+
+        if (!graph && !exact && filterSize == 0) {
+            log_info("Counting the kmers");
+            if (!countDBGBuckets(buckets, minAbundance, &nbKmers)) {
+                log_error("Unable to count the kmers of the given file");
+                goto EXIT;
+            }
+            log_info("Done : %" PRIu64 " solid kmers", nbKmers);
+        }
+    }
+
+    // The solid kmers are inserted once into the filter
+    if (!graph && !exact && dedupe && !buckets) {
+        log_info("Collecting the distinct kmers");
+        if ((distinctKmers = collectDBGKmers(inFp, kmerSize, counts, minAbundance)) == NULL) {
+            log_error("Unable to collect the kmers of the given file");
+            goto EXIT;
+        }
+
+        fseek(inFp, 0, SEEK_SET);
+        nbKmers = kmerSetSize(distinctKmers);
+        log_info("Done : %" PRIu64 " distinct kmers", nbKmers);
+    }
+
+    if (graph) {
+        log_info("Using the %s graph of %s", (graph->backend == DBG_BACKEND_EXACT) ? "exact" : "Bloom", inputGraphFile);
+    }
+    else if (exact) {
+        log_info("Creating exact De Bruijn graph");
+        if (buckets) {
+            KmerSet *kmers = collectDBGBuckets(buckets, minAbundance);
+
+            if (kmers && (graph = wrapExactDBG(kmers, kmerSize)) == NULL) {
+                kmerSetDelete(kmers);
+            }
+        }
+        else {
+            graph = createExactDBG(inFp, kmerSize, counts, minAbundance);
+        }
+
+        if (!graph) {
+            log_error("Unable to fill the graph with the given file");
+            goto EXIT;
+        }
+        log_info("Done : %" PRIu64 " kmers", kmerSetSize(graph->kmers));
+    }
+    else if (filterSize == 0) {
+        long size;
+        int8_t nbHashs;
+
+        if (!bfOptimalParameters(nbKmers, bfFpr, bfMaxSize, &size, &nbHashs)) {
+            log_error("Unable to compute the filter parameters");
+            goto EXIT;
+        }
+
+        // A blocked filter only uses whole blocks
+        if (bfBlocked) {
+            size = (size + BF_BLOCK_SIZE - 1) / BF_BLOCK_SIZE * BF_BLOCK_SIZE;
+
+            if (bfMaxSize > 0 && size > bfMaxSize && bfMaxSize >= BF_BLOCK_SIZE) {
+                size = bfMaxSize / BF_BLOCK_SIZE * BF_BLOCK_SIZE;
+            }
+        }
+
+        filterSize = size;
+
+        if (bfHash == 0) {
+            bfHash = nbHashs;
+        }
+
+        log_info("Filter : kmers=%" PRIu64 " size=%" PRId64 " hash=%d expected-fpr=%g",
+            nbKmers, filterSize, bfHash, bfFalsePositiveRate(nbKmers, filterSize * 8, bfHash));
+    }
+    else if (bfHash == 0) {
+        bfHash = 7;
+    }
+
+    // The filter is only created for the Bloom backend
+    if (!graph && !exact) {
+        // Creates a new Bloom Filter with the given or computed parameters
+        bf = bfBlocked ? bfCreateBlocked(filterSize, bfHash) : bfCreate(filterSize, bfHash);
+
+        if (bf == NULL) {
+            log_error("Unable to create a new Bloom filter");
+            goto EXIT;
+        }
+
+        bf->hashFunction = fastHash ? BF_FUNCTION_FAST : BF_FUNCTION_MURMUR3;
+
+        log_info("Creating De Bruijn graph");
+        bool created;
+
+        if (buckets) {
+            created = insertDBGBuckets(buckets, bf, minAbundance, nbThreads);
+        }
+        else if (distinctKmers) {
+            created = insertDBGKmers(bf, distinctKmers, kmerSize, nbThreads);
+
+            kmerSetDelete(distinctKmers);
+            distinctKmers = NULL;
+        }
+        else if (partitioned) {
+            created = createPartitionedDBG(bf, inFp, kmerSize, nbThreads, counts, minAbundance);
+        }
+        else {
+            created = createSolidDBG(bf, inFp, kmerSize, nbThreads, counts, minAbundance);
+        }
+
+        if (!created) {
+            log_error("Unable to fill the graph with the given file");
+            goto EXIT;
+        }
+        log_info("Done.");
+
+        // The graph owns the filter
+        if ((graph = wrapDBG(bf, kmerSize)) == NULL) {
+            goto EXIT;
+        }
+
+        bf = NULL;
     }
-    log_info("Done.");
 
-    gzclose(graphOut);
+    // The false positives are stored packed on 64 bits
+    if (graph->backend == DBG_BACKEND_BLOOM && falsePositives && !graphOnly && graph->k > KMER_MAX_SIZE) {
+        log_warn("The false positives of kmers longer than %d are not removed", KMER_MAX_SIZE);
+        falsePositives = false;
+    }
+
+    // The false positives of a part of a file are computed once its graph is merged
+    if (graph->backend == DBG_BACKEND_BLOOM && falsePositives && !graphOnly) {
+        log_info("Computing critical false positives");
+        bool computed = buckets
+            ? computeBucketFalsePositives(graph, inFp, buckets, minAbundance)
+            : computeFalsePositives(graph, inFp, kmerSize, counts, minAbundance);
+
+        if (!computed) {
+            log_error("Unable to compute the false positives of the graph");
+            goto EXIT;
+        }
+        log_info("Done : %" PRIu64 " false positives", kmerSetSize(graph->falsePositives));
+    }
+
+    // The counts and their temporary files are not needed for the compression
+    cmsDelete(counts);
+    counts = NULL;
+    deleteDBGBuckets(buckets);
+    buckets = NULL;
+
+    if (mapped) {
+        FILE *graphOut = NULL;
+        if ((graphOut = fopen(graphOutputFile, "wb")) == NULL) {
+            log_error("Unable to create the output file");
+            log_error(strerror(errno));
+            goto EXIT;
+        }
+
+        log_info("Saving mapped graph to ...");
+        if (!saveMappedDBG(graph, graphOut)) {
+            log_error("save failed");
+            fclose(graphOut);
+            goto EXIT;
+        }
+
+        if (fclose(graphOut) != 0) {
+            log_error("Unable to close the graph file");
+            goto EXIT;
+        }
+        log_info("Done.");
+    }
+    else {
+        FILE *graphOut = NULL;
+        if ((graphOut = fopen(graphOutputFile, "wb")) == NULL) {
+            log_error("Unable to create the output file");
+            log_error(strerror(errno));
+            goto EXIT;
+        }
+
+        log_info("Saving graph to ...");
+        if (!saveBlockedDBG(graph, graphOut, compressionLevel, nbThreads)) {
+            log_error("save failed");
+            fclose(graphOut);
+            goto EXIT;
+        }
+
+        if (fclose(graphOut) != 0) {
+            log_error("Unable to close the graph file");
+            goto EXIT;
+        }
+        log_info("Done.");
+    }
+
+    // The reads of a part are compressed with the merged graph
+    if (graphOnly) {
+        resultStatus = EXIT_SUCCESS;
+        goto EXIT;
+    }
 
     // Lets read the file again
     fseek(inFp, 0, SEEK_SET);
@@ -182,7 +630,7 @@ int main(int argc, char **argv) {
     }
 
     log_info("Compressing reads");
-    if (!compressFile(bf, inFp, outFp, kmerSize)) {
+    if (!compressFile(graph, inFp, outFp, kmerSize)) {
         log_error("compression error");
         goto EXIT;
     }
@@ -192,6 +640,10 @@ int main(int argc, char **argv) {
 
 EXIT:
     bfDelete(bf);
+    cmsDelete(counts);
+    kmerSetDelete(distinctKmers);
+    deleteDBGBuckets(buckets);
+    deleteDBG(graph);
     if (inFp) {
         fclose(inFp);
     }
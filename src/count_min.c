@@ -0,0 +1,108 @@
+#include "count_min.h"
+
+#include "log.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+CountMinSketch *cmsCreate(uint64_t width, uint8_t depth) {
+    if (width == 0 || depth == 0 || depth > CMS_MAX_DEPTH) {
+        return NULL;
+    }
+
+    CountMinSketch *cms = malloc(sizeof(*cms));
+
+    if (!cms) {
+        log_error("Sketch allocation error");
+        return NULL;
+    }
+
+    cms->width = width;
+    cms->depth = depth;
+    cms->counters = calloc(width, depth);
+
+    if (!cms->counters) {
+        log_error("Sketch counters allocation error");
+        free(cms);
+        return NULL;
+    }
+
+    return cms;
+}
+
+void cmsDelete(CountMinSketch *cms) {
+    if (cms) {
+        free(cms->counters);
+        free(cms);
+    }
+}
+
+/**
+ * \brief Computes the index of the counter of a value in each row
+ * 
+ * The indexes are derived from two hashs with the double hashing,
+ * they are mapped to the width of a row with a multiplication.
+ */
+static void getCounters(const CountMinSketch *cms, uint64_t hash, uint64_t *counters) {
+    // Finalizer of the 64 bits MurmurHash3
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    uint64_t step = (hash >> 32 | hash << 32) | 1;
+
+    for (uint8_t row = 0;row < cms->depth;row++) {
+        uint64_t value = hash + row * step;
+        uint64_t column = (uint64_t) (((unsigned __int128) value * cms->width) >> 64);
+
+        counters[row] = row * cms->width + column;
+    }
+}
+
+uint8_t cmsAdd(CountMinSketch *cms, uint64_t hash) {
+    assert(cms);
+
+    uint64_t counters[CMS_MAX_DEPTH];
+    getCounters(cms, hash, counters);
+
+    uint8_t min = CMS_MAX_COUNT;
+
+    for (uint8_t row = 0;row < cms->depth;row++) {
+        if (cms->counters[counters[row]] < min) {
+            min = cms->counters[counters[row]];
+        }
+    }
+
+    if (min == CMS_MAX_COUNT) {
+        return min;
+    }
+
+    // Conservative update : only the counters equal to
+    // the estimate are incremented
+    for (uint8_t row = 0;row < cms->depth;row++) {
+        if (cms->counters[counters[row]] == min) {
+            cms->counters[counters[row]]++;
+        }
+    }
+
+    return min + 1;
+}
+
+uint8_t cmsEstimate(const CountMinSketch *cms, uint64_t hash) {
+    assert(cms);
+
+    uint64_t counters[CMS_MAX_DEPTH];
+    getCounters(cms, hash, counters);
+
+    uint8_t min = CMS_MAX_COUNT;
+
+    for (uint8_t row = 0;row < cms->depth;row++) {
+        if (cms->counters[counters[row]] < min) {
+            min = cms->counters[counters[row]];
+        }
+    }
+
+    return min;
+}
@@ -0,0 +1,98 @@
+#ifndef COUNT_MIN_H
+#define COUNT_MIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \brief Maximum number of rows of a count-min sketch
+ */
+#define CMS_MAX_DEPTH 8
+
+/**
+ * \brief Counters saturate at this value
+ */
+#define CMS_MAX_COUNT UINT8_MAX
+
+/**
+ * \brief Sketch that counts the occurrences of values
+ * 
+ * The sketch has depth rows of width counters of one byte. A value
+ * increments one counter per row and its count is estimated by the smallest
+ * of its counters : the estimate is never lower than the real count.
+ * Counters are incremented with the conservative update, only the smallest
+ * ones are increased, which reduces the overestimation.
+ */
+typedef struct CountMinSketch {
+    uint8_t *counters;
+    uint64_t width;
+    uint8_t depth;
+} CountMinSketch;
+
+/**
+ * \brief Gets the number of counters of a row
+ */
+#define cmsWidth(cms) ((cms)->width)
+
+/**
+ * \brief Gets the number of rows of the sketch
+ */
+#define cmsDepth(cms) ((cms)->depth)
+
+/**
+ * \brief Creates a new sketch where all counts are 0
+ * 
+ * The width must be strictly positive and the depth must be between 1
+ * and CMS_MAX_DEPTH, otherwise NULL will be returned. NULL is also returned
+ * if an allocation error occured.
+ * 
+ * @param width number of counters of each row
+ * @param depth number of rows
+ * @return a pointer to an allocated CountMinSketch structure
+ */
+CountMinSketch *cmsCreate(uint64_t width, uint8_t depth);
+
+/**
+ * \brief Frees the memory allocated for the given sketch
+ * 
+ * @param cms a pointer to an allocated CountMinSketch structure
+ */
+void cmsDelete(CountMinSketch *cms);
+
+/**
+ * \brief Adds an occurrence of a value into the sketch from its hash
+ * 
+ * The hash is mixed before being used, so hashs with
+ * poorly distributed bits can be given.
+ * 
+ * @param cms a pointer to a CountMinSketch structure
+ * @param hash a 64 bits hash of the value
+ * @return the estimated count of the value after the insertion
+ */
+uint8_t cmsAdd(CountMinSketch *cms, uint64_t hash);
+
+/**
+ * \brief Estimates the number of occurrences of a value
+ * 
+ * @param cms a pointer to a CountMinSketch structure
+ * @param hash a 64 bits hash of the value
+ * @return the estimated count, at most CMS_MAX_COUNT
+ */
+uint8_t cmsEstimate(const CountMinSketch *cms, uint64_t hash);
+
+/**
+ * \brief Checks if a value has been counted enough times to be solid
+ * 
+ * All values are solid when they are not counted, so that the callers
+ * can give a NULL sketch to keep all of them.
+ * 
+ * @param cms a pointer to a CountMinSketch structure, could be NULL
+ * @param minCount minimum count of a solid value
+ * @param hash a 64 bits hash of the value
+ * @return true if the value is solid, otherwise false
+ */
+static inline bool cmsIsSolid(const CountMinSketch *cms, int minCount, uint64_t hash) {
+    return !cms || cmsEstimate(cms, hash) >= minCount;
+}
+
+#endif // COUNT_MIN_H
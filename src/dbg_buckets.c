@@ -0,0 +1,679 @@
+#include "dbg_buckets.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fasta.h"
+#include "kmer_hash.h"
+#include "log.h"
+
+// Number of kmers buffered for each bucket by bucketDBGKmers before they are written
+#define DBG_BUCKET_BUFFER 1024
+
+// Maximum number of buckets of bucketDBGKmers, each one is an open file
+#define DBG_MAX_BUCKETS 1024
+
+// Maximum number of buckets a bucket is split into at once
+#define DBG_MAX_SPLITS 1024
+
+// Open files kept for the rest of the program (standard streams, fasta and graph files)
+#define DBG_FILE_HEADROOM 32
+
+/**
+ * \brief Gives the number of temporary files that can be open at the same time
+ * 
+ * @return the limit of open files of the process minus DBG_FILE_HEADROOM, at most DBG_MAX_BUCKETS
+ */
+static int getMaxOpenFiles() {
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY
+        || limit.rlim_cur >= DBG_MAX_BUCKETS + DBG_FILE_HEADROOM) {
+        return DBG_MAX_BUCKETS;
+    }
+
+    return (limit.rlim_cur > DBG_FILE_HEADROOM) ? (int) (limit.rlim_cur - DBG_FILE_HEADROOM) : 0;
+}
+
+/**
+ * \brief Creates a temporary file that is removed when it is closed
+ * 
+ * @param tmpDir directory of the file, the one of tmpfile if NULL
+ * @return the opened file or NULL if it could not be created
+ */
+static FILE *createTemporaryFile(const char *tmpDir) {
+    if (!tmpDir) {
+        return tmpfile();
+    }
+
+    char path[PATH_MAX];
+
+    if (snprintf(path, sizeof(path), "%s/fasta_kmers_XXXXXX", tmpDir) >= (int) sizeof(path)) {
+        return NULL;
+    }
+
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    // The data stays available until the file is closed
+    unlink(path);
+
+    FILE *fp = fdopen(fd, "w+b");
+
+    if (!fp) {
+        close(fd);
+    }
+
+    return fp;
+}
+
+/**
+ * \brief Creates a temporary file and adds it to the files of buckets
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param tmpDir directory of the file, the one of tmpfile if NULL
+ * @return the index of the file or -1 if it could not be created
+ */
+static int addBucketFile(DBGBuckets *buckets, const char *tmpDir) {
+    FILE **files = realloc(buckets->files, sizeof(*files) * (buckets->nbFiles + 1));
+
+    if (files) {
+        buckets->files = files;
+    }
+
+    int *references = realloc(buckets->references, sizeof(*references) * (buckets->nbFiles + 1));
+
+    if (references) {
+        buckets->references = references;
+    }
+
+    if (!files || !references) {
+        log_error("Unable to allocate the buckets");
+        return -1;
+    }
+
+    FILE *fp = createTemporaryFile(tmpDir);
+
+    if (!fp) {
+        log_error("Unable to create a temporary file in %s", tmpDir ? tmpDir : P_tmpdir);
+        log_error(strerror(errno));
+        return -1;
+    }
+
+    buckets->files[buckets->nbFiles] = fp;
+    buckets->references[buckets->nbFiles] = 0;
+    buckets->nbOpenFiles++;
+
+    return buckets->nbFiles++;
+}
+
+/**
+ * \brief Removes a bucket from the buckets stored in a file, the file is closed when it has no bucket left
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param file index of the file
+ */
+static void releaseBucketFile(DBGBuckets *buckets, int file) {
+    if (--buckets->references[file] == 0) {
+        fclose(buckets->files[file]);
+        buckets->files[file] = NULL;
+        buckets->nbOpenFiles--;
+    }
+}
+
+/**
+ * \brief Gives the first hash of a part of the hashes of a bucket
+ * 
+ * @param bucket a pointer to a DBGBucket structure
+ * @param part index of the part, from 0 to nbParts (excluded)
+ * @param nbParts number of parts of the hashes of the bucket
+ * @return the first hash of the part
+ */
+static uint64_t getPartFirst(const DBGBucket *bucket, uint64_t part, uint64_t nbParts) {
+    unsigned __int128 width = (unsigned __int128) (bucket->last - bucket->first) + 1;
+
+    return bucket->first + (uint64_t) ((part * width + nbParts - 1) / nbParts);
+}
+
+/**
+ * \brief Gives the part of the hashes of a bucket a hash belongs to
+ * 
+ * @param bucket a pointer to a DBGBucket structure
+ * @param hash a hash of the bucket
+ * @param nbParts number of parts of the hashes of the bucket
+ * @return the index of the part, from 0 to nbParts (excluded)
+ */
+static uint64_t getPart(const DBGBucket *bucket, uint64_t hash, uint64_t nbParts) {
+    unsigned __int128 width = (unsigned __int128) (bucket->last - bucket->first) + 1;
+
+    return (uint64_t) ((unsigned __int128) (hash - bucket->first) * nbParts / width);
+}
+
+/**
+ * \brief Gives the hash of a kmer read from a bucket, the one that selected its bucket
+ * 
+ * @param kmer a kmer of a bucket
+ * @param k length of the kmer
+ * @return the hash of the kmer
+ */
+static inline uint64_t hashBucketKmer(Kmer kmer, int k) {
+    KmerHash hash;
+
+    kmerHashInit(&hash, kmer, k);
+
+    return kmerHashCanonical(&hash);
+}
+
+/**
+ * \brief Writes kmers to a bucket
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param bucket a pointer to the bucket
+ * @param position index of the first written kmer in the bucket
+ * @param kmers array of kmers
+ * @param n number of kmers
+ * @return true if the kmers were written, otherwise false
+ */
+static bool writeBucket(DBGBuckets *buckets, const DBGBucket *bucket, uint64_t position, const Kmer *kmers, uint64_t n) {
+    FILE *fp = buckets->files[bucket->file];
+
+    if (fseeko(fp, (off_t) ((bucket->offset + position) * sizeof(*kmers)), SEEK_SET) != 0
+        || fwrite(kmers, sizeof(*kmers), n, fp) != n) {
+        log_error("Unable to write a bucket of kmers");
+        log_error(strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Reads kmers from a bucket
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param bucket a pointer to the bucket
+ * @param position index of the first read kmer in the bucket
+ * @param kmers destination of the kmers
+ * @param n number of kmers
+ * @return true if the kmers were read, otherwise false
+ */
+static bool readBucket(DBGBuckets *buckets, const DBGBucket *bucket, uint64_t position, Kmer *kmers, uint64_t n) {
+    FILE *fp = buckets->files[bucket->file];
+
+    if (fseeko(fp, (off_t) ((bucket->offset + position) * sizeof(*kmers)), SEEK_SET) != 0
+        || fread(kmers, sizeof(*kmers), n, fp) != n) {
+        log_error("Unable to read a bucket of kmers");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Counts the kmers of a bucket in each part of its hashes
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param bucket a pointer to the bucket
+ * @param nbParts number of parts of the hashes of the bucket
+ * @param chunk array of DBG_BUCKET_BUFFER kmers
+ * @param counts destination of the number of kmers of each part
+ * @return true if the bucket was read, otherwise false
+ */
+static bool countParts(DBGBuckets *buckets, const DBGBucket *bucket, uint64_t nbParts, Kmer *chunk, uint64_t *counts) {
+    memset(counts, 0, sizeof(*counts) * nbParts);
+
+    for (uint64_t i = 0;i < bucket->size;i += DBG_BUCKET_BUFFER) {
+        uint64_t n = (bucket->size - i < DBG_BUCKET_BUFFER) ? bucket->size - i : DBG_BUCKET_BUFFER;
+
+        if (!readBucket(buckets, bucket, i, chunk, n)) {
+            return false;
+        }
+
+        for (uint64_t j = 0;j < n;j++) {
+            counts[getPart(bucket, hashBucketKmer(chunk[j], buckets->k), nbParts)]++;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Splits a bucket on its hashes into buckets of at most maxKmers kmers, stored in a new file
+ * 
+ * The split buckets replace the bucket in the buckets, some of them may still have more than
+ * maxKmers kmers. When all the kmers have the same hash, or too many files are open, the bucket
+ * is kept.
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param index index of the split bucket
+ * @param maxKmers maximum number of kmers of a bucket
+ * @param tmpDir directory of the new file, the one of tmpfile if NULL
+ * @return the number of buckets replacing the bucket, 0 if it was kept or -1 if an error occured
+ */
+static int splitBucket(DBGBuckets *buckets, int index, uint64_t maxKmers, const char *tmpDir) {
+    DBGBucket *bucket = buckets->buckets + index;
+    uint64_t nbParts = 2 * ((bucket->size + maxKmers - 1) / maxKmers);
+
+    if (nbParts > DBG_MAX_SPLITS) {
+        nbParts = DBG_MAX_SPLITS;
+    }
+
+    if (buckets->nbOpenFiles >= buckets->maxOpenFiles) {
+        return 0;
+    }
+
+    int result = -1;
+    Kmer *chunk = malloc(sizeof(*chunk) * DBG_BUCKET_BUFFER);
+    uint64_t *counts = malloc(sizeof(*counts) * nbParts);
+    uint64_t *filled = calloc(nbParts, sizeof(*filled));
+    uint64_t *written = calloc(nbParts, sizeof(*written));
+    Kmer *buffers = malloc(sizeof(*buffers) * nbParts * DBG_BUCKET_BUFFER);
+    DBGBucket *parts = malloc(sizeof(*parts) * nbParts);
+
+    if (!chunk || !counts || !filled || !written || !buffers || !parts) {
+        log_error("Unable to allocate the buckets");
+        goto EXIT;
+    }
+
+    // The range of the hashes is narrowed until the kmers are in several parts
+    while (true) {
+        if (bucket->first == bucket->last) {
+            result = 0;
+            goto EXIT;
+        }
+
+        if (bucket->last - bucket->first < nbParts) {
+            nbParts = bucket->last - bucket->first + 1;
+        }
+
+        if (!countParts(buckets, bucket, nbParts, chunk, counts)) {
+            goto EXIT;
+        }
+
+        uint64_t part = 0;
+
+        while (counts[part] == 0) {
+            part++;
+        }
+
+        if (counts[part] < bucket->size) {
+            break;
+        }
+
+        uint64_t first = getPartFirst(bucket, part, nbParts);
+        bucket->last = (part + 1 < nbParts) ? getPartFirst(bucket, part + 1, nbParts) - 1 : bucket->last;
+        bucket->first = first;
+    }
+
+    int file = addBucketFile(buckets, tmpDir);
+
+    if (file < 0) {
+        goto EXIT;
+    }
+
+    int nbSplits = 0;
+    uint64_t offset = 0;
+
+    for (uint64_t i = 0;i < nbParts;i++) {
+        parts[i].size = counts[i];
+        parts[i].offset = offset;
+        parts[i].first = getPartFirst(bucket, i, nbParts);
+        parts[i].last = (i + 1 < nbParts) ? getPartFirst(bucket, i + 1, nbParts) - 1 : bucket->last;
+        parts[i].file = file;
+        offset += counts[i];
+        nbSplits += (counts[i] > 0);
+    }
+
+    for (uint64_t i = 0;i < bucket->size;i += DBG_BUCKET_BUFFER) {
+        uint64_t n = (bucket->size - i < DBG_BUCKET_BUFFER) ? bucket->size - i : DBG_BUCKET_BUFFER;
+
+        if (!readBucket(buckets, bucket, i, chunk, n)) {
+            goto EXIT;
+        }
+
+        for (uint64_t j = 0;j < n;j++) {
+            uint64_t part = getPart(bucket, hashBucketKmer(chunk[j], buckets->k), nbParts);
+            Kmer *buffer = buffers + part * DBG_BUCKET_BUFFER;
+
+            buffer[filled[part]++] = chunk[j];
+
+            if (filled[part] == DBG_BUCKET_BUFFER) {
+                if (!writeBucket(buckets, parts + part, written[part], buffer, DBG_BUCKET_BUFFER)) {
+                    goto EXIT;
+                }
+
+                written[part] += DBG_BUCKET_BUFFER;
+                filled[part] = 0;
+            }
+        }
+    }
+
+    for (uint64_t i = 0;i < nbParts;i++) {
+        if (!writeBucket(buckets, parts + i, written[i], buffers + i * DBG_BUCKET_BUFFER, filled[i])) {
+            goto EXIT;
+        }
+    }
+
+    DBGBucket *resized = realloc(buckets->buckets, sizeof(*resized) * (buckets->nbBuckets + nbSplits - 1));
+
+    if (!resized) {
+        log_error("Unable to allocate the buckets");
+        goto EXIT;
+    }
+
+    buckets->buckets = resized;
+    bucket = buckets->buckets + index;
+    releaseBucketFile(buckets, bucket->file);
+
+    // The non-empty parts replace the bucket, in the order of their hashes
+    memmove(bucket + nbSplits, bucket + 1, sizeof(*bucket) * (buckets->nbBuckets - index - 1));
+
+    for (uint64_t i = 0;i < nbParts;i++) {
+        if (parts[i].size > 0) {
+            *bucket++ = parts[i];
+        }
+    }
+
+    buckets->nbBuckets += nbSplits - 1;
+    buckets->references[file] = nbSplits;
+    result = nbSplits;
+
+EXIT:
+    free(chunk);
+    free(counts);
+    free(filled);
+    free(written);
+    free(buffers);
+    free(parts);
+    return result;
+}
+
+DBGBuckets *bucketDBGKmers(FILE *fp, int k, uint64_t maxMemory, const char *tmpDir) {
+    assert(fp);
+
+    if (k <= 0 || k > KMER_MAX_SIZE || maxMemory == 0) {
+        return NULL;
+    }
+
+    // The size of the file is greater than its number of kmers,
+    // a bucket and the array used to sort it need 16 bytes per kmer
+    struct stat st;
+    uint64_t nbKmers = (fstat(fileno(fp), &st) == 0 && st.st_size > 0) ? (uint64_t) st.st_size : 0;
+    uint64_t bucketKmers = (maxMemory >= 2 * sizeof(Kmer)) ? maxMemory / (2 * sizeof(Kmer)) : 1;
+    uint64_t nbBuckets = (nbKmers + bucketKmers - 1) / bucketKmers;
+    int maxOpenFiles = getMaxOpenFiles();
+
+    if (maxOpenFiles < 2) {
+        log_error("Unable to create the buckets, too few files can be opened");
+        return NULL;
+    }
+
+    if (nbBuckets < 1) {
+        nbBuckets = 1;
+    }
+
+    // The buckets that are too large are split once the file is read,
+    // one more file must then be opened
+    if (nbBuckets > (uint64_t) maxOpenFiles - 1) {
+        nbBuckets = maxOpenFiles - 1;
+    }
+
+    DBGBuckets *buckets = calloc(1, sizeof(*buckets));
+    Kmer *buffers = malloc(sizeof(*buffers) * nbBuckets * DBG_BUCKET_BUFFER);
+    uint64_t *filled = calloc(nbBuckets, sizeof(*filled));
+
+    char *line = NULL;
+    size_t length = 0;
+
+    if (!buckets || !buffers || !filled) {
+        log_error("Unable to allocate the buckets");
+        goto ERROR;
+    }
+
+    buckets->k = k;
+    buckets->maxOpenFiles = maxOpenFiles;
+    buckets->buckets = calloc(nbBuckets, sizeof(*buckets->buckets));
+
+    if (!buckets->buckets) {
+        log_error("Unable to allocate the buckets");
+        goto ERROR;
+    }
+
+    DBGBucket all = { .first = 0, .last = UINT64_MAX };
+
+    for (uint64_t i = 0;i < nbBuckets;i++) {
+        DBGBucket *bucket = buckets->buckets + i;
+
+        if ((bucket->file = addBucketFile(buckets, tmpDir)) < 0) {
+            goto ERROR;
+        }
+
+        bucket->first = getPartFirst(&all, i, nbBuckets);
+        bucket->last = (i + 1 < nbBuckets) ? getPartFirst(&all, i + 1, nbBuckets) - 1 : UINT64_MAX;
+        buckets->references[bucket->file] = 1;
+        buckets->nbBuckets++;
+    }
+
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength) {
+            goto ERROR;
+        }
+
+        Kmer kmer;
+        KmerHash hash;
+
+        kmerEncode(line, k, &kmer);
+        kmerHashInit(&hash, kmer, k);
+        Kmer rc = kmerReverseComplement(kmer, k);
+
+        for (int64_t i = k;i <= lineLength;i++) {
+            // The highest bits of the hash select the bucket, as getPart(&all, hash, nbBuckets)
+            uint64_t bucket = (uint64_t) (((unsigned __int128) kmerHashCanonical(&hash) * nbBuckets) >> 64);
+            Kmer *buffer = buffers + bucket * DBG_BUCKET_BUFFER;
+
+            buffer[filled[bucket]++] = (kmerCanonicalMode && rc < kmer) ? rc : kmer;
+
+            if (filled[bucket] == DBG_BUCKET_BUFFER) {
+                DBGBucket *b = buckets->buckets + bucket;
+
+                if (!writeBucket(buckets, b, b->size, buffer, DBG_BUCKET_BUFFER)) {
+                    goto ERROR;
+                }
+
+                b->size += DBG_BUCKET_BUFFER;
+                filled[bucket] = 0;
+            }
+
+            if (i < lineLength) {
+                uint8_t base = kmerEncodeBase(line[i]);
+
+                hash = kmerHashRoll(&hash, kmerFirstBase(kmer, k), base, k);
+                kmer = kmerAppend(kmer, base, k);
+                rc = kmerAppendReverse(rc, base, k);
+            }
+        }
+    }
+
+    if (ferror(fp)) {
+        perror("something bad happened");
+        goto ERROR;
+    }
+
+    for (uint64_t i = 0;i < nbBuckets;i++) {
+        DBGBucket *b = buckets->buckets + i;
+
+        if (!writeBucket(buckets, b, b->size, buffers + i * DBG_BUCKET_BUFFER, filled[i])) {
+            goto ERROR;
+        }
+
+        b->size += filled[i];
+    }
+
+    free(line);
+    free(buffers);
+    free(filled);
+    line = NULL;
+    buffers = NULL;
+    filled = NULL;
+
+    for (int i = 0;i < buckets->nbBuckets;) {
+        int nbSplits = 0;
+
+        if (buckets->buckets[i].size > bucketKmers
+            && (nbSplits = splitBucket(buckets, i, bucketKmers, tmpDir)) < 0) {
+            goto ERROR;
+        }
+
+        if (nbSplits == 0) {
+            if (buckets->buckets[i].size > bucketKmers) {
+                log_warn("A bucket of %" PRIu64 " kmers can not be split, it needs more than %" PRIu64 " bytes", buckets->buckets[i].size, maxMemory);
+            }
+
+            i++;
+        }
+    }
+
+    return buckets;
+
+ERROR:
+    free(line);
+    free(buffers);
+    free(filled);
+    deleteDBGBuckets(buckets);
+    return NULL;
+}
+
+Kmer *allocateDBGBucket(const DBGBuckets *buckets) {
+    assert(buckets);
+
+    uint64_t size = 1;
+
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        if (buckets->buckets[i].size > size) {
+            size = buckets->buckets[i].size;
+        }
+    }
+
+    Kmer *kmers = malloc(sizeof(*kmers) * size);
+
+    if (!kmers) {
+        log_error("Unable to allocate a bucket of %" PRIu64 " kmers", size);
+    }
+
+    return kmers;
+}
+
+bool readDBGBucket(DBGBuckets *buckets, int i, Kmer *kmers, int minAbundance, uint64_t *nbSolid) {
+    assert(buckets);
+    assert(kmers);
+    assert(nbSolid);
+    assert(i >= 0 && i < buckets->nbBuckets);
+
+    uint64_t size = buckets->buckets[i].size;
+
+    if (!readBucket(buckets, buckets->buckets + i, 0, kmers, size)) {
+        return false;
+    }
+
+    *nbSolid = kmerSortCount(kmers, size, (minAbundance > 1) ? minAbundance : 1);
+
+    return true;
+}
+
+bool countDBGBuckets(DBGBuckets *buckets, int minAbundance, uint64_t *nbSolid) {
+    assert(buckets);
+    assert(nbSolid);
+
+    Kmer *kmers = allocateDBGBucket(buckets);
+
+    if (!kmers) {
+        return false;
+    }
+
+    *nbSolid = 0;
+
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        uint64_t n;
+
+        if (!readDBGBucket(buckets, i, kmers, minAbundance, &n)) {
+            free(kmers);
+            return false;
+        }
+
+        *nbSolid += n;
+    }
+
+    free(kmers);
+    return true;
+}
+
+KmerSet *collectDBGBuckets(DBGBuckets *buckets, int minAbundance) {
+    assert(buckets);
+
+    Kmer *bucket = allocateDBGBucket(buckets);
+    Kmer *kmers = NULL;
+    uint64_t size = 0;
+
+    if (!bucket) {
+        return NULL;
+    }
+
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        uint64_t n;
+
+        if (!readDBGBucket(buckets, i, bucket, minAbundance, &n)) {
+            goto ERROR;
+        }
+
+        Kmer *resized = realloc(kmers, sizeof(*kmers) * (size + n > 0 ? size + n : 1));
+
+        if (!resized) {
+            log_error("Unable to collect more than %" PRIu64 " kmers", size);
+            goto ERROR;
+        }
+
+        kmers = resized;
+        memcpy(kmers + size, bucket, sizeof(*kmers) * n);
+        size += n;
+    }
+
+    free(bucket);
+
+    // The kmers of a bucket are sorted, but the buckets are not
+    return kmerSetCreate(kmers, size);
+
+ERROR:
+    free(bucket);
+    free(kmers);
+    return NULL;
+}
+
+void deleteDBGBuckets(DBGBuckets *buckets) {
+    if (!buckets) {
+        return;
+    }
+
+    if (buckets->files) {
+        for (int i = 0;i < buckets->nbFiles;i++) {
+            if (buckets->files[i]) {
+                fclose(buckets->files[i]);
+            }
+        }
+    }
+
+    free(buckets->files);
+    free(buckets->references);
+    free(buckets->buckets);
+    free(buckets);
+}
@@ -0,0 +1,124 @@
+#ifndef DBG_BUCKETS_H
+#define DBG_BUCKETS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "kmer.h"
+#include "kmer_set.h"
+
+/**
+ * \brief Bucket of kmers stored in a region of a temporary file
+ */
+typedef struct DBGBucket {
+    // Number of kmers and position of the first one in the file
+    uint64_t size;
+    uint64_t offset;
+    // Range of the hashes of the kmers of the bucket
+    uint64_t first;
+    uint64_t last;
+    // Index of the file in the files of the buckets
+    int file;
+} DBGBucket;
+
+/**
+ * \brief Kmers of a fasta file split into temporary files (see bucketDBGKmers)
+ */
+typedef struct DBGBuckets {
+    int k;
+    int nbBuckets;
+    DBGBucket *buckets;
+    // Temporary files and number of buckets stored in each one,
+    // a file is closed once all its buckets have been split
+    int nbFiles;
+    int nbOpenFiles;
+    int maxOpenFiles;
+    FILE **files;
+    int *references;
+} DBGBuckets;
+
+/**
+ * \brief Splits the kmers of a fasta file into buckets stored in temporary files
+ * 
+ * Each canonical kmer of the file is written to the bucket selected by the highest bits
+ * of its hash, so all occurrences of a kmer are in the same bucket. The number of buckets
+ * is chosen from the size of the file, so that a bucket can be sorted with maxMemory bytes
+ * (16 bytes per kmer). The buckets are then counted one after the other in memory
+ * (see countDBGBuckets, insertDBGBuckets and collectDBGBuckets) : the kmers of the file
+ * never need to fit into memory, only the ones of a bucket.
+ * 
+ * Each bucket is first an open file, so their number is also bounded by the limit
+ * of open files of the process (RLIMIT_NOFILE). The buckets that are then too large
+ * are split on their hashes, into regions of a new file. Only the occurrences
+ * of a same kmer can not be split, such a bucket may need more than maxMemory bytes.
+ * 
+ * The files are created in tmpDir, or in the default directory of tmpfile if tmpDir is NULL.
+ * They are removed when the buckets are deleted or the program exits.
+ * 
+ * The same errors as createDBG are reported and k must be less or equal to KMER_MAX_SIZE,
+ * NULL is returned in case of an error
+ * or if maxMemory is 0.
+ * 
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param maxMemory memory (in bytes) available to count a bucket
+ * @param tmpDir directory of the temporary files, can be NULL
+ * @return a pointer to an allocated DBGBuckets structure
+ */
+DBGBuckets *bucketDBGKmers(FILE *fp, int k, uint64_t maxMemory, const char *tmpDir);
+
+/**
+ * \brief Counts the distinct solid kmers of buckets
+ * 
+ * The kmers are counted exactly, a solid kmer appears at least minAbundance times.
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param minAbundance minimum count of a solid kmer
+ * @param nbSolid destination of the number of distinct solid kmers
+ * @return true if the buckets were counted, otherwise false
+ */
+bool countDBGBuckets(DBGBuckets *buckets, int minAbundance, uint64_t *nbSolid);
+
+/**
+ * \brief Allocates an array that can store the kmers of the largest bucket
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @return the allocated array or NULL if an allocation error occured
+ */
+Kmer *allocateDBGBucket(const DBGBuckets *buckets);
+
+/**
+ * \brief Reads a bucket and only keeps its distinct solid kmers
+ * 
+ * The kmers are counted exactly, a solid kmer appears at least minAbundance times.
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param i index of the bucket
+ * @param kmers array that can store the kmers of the bucket (see allocateDBGBucket)
+ * @param minAbundance minimum count of a solid kmer
+ * @param nbSolid destination of the number of distinct solid kmers, sorted at the beginning of the array
+ * @return true if the bucket was read, otherwise false
+ */
+bool readDBGBucket(DBGBuckets *buckets, int i, Kmer *kmers, int minAbundance, uint64_t *nbSolid);
+
+/**
+ * \brief Collects the distinct solid kmers of buckets into a set
+ * 
+ * The set needs 8 bytes per distinct solid kmer, it is the same
+ * as the set collected by collectDBGKmers with exact counts.
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param minAbundance minimum count of a collected kmer
+ * @return a pointer to an allocated KmerSet structure or NULL if an error occured
+ */
+KmerSet *collectDBGBuckets(DBGBuckets *buckets, int minAbundance);
+
+/**
+ * \brief Frees the memory allocated for the given buckets and removes their files
+ * 
+ * @param buckets a pointer to an allocated DBGBuckets structure
+ */
+void deleteDBGBuckets(DBGBuckets *buckets);
+
+#endif // DBG_BUCKETS_H
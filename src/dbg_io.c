@@ -0,0 +1,1566 @@
+#include "dbg_io.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "block_gzip.h"
+#include "bloom_filter.h"
+#include "elias_fano.h"
+#include "kmer.h"
+#include "kmer_set.h"
+#include "log.h"
+#include "utils.h"
+
+// Version of the graph format written by saveDBG
+#define DBG_FORMAT_VERSION 8
+
+// Written in the header of a graph, its bytes are swapped
+// when the graph is read by a computer with another byte order
+#define DBG_BYTE_ORDER 0x01020304U
+
+// Maximum number of bytes given to gzread or gzwrite
+#define DBG_IO_CHUNK (1U << 30)
+
+// Minimum size (in bytes) of the blocks written by saveBlockedDBG
+#define DBG_BLOCK_SIZE (1U << 20)
+
+// Maximum number of blocks written by saveBlockedDBG, so that their
+// offset table fits into the extra field of a gzip member
+#define DBG_MAX_BLOCKS 4096
+
+// Identifiers of the subfield that contains the offset table of saveBlockedDBG
+#define DBG_BLOCKS_ID1 'F'
+#define DBG_BLOCKS_ID2 'G'
+
+// Version of the mapped graph format written by saveMappedDBG
+#define DBG_MAPPED_VERSION 3
+
+/**
+ * \brief Header of a mapped graph file (see saveMappedDBG)
+ */
+typedef struct MappedHeader {
+    char magic[8];
+    uint32_t version;
+    uint8_t backend;
+    uint8_t hashScheme;
+    uint8_t layout;
+    uint8_t addressing;
+    int8_t nbHashs;
+    // Stored since the version 2
+    uint8_t k;
+    uint8_t canonical;
+    // Stored since the version 3
+    uint8_t hashFunction;
+    uint32_t checksum;
+    uint64_t bitSize;
+    uint64_t contentOffset;
+    uint64_t contentSize;
+    uint64_t falsePositivesOffset;
+    uint64_t nbFalsePositives;
+    uint64_t kmersOffset;
+    uint64_t nbKmers;
+} MappedHeader;
+
+_Static_assert(sizeof(MappedHeader) == 80, "Unexpected size of the mapped graph header");
+
+/**
+ * \brief Header of a graph saved since the version 6 (see saveDBG)
+ */
+typedef struct GraphHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint8_t backend;
+    uint8_t k;
+    uint8_t canonical;
+    uint8_t hashScheme;
+    uint8_t layout;
+    uint8_t addressing;
+    int8_t nbHashs;
+    // Stored since the version 7
+    uint8_t encoding;
+    uint64_t bitSize;
+    uint32_t checksum;
+    // Stored since the version 8
+    uint8_t hashFunction;
+    uint8_t unused[3];
+} GraphHeader;
+
+_Static_assert(sizeof(GraphHeader) == 40, "Unexpected size of the graph header");
+
+/**
+ * \brief Reads a field of a serialized graph
+ * 
+ * An error is logged if the field could not be entirely read.
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param field destination of the field
+ * @param len size of the field (in bytes)
+ * @param name name of the field for error messages
+ * @return true if the field was read, otherwise false
+ */
+static bool readField(gzFile fp, void *field, uint64_t len, const char *name) {
+    char *dest = field;
+
+    // gzread can not read more than UINT_MAX bytes at once
+    while (len > 0) {
+        unsigned chunk = (len > DBG_IO_CHUNK) ? DBG_IO_CHUNK : (unsigned) len;
+        int r = gzread(fp, dest, chunk);
+
+        if (r < 0) {
+            log_error("Unable to read the %s of the graph : %s", name, gzFileError(fp));
+            return false;
+        }
+
+        if ((unsigned) r != chunk) {
+            log_error("Unable to read the %s of the graph : unexpected end of file", name);
+            return false;
+        }
+
+        dest += chunk;
+        len -= chunk;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Writes a field of a serialized graph
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param field value of the field
+ * @param len size of the field (in bytes)
+ * @param name name of the field for error messages
+ * @return true if the field was written, otherwise false
+ */
+static bool writeField(gzFile fp, const void *field, uint64_t len, const char *name) {
+    const char *src = field;
+
+    while (len > 0) {
+        unsigned chunk = (len > DBG_IO_CHUNK) ? DBG_IO_CHUNK : (unsigned) len;
+
+        if (gzwrite(fp, src, chunk) != (int) chunk) {
+            log_error("Unable to write the %s of the graph : %s", name, gzFileError(fp));
+            return false;
+        }
+
+        src += chunk;
+        len -= chunk;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Reads a set of kmers of a serialized graph
+ * 
+ * The set is stored as its number of kmers followed by the kmers in increasing order.
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param name name of the set for error messages
+ * @return a pointer to an allocated KmerSet structure or NULL if an error occured
+ */
+static KmerSet *readKmerSet(gzFile fp, const char *name) {
+    int64_t size = 0;
+
+    if (!readField(fp, &size, 8, "number of kmers")) {
+        return NULL;
+    }
+
+    // The size of the kmers must not overflow before they are read
+    if (size < 0 || (uint64_t) size > SIZE_MAX / sizeof(Kmer)) {
+        log_error("Invalid number of %s %" PRId64, name, size);
+        return NULL;
+    }
+
+    Kmer *kmers = malloc(sizeof(*kmers) * (size > 0 ? size : 1));
+
+    if (!kmers) {
+        log_error("Allocation error of the %s", name);
+        return NULL;
+    }
+
+    if (!readField(fp, kmers, sizeof(*kmers) * size, name)) {
+        free(kmers);
+        return NULL;
+    }
+
+    // The kmers are already sorted
+    return kmerSetCreate(kmers, size);
+}
+
+/**
+ * \brief Writes a set of kmers of a serialized graph (see readKmerSet)
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param set a pointer to a KmerSet structure, NULL for an empty set
+ * @param name name of the set for error messages
+ * @return true if the set was written, otherwise false
+ */
+static bool writeKmerSet(gzFile fp, const KmerSet *set, const char *name) {
+    int64_t size = set ? kmerSetSize(set) : 0;
+
+    return writeField(fp, &size, 8, "number of kmers")
+        && (size == 0 || writeField(fp, set->kmers, sizeof(Kmer) * size, name));
+}
+
+/**
+ * \brief Computes the checksum of a graph header
+ * 
+ * The checksum field of the header is not included.
+ * 
+ * @param header a pointer to the header
+ * @param len size of the header (in bytes)
+ * @param checksum a pointer to the checksum field of the header
+ * @return the CRC-32 of the other bytes of the header
+ */
+static uint32_t headerChecksum(const void *header, size_t len, const uint32_t *checksum) {
+    const unsigned char *bytes = header;
+    size_t before = (const unsigned char*) checksum - bytes;
+    size_t after = before + sizeof(*checksum);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, bytes, before);
+    crc = crc32(crc, bytes + after, len - after);
+
+    return crc;
+}
+
+/**
+ * \brief Checks the header of a graph saved since the version 6
+ * 
+ * @param header a pointer to the header
+ * @return true if the header is valid, otherwise false
+ */
+static bool checkHeader(const GraphHeader *header) {
+    if (memcmp(header->magic, DBG_FORMAT_MAGIC, sizeof(header->magic)) != 0) {
+        log_error("The file is not a graph");
+        return false;
+    }
+
+    if (header->byteOrder != DBG_BYTE_ORDER) {
+        log_error("The graph was saved by a computer with another byte order");
+        return false;
+    }
+
+    if (header->version < 6 || header->version > DBG_FORMAT_VERSION) {
+        log_error("Unsupported graph format version %" PRIu32, header->version);
+        return false;
+    }
+
+    if (header->checksum != headerChecksum(header, sizeof(*header), &header->checksum)) {
+        log_error("Invalid checksum of the graph header");
+        return false;
+    }
+
+    if (header->k <= 0 || header->k > dbgMaxKmerSize(header->backend)) {
+        log_error("Invalid kmer size %d", header->k);
+        return false;
+    }
+
+    if (header->canonical > 1) {
+        log_error("Invalid canonical mode %d", header->canonical);
+        return false;
+    }
+
+    if (header->encoding > DBG_ENCODING_SPARSE) {
+        log_error("Unknown content encoding %d", header->encoding);
+        return false;
+    }
+
+    if (header->hashFunction > BF_FUNCTION_FAST) {
+        log_error("Unknown hash function %d", header->hashFunction);
+        return false;
+    }
+
+    // The fast hash function mixes kmers packed on 64 bits
+    if (header->hashFunction == BF_FUNCTION_FAST && header->k > KMER_MAX_SIZE) {
+        log_error("Invalid kmer size %d for the hash function", header->k);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Reads the header of a graph saved since the version 6
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param first first 4 bytes of the file, already read
+ * @param header destination of the header
+ * @return true if the header is valid, otherwise false
+ */
+static bool readHeader(gzFile fp, int32_t first, GraphHeader *header) {
+    memcpy(header, &first, sizeof(first));
+
+    return readField(fp, (char*) header + sizeof(first), sizeof(*header) - sizeof(first), "header")
+        && checkHeader(header);
+}
+
+/**
+ * \brief Reads the fields of a graph saved before the version 6
+ * 
+ * Those graphs do not store the size of their kmers, DBG_LEGACY_KMER_SIZE is used.
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param first first 4 bytes of the file, already read
+ * @param header destination of the fields
+ * @param contentSize destination of the size (in bytes) of the filter content in the file
+ * @return true if the fields were read, otherwise false
+ */
+static bool readLegacyHeader(gzFile fp, int32_t first, GraphHeader *header, uint64_t *contentSize) {
+    // Graphs saved without a format version start with the size
+    // of the filter, which is always positive
+    int32_t version = 0;
+
+    if (first < 0) {
+        version = -first;
+
+        if (version > 5) {
+            log_error("Unsupported graph format version %d", version);
+            return false;
+        }
+    }
+
+    header->version = version;
+    header->k = DBG_LEGACY_KMER_SIZE;
+    header->canonical = true;
+    header->backend = DBG_BACKEND_BLOOM;
+    header->hashScheme = BF_HASH_DOUBLE;
+    header->layout = BF_LAYOUT_STANDARD;
+    header->addressing = BF_ADDRESSING_FASTRANGE;
+
+    // The backend is stored since the version 5
+    if (version >= 5 && !readField(fp, &header->backend, 1, "backend")) {
+        return false;
+    }
+
+    if (header->backend == DBG_BACKEND_EXACT) {
+        return true;
+    }
+
+    if (version >= 3) {
+        int64_t bitSize = 0;
+
+        if (!readField(fp, &bitSize, 8, "size")
+            || !readField(fp, &header->nbHashs, 1, "number of hashs")
+            || !readField(fp, &header->hashScheme, 1, "hash scheme")
+            || !readField(fp, &header->layout, 1, "layout")
+            || !readField(fp, &header->addressing, 1, "addressing")) {
+            return false;
+        }
+
+        if (bitSize <= 0) {
+            log_error("Invalid graph size %" PRId64, bitSize);
+            return false;
+        }
+
+        header->bitSize = bitSize;
+        *contentSize = (header->bitSize + 7) / 8;
+    }
+    else {
+        int32_t size = first;
+
+        if (version > 0 && !readField(fp, &size, 4, "size")) {
+            return false;
+        }
+
+        if (!readField(fp, &header->nbHashs, 1, "number of hashs")) {
+            return false;
+        }
+
+        // The layout of the filter is stored since the version 2
+        if (version >= 2 && !readField(fp, &header->layout, 1, "layout")) {
+            return false;
+        }
+
+        if (size <= 0) {
+            log_error("Invalid graph size %" PRId32, size);
+            return false;
+        }
+
+        // Kmers of a graph without a format version were hashed
+        // once per hash function
+        header->hashScheme = (version == 0) ? BF_HASH_SEEDED : BF_HASH_DOUBLE;
+
+        // Before the version 3, positions were computed modulo the size of the
+        // filter in bytes : a standard filter only used its first size bits.
+        // Only those bits are kept, so the filter is 8 times smaller in memory.
+        header->addressing = BF_ADDRESSING_MODULO;
+        header->bitSize = (header->layout == BF_LAYOUT_BLOCKED) ? (uint64_t) size * 8 : (uint64_t) size;
+        *contentSize = size;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Creates an empty filter with the fields of a graph header
+ * 
+ * @param header fields of the filter
+ * @return a pointer to an allocated BloomFilter structure or NULL if the fields are not valid
+ */
+static BloomFilter *createHeaderFilter(const GraphHeader *header) {
+    if (header->bitSize == 0 || header->bitSize > (uint64_t) LONG_MAX) {
+        log_error("Invalid graph size %" PRIu64, header->bitSize);
+        return NULL;
+    }
+
+    if (header->hashScheme > BF_HASH_DOUBLE) {
+        log_error("Unknown hash scheme %d", header->hashScheme);
+        return NULL;
+    }
+
+    if (header->layout != BF_LAYOUT_STANDARD && header->layout != BF_LAYOUT_BLOCKED) {
+        log_error("Unknown filter layout %d", header->layout);
+        return NULL;
+    }
+
+    if (header->addressing > BF_ADDRESSING_FASTRANGE) {
+        log_error("Unknown filter addressing %d", header->addressing);
+        return NULL;
+    }
+
+    long size = (header->bitSize + 7) / 8;
+    BloomFilter *bf = (header->layout == BF_LAYOUT_BLOCKED)
+        ? bfCreateBlocked(size, header->nbHashs) : bfCreate(size, header->nbHashs);
+
+    if (!bf) {
+        log_error("Unable to create a new Bloom filter");
+        return NULL;
+    }
+
+    bf->bitSize = header->bitSize;
+    bf->hashScheme = header->hashScheme;
+    bf->hashFunction = header->hashFunction;
+    bf->addressing = header->addressing;
+
+    return bf;
+}
+
+/**
+ * \brief Checks the number of set bits of a filter with the DBG_ENCODING_SPARSE encoding
+ * 
+ * @param bf a pointer to a BloomFilter structure
+ * @param nbBits number of set bits read from the graph
+ * @return true if the filter can have this number of set bits, otherwise false
+ */
+static bool validSparseBits(const BloomFilter *bf, int64_t nbBits) {
+    if (nbBits < 0 || (uint64_t) nbBits > 8 * (uint64_t) bfSize(bf)) {
+        log_error("Invalid number of set bits %" PRId64, nbBits);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Sets the bits of a filter from its content with the DBG_ENCODING_SPARSE encoding
+ * 
+ * @param bf a pointer to an empty BloomFilter structure
+ * @param content the Elias-Fano encoding of the positions of the set bits
+ * @param nbBits number of set bits (see validSparseBits)
+ * @return true if the content is valid, otherwise false
+ */
+static bool decodeContent(BloomFilter *bf, const uint64_t *content, int64_t nbBits) {
+    if (!efDecode(content, nbBits, bf->data, bfSize(bf))) {
+        log_error("Invalid sparse content of the graph");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Reads the content of a filter with the DBG_ENCODING_SPARSE encoding
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param bf a pointer to an empty BloomFilter structure
+ * @return true if the content was read, otherwise false
+ */
+static bool readSparseContent(gzFile fp, BloomFilter *bf) {
+    int64_t nbBits = 0;
+
+    if (!readField(fp, &nbBits, 8, "number of set bits") || !validSparseBits(bf, nbBits)) {
+        return false;
+    }
+
+    uint64_t len = efEncodedSize(nbBits, 8 * (uint64_t) bfSize(bf));
+    uint64_t *content = malloc(len > 0 ? len : 1);
+
+    if (!content) {
+        log_error("Allocation error of the sparse content");
+        return false;
+    }
+
+    bool result = readField(fp, content, len, "content") && decodeContent(bf, content, nbBits);
+    free(content);
+
+    return result;
+}
+
+/**
+ * \brief Reads the filter of a serialized graph
+ * 
+ * @param fp a file pointer to a gzip file
+ * @param header fields of the filter
+ * @param contentSize size (in bytes) of the filter content in the file
+ * @return a pointer to an allocated BloomFilter structure or NULL if an error occured
+ */
+static BloomFilter *readFilter(gzFile fp, const GraphHeader *header, uint64_t contentSize) {
+    BloomFilter *bf = createHeaderFilter(header);
+
+    if (!bf) {
+        return NULL;
+    }
+
+    if (header->encoding == DBG_ENCODING_SPARSE) {
+        if (!readSparseContent(fp, bf)) {
+            bfDelete(bf);
+            return NULL;
+        }
+
+        return bf;
+    }
+
+    long size = bfSize(bf);
+
+    // The content is directly read into the filter
+    if (!readField(fp, bf->data, size, "content")) {
+        bfDelete(bf);
+        return NULL;
+    }
+
+    // Unused bytes of graphs saved before the version 3 are skipped
+    char skipped[4096];
+    for (uint64_t remaining = contentSize - size;remaining > 0;) {
+        uint64_t chunk = (remaining > sizeof(skipped)) ? sizeof(skipped) : remaining;
+
+        if (!readField(fp, skipped, chunk, "content")) {
+            bfDelete(bf);
+            return NULL;
+        }
+
+        remaining -= chunk;
+    }
+
+    return bf;
+}
+
+DeBruijnGraph *loadDBG(gzFile fp) {
+    assert(fp);
+
+    int32_t first = 0;
+
+    if (!readField(fp, &first, 4, "size")) {
+        return NULL;
+    }
+
+    GraphHeader header;
+    memset(&header, 0, sizeof(header));
+
+    uint64_t contentSize = 0;
+
+    // A graph without a format version would need a filter of more
+    // than 1 GB with 71 hashs to start with the same bytes
+    if (memcmp(&first, DBG_FORMAT_MAGIC, sizeof(first)) == 0) {
+        if (!readHeader(fp, first, &header)) {
+            return NULL;
+        }
+
+        contentSize = (header.bitSize + 7) / 8;
+    }
+    else if (!readLegacyHeader(fp, first, &header, &contentSize)) {
+        return NULL;
+    }
+
+    DeBruijnGraph *graph = NULL;
+
+    if (header.backend == DBG_BACKEND_EXACT) {
+        KmerSet *kmers = readKmerSet(fp, "kmers");
+
+        if (!kmers) {
+            return NULL;
+        }
+
+        if ((graph = wrapExactDBG(kmers, header.k)) == NULL) {
+            kmerSetDelete(kmers);
+            return NULL;
+        }
+    }
+    else if (header.backend == DBG_BACKEND_BLOOM) {
+        BloomFilter *bf = readFilter(fp, &header, contentSize);
+
+        if (!bf) {
+            return NULL;
+        }
+
+        if ((graph = wrapDBG(bf, header.k)) == NULL) {
+            bfDelete(bf);
+            return NULL;
+        }
+
+        // The false positives are stored since the version 4
+        if (header.version >= 4 && (graph->falsePositives = readKmerSet(fp, "false positives")) == NULL) {
+            deleteDBG(graph);
+            return NULL;
+        }
+    }
+    else {
+        log_error("Unknown graph backend %d", header.backend);
+        return NULL;
+    }
+
+    graph->canonical = header.canonical;
+
+    // The checksum of the content is checked by zlib at the end of the stream
+    char end;
+    if (header.version >= 6 && gzread(fp, &end, 1) != 0) {
+        log_error("Unexpected data or invalid checksum at the end of the graph : %s", gzFileError(fp));
+        deleteDBG(graph);
+        return NULL;
+    }
+
+    return graph;
+}
+
+/**
+ * \brief Encodes the content of a filter with the DBG_ENCODING_SPARSE encoding
+ * 
+ * The content is only encoded when it is smaller than the bits of the filter.
+ * 
+ * @param bf a pointer to a BloomFilter structure
+ * @param nbBits destination of the number of set bits of the filter
+ * @param content destination of the encoded content allocated with malloc,
+ *        NULL if the filter has too many set bits
+ * @param len destination of the size (in bytes) of the encoded content
+ * @return true if no error occured, otherwise false
+ */
+static bool encodeContent(const BloomFilter *bf, int64_t *nbBits, uint64_t **content, uint64_t *len) {
+    uint64_t size = bfSize(bf);
+    uint64_t n = efCountBits(bf->data, size);
+
+    *nbBits = n;
+    *len = efEncodedSize(n, 8 * size);
+    *content = NULL;
+
+    if (sizeof(*nbBits) + *len >= size) {
+        return true;
+    }
+
+    if ((*content = malloc(*len > 0 ? *len : 1)) == NULL) {
+        log_error("Allocation error of the sparse content");
+        return false;
+    }
+
+    efEncode(bf->data, size, n, *content);
+
+    return true;
+}
+
+/**
+ * \brief Fills the header of a graph saved with the current version
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param encoding encoding of the content of the filter
+ * @param header destination of the header
+ * @return true if the graph can be saved, otherwise false
+ */
+static bool fillHeader(const DeBruijnGraph *graph, DBGEncoding encoding, GraphHeader *header) {
+    if (graph->k <= 0 || graph->k > dbgMaxKmerSize(graph->backend)) {
+        log_error("Invalid kmer size %d", graph->k);
+        return false;
+    }
+
+    memset(header, 0, sizeof(*header));
+
+    memcpy(header->magic, DBG_FORMAT_MAGIC, sizeof(header->magic));
+    header->version = DBG_FORMAT_VERSION;
+    header->byteOrder = DBG_BYTE_ORDER;
+    header->backend = graph->backend;
+    header->k = graph->k;
+    header->canonical = graph->canonical;
+
+    if (graph->backend == DBG_BACKEND_BLOOM) {
+        BloomFilter *bf = graph->bf;
+
+        if (bfHashFunction(bf) == BF_FUNCTION_FAST && graph->k > KMER_MAX_SIZE) {
+            log_error("Invalid kmer size %d for the hash function", graph->k);
+            return false;
+        }
+
+        header->bitSize = bfBitSize(bf);
+        header->nbHashs = bfNbHashs(bf);
+        header->hashScheme = bfHashScheme(bf);
+        header->layout = bfLayout(bf);
+        header->addressing = bfAddressing(bf);
+        header->encoding = encoding;
+        header->hashFunction = bfHashFunction(bf);
+    }
+
+    header->checksum = headerChecksum(header, sizeof(*header), &header->checksum);
+
+    return true;
+}
+
+bool saveDBG(DeBruijnGraph *graph, gzFile fp) {
+    assert(graph);
+    assert(fp);
+
+    GraphHeader header;
+    BloomFilter *bf = graph->bf;
+
+    int64_t nbBits = 0;
+    uint64_t *content = NULL;
+    uint64_t len = 0;
+
+    if (graph->backend == DBG_BACKEND_BLOOM && !encodeContent(bf, &nbBits, &content, &len)) {
+        return false;
+    }
+
+    bool result = fillHeader(graph, content ? DBG_ENCODING_SPARSE : DBG_ENCODING_RAW, &header)
+        && writeField(fp, &header, sizeof(header), "header");
+
+    if (result && graph->backend == DBG_BACKEND_EXACT) {
+        result = writeKmerSet(fp, graph->kmers, "kmers");
+    }
+    else if (result) {
+        result = (content
+                ? writeField(fp, &nbBits, 8, "number of set bits") && writeField(fp, content, len, "content")
+                : writeField(fp, bf->data, bfSize(bf), "content"))
+            && writeKmerSet(fp, graph->falsePositives, "false positives");
+    }
+
+    free(content);
+
+    return result;
+}
+
+/**
+ * \brief Offset table of a block compressed graph (see saveBlockedDBG)
+ * 
+ * The sizes are the sizes of the members of the file : the first member,
+ * the nbBlocks members of the blocks and the last member.
+ */
+typedef struct BlockTable {
+    uint64_t blockSize;
+    uint64_t nbBlocks;
+    uint64_t sizes[];
+} BlockTable;
+
+/**
+ * \brief Gets the size (in bytes) of the offset table of nbBlocks blocks
+ */
+#define blockTableSize(nbBlocks) (sizeof(BlockTable) + sizeof(uint64_t) * ((nbBlocks) + 2))
+
+/**
+ * \brief Writes a gzip member that contains a set of kmers (see readKmerSet)
+ * 
+ * @param fp a pointer to a file
+ * @param set a pointer to a KmerSet structure, NULL for an empty set
+ * @param level compression level
+ * @param size destination of the size of the member (in bytes)
+ * @return true if the member was written, otherwise false
+ */
+static bool writeKmerSetMember(FILE *fp, const KmerSet *set, int level, uint64_t *size) {
+    int64_t nbKmers = set ? kmerSetSize(set) : 0;
+    uint64_t len = sizeof(nbKmers) + sizeof(Kmer) * nbKmers;
+    char *data = malloc(len);
+
+    if (!data) {
+        log_error("Allocation error of the false positives");
+        return false;
+    }
+
+    memcpy(data, &nbKmers, sizeof(nbKmers));
+    if (nbKmers > 0) {
+        memcpy(data + sizeof(nbKmers), set->kmers, sizeof(Kmer) * nbKmers);
+    }
+
+    unsigned char *member = NULL;
+    bool result = bgzCompress(data, len, level, 0, 0, NULL, 0, &member, size)
+        && fwrite(member, 1, *size, fp) == *size;
+
+    if (!result) {
+        log_error("Unable to write the false positives of the graph");
+    }
+
+    free(data);
+    free(member);
+
+    return result;
+}
+
+bool saveBlockedDBG(DeBruijnGraph *graph, FILE *fp, int level, int nbThreads) {
+    assert(graph);
+    assert(fp);
+
+    // The first member contains the header, followed by the number of kmers
+    // of an exact graph or by the number of set bits of a sparse filter
+    char first[sizeof(GraphHeader) + sizeof(int64_t)];
+    uint64_t firstLen = sizeof(GraphHeader);
+
+    bool result = false;
+    BlockTable *table = NULL;
+    unsigned char *member = NULL;
+    uint64_t *content = NULL;
+
+    // The data split into blocks
+    int64_t count = 0;
+    uint64_t len = 0;
+    const void *data = NULL;
+
+    if (graph->backend == DBG_BACKEND_EXACT) {
+        count = kmerSetSize(graph->kmers);
+        len = sizeof(Kmer) * count;
+        data = graph->kmers->kmers;
+    }
+    else if (!encodeContent(graph->bf, &count, &content, &len)) {
+        return false;
+    }
+    else if (content) {
+        data = content;
+    }
+    else {
+        len = bfSize(graph->bf);
+        data = graph->bf->data;
+    }
+
+    if (!fillHeader(graph, content ? DBG_ENCODING_SPARSE : DBG_ENCODING_RAW, (GraphHeader*) first)) {
+        goto EXIT;
+    }
+
+    if (graph->backend == DBG_BACKEND_EXACT || content) {
+        memcpy(first + firstLen, &count, sizeof(count));
+        firstLen += sizeof(count);
+    }
+
+    // Large graphs have larger blocks, so that the table fits into the extra field
+    uint64_t blockSize = (len + DBG_MAX_BLOCKS - 1) / DBG_MAX_BLOCKS;
+    blockSize = (blockSize > DBG_BLOCK_SIZE) ? blockSize : DBG_BLOCK_SIZE;
+
+    if (blockSize > BGZ_MAX_BLOCK) {
+        log_error("The graph is too large to be split into blocks");
+        goto EXIT;
+    }
+
+    uint64_t nbBlocks = (len + blockSize - 1) / blockSize;
+
+    if ((table = calloc(1, blockTableSize(nbBlocks))) == NULL) {
+        log_error("Allocation error of the block table");
+        goto EXIT;
+    }
+
+    table->blockSize = blockSize;
+    table->nbBlocks = nbBlocks;
+
+    long start = ftell(fp);
+
+    // The table is written once the sizes of the members are known
+    if (start < 0 || !bgzCompress(first, firstLen, level, DBG_BLOCKS_ID1, DBG_BLOCKS_ID2,
+        table, blockTableSize(nbBlocks), &member, table->sizes)) {
+        log_error("Unable to compress the header of the graph");
+        goto EXIT;
+    }
+
+    if (fwrite(member, 1, table->sizes[0], fp) != table->sizes[0]) {
+        log_error("Unable to write the header of the graph");
+        goto EXIT;
+    }
+
+    if (!bgzWriteBlocks(fp, data, len, blockSize, level, nbThreads, table->sizes + 1)) {
+        log_error("Unable to write the content of the graph");
+        goto EXIT;
+    }
+
+    // The false positives are small, they are stored in the last member
+    const KmerSet *last = (graph->backend == DBG_BACKEND_BLOOM) ? graph->falsePositives : NULL;
+
+    if (graph->backend == DBG_BACKEND_EXACT) {
+        // The last member of an exact graph is empty
+        free(member);
+        member = NULL;
+
+        if (!bgzCompress(NULL, 0, level, 0, 0, NULL, 0, &member, table->sizes + nbBlocks + 1)
+            || fwrite(member, 1, table->sizes[nbBlocks + 1], fp) != table->sizes[nbBlocks + 1]) {
+            log_error("Unable to write the end of the graph");
+            goto EXIT;
+        }
+    }
+    else if (!writeKmerSetMember(fp, last, level, table->sizes + nbBlocks + 1)) {
+        goto EXIT;
+    }
+
+    if (fseek(fp, start + BGZ_HEADER_SIZE + 6, SEEK_SET) != 0
+        || fwrite(table, 1, blockTableSize(nbBlocks), fp) != blockTableSize(nbBlocks)
+        || fseek(fp, 0, SEEK_END) != 0) {
+        log_error("Unable to write the block table of the graph");
+        goto EXIT;
+    }
+
+    result = true;
+
+EXIT:
+    free(member);
+    free(table);
+    free(content);
+
+    return result;
+}
+
+/**
+ * \brief Reads a whole member of a block compressed graph
+ * 
+ * @param fp a pointer to a file
+ * @param offset offset of the member in the file
+ * @param size size of the member (in bytes)
+ * @param len destination of the size of the member data (in bytes)
+ * @return the data of the member allocated with malloc, or NULL if an error occured
+ */
+static char *readMember(FILE *fp, uint64_t offset, uint64_t size, uint64_t *len) {
+    unsigned char *member = malloc(size > 0 ? size : 1);
+    char *data = NULL;
+
+    if (!member) {
+        log_error("Allocation error of a graph block");
+        return NULL;
+    }
+
+    if (fseek(fp, offset, SEEK_SET) != 0 || fread(member, 1, size, fp) != size) {
+        log_error("Unable to read a block of the graph : unexpected end of file");
+        goto EXIT;
+    }
+
+    *len = bgzDataSize(member, size);
+
+    if ((data = malloc(*len > 0 ? *len : 1)) == NULL) {
+        log_error("Allocation error of a graph block");
+        goto EXIT;
+    }
+
+    if (!bgzDecompress(member, size, data, *len)) {
+        log_error("Invalid block of the graph");
+        free(data);
+        data = NULL;
+    }
+
+EXIT:
+    free(member);
+    return data;
+}
+
+/**
+ * \brief Reads the offset table of a block compressed graph
+ * 
+ * @param fp a pointer to a file, positioned at the start of the graph
+ * @return the table allocated with malloc, or NULL if the file is not a block compressed graph
+ */
+static BlockTable *readBlockTable(FILE *fp) {
+    unsigned char *prefix = malloc(BGZ_HEADER_SIZE + 2 + UINT16_MAX);
+
+    if (!prefix) {
+        log_error("Allocation error of the block table");
+        return NULL;
+    }
+
+    BlockTable *table = NULL;
+    size_t len = fread(prefix, 1, BGZ_HEADER_SIZE + 2 + UINT16_MAX, fp);
+
+    const unsigned char *subfield;
+    uint16_t subfieldLen;
+
+    if (!bgzFindSubfield(prefix, len, DBG_BLOCKS_ID1, DBG_BLOCKS_ID2, &subfield, &subfieldLen)
+        || subfieldLen < blockTableSize(0)) {
+        log_error("The file is not a block compressed graph");
+        goto EXIT;
+    }
+
+    if ((table = malloc(subfieldLen)) == NULL) {
+        log_error("Allocation error of the block table");
+        goto EXIT;
+    }
+
+    memcpy(table, subfield, subfieldLen);
+
+    if (table->blockSize == 0 || table->blockSize > BGZ_MAX_BLOCK
+        || table->nbBlocks > DBG_MAX_BLOCKS || subfieldLen != blockTableSize(table->nbBlocks)) {
+        log_error("Invalid block table of the graph");
+        free(table);
+        table = NULL;
+    }
+
+EXIT:
+    free(prefix);
+    return table;
+}
+
+DeBruijnGraph *loadBlockedDBG(FILE *fp, int nbThreads) {
+    assert(fp);
+
+    long start = ftell(fp);
+    BlockTable *table = (start >= 0) ? readBlockTable(fp) : NULL;
+
+    if (!table) {
+        return NULL;
+    }
+
+    DeBruijnGraph *graph = NULL;
+    BloomFilter *bf = NULL;
+    KmerSet *kmers = NULL;
+    Kmer *array = NULL;
+    uint64_t *content = NULL;
+    char *first = NULL;
+    char *last = NULL;
+
+    uint64_t firstLen = 0;
+    uint64_t lastLen = 0;
+    GraphHeader header;
+
+    if ((first = readMember(fp, start, table->sizes[0], &firstLen)) == NULL) {
+        goto ERROR;
+    }
+
+    if (firstLen < sizeof(header)) {
+        log_error("Missing header of the graph");
+        goto ERROR;
+    }
+
+    memcpy(&header, first, sizeof(header));
+
+    if (!checkHeader(&header)) {
+        goto ERROR;
+    }
+
+    // Size of the data split into blocks
+    uint64_t len = 0;
+    void *data = NULL;
+    int64_t nbBits = 0;
+
+    if (header.backend == DBG_BACKEND_EXACT) {
+        int64_t nbKmers = 0;
+
+        if (firstLen != sizeof(header) + sizeof(nbKmers)) {
+            log_error("Missing number of kmers of the graph");
+            goto ERROR;
+        }
+
+        memcpy(&nbKmers, first + sizeof(header), sizeof(nbKmers));
+
+        if (nbKmers < 0 || (uint64_t) nbKmers > table->blockSize * table->nbBlocks / sizeof(Kmer)) {
+            log_error("Invalid number of kmers %" PRId64, nbKmers);
+            goto ERROR;
+        }
+
+        len = sizeof(Kmer) * nbKmers;
+
+        if ((array = malloc(len > 0 ? len : 1)) == NULL) {
+            log_error("Allocation error of the kmers");
+            goto ERROR;
+        }
+
+        data = array;
+    }
+    else if (header.backend == DBG_BACKEND_BLOOM) {
+        if ((bf = createHeaderFilter(&header)) == NULL) {
+            goto ERROR;
+        }
+
+        bool sparse = header.encoding == DBG_ENCODING_SPARSE;
+
+        if (firstLen != sizeof(header) + (sparse ? sizeof(nbBits) : 0)) {
+            log_error("Missing number of set bits of the graph");
+            goto ERROR;
+        }
+
+        if (!sparse) {
+            len = bfSize(bf);
+            data = bf->data;
+        }
+        else {
+            memcpy(&nbBits, first + sizeof(header), sizeof(nbBits));
+
+            if (!validSparseBits(bf, nbBits)) {
+                goto ERROR;
+            }
+
+            len = efEncodedSize(nbBits, 8 * (uint64_t) bfSize(bf));
+
+            if ((content = malloc(len > 0 ? len : 1)) == NULL) {
+                log_error("Allocation error of the sparse content");
+                goto ERROR;
+            }
+
+            data = content;
+        }
+    }
+    else {
+        log_error("Unknown graph backend %d", header.backend);
+        goto ERROR;
+    }
+
+    if (table->nbBlocks != (len + table->blockSize - 1) / table->blockSize) {
+        log_error("Invalid number of blocks of the graph");
+        goto ERROR;
+    }
+
+    // The blocks are directly decompressed into the filter or the kmers
+    uint64_t offset = start + table->sizes[0];
+
+    if (!bgzReadBlocks(fp, offset, data, len, table->blockSize, table->sizes + 1, nbThreads)) {
+        goto ERROR;
+    }
+
+    if (content) {
+        if (!decodeContent(bf, content, nbBits)) {
+            goto ERROR;
+        }
+
+        free(content);
+        content = NULL;
+    }
+
+    for (uint64_t i = 0;i < table->nbBlocks;i++) {
+        offset += table->sizes[i + 1];
+    }
+
+    if ((last = readMember(fp, offset, table->sizes[table->nbBlocks + 1], &lastLen)) == NULL) {
+        goto ERROR;
+    }
+
+    if (header.backend == DBG_BACKEND_EXACT) {
+        // The kmers are already sorted
+        kmers = kmerSetCreate(array, len / sizeof(Kmer));
+        array = NULL;
+
+        if (!kmers || (graph = wrapExactDBG(kmers, header.k)) == NULL) {
+            goto ERROR;
+        }
+
+        kmers = NULL;
+    }
+    else {
+        int64_t nbKmers = 0;
+
+        if (lastLen >= sizeof(nbKmers)) {
+            memcpy(&nbKmers, last, sizeof(nbKmers));
+        }
+
+        // The number of kmers is checked before its size, which could overflow
+        if (nbKmers < 0 || lastLen < sizeof(nbKmers)
+            || (uint64_t) nbKmers > (lastLen - sizeof(nbKmers)) / sizeof(Kmer)
+            || lastLen != sizeof(nbKmers) + sizeof(Kmer) * (uint64_t) nbKmers) {
+            log_error("Invalid false positives of the graph");
+            goto ERROR;
+        }
+
+        // The kmers are moved to the start of the member data
+        memmove(last, last + sizeof(nbKmers), sizeof(Kmer) * nbKmers);
+
+        if ((graph = wrapDBG(bf, header.k)) == NULL) {
+            goto ERROR;
+        }
+
+        bf = NULL;
+
+        if ((graph->falsePositives = kmerSetCreate((Kmer*) last, nbKmers)) == NULL) {
+            last = NULL;
+            goto ERROR;
+        }
+
+        last = NULL;
+    }
+
+    graph->canonical = header.canonical;
+
+    free(first);
+    free(table);
+
+    return graph;
+
+ERROR:
+    deleteDBG(graph);
+    bfDelete(bf);
+    kmerSetDelete(kmers);
+    free(array);
+    free(content);
+    free(first);
+    free(last);
+    free(table);
+
+    return NULL;
+}
+
+/**
+ * \brief Gets the offset of the next section of a mapped graph
+ */
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + DBG_PAGE_SIZE - 1) / DBG_PAGE_SIZE * DBG_PAGE_SIZE;
+}
+
+/**
+ * \brief Writes a section of a mapped graph, followed by zeros up to the next page
+ * 
+ * @param fp a pointer to a file
+ * @param data content of the section
+ * @param len size of the section (in bytes)
+ * @param name name of the section for error messages
+ * @return true if the section was written, otherwise false
+ */
+static bool writeSection(FILE *fp, const void *data, uint64_t len, const char *name) {
+    static const char zeros[DBG_PAGE_SIZE] = { 0 };
+
+    if (len > 0 && fwrite(data, 1, len, fp) != len) {
+        log_error("Unable to write the %s of the graph", name);
+        return false;
+    }
+
+    uint64_t padding = alignSection(len) - len;
+
+    if (padding > 0 && fwrite(zeros, 1, padding, fp) != padding) {
+        log_error("Unable to write the %s of the graph", name);
+        return false;
+    }
+
+    return true;
+}
+
+bool saveMappedDBG(DeBruijnGraph *graph, FILE *fp) {
+    assert(graph);
+    assert(fp);
+
+    MappedHeader header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, DBG_MAPPED_MAGIC, sizeof(header.magic));
+    header.version = DBG_MAPPED_VERSION;
+    header.backend = graph->backend;
+    header.k = graph->k;
+    header.canonical = graph->canonical;
+
+    const void *content = NULL;
+    uint64_t offset = DBG_PAGE_SIZE;
+
+    if (graph->backend == DBG_BACKEND_BLOOM) {
+        BloomFilter *bf = graph->bf;
+
+        header.hashScheme = bfHashScheme(bf);
+        header.hashFunction = bfHashFunction(bf);
+        header.layout = bfLayout(bf);
+        header.addressing = bfAddressing(bf);
+        header.nbHashs = bfNbHashs(bf);
+        header.bitSize = bfBitSize(bf);
+        header.contentOffset = offset;
+        header.contentSize = bfSize(bf);
+
+        content = bf->data;
+        offset += alignSection(header.contentSize);
+    }
+
+    KmerSet *falsePositives = graph->falsePositives;
+
+    if (falsePositives && kmerSetSize(falsePositives) > 0) {
+        header.falsePositivesOffset = offset;
+        header.nbFalsePositives = kmerSetSize(falsePositives);
+        offset += alignSection(sizeof(Kmer) * header.nbFalsePositives);
+    }
+
+    if (graph->kmers && kmerSetSize(graph->kmers) > 0) {
+        header.kmersOffset = offset;
+        header.nbKmers = kmerSetSize(graph->kmers);
+    }
+
+    header.checksum = headerChecksum(&header, sizeof(header), &header.checksum);
+
+    return writeSection(fp, &header, sizeof(header), "header")
+        && writeSection(fp, content, header.contentSize, "content")
+        && writeSection(fp, header.nbFalsePositives > 0 ? falsePositives->kmers : NULL,
+            sizeof(Kmer) * header.nbFalsePositives, "false positives")
+        && writeSection(fp, header.nbKmers > 0 ? graph->kmers->kmers : NULL,
+            sizeof(Kmer) * header.nbKmers, "kmers");
+}
+
+/**
+ * \brief Checks that a section of a mapped graph is inside the file
+ * 
+ * @param offset offset of the section
+ * @param len size of the section (in bytes)
+ * @param fileSize size of the file (in bytes)
+ * @param name name of the section for error messages
+ * @return true if the section is valid, otherwise false
+ */
+static bool validSection(uint64_t offset, uint64_t len, uint64_t fileSize, const char *name) {
+    if (len == 0) {
+        return true;
+    }
+
+    if (offset % DBG_PAGE_SIZE != 0 || offset > fileSize || len > fileSize - offset) {
+        log_error("Invalid %s section of the mapped graph", name);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Creates a graph from the sections of a mapped file
+ * 
+ * @param mapping first byte of the mapped file
+ * @param size size of the mapped file (in bytes)
+ * @return a pointer to an allocated DeBruijnGraph structure or NULL if the file is not valid
+ */
+static DeBruijnGraph *wrapMapping(char *mapping, uint64_t size) {
+    if (size < sizeof(MappedHeader)) {
+        log_error("Missing header of the mapped graph");
+        return NULL;
+    }
+
+    const MappedHeader *header = (const MappedHeader*) mapping;
+
+    if (memcmp(header->magic, DBG_MAPPED_MAGIC, sizeof(header->magic)) != 0) {
+        log_error("The file is not a mapped graph");
+        return NULL;
+    }
+
+    if (header->version > DBG_MAPPED_VERSION) {
+        log_error("Unsupported mapped graph format version %" PRIu32, header->version);
+        return NULL;
+    }
+
+    // The first version did not store the size of the kmers
+    int k = DBG_LEGACY_KMER_SIZE;
+    bool canonical = true;
+
+    if (header->version >= 2) {
+        if (header->checksum != headerChecksum(header, sizeof(*header), &header->checksum)) {
+            log_error("Invalid checksum of the mapped graph header");
+            return NULL;
+        }
+
+        if (header->k <= 0 || header->k > dbgMaxKmerSize(header->backend) || header->canonical > 1) {
+            log_error("Invalid kmers of the mapped graph");
+            return NULL;
+        }
+
+        k = header->k;
+        canonical = header->canonical;
+    }
+
+    if (!validSection(header->contentOffset, header->contentSize, size, "content")
+        || header->nbFalsePositives > size / sizeof(Kmer) || header->nbKmers > size / sizeof(Kmer)
+        || !validSection(header->falsePositivesOffset, sizeof(Kmer) * header->nbFalsePositives, size, "false positives")
+        || !validSection(header->kmersOffset, sizeof(Kmer) * header->nbKmers, size, "kmers")) {
+        return NULL;
+    }
+
+    DeBruijnGraph *graph = NULL;
+
+    if (header->backend == DBG_BACKEND_EXACT) {
+        KmerSet *kmers = kmerSetWrap((const Kmer*) (mapping + header->kmersOffset), header->nbKmers);
+
+        if (!kmers) {
+            return NULL;
+        }
+
+        if ((graph = wrapExactDBG(kmers, k)) == NULL) {
+            kmerSetDelete(kmers);
+            return NULL;
+        }
+    }
+    else if (header->backend == DBG_BACKEND_BLOOM) {
+        if (header->hashScheme > BF_HASH_DOUBLE || header->layout > BF_LAYOUT_BLOCKED
+            || header->addressing > BF_ADDRESSING_FASTRANGE || header->hashFunction > BF_FUNCTION_FAST
+            || (header->hashFunction == BF_FUNCTION_FAST && k > KMER_MAX_SIZE)
+            || header->bitSize == 0 || header->bitSize > header->contentSize * 8) {
+            log_error("Invalid filter of the mapped graph");
+            return NULL;
+        }
+
+        BloomFilter *bf = bfCreateFromData(mapping + header->contentOffset, header->contentSize,
+            header->nbHashs, header->layout);
+
+        if (!bf) {
+            log_error("Unable to create a new Bloom filter");
+            return NULL;
+        }
+
+        bf->bitSize = header->bitSize;
+        bf->hashScheme = header->hashScheme;
+        bf->hashFunction = header->hashFunction;
+        bf->addressing = header->addressing;
+
+        if ((graph = wrapDBG(bf, k)) == NULL) {
+            bfDelete(bf);
+            return NULL;
+        }
+    }
+    else {
+        log_error("Unknown graph backend %d", header->backend);
+        return NULL;
+    }
+
+    graph->canonical = canonical;
+
+    if (header->nbFalsePositives > 0) {
+        graph->falsePositives = kmerSetWrap((const Kmer*) (mapping + header->falsePositivesOffset),
+            header->nbFalsePositives);
+
+        if (!graph->falsePositives) {
+            deleteDBG(graph);
+            return NULL;
+        }
+    }
+
+    return graph;
+}
+
+DeBruijnGraph *mapDBG(const char *path) {
+    assert(path);
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        log_error("Unable to open %s : %s", path, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        log_error("Unable to get the size of %s", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        log_error("Unable to map %s : %s", path, strerror(errno));
+        return NULL;
+    }
+
+    DeBruijnGraph *graph = wrapMapping(mapping, st.st_size);
+
+    if (!graph) {
+        munmap(mapping, st.st_size);
+        return NULL;
+    }
+
+    // The filter is read at random positions, the whole file is read ahead
+    madvise(mapping, st.st_size, MADV_WILLNEED);
+
+    graph->mapping = mapping;
+    graph->mappingSize = st.st_size;
+
+    return graph;
+}
+
+/**
+ * \brief Checks if a file starts with the first member of a block compressed graph
+ * 
+ * @param fp a pointer to a file, positioned at its start
+ * @return true if the first member has the offset table of saveBlockedDBG, otherwise false
+ */
+static bool isBlockedGraph(FILE *fp) {
+    unsigned char prefix[BGZ_HEADER_SIZE + 2 + UINT16_MAX];
+    size_t len = fread(prefix, 1, BGZ_HEADER_SIZE + 2, fp);
+
+    // Only the extra field is read after the fixed fields
+    if (len == BGZ_HEADER_SIZE + 2) {
+        len += fread(prefix + len, 1, prefix[10] | ((uint16_t) prefix[11] << 8), fp);
+    }
+
+    const unsigned char *subfield;
+    uint16_t subfieldLen;
+
+    return bgzFindSubfield(prefix, len, DBG_BLOCKS_ID1, DBG_BLOCKS_ID2, &subfield, &subfieldLen);
+}
+
+DeBruijnGraph *openDBG(const char *path, int nbThreads) {
+    assert(path);
+
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp) {
+        log_error("Unable to open %s : %s", path, strerror(errno));
+        return NULL;
+    }
+
+    char magic[sizeof(DBG_MAPPED_MAGIC) - 1];
+    bool mapped = fread(magic, 1, sizeof(magic), fp) == sizeof(magic)
+        && memcmp(magic, DBG_MAPPED_MAGIC, sizeof(magic)) == 0;
+
+    if (mapped) {
+        fclose(fp);
+        return mapDBG(path);
+    }
+
+    rewind(fp);
+
+    if (isBlockedGraph(fp)) {
+        rewind(fp);
+
+        DeBruijnGraph *graph = loadBlockedDBG(fp, nbThreads);
+        fclose(fp);
+
+        return graph;
+    }
+
+    fclose(fp);
+
+    gzFile gz = gzopen(path, "rb");
+
+    if (!gz) {
+        log_error("Unable to open %s", path);
+        return NULL;
+    }
+
+    DeBruijnGraph *graph = loadDBG(gz);
+    gzclose(gz);
+
+    return graph;
+}
+
+bool isLegacyDBG(const char *path) {
+    assert(path);
+
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp) {
+        return false;
+    }
+
+    // Mapped and block compressed graphs are always saved with a header
+    char magic[sizeof(DBG_MAPPED_MAGIC) - 1];
+    bool mapped = fread(magic, 1, sizeof(magic), fp) == sizeof(magic)
+        && memcmp(magic, DBG_MAPPED_MAGIC, sizeof(magic)) == 0;
+
+    rewind(fp);
+    bool blocked = !mapped && isBlockedGraph(fp);
+    fclose(fp);
+
+    gzFile gz = (mapped || blocked) ? NULL : gzopen(path, "rb");
+
+    if (!gz) {
+        return false;
+    }
+
+    int32_t first;
+    bool legacy = gzread(gz, &first, sizeof(first)) == sizeof(first)
+        && memcmp(&first, DBG_FORMAT_MAGIC, sizeof(first)) != 0;
+
+    gzclose(gz);
+
+    return legacy;
+}
@@ -0,0 +1,240 @@
+#ifndef DBG_IO_H
+#define DBG_IO_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <zlib.h>
+
+#include "de_bruijn_graph.h"
+
+/**
+ * \brief Encodings of the filter content in a graph file (see saveDBG)
+ */
+typedef enum DBGEncoding {
+    // Bits of the filter, as they are in memory
+    DBG_ENCODING_RAW = 0,
+    // Positions of the set bits with the Elias-Fano encoding (see efEncode)
+    DBG_ENCODING_SPARSE = 1
+} DBGEncoding;
+
+/**
+ * \brief Alignment (in bytes) of the sections of a mapped graph file
+ */
+#define DBG_PAGE_SIZE 4096
+
+/**
+ * \brief First bytes of a mapped graph file
+ */
+#define DBG_MAPPED_MAGIC "FCDBGMAP"
+
+/**
+ * \brief First bytes of a graph file saved since the version 6 (see saveDBG)
+ */
+#define DBG_FORMAT_MAGIC "FCDBGRPH"
+
+/**
+ * \brief Length of the kmers of graphs saved before the version 6, which did not store it
+ */
+#define DBG_LEGACY_KMER_SIZE 20
+
+/**
+ * \brief Loads a De Bruijn from a gzip file
+ * 
+ * The file must contain a serialized graph (See saveDBG for the format).
+ * Graphs saved with an older version of the format are still supported.
+ * Positions in their filters were computed modulo the size in bytes of the filter,
+ * so only the first size bits of a standard filter were used : the returned filter
+ * only keeps those bits and uses the BF_ADDRESSING_MODULO addressing.
+ * 
+ * If an error occured during this decompression or 
+ * during the reading (missing fields), then NULL will be returned.
+ * NULL is also returned if the header is not valid : wrong magic bytes, byte order
+ * or checksum, unsupported version or invalid parameters.
+ * 
+ * This function returns an heap allocated graph if no error occured.
+ * The user is in charge of the releasing the memory (see deleteDBG).
+ * 
+ * @param fp a file pointer to a gzip file
+ * @return a pointer to a graph or NULL in case of an error
+ */
+DeBruijnGraph *loadDBG(gzFile fp);
+
+/**
+ * \brief Writes a De Bruijn into a gzip file
+ * 
+ * The file must be opened in binary writing mode.
+ * 
+ * All fields are written with the order of the computer. The graph starts with
+ * a header of 40 bytes :
+ * - the 8 bytes of DBG_FORMAT_MAGIC,
+ * - the format version on 4 bytes,
+ * - the number 0x01020304 on 4 bytes, which tells the byte order of the other fields,
+ * - the backend of the graph (see DBGBackend) on one byte,
+ * - the size of the kmers on one byte,
+ * - the canonical mode on one byte (1 if a kmer and its reverse complement are the same node),
+ * - the hash scheme (see BloomHashScheme), the layout (see BloomLayout) and the
+ *   addressing (see BloomAddressing) of the filter on one byte each,
+ * - the number of hashs functions used to add a word into the filter on one byte,
+ * - the encoding of the content of the filter (see DBGEncoding) on one byte,
+ * - the size (in bits) of the filter on 8 bytes,
+ * - the CRC-32 of the other bytes of the header on 4 bytes,
+ * - the hash function of the filter (see BloomHashFunction) on one byte, followed by 3 unused bytes.
+ * 
+ * The fields of the filter are 0 for the graphs with the DBG_BACKEND_EXACT backend.
+ * Those graphs only store then the number of kmers on 8 bytes (a signed integer number),
+ * followed by the canonical kmers as packed kmers of 8 bytes in increasing order.
+ * 
+ * The graphs with the DBG_BACKEND_BLOOM backend store the content of the filter,
+ * on n bits where n is the size in bits of the filter (rounded up to a multiple of 8).
+ * When few bits of the filter are set, the content is smaller with the DBG_ENCODING_SPARSE
+ * encoding : it is then made of the number of set bits on 8 bytes (a signed integer number),
+ * followed by the Elias-Fano encoding of their positions in the n bits (see efEncode).
+ * The encoding is chosen when the graph is saved, the smallest one is used.
+ * The next 8 bytes represent the number of critical false positives (a signed integer number),
+ * followed by the false positives as packed kmers of 8 bytes in increasing order.
+ * 
+ * The content is checked with the CRC-32 of the gzip stream when the graph is loaded.
+ * 
+ * Older versions of the format are still loaded, their kmers have DBG_LEGACY_KMER_SIZE bases :
+ * - graphs without a format version start directly with the size (in bytes) of the filter
+ *   on 4 bytes, followed by the number of hashs and the content. Their kmers were inserted
+ *   as strings with the BF_HASH_SEEDED scheme.
+ * - graphs of the versions 1 to 5 start with the opposite of the format version on 4 bytes.
+ * - graphs of the version 1 have the same fields after the format version.
+ * - graphs of the version 2 have an additional byte for the layout before the content.
+ * - graphs of the version 3 store the size (in bits) of the filter on 8 bytes, the number
+ *   of hashs, the hash scheme, the layout and the addressing, followed by the content.
+ * - graphs of the version 4 also store the false positives after the content.
+ * - graphs of the version 5 store the backend on one byte after the format version, followed
+ *   by the fields of the version 4 or by the kmers of an exact graph.
+ * - graphs of the version 6 have the same header, with an unused byte in place of the encoding.
+ * - graphs of the versions 6 and 7 have an unused byte in place of the hash function,
+ *   their kmers are hashed with BF_FUNCTION_MURMUR3.
+ * 
+ * Graphs older than the version 3 use the BF_ADDRESSING_MODULO addressing.
+ * They are saved with the current version.
+ * 
+ * This functions returns true is the graph was correctly written into the disk or false
+ * if an error occured.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param fp a pointer to a gzip file
+ * @return true if no error occured, otherwise false
+ */
+bool saveDBG(DeBruijnGraph *graph, gzFile fp);
+
+/**
+ * \brief Writes a De Bruijn graph into a file made of independently compressed blocks
+ * 
+ * The file must be opened in binary writing mode and it must support fseek.
+ * It is made of gzip members : the file is a gzip file that contains the graph
+ * in the format of saveDBG, so it can also be read by loadDBG.
+ * 
+ * The first member contains the header of the graph, followed by the number of kmers
+ * of an exact graph or by the number of set bits of a sparse filter. The content of the
+ * filter (encoded like saveDBG does) or the kmers of an exact graph are split
+ * into blocks of at least 1 MB, compressed in parallel into their own members. The last
+ * member contains the critical false positives, it is empty for an exact graph.
+ * 
+ * The extra field of the first member has a subfield with the identifiers 'F' and 'G' :
+ * the offset table of the blocks. It contains the size (in bytes) of the blocks on 8 bytes,
+ * their number on 8 bytes, and the sizes (in bytes) of all members on 8 bytes each
+ * (the first one, the blocks and the last one). The blocks can then be decompressed
+ * in parallel by loadBlockedDBG.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param fp a pointer to a file
+ * @param level compression level, between 0 and 9
+ * @param nbThreads number of threads compressing the blocks
+ * @return true if no error occured, otherwise false
+ */
+bool saveBlockedDBG(DeBruijnGraph *graph, FILE *fp, int level, int nbThreads);
+
+/**
+ * \brief Loads a De Bruijn graph written by saveBlockedDBG
+ * 
+ * The graph is read from the current position of the file. Its blocks are
+ * decompressed in parallel directly into the filter or the kmers of the graph,
+ * the content of a sparse filter is decoded once all its blocks are decompressed.
+ * 
+ * If the file does not contain a block compressed graph or if an error occured during
+ * the reading, then NULL will be returned.
+ * 
+ * @param fp a pointer to a file opened in binary reading mode
+ * @param nbThreads number of threads decompressing the blocks
+ * @return a pointer to a graph or NULL in case of an error
+ */
+DeBruijnGraph *loadBlockedDBG(FILE *fp, int nbThreads);
+
+/**
+ * \brief Writes a De Bruijn graph into an uncompressed file that can be mapped
+ * 
+ * The file must be opened in binary writing mode. Unlike saveDBG, the graph is not
+ * compressed : its filter and its kmers are written in sections aligned on
+ * DBG_PAGE_SIZE bytes, so that mapDBG can use them directly from the mapped file.
+ * 
+ * The first page contains the header, all fields are written with the order of the
+ * computer (see saveDBG) :
+ * - the 8 bytes of DBG_MAPPED_MAGIC and the format version on 4 bytes,
+ * - the backend, the hash scheme, the layout and the addressing of the filter on one byte each,
+ * - the number of hashs, the size of the kmers, the canonical mode and the hash function
+ *   of the filter (see BloomHashFunction) on one byte each,
+ * - the CRC-32 of the other bytes of the header on 4 bytes,
+ * - the size (in bits) of the filter on 8 bytes,
+ * - the offset and the size (in bytes) of the filter content on 8 bytes each,
+ * - the offset and the number of the critical false positives on 8 bytes each,
+ * - the offset and the number of the kmers of an exact graph on 8 bytes each.
+ * 
+ * The content is always stored with the DBG_ENCODING_RAW encoding.
+ * Unused sections have an offset and a size of 0. Unlike the header, the content
+ * is not checked when the graph is mapped. Files of the version 1 have unused bytes
+ * in place of the kmers fields and the checksum, their kmers have DBG_LEGACY_KMER_SIZE bases.
+ * Files of the versions 1 and 2 have an unused byte in place of the hash function.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param fp a pointer to a file
+ * @return true if no error occured, otherwise false
+ */
+bool saveMappedDBG(DeBruijnGraph *graph, FILE *fp);
+
+/**
+ * \brief Maps a graph file written by saveMappedDBG
+ * 
+ * The file is mapped in read only mode : the filter and the kmers of the graph are
+ * not copied, the pages are loaded from the file when they are used and they are
+ * shared with the other processes that map the same file. The graph can only be queried.
+ * The mapping is released by deleteDBG.
+ * 
+ * If the file could not be mapped or if its header is not valid,
+ * then NULL will be returned.
+ * 
+ * @param path path to the graph file
+ * @return a pointer to a graph or NULL in case of an error
+ */
+DeBruijnGraph *mapDBG(const char *path);
+
+/**
+ * \brief Opens a graph file written by saveDBG, saveBlockedDBG or saveMappedDBG
+ * 
+ * The format is found from the first bytes of the file : mapped graphs are
+ * mapped (see mapDBG), block compressed graphs are loaded with loadBlockedDBG
+ * and the other ones are loaded with loadDBG.
+ * 
+ * @param path path to the graph file
+ * @param nbThreads number of threads decompressing a block compressed graph
+ * @return a pointer to a graph or NULL in case of an error
+ */
+DeBruijnGraph *openDBG(const char *path, int nbThreads);
+
+/**
+ * \brief Checks if a graph file was saved before the version 6, without the size of its kmers
+ * 
+ * The kmers of those graphs are loaded with DBG_LEGACY_KMER_SIZE bases.
+ * 
+ * @param path path to the graph file
+ * @return true if the file is a graph saved before the version 6, otherwise false
+ */
+bool isLegacyDBG(const char *path);
+
+#endif // DBG_IO_H
@@ -0,0 +1,472 @@
+#include "dbg_partition.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bloom_filter.h"
+#include "count_min.h"
+#include "fasta.h"
+#include "kmer.h"
+#include "kmer_hash.h"
+#include "log.h"
+
+// Size (in bytes) of the part of the filter filled by each partition of createPartitionedDBG,
+// it fits into the L2 cache
+#define DBG_PARTITION_SIZE (1U << 18)
+
+// Maximum number of partitions of createPartitionedDBG, larger filters have larger partitions
+#define DBG_MAX_PARTITIONS (1U << 16)
+
+// Minimum number of hashes or bits routed to the partitions at once by createPartitionedDBG
+#define DBG_PARTITION_BATCH (1U << 22)
+
+// Initial size (in bytes) of the reads of a batch
+#define DBG_BATCH_SIZE (1U << 22)
+
+/**
+ * \brief Reads of createPartitionedDBG whose kmers are routed to the partitions at once
+ */
+typedef struct PartitionBatch {
+    BloomFilter *bf;
+    int k;
+    const CountMinSketch *counts;
+    int minAbundance;
+
+    // The hashes of the kmers are routed for a blocked filter, their bits otherwise
+    bool blocked;
+    // A hash or a bit goes to the partition of its block or bit shifted by partitionShift
+    int partitionShift;
+    uint64_t nbPartitions;
+
+    // Reads separated by an end of line, the i-th one starts at readOffsets[i]
+    char *reads;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t *readOffsets;
+    uint64_t nbReads;
+    uint64_t offsetsCapacity;
+    uint64_t nbItems;
+
+    // Hashes or bits grouped by partition, the ones of the i-th partition start at partitionOffsets[i]
+    uint64_t *items;
+    uint64_t itemsCapacity;
+    uint64_t *partitionOffsets;
+
+    // Next partition filled by a worker
+    uint64_t nextPartition;
+} PartitionBatch;
+
+/**
+ * \brief Work of one thread of createPartitionedDBG
+ */
+typedef struct PartitionWorker {
+    PartitionBatch *batch;
+    // Routed reads, from firstRead to lastRead (excluded)
+    uint64_t firstRead;
+    uint64_t lastRead;
+    // Hashes or bits of the kmers of the reads, in the order of the reads
+    uint64_t *items;
+    uint64_t nbItems;
+    uint64_t capacity;
+    // Number of items of each partition, then offset of the next item of each partition in the batch
+    uint64_t *partitionCounts;
+    bool failed;
+} PartitionWorker;
+
+/**
+ * \brief Gets the partition of a hash or a bit routed by createPartitionedDBG
+ */
+static inline uint64_t itemPartition(const PartitionBatch *batch, uint64_t item) {
+    uint64_t position = batch->blocked ? bfHashBlock(batch->bf, item) : item;
+
+    return position >> batch->partitionShift;
+}
+
+/**
+ * \brief Computes the hashes or bits of the solid kmers of some reads of a batch
+ * 
+ * The items are stored in the order of the kmers and counted per partition.
+ * 
+ * @param voidArgs a pointer to a PartitionWorker structure
+ * @return NULL
+ */
+static void *routeWorker(void *voidArgs) {
+    PartitionWorker *worker = voidArgs;
+    PartitionBatch *batch = worker->batch;
+    int k = batch->k;
+    int itemsPerKmer = batch->blocked ? 1 : bfNbHashs(batch->bf);
+
+    memset(worker->partitionCounts, 0, batch->nbPartitions * sizeof(*worker->partitionCounts));
+    worker->nbItems = 0;
+
+    // Upper bound of the number of items, when all kmers are solid
+    uint64_t capacity = 0;
+
+    for (uint64_t i = worker->firstRead;i < worker->lastRead;i++) {
+        uint64_t length = batch->readOffsets[i + 1] - batch->readOffsets[i] - 1;
+        capacity += (length - k + 1) * itemsPerKmer;
+    }
+
+    if (capacity > worker->capacity) {
+        uint64_t *items = realloc(worker->items, capacity * sizeof(*items));
+
+        if (!items) {
+            log_error("Unable to allocate %" PRIu64 " routed kmers", capacity);
+            worker->failed = true;
+            return NULL;
+        }
+
+        worker->items = items;
+        worker->capacity = capacity;
+    }
+
+    for (uint64_t i = worker->firstRead;i < worker->lastRead;i++) {
+        const char *read = batch->reads + batch->readOffsets[i];
+        int64_t len = batch->readOffsets[i + 1] - batch->readOffsets[i] - 1;
+
+        KmerHash hash;
+        kmerHashInitString(&hash, read, k);
+
+        for (int64_t j = k;j <= len;j++) {
+            uint64_t value = kmerHashCanonical(&hash);
+
+            if (cmsIsSolid(batch->counts, batch->minAbundance, value)) {
+                uint64_t *items = worker->items + worker->nbItems;
+
+                if (batch->blocked) {
+                    items[0] = value;
+                }
+                else {
+                    bfHashBits(batch->bf, value, items);
+                }
+
+                for (int l = 0;l < itemsPerKmer;l++) {
+                    worker->partitionCounts[itemPartition(batch, items[l])]++;
+                }
+
+                worker->nbItems += itemsPerKmer;
+            }
+
+            if (j < len) {
+                hash = kmerHashRoll(&hash, kmerEncodeBase(read[j - k]), kmerEncodeBase(read[j]), k);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Copies the items of a worker to their partitions in the batch
+ * 
+ * The counts of the worker must have been replaced by the offsets of its items in each partition.
+ * 
+ * @param voidArgs a pointer to a PartitionWorker structure
+ * @return NULL
+ */
+static void *scatterWorker(void *voidArgs) {
+    PartitionWorker *worker = voidArgs;
+    PartitionBatch *batch = worker->batch;
+
+    for (uint64_t i = 0;i < worker->nbItems;i++) {
+        uint64_t item = worker->items[i];
+
+        batch->items[worker->partitionCounts[itemPartition(batch, item)]++] = item;
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Fills the partitions of the filter with their items, one partition after the other
+ * 
+ * A partition is only filled by one worker : its bits are set without atomic operations.
+ * 
+ * @param voidArgs a pointer to a PartitionWorker structure
+ * @return NULL
+ */
+static void *fillWorker(void *voidArgs) {
+    PartitionWorker *worker = voidArgs;
+    PartitionBatch *batch = worker->batch;
+    uint64_t partition;
+
+    while ((partition = __atomic_fetch_add(&batch->nextPartition, 1, __ATOMIC_RELAXED)) < batch->nbPartitions) {
+        uint64_t end = batch->partitionOffsets[partition + 1];
+
+        for (uint64_t i = batch->partitionOffsets[partition];i < end;i++) {
+            bool inserted = batch->blocked
+                ? bfAddHash(batch->bf, batch->items[i]) : bfSetBit(batch->bf, batch->items[i]);
+
+            if (!inserted) {
+                log_error("Unable to insert a kmer in partition %" PRIu64, partition);
+                worker->failed = true;
+                return NULL;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Runs a function on all workers of createPartitionedDBG
+ * 
+ * The calling thread runs the first worker.
+ * 
+ * @param function function of the workers
+ * @param workers array of nbThreads workers
+ * @param threads array of nbThreads threads
+ * @param nbThreads number of workers
+ * @return true if no worker failed, otherwise false
+ */
+static bool runPartitionWorkers(void *(*function)(void*), PartitionWorker *workers, pthread_t *threads, int nbThreads) {
+    int started = 1;
+
+    for (;started < nbThreads;started++) {
+        if (pthread_create(threads + started, NULL, function, workers + started) != 0) {
+            log_error("Unable to start a partition worker");
+            break;
+        }
+    }
+
+    // The workers that could not be started are run by the calling thread
+    for (int i = started;i < nbThreads;i++) {
+        function(workers + i);
+    }
+
+    function(workers);
+
+    for (int i = 1;i < started;i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    bool failed = false;
+
+    for (int i = 0;i < nbThreads;i++) {
+        failed |= workers[i].failed;
+    }
+
+    return !failed;
+}
+
+/**
+ * \brief Inserts the kmers of the reads of a batch into the filter
+ * 
+ * The items of the kmers are computed by the workers, then grouped by partition
+ * and the partitions are filled by the workers. The reads are removed from the batch.
+ * 
+ * @param batch a pointer to a PartitionBatch structure
+ * @param workers array of nbThreads workers
+ * @param threads array of nbThreads threads
+ * @param nbThreads number of workers
+ * @return true if all kmers were inserted, otherwise false
+ */
+static bool fillBatch(PartitionBatch *batch, PartitionWorker *workers, pthread_t *threads, int nbThreads) {
+    // Each worker routes the same number of reads
+    for (int i = 0;i < nbThreads;i++) {
+        workers[i].firstRead = batch->nbReads * i / nbThreads;
+        workers[i].lastRead = batch->nbReads * (i + 1) / nbThreads;
+    }
+
+    if (!runPartitionWorkers(routeWorker, workers, threads, nbThreads)) {
+        return false;
+    }
+
+    // The items of a partition are stored in the order of the workers
+    uint64_t offset = 0;
+
+    for (uint64_t i = 0;i < batch->nbPartitions;i++) {
+        batch->partitionOffsets[i] = offset;
+
+        for (int j = 0;j < nbThreads;j++) {
+            uint64_t count = workers[j].partitionCounts[i];
+
+            workers[j].partitionCounts[i] = offset;
+            offset += count;
+        }
+    }
+
+    batch->partitionOffsets[batch->nbPartitions] = offset;
+
+    if (offset > batch->itemsCapacity) {
+        uint64_t *items = realloc(batch->items, offset * sizeof(*items));
+
+        if (!items) {
+            log_error("Unable to allocate %" PRIu64 " routed kmers", offset);
+            return false;
+        }
+
+        batch->items = items;
+        batch->itemsCapacity = offset;
+    }
+
+    if (!runPartitionWorkers(scatterWorker, workers, threads, nbThreads)) {
+        return false;
+    }
+
+    batch->nextPartition = 0;
+
+    if (!runPartitionWorkers(fillWorker, workers, threads, nbThreads)) {
+        return false;
+    }
+
+    batch->size = 0;
+    batch->nbReads = 0;
+    batch->nbItems = 0;
+
+    return true;
+}
+
+/**
+ * \brief Adds a read to a batch of createPartitionedDBG
+ * 
+ * @param batch a pointer to a PartitionBatch structure
+ * @param read first letter of the read
+ * @param len length of the read
+ * @return true if the read was added, otherwise false
+ */
+static bool addBatchRead(PartitionBatch *batch, const char *read, uint64_t len) {
+    if (batch->size + len + 1 > batch->capacity) {
+        uint64_t capacity = (batch->capacity > 0) ? batch->capacity * 2 : DBG_BATCH_SIZE;
+
+        while (capacity < batch->size + len + 1) {
+            capacity *= 2;
+        }
+
+        char *reads = realloc(batch->reads, capacity);
+
+        if (!reads) {
+            log_error("Unable to allocate a batch of reads");
+            return false;
+        }
+
+        batch->reads = reads;
+        batch->capacity = capacity;
+    }
+
+    // The offsets have an extra value for the end of the last read
+    if (batch->nbReads + 2 > batch->offsetsCapacity) {
+        uint64_t capacity = (batch->offsetsCapacity > 0) ? batch->offsetsCapacity * 2 : 1024;
+        uint64_t *offsets = realloc(batch->readOffsets, capacity * sizeof(*offsets));
+
+        if (!offsets) {
+            log_error("Unable to allocate a batch of reads");
+            return false;
+        }
+
+        batch->readOffsets = offsets;
+        batch->offsetsCapacity = capacity;
+    }
+
+    memcpy(batch->reads + batch->size, read, len);
+    batch->reads[batch->size + len] = '\n';
+
+    batch->readOffsets[batch->nbReads] = batch->size;
+    batch->size += len + 1;
+    batch->readOffsets[++batch->nbReads] = batch->size;
+
+    return true;
+}
+
+bool createPartitionedDBG(BloomFilter *bf, FILE *fp, int k, int nbThreads, const CountMinSketch *counts, int minAbundance) {
+    assert(bf);
+    assert(fp);
+
+    if (k <= 0 || k > KMER128_MAX_SIZE) {
+        return false;
+    }
+
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+
+    PartitionBatch batch = {
+        .bf = bf, .k = k, .counts = counts, .minAbundance = minAbundance,
+        .blocked = bfLayout(bf) == BF_LAYOUT_BLOCKED
+    };
+
+    // A partition covers whole cache lines of the filter, so that two partitions never share a byte
+    uint64_t positions = batch.blocked ? (uint64_t) bfSize(bf) / BF_BLOCK_SIZE : bfBitSize(bf);
+    batch.partitionShift = batch.blocked ? __builtin_ctz(DBG_PARTITION_SIZE / BF_BLOCK_SIZE) : __builtin_ctz(DBG_PARTITION_SIZE * 8);
+
+    while (((positions - 1) >> batch.partitionShift) + 1 > DBG_MAX_PARTITIONS) {
+        batch.partitionShift++;
+    }
+
+    batch.nbPartitions = ((positions - 1) >> batch.partitionShift) + 1;
+
+    int itemsPerKmer = batch.blocked ? 1 : bfNbHashs(bf);
+
+    PartitionWorker *workers = calloc(nbThreads, sizeof(*workers));
+    pthread_t *threads = malloc(sizeof(*threads) * nbThreads);
+    batch.partitionOffsets = malloc((batch.nbPartitions + 1) * sizeof(*batch.partitionOffsets));
+
+    char *line = NULL;
+    size_t length = 0;
+
+    bool result = false;
+
+    if (!workers || !threads || !batch.partitionOffsets) {
+        log_error("Unable to allocate the partitions");
+        goto EXIT;
+    }
+
+    for (int i = 0;i < nbThreads;i++) {
+        workers[i].batch = &batch;
+
+        if ((workers[i].partitionCounts = malloc(batch.nbPartitions * sizeof(uint64_t))) == NULL) {
+            log_error("Unable to allocate the partitions");
+            goto EXIT;
+        }
+    }
+
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength) {
+            goto EXIT;
+        }
+
+        if (!addBatchRead(&batch, line, lineLength)) {
+            goto EXIT;
+        }
+
+        batch.nbItems += (uint64_t) (lineLength - k + 1) * itemsPerKmer;
+
+        if (batch.nbItems >= DBG_PARTITION_BATCH && !fillBatch(&batch, workers, threads, nbThreads)) {
+            goto EXIT;
+        }
+    }
+
+    if (ferror(fp)) {
+        perror("something bad happened");
+        goto EXIT;
+    }
+
+    if (batch.nbReads > 0 && !fillBatch(&batch, workers, threads, nbThreads)) {
+        goto EXIT;
+    }
+
+    result = true;
+
+EXIT:
+    if (workers) {
+        for (int i = 0;i < nbThreads;i++) {
+            free(workers[i].items);
+            free(workers[i].partitionCounts);
+        }
+    }
+
+    free(workers);
+    free(threads);
+    free(line);
+    free(batch.reads);
+    free(batch.readOffsets);
+    free(batch.items);
+    free(batch.partitionOffsets);
+
+    return result;
+}
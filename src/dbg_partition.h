@@ -0,0 +1,32 @@
+#ifndef DBG_PARTITION_H
+#define DBG_PARTITION_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+struct BloomFilter;
+struct CountMinSketch;
+
+/**
+ * \brief Creates a De Bruijn graph from the solid kmers of a fasta file, one part of the filter at a time
+ * 
+ * The filter is split into partitions of 256 KiB (more for very large filters), small enough to stay
+ * in the L2 cache. The reads are processed in batches : the bits (or the block for
+ * a blocked filter) of each kmer of a batch are computed and grouped by partition, then
+ * each partition is filled by one of the nbThreads workers without atomic operations.
+ * The accesses to the filter have a good locality, which is faster than createSolidDBG
+ * for filters that are much larger than the caches.
+ * 
+ * The filter is the same as the one created by createSolidDBG, the same errors are reported.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param nbThreads number of workers
+ * @param counts counts of the kmers of the file, all kmers are inserted if NULL
+ * @param minAbundance minimum count of an inserted kmer
+ * @return true is the graph was correctly loaded, otherwise false
+ */
+bool createPartitionedDBG(struct BloomFilter *bf, FILE *fp, int k, int nbThreads, const struct CountMinSketch *counts, int minAbundance);
+
+#endif // DBG_PARTITION_H
@@ -1,172 +1,1087 @@
 #include "de_bruijn_graph.h"
 
 #include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-
-#include <zlib.h>
+#include <sys/mman.h>
 
 #include "bloom_filter.h"
-#include "getline.h"
+#include "count_min.h"
+#include "dbg_buckets.h"
+#include "fasta.h"
+#include "hyperloglog.h"
+#include "kmer.h"
+#include "kmer_hash.h"
+#include "kmer_set.h"
 #include "log.h"
-#include "string_utils.h"
-#include "utils.h"
+#include "numa.h"
+#include "queue.h"
+
+// Size (in bytes) of the chunks of reads given to the workers of createDBGThreads
+#define DBG_CHUNK_SIZE (1U << 22)
+
+// Initial number of kmers collected by computeFalsePositives
+#define DBG_COLLECT_SIZE (1U << 20)
+
+// Maximum number of kmers whose successors are looked up at once by containsSuccessors
+#define DBG_SUCCESSORS_BATCH 16
+
+/**
+ * \brief Chunk of reads given to a worker of createDBGThreads
+ */
+typedef struct ReadChunk {
+    // Reads separated by a new line, NULL for the end of the input
+    char *reads;
+    size_t size;
+} ReadChunk;
+
+/**
+ * \brief Arguments of a worker of createDBGThreads
+ */
+typedef struct BuildArgs {
+    BloomFilter *bf;
+    Queue *queue;
+    int k;
+    // Only the kmers counted at least minAbundance times are inserted, all kmers if NULL
+    const CountMinSketch *counts;
+    int minAbundance;
+    // Set by a worker if a kmer could not be inserted
+    bool failed;
+} BuildArgs;
+
+/**
+ * \brief Arguments of a worker of insertDBGKmers
+ */
+typedef struct InsertArgs {
+    BloomFilter *bf;
+    const Kmer *kmers;
+    uint64_t nbKmers;
+    int k;
+    bool concurrent;
+    bool failed;
+} InsertArgs;
+
+/**
+ * \brief Inserts the solid kmers of a read into the filter
+ * 
+ * The read must contain at least k letters.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param read first letter of the read
+ * @param len length of the read
+ * @param k length of each kmer
+ * @param concurrent true if other threads insert kmers at the same time
+ * @param counts counts of the kmers, all kmers are inserted if NULL
+ * @param minAbundance minimum count of an inserted kmer
+ * @return true if all kmers were inserted, otherwise false
+ */
+static bool insertRead(BloomFilter *bf, const char *read, int64_t len, int k, bool concurrent,
+    const CountMinSketch *counts, int minAbundance) {
+    // Only the first kmer is hashed entirely, the hash
+    // values of the next ones are updated with each letter
+    KmerHash hash;
+    kmerHashInitString(&hash, read, k);
+
+    for (int64_t i = k;i <= len;i++) {
+        uint64_t value = kmerHashCanonical(&hash);
+        bool inserted = !cmsIsSolid(counts, minAbundance, value)
+            || (concurrent ? bfAddHashConcurrent(bf, value) : bfAddHash(bf, value));
+
+        if (!inserted) {
+            log_error("Unable to insert kmer %.*s", k, read + i - k);
+            return false;
+        }
+
+        if (i < len) {
+            hash = kmerHashRoll(&hash, kmerEncodeBase(read[i - k]), kmerEncodeBase(read[i]), k);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Inserts the solid kmers of a fasta file into a filter with the calling thread
+ * 
+ * See createSolidDBG.
+ */
+static bool buildSerial(BloomFilter *bf, FILE *fp, int k, const CountMinSketch *counts, int minAbundance) {
+    char *line = NULL;
+    size_t length = 0;
+
+    bool result = false;
+
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength) {
+            goto EXIT;
+        }
+
+        if (!insertRead(bf, line, lineLength, k, false, counts, minAbundance)) {
+            goto EXIT;
+        }
+    }
+
+    if (ferror(fp)) {
+        perror("something bad happened");
+    }
+    else {
+        result = true;
+    }
+
+EXIT:
+    free(line);
+    return result;
+}
 
 bool createDBG(BloomFilter *bf, FILE *fp, int k) {
     assert(bf);
     assert(fp);
 
-    // A kmer must have a positive length
-    if (k <= 0) {
+    // A kmer must have a positive length and fit into a kmer packed on 128 bits
+    if (k <= 0 || k > KMER128_MAX_SIZE) {
         return false;
     }
 
+    return buildSerial(bf, fp, k, NULL, 0);
+}
+
+/**
+ * \brief Inserts the kmers of the chunks given by createDBGThreads
+ * 
+ * The worker stops when it gets the end of the input, which is given
+ * back to the queue for the other workers. After an error, the next
+ * chunks are only released so that the reading thread never waits.
+ * 
+ * @param voidArgs a pointer to a BuildArgs structure
+ * @return NULL
+ */
+static void *buildWorker(void *voidArgs) {
+    BuildArgs *args = voidArgs;
+    ReadChunk chunk;
+
+    if (!numaPinThread()) {
+        log_warn("Unable to pin a build thread");
+    }
+
+    while (queuePop(args->queue, &chunk)) {
+        if (!chunk.reads) {
+            queuePush(args->queue, &chunk);
+            return NULL;
+        }
+
+        char *read = chunk.reads;
+        char *end = chunk.reads + chunk.size;
+
+        while (read < end && !__atomic_load_n(&args->failed, __ATOMIC_RELAXED)) {
+            char *eol = memchr(read, '\n', end - read);
+
+            if (!insertRead(args->bf, read, eol - read, args->k, true, args->counts, args->minAbundance)) {
+                __atomic_store_n(&args->failed, true, __ATOMIC_RELAXED);
+            }
+
+            read = eol + 1;
+        }
+
+        free(chunk.reads);
+    }
+
+    log_error("Unable to get a chunk of reads");
+    __atomic_store_n(&args->failed, true, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+bool createDBGThreads(BloomFilter *bf, FILE *fp, int k, int nbThreads) {
+    return createSolidDBG(bf, fp, k, nbThreads, NULL, 0);
+}
+
+bool createSolidDBG(BloomFilter *bf, FILE *fp, int k, int nbThreads, const CountMinSketch *counts, int minAbundance) {
+    assert(bf);
+    assert(fp);
+
+    if (k <= 0 || k > KMER128_MAX_SIZE) {
+        return false;
+    }
+
+    if (nbThreads <= 1) {
+        return buildSerial(bf, fp, k, counts, minAbundance);
+    }
+
+    // Each worker can have a chunk waiting for it
+    Queue *queue = queueCreate(nbThreads, sizeof(ReadChunk));
+
+    if (!queue) {
+        log_error("Unable to create the chunks queue");
+        return false;
+    }
+
+    BuildArgs args = {
+        .bf = bf, .queue = queue, .k = k,
+        .counts = counts, .minAbundance = minAbundance, .failed = false
+    };
+
+    pthread_t *threads = malloc(sizeof(*threads) * nbThreads);
+    int nbStarted = 0;
+
     char *line = NULL;
     size_t length = 0;
 
-    char *kmer = malloc(k);
+    ReadChunk chunk = { .reads = NULL, .size = 0 };
+    size_t capacity = 0;
+
+    bool result = false;
+
+    if (!threads) {
+        log_error("Threads allocation error");
+        goto EXIT;
+    }
+
+    for (;nbStarted < nbThreads;nbStarted++) {
+        if (pthread_create(&threads[nbStarted], NULL, buildWorker, &args) != 0) {
+            log_error("Unable to create a worker");
+            goto EXIT;
+        }
+    }
+
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength || __atomic_load_n(&args.failed, __ATOMIC_RELAXED)) {
+            goto EXIT;
+        }
+
+        // Chunks only contain whole reads
+        if (chunk.reads && chunk.size + lineLength + 1 > capacity) {
+            if (!queuePush(queue, &chunk)) {
+                log_error("Unable to give a chunk of reads to the workers");
+                goto EXIT;
+            }
+
+            chunk.reads = NULL;
+        }
+
+        if (!chunk.reads) {
+            capacity = ((size_t) lineLength + 1 > DBG_CHUNK_SIZE) ? (size_t) lineLength + 1 : DBG_CHUNK_SIZE;
+            chunk.size = 0;
 
-    if (!kmer) {
+            if ((chunk.reads = malloc(capacity)) == NULL) {
+                log_error("Chunk allocation error");
+                goto EXIT;
+            }
+        }
+
+        memcpy(chunk.reads + chunk.size, line, lineLength);
+        chunk.reads[chunk.size + lineLength] = '\n';
+        chunk.size += lineLength + 1;
+    }
+
+    if (ferror(fp)) {
+        perror("something bad happened");
+        goto EXIT;
+    }
+
+    if (chunk.reads) {
+        if (!queuePush(queue, &chunk)) {
+            log_error("Unable to give a chunk of reads to the workers");
+            goto EXIT;
+        }
+
+        chunk.reads = NULL;
+    }
+
+    result = true;
+
+EXIT:
+    free(chunk.reads);
+    free(line);
+
+    // Workers stop once they get the end of the input
+    if (nbStarted > 0) {
+        ReadChunk last = { .reads = NULL, .size = 0 };
+        queuePush(queue, &last);
+
+        for (int i = 0;i < nbStarted;i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    free(threads);
+    queueDelete(queue);
+
+    return result && !args.failed;
+}
+
+bool estimateDBGKmers(FILE *fp, int k, uint64_t *nbKmers) {
+    assert(fp);
+    assert(nbKmers);
+
+    if (k <= 0 || k > KMER128_MAX_SIZE) {
+        return false;
+    }
+
+    HyperLogLog *hll = hllCreate(DBG_ESTIMATE_PRECISION);
+
+    if (!hll) {
+        log_error("Unable to create a new sketch");
         return false;
     }
 
+    char *line = NULL;
+    size_t length = 0;
+
     bool result = false;
 
     ssize_t lineLength;
-    while ((lineLength = getline(&line, &length, fp)) > 0) {
-        // Skips headers
-        if (*line == '>') {
-            continue;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength) {
+            goto EXIT;
         }
 
+        KmerHash hash;
+        kmerHashInitString(&hash, line, k);
+
+        for (int64_t i = k;i <= lineLength;i++) {
+            hllAdd(hll, kmerHashCanonical(&hash));
+
+            if (i < lineLength) {
+                hash = kmerHashRoll(&hash, kmerEncodeBase(line[i - k]), kmerEncodeBase(line[i]), k);
+            }
+        }
+    }
+
+    if (ferror(fp)) {
+        perror("something bad happened");
+    }
+    else {
+        *nbKmers = hllEstimate(hll);
+        result = true;
+    }
+
+EXIT:
+    free(line);
+    hllDelete(hll);
+    return result;
+}
+
+CountMinSketch *countDBGKmers(FILE *fp, int k, uint64_t nbKmers, int minAbundance, uint64_t *nbSolid) {
+    assert(fp);
+    assert(nbSolid);
+
+    if (k <= 0 || k > KMER128_MAX_SIZE || minAbundance <= 0 || minAbundance > CMS_MAX_COUNT) {
+        return NULL;
+    }
+
+    CountMinSketch *counts = cmsCreate(nbKmers > 0 ? nbKmers : 1, DBG_COUNT_DEPTH);
+    HyperLogLog *solid = hllCreate(DBG_ESTIMATE_PRECISION);
+
+    char *line = NULL;
+    size_t length = 0;
+
+    bool result = false;
+
+    if (!counts || !solid) {
+        log_error("Unable to create the sketches");
+        goto EXIT;
+    }
+
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
         if (k > lineLength) {
             goto EXIT;
         }
 
-        // Inserts each kmer into the filter
-        for (int64_t i = 0;i < lineLength - k + 1;i++) {
-            // Each kmer starts at position i and has
-            // a length of k. 
-            // The line must be greater than k
+        KmerHash hash;
+        kmerHashInitString(&hash, line, k);
 
-            memcpy(kmer, line + i, k);
-            if (!insertKmer(bf, kmer, k)) {
-                log_error("Unable to insert kmer %.*s", k, kmer);
-                goto EXIT;
+        for (int64_t i = k;i <= lineLength;i++) {
+            uint64_t value = kmerHashCanonical(&hash);
+
+            // A kmer is added to the solid ones at each occurrence
+            // once it has been seen enough times
+            if (cmsAdd(counts, value) >= minAbundance) {
+                hllAdd(solid, value);
+            }
+
+            if (i < lineLength) {
+                hash = kmerHashRoll(&hash, kmerEncodeBase(line[i - k]), kmerEncodeBase(line[i]), k);
             }
         }
     }
 
-    if (!feof(fp) && lineLength < 0) {
+    if (ferror(fp)) {
         perror("something bad happened");
     }
     else {
+        *nbSolid = hllEstimate(solid);
         result = true;
     }
 
 EXIT:
-    free(kmer);
     free(line);
-    return result;
+    hllDelete(solid);
+
+    if (!result) {
+        cmsDelete(counts);
+        return NULL;
+    }
+
+    return counts;
 }
 
-bool insertKmer(struct BloomFilter *bf, char *kmer, int k) {
+DeBruijnGraph *wrapDBG(BloomFilter *bf, int k) {
     assert(bf);
-    assert(kmer);
 
-    if (k <= 0) {
+    DeBruijnGraph *graph = malloc(sizeof(*graph));
+
+    if (!graph) {
+        log_error("Graph allocation error");
+        return NULL;
+    }
+
+    graph->backend = DBG_BACKEND_BLOOM;
+    graph->k = k;
+    graph->canonical = kmerCanonicalMode;
+    graph->bf = bf;
+    graph->falsePositives = NULL;
+    graph->kmers = NULL;
+    graph->mapping = NULL;
+    graph->mappingSize = 0;
+
+    return graph;
+}
+
+DeBruijnGraph *wrapExactDBG(KmerSet *kmers, int k) {
+    assert(kmers);
+
+    DeBruijnGraph *graph = malloc(sizeof(*graph));
+
+    if (!graph) {
+        log_error("Graph allocation error");
+        return NULL;
+    }
+
+    graph->backend = DBG_BACKEND_EXACT;
+    graph->k = k;
+    graph->canonical = kmerCanonicalMode;
+    graph->bf = NULL;
+    graph->falsePositives = NULL;
+    graph->kmers = kmers;
+    graph->mapping = NULL;
+    graph->mappingSize = 0;
+
+    return graph;
+}
+
+void deleteDBG(DeBruijnGraph *graph) {
+    if (graph) {
+        bfDelete(graph->bf);
+        kmerSetDelete(graph->falsePositives);
+        kmerSetDelete(graph->kmers);
+
+        // The filter and the sets used the mapped data
+        if (graph->mapping) {
+            munmap(graph->mapping, graph->mappingSize);
+        }
+
+        free(graph);
+    }
+}
+
+void useDBGKmerMode(const DeBruijnGraph *graph) {
+    assert(graph);
+
+    // The kmers of an exact graph are not hashed by the lookups
+    bool fast = graph->backend == DBG_BACKEND_BLOOM && bfHashFunction(graph->bf) == BF_FUNCTION_FAST;
+
+    kmerHashUseFunction(fast ? KMER_HASH_MIX : KMER_HASH_NTHASH);
+    kmerUseCanonical(graph->canonical);
+}
+
+bool mergeDBG(DeBruijnGraph *graph, const DeBruijnGraph *other) {
+    assert(graph);
+    assert(other);
+
+    if (graph->mapping) {
+        log_error("A mapped graph can not be changed");
         return false;
     }
 
-    if (!canonicalForm(kmer, k)) {
+    if (graph->backend != other->backend || graph->k != other->k || graph->canonical != other->canonical) {
+        log_error("The graphs do not have the same backend, kmer size or canonical mode");
         return false;
     }
 
-    return bfAdd(bf, kmer, k);
-}
+    if (graph->backend == DBG_BACKEND_BLOOM) {
+        if (!bfUnion(graph->bf, other->bf)) {
+            log_error("The filters of the graphs do not have the same parameters");
+            return false;
+        }
 
-BloomFilter *loadDBG(gzFile fp) {
-    assert(fp);
+        // The false positives of a graph may be kmers of the other one
+        kmerSetDelete(graph->falsePositives);
+        graph->falsePositives = NULL;
+
+        return true;
+    }
 
-    int r;
-    long size = 0;
+    uint64_t n = kmerSetSize(graph->kmers);
+    uint64_t otherN = kmerSetSize(other->kmers);
+    Kmer *kmers = malloc(sizeof(*kmers) * (n + otherN > 0 ? n + otherN : 1));
+
+    if (!kmers) {
+        log_error("Allocation error of the kmers");
+        return false;
+    }
+
+    if (n > 0) {
+        memcpy(kmers, graph->kmers->kmers, sizeof(*kmers) * n);
+    }
+    if (otherN > 0) {
+        memcpy(kmers + n, other->kmers->kmers, sizeof(*kmers) * otherN);
+    }
 
-    if ((r = gzread(fp, &size, 4)) != 4) {
-        if (r != -1) {
-            log_error("Unable to read the size of the graph : %s", gzFileError(fp));
+    // The kmers of both graphs are sorted again without duplicates
+    KmerSet *set = kmerSetCreate(kmers, n + otherN);
+
+    if (!set) {
+        return false;
+    }
+
+    kmerSetDelete(graph->kmers);
+    graph->kmers = set;
+
+    return true;
+}
+
+/**
+ * \brief Appends a kmer at the end of an array
+ * 
+ * When the array is full, the kmers appended since the last time are sorted and merged
+ * with the previous distinct ones (see kmerMergeUnique). The array is only reallocated
+ * if more than the half of its kmers are distinct.
+ * 
+ * @param kmers pointer to the array
+ * @param size pointer to the number of kmers in the array
+ * @param sorted pointer to the number of distinct sorted kmers at the beginning of the array
+ * @param capacity pointer to the capacity of the array
+ * @param kmer kmer to append
+ * @return true if the kmer was appended, otherwise false
+ */
+static bool appendKmer(Kmer **kmers, uint64_t *size, uint64_t *sorted, uint64_t *capacity, Kmer kmer) {
+    if (*size == *capacity) {
+        if (!kmerMergeUnique(*kmers, *sorted, *size, size)) {
+            return false;
         }
-        else {
-            log_error("size error");
+
+        *sorted = *size;
+
+        // The array grows when removing the duplicates did not free enough space
+        if (*size > *capacity / 2) {
+            Kmer *resized = realloc(*kmers, sizeof(**kmers) * *capacity * 2);
+
+            if (!resized) {
+                log_error("Unable to collect more than %" PRIu64 " kmers", *size);
+                return false;
+            }
+
+            *kmers = resized;
+            *capacity *= 2;
         }
+    }
+
+    (*kmers)[(*size)++] = kmer;
+
+    return true;
+}
+
+/**
+ * \brief Collects the distinct solid canonical kmers of a fasta file
+ * 
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param counts counts of the kmers, all kmers are collected if NULL
+ * @param minAbundance minimum count of a collected kmer
+ * @return a pointer to an allocated KmerSet structure or NULL if an error occured
+ */
+static KmerSet *collectKmers(FILE *fp, int k, const CountMinSketch *counts, int minAbundance) {
+    uint64_t size = 0;
+    uint64_t sorted = 0;
+    uint64_t capacity = DBG_COLLECT_SIZE;
+    Kmer *kmers = malloc(sizeof(*kmers) * capacity);
+
+    char *line = NULL;
+    size_t length = 0;
+
+    if (!kmers) {
+        log_error("Kmers allocation error");
         return NULL;
     }
 
-    int8_t nbHashs = 0;
-    if ((r = gzread(fp, &nbHashs, 1)) != 1) {
-        if (r != -1) {
-            log_error("Unable to read the number of hashs : %s", gzFileError(fp));
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength) {
+            goto ERROR;
         }
-        else {
-            log_error("nbhashs error");
+
+        Kmer kmer;
+        KmerHash hash;
+
+        kmerEncode(line, k, &kmer);
+        kmerHashInit(&hash, kmer, k);
+        Kmer rc = kmerReverseComplement(kmer, k);
+
+        for (int64_t i = k;i <= lineLength;i++) {
+            if (cmsIsSolid(counts, minAbundance, kmerHashCanonical(&hash))
+                && !appendKmer(&kmers, &size, &sorted, &capacity, (kmerCanonicalMode && rc < kmer) ? rc : kmer)) {
+                goto ERROR;
+            }
+
+            if (i < lineLength) {
+                uint8_t base = kmerEncodeBase(line[i]);
+
+                // The hash is only needed to check the counts
+                if (counts) {
+                    hash = kmerHashRoll(&hash, kmerFirstBase(kmer, k), base, k);
+                }
+
+                kmer = kmerAppend(kmer, base, k);
+                rc = kmerAppendReverse(rc, base, k);
+            }
         }
-        return NULL;
     }
 
-    int8_t *bytes = malloc(sizeof(*bytes) * size);
+    if (ferror(fp)) {
+        perror("something bad happened");
+        goto ERROR;
+    }
+
+    free(line);
+    return kmerSetCreate(kmers, size);
+
+ERROR:
+    free(line);
+    free(kmers);
+    return NULL;
+}
+
+KmerSet *collectDBGKmers(FILE *fp, int k, const CountMinSketch *counts, int minAbundance) {
+    assert(fp);
 
-    if (!bytes) {
-        log_error("Unable to allocate a buffer of size %I64d", size);
+    if (k <= 0 || k > KMER_MAX_SIZE) {
         return NULL;
     }
 
-    if ((r = gzread(fp, bytes, size)) != size) {
-        if (r != -1) {
-            log_error("Unable to read the content of the Bloom filter : %s", gzFileError(fp));
+    return collectKmers(fp, k, counts, minAbundance);
+}
+
+/**
+ * \brief Inserts a range of distinct kmers into the filter
+ * 
+ * @param voidArgs a pointer to an InsertArgs structure
+ * @return NULL
+ */
+static void *insertWorker(void *voidArgs) {
+    InsertArgs *args = voidArgs;
+    KmerHash hash;
+
+    for (uint64_t i = 0;i < args->nbKmers;i++) {
+        // The canonical hash of a kmer is the one of its reverse complement
+        kmerHashInit(&hash, args->kmers[i], args->k);
+        uint64_t value = kmerHashCanonical(&hash);
+
+        if (!(args->concurrent ? bfAddHashConcurrent(args->bf, value) : bfAddHash(args->bf, value))) {
+            args->failed = true;
+            return NULL;
         }
-        else {
-            log_error("content error");
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Inserts distinct kmers into a filter with several threads
+ * 
+ * See insertDBGKmers.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param kmers array of canonical kmers
+ * @param nbKmers number of kmers
+ * @param k length of each kmer
+ * @param nbThreads number of workers
+ * @return true if all kmers were inserted, otherwise false
+ */
+static bool insertKmers(BloomFilter *bf, const Kmer *kmers, uint64_t nbKmers, int k, int nbThreads) {
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+
+    InsertArgs *args = malloc(sizeof(*args) * nbThreads);
+    pthread_t *threads = malloc(sizeof(*threads) * nbThreads);
+    int started = 1;
+    bool failed = false;
+
+    if (!args || !threads) {
+        log_error("Threads allocation error");
+        free(args);
+        free(threads);
+        return false;
+    }
+
+    // Each worker inserts the same number of kmers
+    for (int i = 0;i < nbThreads;i++) {
+        uint64_t first = nbKmers * i / nbThreads;
+        uint64_t last = nbKmers * (i + 1) / nbThreads;
+
+        args[i] = (InsertArgs) {
+            .bf = bf, .kmers = kmers + first, .nbKmers = last - first,
+            .k = k, .concurrent = nbThreads > 1, .failed = false
+        };
+    }
+
+    for (;started < nbThreads;started++) {
+        if (pthread_create(threads + started, NULL, insertWorker, args + started) != 0) {
+            log_error("Unable to create a worker");
+            failed = true;
+            break;
         }
-        free(bytes);
-        return NULL;
     }
 
-    BloomFilter *bf = bfCreate(size, nbHashs);
+    if (!failed) {
+        insertWorker(args);
+    }
+
+    for (int i = 1;i < started;i++) {
+        pthread_join(threads[i], NULL);
+    }
 
-    if (!bf) {
-        log_error("Unable to create a new Bloom filter");
-        free(bytes);
-        return NULL;
+    for (int i = 0;i < nbThreads && !failed;i++) {
+        if (args[i].failed) {
+            log_error("Unable to insert the kmers into the filter");
+            failed = true;
+        }
     }
 
-    bfFill(bf, bytes);
+    free(args);
+    free(threads);
+    return !failed;
+}
+
+bool insertDBGKmers(BloomFilter *bf, const KmerSet *kmers, int k, int nbThreads) {
+    assert(bf);
+    assert(kmers);
+
+    if (k <= 0 || k > KMER_MAX_SIZE) {
+        return false;
+    }
 
-    free(bytes);
-    return bf;
+    return insertKmers(bf, kmers->kmers, kmerSetSize(kmers), k, nbThreads);
 }
 
-bool saveDBG(BloomFilter *bf, gzFile fp) {
+bool insertDBGBuckets(DBGBuckets *buckets, BloomFilter *bf, int minAbundance, int nbThreads) {
+    assert(buckets);
     assert(bf);
+
+    Kmer *kmers = allocateDBGBucket(buckets);
+
+    if (!kmers) {
+        return false;
+    }
+
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        uint64_t n;
+
+        if (!readDBGBucket(buckets, i, kmers, minAbundance, &n)
+            || !insertKmers(bf, kmers, n, buckets->k, nbThreads)) {
+            free(kmers);
+            return false;
+        }
+    }
+
+    free(kmers);
+    return true;
+}
+
+DeBruijnGraph *createExactDBG(FILE *fp, int k, const CountMinSketch *counts, int minAbundance) {
     assert(fp);
 
-    // @TODO check endianness
+    if (k <= 0 || k > KMER_MAX_SIZE) {
+        return NULL;
+    }
+
+    KmerSet *kmers = collectKmers(fp, k, counts, minAbundance);
+
+    if (!kmers) {
+        return NULL;
+    }
+
+    DeBruijnGraph *graph = wrapExactDBG(kmers, k);
 
-    long filterSize = bfSize(bf);
-    if (gzwrite(fp, &filterSize, 4) <= 0) {
-        log_error("Unable to write filter size : %s", gzFileError(fp));
+    if (!graph) {
+        kmerSetDelete(kmers);
+    }
+
+    return graph;
+}
+
+/**
+ * \brief Computes the critical false positives of a graph
+ * 
+ * The solid kmers are collected from the buckets if they are given, otherwise from the file.
+ * See computeFalsePositives and computeBucketFalsePositives.
+ */
+static bool findFalsePositives(DeBruijnGraph *graph, FILE *fp, int k, const CountMinSketch *counts, int minAbundance,
+    DBGBuckets *buckets) {
+
+    if (k <= 0 || k > KMER_MAX_SIZE) {
         return false;
     }
 
-    long filterHashs = bfNbHashs(bf);
-    if (gzwrite(fp, &filterHashs, 1) <= 0) {
-        log_error("Unable to write filter nbHashs : %s", gzFileError(fp));
+    if (graph->backend == DBG_BACKEND_EXACT) {
+        return true;
+    }
+
+    BloomFilter *bf = graph->bf;
+
+    if (bfHashScheme(bf) == BF_HASH_SEEDED) {
+        log_error("False positives of a graph without a format version are not supported");
         return false;
     }
 
-    if (gzwrite(fp, bf->data, filterSize) < bf->size) {
-        log_error("Unable to write filter content : %s", gzFileError(fp));
+    rewind(fp);
+    KmerSet *reads = buckets ? collectDBGBuckets(buckets, minAbundance) : collectKmers(fp, k, counts, minAbundance);
+
+    if (!reads) {
         return false;
     }
 
-    return true;
-}
\ No newline at end of file
+    rewind(fp);
+
+    uint64_t size = 0;
+    uint64_t sorted = 0;
+    uint64_t capacity = DBG_COLLECT_SIZE;
+    Kmer *falsePositives = malloc(sizeof(*falsePositives) * capacity);
+
+    char *line = NULL;
+    size_t length = 0;
+
+    bool result = false;
+
+    if (!falsePositives) {
+        log_error("False positives allocation error");
+        goto EXIT;
+    }
+
+    ssize_t lineLength;
+    while ((lineLength = readSequence(&line, &length, fp)) >= 0) {
+        if (k > lineLength) {
+            goto EXIT;
+        }
+
+        Kmer kmer;
+        KmerHash hash;
+
+        kmerEncode(line, k, &kmer);
+        kmerHashInit(&hash, kmer, k);
+
+        // The successors of the last kmer of a read are never checked
+        for (int64_t i = k;i < lineLength;i++) {
+            uint8_t first = kmerFirstBase(kmer, k);
+            uint64_t hashes[4];
+            bool found[4];
+
+            kmerHashSuccessors(&hash, &first, 1, k, hashes);
+            bfContainsHashBatch(bf, hashes, 4, found);
+
+            for (uint8_t base = 0;base < 4;base++) {
+                Kmer next = kmerCanonical(kmerAppend(kmer, base, k), k);
+
+                if (found[base] && !kmerSetContains(reads, next)
+                    && !appendKmer(&falsePositives, &size, &sorted, &capacity, next)) {
+                    goto EXIT;
+                }
+            }
+
+            uint8_t base = kmerEncodeBase(line[i]);
+
+            hash = kmerHashRoll(&hash, first, base, k);
+            kmer = kmerAppend(kmer, base, k);
+        }
+    }
+
+    if (ferror(fp)) {
+        perror("something bad happened");
+        goto EXIT;
+    }
+
+    KmerSet *set = kmerSetCreate(falsePositives, size);
+    falsePositives = NULL;
+
+    if (!set) {
+        goto EXIT;
+    }
+
+    kmerSetDelete(graph->falsePositives);
+    graph->falsePositives = set;
+
+    result = true;
+
+EXIT:
+    free(line);
+    free(falsePositives);
+    kmerSetDelete(reads);
+    return result;
+}
+
+bool computeFalsePositives(DeBruijnGraph *graph, FILE *fp, int k, const CountMinSketch *counts, int minAbundance) {
+    assert(graph);
+    assert(fp);
+
+    return findFalsePositives(graph, fp, k, counts, minAbundance, NULL);
+}
+
+bool computeBucketFalsePositives(DeBruijnGraph *graph, FILE *fp, DBGBuckets *buckets, int minAbundance) {
+    assert(graph);
+    assert(fp);
+    assert(buckets);
+
+    return findFalsePositives(graph, fp, buckets->k, NULL, minAbundance, buckets);
+}
+
+bool insertKmer(struct BloomFilter *bf, const char *kmer, int k) {
+    assert(bf);
+    assert(kmer);
+
+    KmerHash hash;
+
+    if (!kmerHashInitString(&hash, kmer, k)) {
+        return false;
+    }
+
+    return bfAddHash(bf, kmerHashCanonical(&hash));
+}
+
+bool containsKmer(struct BloomFilter *bf, const char *kmer, int k) {
+    assert(bf);
+    assert(kmer);
+
+    if (bfHashScheme(bf) == BF_HASH_SEEDED) {
+        Kmer packed;
+
+        if (!kmerEncode(kmer, k, &packed)) {
+            return false;
+        }
+
+        char canonical[KMER_MAX_SIZE];
+        kmerDecode(kmerCanonical(packed, k), k, canonical);
+
+        return bfContains(bf, canonical, k);
+    }
+
+    KmerHash hash;
+
+    if (!kmerHashInitString(&hash, kmer, k)) {
+        return false;
+    }
+
+    return bfContainsHash(bf, kmerHashCanonical(&hash));
+}
+
+/**
+ * \brief Checks the successors of at most DBG_SUCCESSORS_BATCH kmers
+ * 
+ * See containsSuccessors, critical false positives are not removed.
+ */
+static void containsSuccessorsBatch(const DeBruijnGraph *graph, const Kmer *kmers, const KmerHash *hashes, int n, int k, bool *found) {
+    if (graph->backend == DBG_BACKEND_EXACT) {
+        Kmer successors[DBG_SUCCESSORS_BATCH * 4];
+
+        for (int i = 0;i < n * 4;i++) {
+            successors[i] = kmerCanonical(kmerAppend(kmers[i / 4], i % 4, k), k);
+            kmerSetPrefetch(graph->kmers, successors[i]);
+        }
+
+        for (int i = 0;i < n * 4;i++) {
+            found[i] = kmerSetContains(graph->kmers, successors[i]);
+        }
+    }
+    else if (bfHashScheme(graph->bf) == BF_HASH_SEEDED) {
+        // Graphs saved without a format version contain
+        // the canonical kmers as strings
+        for (int i = 0;i < n * 4;i++) {
+            char canonical[KMER_MAX_SIZE];
+            kmerDecode(kmerCanonical(kmerAppend(kmers[i / 4], i % 4, k), k), k, canonical);
+
+            found[i] = bfContains(graph->bf, canonical, k);
+        }
+    }
+    else {
+        // The hash of each successor is derived from the one of its kmer
+        uint64_t successors[DBG_SUCCESSORS_BATCH * 4];
+        uint8_t firsts[DBG_SUCCESSORS_BATCH];
+
+        for (int i = 0;i < n;i++) {
+            firsts[i] = kmerFirstBase(kmers[i], k);
+        }
+
+        kmerHashSuccessors(hashes, firsts, n, k, successors);
+        bfContainsHashBatch(graph->bf, successors, n * 4, found);
+    }
+}
+
+void containsSuccessors(const DeBruijnGraph *graph, const Kmer *kmers, const KmerHash *hashes, int n, int k, bool *found) {
+    assert(graph);
+    assert(kmers);
+    assert(hashes);
+    assert(found);
+
+    for (int first = 0;first < n;first += DBG_SUCCESSORS_BATCH) {
+        int size = (n - first < DBG_SUCCESSORS_BATCH) ? n - first : DBG_SUCCESSORS_BATCH;
+
+        containsSuccessorsBatch(graph, kmers + first, hashes + first, size, k, found + first * 4);
+    }
+
+    if (graph->falsePositives) {
+        for (int i = 0;i < n * 4;i++) {
+            if (found[i] && isFalsePositive(graph, kmerAppend(kmers[i / 4], i % 4, k), k)) {
+                found[i] = false;
+            }
+        }
+    }
+}
+
+void containsSuccessors128(const DeBruijnGraph *graph, const Kmer128 *kmers, const KmerHash *hashes, int n, int k, bool *found) {
+    assert(graph);
+    assert(kmers);
+    assert(hashes);
+    assert(found);
+
+    for (int first = 0;first < n;first += DBG_SUCCESSORS_BATCH) {
+        int size = (n - first < DBG_SUCCESSORS_BATCH) ? n - first : DBG_SUCCESSORS_BATCH;
+
+        if (k <= KMER_MAX_SIZE) {
+            Kmer packed[DBG_SUCCESSORS_BATCH];
+
+            for (int i = 0;i < size;i++) {
+                packed[i] = (Kmer) kmers[first + i];
+            }
+
+            containsSuccessors(graph, packed, hashes + first, size, k, found + first * 4);
+            continue;
+        }
+
+        // Longer kmers are only in filters that use the rolling hashes,
+        // without false positives (see dbgMaxKmerSize)
+        uint64_t successors[DBG_SUCCESSORS_BATCH * 4];
+        uint8_t firsts[DBG_SUCCESSORS_BATCH];
+
+        for (int i = 0;i < size;i++) {
+            firsts[i] = kmer128FirstBase(kmers[first + i], k);
+        }
+
+        kmerHashSuccessors(hashes + first, firsts, size, k, successors);
+        bfContainsHashBatch(graph->bf, successors, size * 4, found + first * 4);
+    }
+}
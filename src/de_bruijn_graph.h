@@ -2,11 +2,69 @@
 #define DE_BRUIJN_GRAPH_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
-#include <zlib.h>
+#include "kmer.h"
+#include "kmer_hash.h"
+#include "kmer_set.h"
 
 struct BloomFilter;
+struct CountMinSketch;
+struct DBGBuckets;
+
+/**
+ * \brief Structures that store the kmers of a graph
+ */
+typedef enum DBGBackend {
+    // Probabilistic set, it may contain kmers that are not in the reads
+    DBG_BACKEND_BLOOM = 0,
+    // Sorted array of the canonical kmers (see KmerSet), without false positives
+    DBG_BACKEND_EXACT = 1
+} DBGBackend;
+
+/**
+ * \brief De Bruijn graph stored in a Bloom filter or in an exact set of kmers
+ * 
+ * The critical false positives are the kmers that are wrongly contained by the filter
+ * and that follow a kmer of the reads : without them, the walk along a read would
+ * find spurious neighbors. They are stored with their canonical form.
+ */
+typedef struct DeBruijnGraph {
+    DBGBackend backend;
+    // Length of the kmers of the graph
+    int k;
+    // True if a kmer and its reverse complement are the same node of the graph
+    bool canonical;
+    // Filter of a DBG_BACKEND_BLOOM graph, NULL otherwise
+    struct BloomFilter *bf;
+    // Critical false positives of the filter, could be NULL
+    KmerSet *falsePositives;
+    // Canonical kmers of a DBG_BACKEND_EXACT graph, NULL otherwise
+    KmerSet *kmers;
+    // Mapped file that contains the data of the graph, NULL if it was not mapped (see mapDBG)
+    void *mapping;
+    size_t mappingSize;
+} DeBruijnGraph;
+
+/**
+ * \brief Gets the maximum length of the kmers of a graph backend
+ * 
+ * The kmers of an exact graph and the false positives of a filter are stored packed
+ * on 64 bits, while a filter only stores the hashes of its kmers : they are packed
+ * on 128 bits when they are read (see Kmer128).
+ */
+#define dbgMaxKmerSize(backend) ((backend) == DBG_BACKEND_EXACT ? KMER_MAX_SIZE : KMER128_MAX_SIZE)
+
+/**
+ * \brief Precision of the sketch used by estimateDBGKmers
+ */
+#define DBG_ESTIMATE_PRECISION 14
+
+/**
+ * \brief Number of rows of the sketch created by countDBGKmers
+ */
+#define DBG_COUNT_DEPTH 4
 
 /**
  * \brief Creates a De Bruijn graph from a given fasta file
@@ -14,8 +72,9 @@ struct BloomFilter;
  * The file pointer must be an opened file in reading mode
  * and must be a fasta file.
  * 
- * If k is negative or greater than the length of a lecture, then the
- * function will return 0.
+ * If k is negative, greater than KMER128_MAX_SIZE or greater than the length
+ * of a lecture, then the function will return false. Kmers longer than
+ * KMER_MAX_SIZE are packed on 128 bits before they are hashed.
  * 
  * If an io error occured, then false will be returned.
  * 
@@ -26,58 +85,325 @@ struct BloomFilter;
  */
 bool createDBG(struct BloomFilter *bf, FILE *fp, int k);
 
+/**
+ * \brief Creates a De Bruijn graph from a given fasta file with several threads
+ * 
+ * The file is read by the calling thread and split into chunks of whole reads.
+ * The kmers of each chunk are inserted by one of the nbThreads workers,
+ * with atomic bit sets (see bfAddHashConcurrent).
+ * The filter is the same as the one created by createDBG.
+ * 
+ * If nbThreads is less or equal to 1, then this function behaves like createDBG.
+ * The same errors as createDBG are reported.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param nbThreads number of workers
+ * @return true is the graph was correctly loaded, otherwise false
+ */
+bool createDBGThreads(struct BloomFilter *bf, FILE *fp, int k, int nbThreads);
+
+/**
+ * \brief Creates a De Bruijn graph from the solid kmers of a fasta file
+ * 
+ * A kmer is solid if it has been counted at least minAbundance times (see countDBGKmers),
+ * the other ones mostly come from sequencing errors and are not inserted into the filter.
+ * Reads that contain them are still compressed without loss (see computeBranchings).
+ * 
+ * The kmers are inserted like createDBGThreads, which is the same as
+ * this function with NULL counts. The same errors are reported.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param nbThreads number of workers
+ * @param counts counts of the kmers of the file, all kmers are inserted if NULL
+ * @param minAbundance minimum count of an inserted kmer
+ * @return true is the graph was correctly loaded, otherwise false
+ */
+bool createSolidDBG(struct BloomFilter *bf, FILE *fp, int k, int nbThreads, const struct CountMinSketch *counts, int minAbundance);
+
+/**
+ * \brief Collects the distinct solid canonical kmers of a fasta file
+ * 
+ * The kmers are collected in chunks, each chunk is radix sorted and merged with the
+ * distinct kmers of the previous ones (see kmerMergeUnique) : the memory needed is about
+ * 8 bytes per distinct kmer, whatever the coverage of the reads. The size of the set
+ * is the exact number of distinct kmers, which can be used to size a filter.
+ * 
+ * The same errors as createDBG are reported and k must be less or equal to KMER_MAX_SIZE,
+ * NULL is returned in case of an error.
+ * 
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param counts counts of the kmers of the file, all kmers are collected if NULL (see createSolidDBG)
+ * @param minAbundance minimum count of a collected kmer
+ * @return a pointer to an allocated KmerSet structure
+ */
+KmerSet *collectDBGKmers(FILE *fp, int k, const struct CountMinSketch *counts, int minAbundance);
+
+/**
+ * \brief Inserts distinct kmers into a filter
+ * 
+ * Each kmer is hashed and inserted once, instead of once per occurrence in the reads.
+ * The filter is the same as the one created by createSolidDBG with the reads
+ * of the kmers (see collectDBGKmers). With several threads, the kmers are split
+ * between the workers and inserted with atomic bit sets.
+ * 
+ * False will be returned if k is not valid or a kmer could not be inserted.
+ * 
+ * @param bf a pointer to a Bloom filter structure
+ * @param kmers a pointer to a set of canonical kmers
+ * @param k length of each kmer
+ * @param nbThreads number of workers
+ * @return true if all kmers were inserted, otherwise false
+ */
+bool insertDBGKmers(struct BloomFilter *bf, const KmerSet *kmers, int k, int nbThreads);
+
+/**
+ * \brief Creates an exact De Bruijn graph from a given fasta file
+ * 
+ * All distinct solid canonical kmers of the file are stored in a sorted array,
+ * so the graph has no false positives. It needs 8 bytes per kmer in memory,
+ * plus 2 bytes per kmer for the index of the set.
+ * 
+ * The same errors as createDBG are reported and k must be less or equal to KMER_MAX_SIZE,
+ * NULL is returned in case of an error.
+ * 
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param counts counts of the kmers of the file, all kmers are stored if NULL (see createSolidDBG)
+ * @param minAbundance minimum count of a stored kmer
+ * @return a pointer to an allocated DeBruijnGraph structure
+ */
+DeBruijnGraph *createExactDBG(FILE *fp, int k, const struct CountMinSketch *counts, int minAbundance);
+
+/**
+ * \brief Estimates the number of distinct canonical kmers of a fasta file
+ * 
+ * The kmers are added into a HyperLogLog sketch with the precision
+ * DBG_ESTIMATE_PRECISION, the relative error of the estimate is about 1%.
+ * The whole file is read, the caller has to rewind it.
+ * 
+ * The same errors as createDBG are reported.
+ * 
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param nbKmers destination of the estimate
+ * @return true if the kmers were counted, otherwise false
+ */
+bool estimateDBGKmers(FILE *fp, int k, uint64_t *nbKmers);
+
+/**
+ * \brief Counts the kmers of a fasta file
+ * 
+ * The canonical kmers are counted by a count-min sketch of DBG_COUNT_DEPTH rows
+ * of nbKmers counters, where nbKmers is the number of distinct kmers of the file
+ * (see estimateDBGKmers). The number of distinct solid kmers, counted at least
+ * minAbundance times, is estimated at the same time so that the filter can be sized.
+ * The whole file is read, the caller has to rewind it.
+ * 
+ * The minimum abundance must be between 1 and CMS_MAX_COUNT.
+ * The same errors as createDBG are reported, NULL is returned in case of an error.
+ * 
+ * @param fp fasta file
+ * @param k length of each kmer
+ * @param nbKmers number of distinct kmers of the file
+ * @param minAbundance minimum count of a solid kmer
+ * @param nbSolid destination of the estimated number of solid kmers
+ * @return a pointer to an allocated CountMinSketch structure
+ */
+struct CountMinSketch *countDBGKmers(FILE *fp, int k, uint64_t nbKmers, int minAbundance, uint64_t *nbSolid);
+
+/**
+ * \brief Inserts the distinct solid kmers of buckets into a filter
+ * 
+ * The filter is the same as the one created by createDBG if minAbundance is 1.
+ * The solid kmers of each bucket are inserted by nbThreads workers (see insertDBGKmers).
+ * 
+ * @param buckets a pointer to a DBGBuckets structure
+ * @param bf a pointer to a Bloom filter structure
+ * @param minAbundance minimum count of an inserted kmer
+ * @param nbThreads number of workers
+ * @return true if all kmers were inserted, otherwise false
+ */
+bool insertDBGBuckets(struct DBGBuckets *buckets, struct BloomFilter *bf, int minAbundance, int nbThreads);
+
 /**
  * Inserts the canonical kmer form into the Bloom filter
  * 
- * If the kmer length k is negative or equals 0 then false will be returned.
- * The given kmer will be modified to store its canonical form.
+ * If the kmer length k is negative, equals 0 or is greater than
+ * KMER128_MAX_SIZE then false will be returned.
+ * The kmer is inserted with its canonical hash (see KmerHash),
+ * the given string is not modified.
  * 
  * @param bf a pointer to a Bloom filter structure, it will store the kmer
  * @param kmer kmer to store
  * @param k length of the kmer
  * @return true if the insertion succeed, false otherwise
  */
-bool insertKmer(struct BloomFilter *bf, char *kmer, int k);
+bool insertKmer(struct BloomFilter *bf, const char *kmer, int k);
 
 /**
- * \brief Loads a De Bruijn from a gzip file
+ * \brief Checks if the canonical kmer form is in the Bloom filter
  * 
- * The file must contain a serialized graph (See saveDBG for the format).
+ * If the kmer length k is negative, equals 0 or is greater than
+ * KMER128_MAX_SIZE then false will be returned.
  * 
- * If an error occured during this decompression or 
- * during the reading (missing fields), then NULL will be returned.
+ * @param bf a pointer to a Bloom filter structure
+ * @param kmer kmer to look for
+ * @param k length of the kmer
+ * @return true if the filter contains the kmer, otherwise false
+ */
+bool containsKmer(struct BloomFilter *bf, const char *kmer, int k);
+
+/**
+ * \brief Creates a new graph from a Bloom filter
  * 
- * This function returns an heap allocated Bloom filter if no error occured.
- * The user is in charge of the releasing the memory.
+ * The filter is owned by the graph, it will be released by deleteDBG.
+ * The graph stores the canonical kmers of the current mode (see kmerCanonicalMode).
+ * If an allocation error occured, then NULL will be returned.
  * 
- * @param fp a file pointer to a gzip file
- * @return a pointer to a Bloom filter or NULL in case of an error
+ * @param bf a pointer to an allocated Bloom filter structure
+ * @param k length of the kmers inserted into the filter
+ * @return a pointer to an allocated DeBruijnGraph structure
  */
-struct BloomFilter *loadDBG(gzFile fp);
+DeBruijnGraph *wrapDBG(struct BloomFilter *bf, int k);
 
 /**
- * \brief Writes a De Bruijn into a gzip file
+ * \brief Creates a new exact graph from a set of canonical kmers
  * 
- * The file must be opened in binary writing mode.
+ * The set is owned by the graph, it will be released by deleteDBG.
+ * The kmers are canonical in the current mode (see kmerCanonicalMode).
+ * If an allocation error occured, then NULL will be returned.
  * 
- * All fields are written with the order of the computer.
- * We assume that only the little endian order will be used.
+ * @param kmers a pointer to an allocated KmerSet structure
+ * @param k length of the kmers of the set
+ * @return a pointer to an allocated DeBruijnGraph structure
+ */
+DeBruijnGraph *wrapExactDBG(KmerSet *kmers, int k);
+
+/**
+ * \brief Frees the memory allocated for the given graph, its kmers and its false positives
  * 
- * The first 8 bytes represent the size (in bits) of the associated Bloom filter.
- * It is a signed integer number.
+ * @param graph a pointer to an allocated DeBruijnGraph structure
+ */
+void deleteDBG(DeBruijnGraph *graph);
+
+/**
+ * \brief Selects the hash function and the canonical mode of the kmers of a graph
  * 
- * The next byte represents the number of hashs functions used to add a word into the filter.
- * It is a signed char.
+ * The kmers of a filter with the BF_FUNCTION_FAST hash function are hashed by
+ * KMER_HASH_MIX, the other ones by KMER_HASH_NTHASH (see kmerHashUseFunction).
+ * The canonical mode of the graph is used for all kmers (see kmerUseCanonical).
+ * It must be called before the kmers of a loaded graph are looked up.
+ * This function is not thread safe.
  * 
- * Then the last n bits represent the content of the filter, where n is the size in bits of the filter.
+ * @param graph a pointer to a DeBruijnGraph structure
+ */
+void useDBGKmerMode(const DeBruijnGraph *graph);
+
+/**
+ * \brief Adds the kmers of another graph into a graph
+ * 
+ * The graphs must have the same backend, kmer size and canonical mode. The filters of
+ * Bloom graphs must also have the same parameters (see bfUnion) : the merged filter is
+ * then the filter of a graph created from the reads of both graphs. Graphs built from
+ * several parts of a file can be merged into the graph of the whole file.
+ * 
+ * The critical false positives of the graph are removed, they have to be computed
+ * again with all reads (see computeFalsePositives). A mapped graph can not be changed.
+ * 
+ * If the graphs can not be merged or if an allocation error occured, then false will be
+ * returned and the graph is not changed.
+ * 
+ * @param graph a pointer to the DeBruijnGraph structure that receives the kmers
+ * @param other a pointer to the DeBruijnGraph structure whose kmers are added
+ * @return true if the graphs were merged, otherwise false
+ */
+bool mergeDBG(DeBruijnGraph *graph, const DeBruijnGraph *other);
+
+/**
+ * \brief Computes the critical false positives of a graph
+ * 
+ * The filter of the graph must have been filled with the kmers of the file (see createSolidDBG).
+ * The file is read twice : all distinct solid kmers are collected, then the successors of each kmer
+ * that are contained by the filter but are not solid kmers of the reads are stored as false positives.
+ * 
+ * The filter must not use the BF_HASH_SEEDED scheme. An exact graph has
+ * no false positives, true is returned without reading the file.
+ * The same errors as createDBG are reported and k must be less or equal to KMER_MAX_SIZE.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param fp fasta file, will be rewinded
+ * @param k length of each kmer
+ * @param counts counts given to createSolidDBG, NULL if all kmers were inserted
+ * @param minAbundance minimum count given to createSolidDBG
+ * @return true if the false positives were computed, otherwise false
+ */
+bool computeFalsePositives(DeBruijnGraph *graph, FILE *fp, int k, const struct CountMinSketch *counts, int minAbundance);
+
+/**
+ * \brief Computes the critical false positives of a graph filled from buckets
+ * 
+ * This function behaves like computeFalsePositives, but the solid kmers are
+ * collected from the buckets with exact counts (see collectDBGBuckets)
+ * instead of being read from the file.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param fp fasta file of the buckets, will be rewinded
+ * @param buckets buckets given to insertDBGBuckets
+ * @param minAbundance minimum count given to insertDBGBuckets
+ * @return true if the false positives were computed, otherwise false
+ */
+bool computeBucketFalsePositives(DeBruijnGraph *graph, FILE *fp, struct DBGBuckets *buckets, int minAbundance);
+
+/**
+ * \brief Checks if a kmer is a critical false positive of the graph
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param kmer a packed kmer
+ * @param k length of the kmer
+ * @return true if the canonical form of the kmer is a false positive, otherwise false
+ */
+static inline bool isFalsePositive(const DeBruijnGraph *graph, Kmer kmer, int k) {
+    return graph->falsePositives && kmerSetContains(graph->falsePositives, kmerCanonical(kmer, k));
+}
+
+/**
+ * \brief Checks which successors of several kmers are in the graph
+ * 
+ * The successors of a kmer are the kmers obtained by removing its first base
+ * and appending A, C, G or T. found[i * 4 + b] is set to true if the kmer i
+ * followed by the base b is in the graph and is not a critical false positive.
+ * 
+ * The lookups of all successors are issued before their results are used,
+ * so that their memory accesses overlap.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param kmers n packed kmers
+ * @param hashes hash values of the n kmers
+ * @param n number of kmers
+ * @param k length of the kmers, between 2 and KMER_MAX_SIZE
+ * @param found destination of the 4 * n results
+ */
+void containsSuccessors(const DeBruijnGraph *graph, const Kmer *kmers, const KmerHash *hashes, int n, int k, bool *found);
+
+/**
+ * \brief Checks which successors of several kmers packed on 128 bits are in the graph
  * 
- * This functions returns true is the graph was correctly written into the disk or false
- * if an error occured.
+ * This function behaves like containsSuccessors. Kmers of at most KMER_MAX_SIZE bases
+ * are looked up by containsSuccessors, the longer ones can only be in a filter
+ * (see dbgMaxKmerSize) and only the hashes of their successors are computed.
  * 
- * @param bf a pointer to a Bloom filter structure (represents the De Bruin graph)
- * @param fp a pointer to a gzip file
- * @return true if no error occured, otherwise false
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param kmers n kmers packed on 128 bits
+ * @param hashes hash values of the n kmers
+ * @param n number of kmers
+ * @param k length of the kmers, between 2 and KMER128_MAX_SIZE
+ * @param found destination of the 4 * n results
  */
-bool saveDBG(struct BloomFilter *bf, gzFile fp);
+void containsSuccessors128(const DeBruijnGraph *graph, const Kmer128 *kmers, const KmerHash *hashes, int n, int k, bool *found);
 
-#endif // DE_BRUIJN_GRAPH_H
\ No newline at end of file
+#endif // DE_BRUIJN_GRAPH_H
@@ -4,22 +4,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#include <zlib.h>
+#include <unistd.h>
 
 #include "bloom_filter.h"
+#include "dbg_io.h"
 #include "de_bruijn_graph.h"
 #include "decompress_thread.h"
 #include "fasta.h"
 #include "log.h"
+#include "numa.h"
 #include "string_utils.h"
 #include "utils.h"
 
 void help(const char *prog) {
-    printf("Usage : %s [--graph file] [--output, -o file] compressed_file\n\n", prog);
+    printf("Usage : %s [--graph file] [--output, -o file] [--interleave n] [--huge-pages] [--hugetlb] [--numa-interleave] [--pin-threads] [--threads, -t n] compressed_file\n\n", prog);
 
-    printf("--graph -> path to a file for loading Bloom filter\n");
+    printf("--graph -> path to a file for loading Bloom filter (compressed or mapped graph, see fasta_compress --mapped)\n");
     printf("--output, -o file -> path to a file for writing decompressed reads\n");
+    printf("--interleave n -> number of reads decompressed together by each thread (default 8)\n");
+    printf("--huge-pages -> backs the loaded Bloom filter with transparent huge pages, its lookups miss the TLB less often\n");
+    printf("--hugetlb -> backs the loaded Bloom filter with the huge pages reserved by the administrator (transparent ones if none is left)\n");
+    printf("--numa-interleave -> interleaves the pages of the loaded Bloom filter on all NUMA nodes\n");
+    printf("--pin-threads -> pins each decompression thread on one processor, spread on all NUMA nodes\n");
+    printf("--threads, -t n -> number of threads used to load the graph (default number of processors)\n");
 }
 
 int main(int argc, char **argv) {
@@ -27,14 +34,30 @@ int main(int argc, char **argv) {
         { "help", no_argument, NULL, '?' },
         { "graph", required_argument, NULL, 'g' },
         { "output", required_argument, NULL, 'o' },
+        { "interleave", required_argument, NULL, 'i' },
+        { "threads", required_argument, NULL, 't' },
+        { "huge-pages", no_argument, NULL, 'H' },
+        { "hugetlb", no_argument, NULL, 'T' },
+        { "numa-interleave", no_argument, NULL, 'N' },
+        { "pin-threads", no_argument, NULL, 'P' },
         { 0, 0, 0, 0 }
     };
 
     char graphPath[255] = { '\0' };
     char outputPath[255] = { '\0' };
 
+    // Lookups of a read are done while the other reads of its group are processed
+    int groupSize = 8;
+
+    // The blocks of the graph are decompressed by all processors by default
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int nbThreads = (processors > 0) ? processors : 1;
+
+    int allocation = BF_ALLOC_DEFAULT;
+    bool pinThreads = false;
+
     int opt;
-    while ((opt = getopt_long(argc, argv, "?1:o:", options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "?1:o:i:t:", options, NULL)) != -1) {
         switch(opt) {
             case '?':
                 help(argv[0]);
@@ -47,6 +70,40 @@ int main(int argc, char **argv) {
             case 'o':
                 strncpy(outputPath, optarg, 255);
                 break;
+
+            case 'i':
+                groupSize = atoi(optarg);
+
+                if (groupSize <= 0) {
+                    fprintf(stderr, "Invalid number of interleaved reads\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 't':
+                nbThreads = atoi(optarg);
+
+                if (nbThreads <= 0) {
+                    fprintf(stderr, "Invalid number of threads\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'H':
+                allocation |= BF_ALLOC_HUGE_PAGES;
+                break;
+
+            case 'T':
+                allocation |= BF_ALLOC_HUGETLB;
+                break;
+
+            case 'N':
+                allocation |= BF_ALLOC_INTERLEAVE;
+                break;
+
+            case 'P':
+                pinThreads = true;
+                break;
             
             default:
                 fprintf(stderr, "Unknown option %s\n", optarg);
@@ -68,9 +125,17 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
-    if (graphPath[0] == '\0' && pathExtension(inputFile, pathLength, "graph.gz", 8, graphPath, 255) == 0) {
-        fprintf(stderr, "The given path is too long\n");
-        return EXIT_FAILURE;
+    if (graphPath[0] == '\0') {
+        if (pathExtension(inputFile, pathLength, "graph.gz", 8, graphPath, 255) == 0) {
+            fprintf(stderr, "The given path is too long\n");
+            return EXIT_FAILURE;
+        }
+
+        // Mapped graphs are not compressed
+        if (access(graphPath, F_OK) != 0 && pathExtension(inputFile, pathLength, "graph", 5, graphPath, 255) == 0) {
+            fprintf(stderr, "The given path is too long\n");
+            return EXIT_FAILURE;
+        }
     }
 
     if (outputPath[0] == '\0' && pathExtension(inputFile, pathLength, "fasta", 5, outputPath, 255) == 0) {
@@ -80,28 +145,26 @@ int main(int argc, char **argv) {
 
     // Objects that have to freed before
     // the end of the program
-    gzFile graphFp = NULL;
     FILE *inFp = NULL;
     FILE *outFp = NULL;
-    BloomFilter *bf = NULL;
+    DeBruijnGraph *graph = NULL;
 
     int result = EXIT_FAILURE;
 
-    if ((graphFp = gzopen(graphPath, "rb")) == NULL) {
-        log_error("Unable to open the graph file : %s", gzFileError(graphFp));
-        return EXIT_FAILURE;
-    }
+    // Only the filters loaded from a compressed graph are allocated, a mapped graph uses the pages of its file
+    bfSetAllocation(allocation);
+    numaSetPinning(pinThreads);
 
     log_info("Loading graph");
-    if ((bf = loadDBG(graphFp)) == NULL) {
+    if ((graph = openDBG(graphPath, nbThreads)) == NULL) {
         log_error("Unable to load graph from %s", graphPath);
         goto EXIT;
     }
 
-    gzclose(graphFp);
-    graphFp = NULL;
+    log_info("Done : kmer-size=%d", graph->k);
 
-    log_info("Done.");
+    // The kmers of the reads are hashed and canonicalized like the ones of the graph
+    useDBGKmerMode(graph);
 
     if ((inFp = fopen(inputFile, "r")) == NULL) {
         log_error("Unable to open %s", inputFile);
@@ -116,7 +179,7 @@ int main(int argc, char **argv) {
     }
 
     log_info("Decompressing file");
-    if (!decompressFileThreads(bf, inFp, outFp, 20)) {
+    if (!decompressFileThreads(graph, inFp, outFp, graph->k, groupSize)) {
         log_error("Decompression error");
         goto EXIT;
     }
@@ -126,10 +189,6 @@ int main(int argc, char **argv) {
     result = EXIT_SUCCESS;
 
 EXIT:
-    if (graphFp) {
-        gzclose(graphFp);
-    }
-
     if (inFp) {
         fclose(inFp);
     }
@@ -137,7 +196,7 @@ EXIT:
     if (outFp) {
         fclose(outFp);
     }
-    bfDelete(bf);
+    deleteDBG(graph);
 
     return result;
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "decompress_thread.h"
 
-#include "bloom_filter.h"
+#include "de_bruijn_graph.h"
 #include "fasta.h"
 #include "log.h"
+#include "numa.h"
 #include "queue.h"
 #include "getline.h"
 #include "vector.h"
@@ -14,12 +15,13 @@
 #include <pthread.h>
 
 typedef struct ThreadArgs {
-    struct BloomFilter *bf;
+    DeBruijnGraph *graph;
     FILE *out;
     Queue *workQueue;
     Queue *outQueue;
     int kmerLength;
     int readLength;
+    int groupSize;
 } ThreadArgs;
 
 typedef struct CompressedRead {
@@ -37,6 +39,9 @@ typedef struct DecompressedRead {
  * 
  * The given args should be a ThreadArgs structure.
  * 
+ * The reads are popped by groups of groupSize reads that are
+ * decompressed together (see decompressReads).
+ * 
  * @param voidArgs a pointer to a ThreadArgs structure
  * @return not used for now
  */
@@ -45,71 +50,113 @@ static void *decompressionWorker(void *voidArgs) {
 
     ThreadArgs *args = voidArgs;
 
-    Vector *branchings = vectorCreate(10, 1);
-
-    if (!branchings) {
-        log_error("oulala");
-        return NULL;
+    if (!numaPinThread()) {
+        log_warn("Unable to pin a decompression thread");
     }
 
+    int groupSize = args->groupSize;
     int readLength = args->readLength;
 
-    CompressedRead cr;
-    DecompressedRead dr;
-    Queue *queue = args->workQueue;
-
-    while (true) {
-        vectorClear(branchings);
+    CompressedRead *crs = calloc(groupSize, sizeof(*crs));
+    ReadWalk *walks = calloc(groupSize, sizeof(*walks));
 
-        if (!queuePop(queue, &cr)) {
-            log_error("Unable to pop an element from the work queue");
-            goto EXIT;
-        }
+    if (!crs || !walks) {
+        log_error("Unable to allocate a group of %d reads", groupSize);
+        goto EXIT;
+    }
 
-        // Delimiter that indicates the end of the thread
-        if (cr.id == -1) {
-            queuePush(queue, &cr);
-            log_debug("Stop worker at %ld", cr.id);
-            break;
-        }
+    for (int i = 0;i < groupSize;i++) {
+        walks[i].literals = vectorCreate(10, sizeof(ReadLiteral));
 
-        int nbBranchings;
-        if ((nbBranchings = extractBranchings(branchings, cr.read)) < 0) {
-            log_error("Unable to extract branchings");
+        if ((walks[i].branchings = vectorCreate(10, 1)) == NULL || walks[i].literals == NULL) {
+            log_error("Unable to create a new vector");
             goto EXIT;
         }
+    }
 
-        dr.id = cr.id;
-        dr.read = malloc(sizeof(*dr.read) * (readLength + 1));
-
-        if (!dr.read) {
-            log_error("Unable to allocate a buffer of length %d", readLength);
-            break;
+    Queue *queue = args->workQueue;
+    bool stop = false;
+
+    while (!stop) {
+        int n = 0;
+
+        while (n < groupSize) {
+            CompressedRead *cr = crs + n;
+
+            if (!queuePop(queue, cr)) {
+                log_error("Unable to pop an element from the work queue");
+                goto EXIT;
+            }
+
+            // Delimiter that indicates the end of the thread,
+            // the current group is still decompressed
+            if (cr->id == -1) {
+                queuePush(queue, cr);
+                log_debug("Stop worker at %ld", cr->id);
+                stop = true;
+                break;
+            }
+
+            ReadWalk *walk = walks + n;
+            n++;
+
+            vectorClear(walk->branchings);
+            vectorClear(walk->literals);
+
+            if (extractBranchings(walk->branchings, cr->read) < 0) {
+                log_error("Unable to extract branchings");
+                goto EXIT;
+            }
+
+            if (extractLiterals(walk->literals, cr->read) < 0) {
+                log_error("Unable to extract literals");
+                goto EXIT;
+            }
+
+            walk->read = malloc(sizeof(*walk->read) * (readLength + 1));
+
+            if (!walk->read) {
+                log_error("Unable to allocate a buffer of length %d", readLength);
+                goto EXIT;
+            }
+
+            walk->read[readLength] = '\0';
+            walk->readLength = readLength;
+            walk->firstKmer = cr->read;
         }
 
-        dr.read[readLength] = '\0';
-        if (!decompressRead(args->bf, branchings, dr.read, readLength, cr.read, args->kmerLength)) {
+        if (n > 0 && !decompressReads(args->graph, walks, n, args->kmerLength)) {
             log_error("Unable to decompress a read");
             goto EXIT;
         }
 
-        // Inserts the decompressed read into the
+        // Inserts the decompressed reads into the
         // output queue
-        if (!queuePush(args->outQueue, &dr)) {
-            log_error("Unable to push a read into the out queue");
-            goto EXIT;
-        }
+        for (int i = 0;i < n;i++) {
+            DecompressedRead dr = { .id = crs[i].id, .read = walks[i].read };
 
-        free(cr.read);
-        cr.read = NULL;
+            if (!queuePush(args->outQueue, &dr)) {
+                log_error("Unable to push a read into the out queue");
+                goto EXIT;
+            }
+
+            walks[i].read = NULL;
 
-        dr.read = NULL;
+            free(crs[i].read);
+            crs[i].read = NULL;
+        }
     }
 
 EXIT:
-    free(cr.read);
-    free(dr.read);
-    vectorDelete(branchings);
+    for (int i = 0;crs && walks && i < groupSize;i++) {
+        free(crs[i].read);
+        free(walks[i].read);
+        vectorDelete(walks[i].branchings);
+        vectorDelete(walks[i].literals);
+    }
+
+    free(crs);
+    free(walks);
 
     return NULL;
 }
@@ -157,12 +204,12 @@ static void *outputWorker(void *voidArgs) {
     return voidArgs;
 }
 
-bool decompressFileThreads(BloomFilter *bf, FILE *in, FILE *out, int k) {
-    assert(bf);
+bool decompressFileThreads(DeBruijnGraph *graph, FILE *in, FILE *out, int k, int groupSize) {
+    assert(graph);
     assert(in);
     assert(out);
     
-    if (k <= 0) {
+    if (k <= 0 || groupSize <= 0) {
         return false;
     }
 
@@ -179,10 +226,6 @@ bool decompressFileThreads(BloomFilter *bf, FILE *in, FILE *out, int k) {
     int c;
     while ((c = getc(in)) != EOF && c != '\n') { }
 
-    // A compressed read follows this format : "first_kmer branchings"
-    // Stores a space and a null character
-    size_t lineSize = readLength * 2 + 2;
-    
     // Queue for storing compressed reads from the main thread
     Queue *workQueue = queueCreate(800, sizeof(CompressedRead));
 
@@ -202,12 +245,13 @@ bool decompressFileThreads(BloomFilter *bf, FILE *in, FILE *out, int k) {
 
     // Threads arguments initialization
     ThreadArgs args;
-    args.bf = bf;
+    args.graph = graph;
     args.out = out;
     args.outQueue = outQueue;
     args.readLength = readLength;
     args.kmerLength = k;
     args.workQueue = workQueue;
+    args.groupSize = groupSize;
 
     // @TODO should be a function parameter
     int nbThreads = 4;
@@ -230,17 +274,13 @@ bool decompressFileThreads(BloomFilter *bf, FILE *in, FILE *out, int k) {
         }
     }
 
-    // Input file reading
+    // Input file reading, a compressed read follows this format :
+    // "first_kmer branchings [literals]"
     cr.id = 0;
     while (true) {
-        cr.read = malloc(lineSize);
-
-        if (!cr.read) {
-            log_error("Unable to allocate a buffer of size %ld", lineSize);
-            goto EXIT;
-        }
+        size_t lineSize = 0;
 
-        if (!fgets(cr.read, lineSize, in)) {
+        if (getline(&cr.read, &lineSize, in) <= 0) {
             break;
         }
         
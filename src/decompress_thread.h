@@ -4,8 +4,21 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-struct BloomFilter;
+struct DeBruijnGraph;
 
-bool decompressFileThreads(struct BloomFilter *bf, FILE *in, FILE *out, int k);
+/**
+ * \brief Decompresses reads into the output file with several threads
+ * 
+ * Each worker decompresses groups of groupSize reads together
+ * (see decompressReads), the order of the reads is not kept.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param in pointer to an input file
+ * @param out pointer to an output file
+ * @param k length of each kmer
+ * @param groupSize number of reads decompressed together by a worker
+ * @return true if no error occured, otherwise false
+ */
+bool decompressFileThreads(struct DeBruijnGraph *graph, FILE *in, FILE *out, int k, int groupSize);
 
 #endif // DECOMPRESS_THREAD_H
\ No newline at end of file
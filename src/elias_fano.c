@@ -0,0 +1,142 @@
+#include "elias_fano.h"
+
+#include <string.h>
+
+/**
+ * \brief Gets the number of 64 bits words that contain n bits
+ */
+#define efWords(n) (((n) + 63) / 64)
+
+/**
+ * \brief Gets the size (in bits) of the high bits array of the encoding
+ *
+ * The i-th position sets the bit high + i, where high is at most (universe - 1) >> lowBits.
+ * The array is empty when no bit is set.
+ */
+#define efHighBits(n, universe, lowBits) (((n) > 0) ? (n) + ((universe) >> (lowBits)) : 0)
+
+int efLowBits(uint64_t n, uint64_t universe) {
+    if (n == 0 || universe <= n) {
+        return 0;
+    }
+
+    // floor(log2(universe / n))
+    return 63 - __builtin_clzll(universe / n);
+}
+
+uint64_t efEncodedSize(uint64_t n, uint64_t universe) {
+    int lowBits = efLowBits(n, universe);
+
+    return 8 * (efWords(n * lowBits) + efWords(efHighBits(n, universe, lowBits)));
+}
+
+uint64_t efCountBits(const char *bits, uint64_t len) {
+    uint64_t count = 0;
+    uint64_t i = 0;
+
+    for (;i + 8 <= len;i += 8) {
+        uint64_t word;
+        memcpy(&word, bits + i, sizeof(word));
+        count += __builtin_popcountll(word);
+    }
+
+    for (;i < len;i++) {
+        count += __builtin_popcount((unsigned char) bits[i]);
+    }
+
+    return count;
+}
+
+void efEncode(const char *bits, uint64_t len, uint64_t n, uint64_t *encoded) {
+    uint64_t universe = 8 * len;
+    int lowBits = efLowBits(n, universe);
+
+    uint64_t *low = encoded;
+    uint64_t *high = encoded + efWords(n * lowBits);
+
+    memset(encoded, 0, efEncodedSize(n, universe));
+
+    uint64_t lowMask = (lowBits > 0) ? UINT64_MAX >> (64 - lowBits) : 0;
+    uint64_t i = 0;
+
+    for (uint64_t start = 0;start < len && i < n;start += 8) {
+        uint64_t end = (len - start > 8) ? start + 8 : len;
+
+        // Most words of a sparse bitvector are empty
+        if (end - start == 8) {
+            uint64_t word;
+            memcpy(&word, bits + start, sizeof(word));
+
+            if (word == 0) {
+                continue;
+            }
+        }
+
+        for (uint64_t byte = start;byte < end && i < n;byte++) {
+            for (unsigned char value = bits[byte];value != 0 && i < n;value &= value - 1) {
+                uint64_t position = 8 * byte + __builtin_ctz(value);
+
+                if (lowBits > 0) {
+                    uint64_t bit = i * lowBits;
+                    uint64_t lowValue = position & lowMask;
+                    int shift = bit % 64;
+
+                    low[bit / 64] |= lowValue << shift;
+                    if (shift + lowBits > 64) {
+                        low[bit / 64 + 1] |= lowValue >> (64 - shift);
+                    }
+                }
+
+                uint64_t highBit = (position >> lowBits) + i;
+                high[highBit / 64] |= (uint64_t) 1 << (highBit % 64);
+
+                i++;
+            }
+        }
+    }
+}
+
+bool efDecode(const uint64_t *encoded, uint64_t n, char *bits, uint64_t len) {
+    uint64_t universe = 8 * len;
+    int lowBits = efLowBits(n, universe);
+
+    const uint64_t *low = encoded;
+    const uint64_t *high = encoded + efWords(n * lowBits);
+    uint64_t nbHighWords = efWords(efHighBits(n, universe, lowBits));
+
+    uint64_t lowMask = (lowBits > 0) ? UINT64_MAX >> (64 - lowBits) : 0;
+    uint64_t i = 0;
+
+    for (uint64_t w = 0;w < nbHighWords;w++) {
+        for (uint64_t word = high[w];word != 0;word &= word - 1) {
+            if (i >= n) {
+                return false;
+            }
+
+            uint64_t highValue = 64 * w + __builtin_ctzll(word) - i;
+            uint64_t lowValue = 0;
+
+            if (lowBits > 0) {
+                uint64_t bit = i * lowBits;
+                int shift = bit % 64;
+
+                lowValue = low[bit / 64] >> shift;
+                if (shift + lowBits > 64) {
+                    lowValue |= low[bit / 64 + 1] << (64 - shift);
+                }
+                lowValue &= lowMask;
+            }
+
+            uint64_t position = (highValue << lowBits) | lowValue;
+
+            if (position >= universe) {
+                return false;
+            }
+
+            bits[position / 8] |= 1 << (position % 8);
+            i++;
+        }
+    }
+
+    return i == n;
+}
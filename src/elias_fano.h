@@ -0,0 +1,72 @@
+#ifndef ELIAS_FANO_H
+#define ELIAS_FANO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \brief Gets the number of low bits of the positions stored by the encoding
+ *
+ * Each one of the n positions of a bitvector of universe bits is split into
+ * its low bits, stored as they are, and its high bits, stored in unary. The
+ * encoding then uses about n * (2 + log2(universe / n)) bits.
+ *
+ * @param n number of set bits
+ * @param universe size of the bitvector (in bits)
+ * @return the number of low bits, between 0 and 63
+ */
+int efLowBits(uint64_t n, uint64_t universe);
+
+/**
+ * \brief Gets the size (in bytes) of the encoding of a bitvector
+ *
+ * The size is a multiple of 8 bytes.
+ *
+ * @param n number of set bits
+ * @param universe size of the bitvector (in bits)
+ * @return the size of the encoding (in bytes)
+ */
+uint64_t efEncodedSize(uint64_t n, uint64_t universe);
+
+/**
+ * \brief Counts the set bits of a bitvector
+ *
+ * The bit i of the bitvector is the bit i % 8 of its byte i / 8.
+ *
+ * @param bits a pointer to the bitvector
+ * @param len size of the bitvector (in bytes)
+ * @return the number of set bits
+ */
+uint64_t efCountBits(const char *bits, uint64_t len);
+
+/**
+ * \brief Encodes the positions of the set bits of a bitvector with the Elias-Fano encoding
+ *
+ * The encoding is made of two arrays of 64 bits words : the low bits of the positions
+ * (see efLowBits), packed in increasing order of the positions, followed by the high bits.
+ * The bit high + i of the second array is set for the i-th position. Words are stored
+ * with the byte order of the computer.
+ *
+ * @param bits a pointer to the bitvector
+ * @param len size of the bitvector (in bytes)
+ * @param n number of set bits of the bitvector (see efCountBits)
+ * @param encoded destination of the encoding, of efEncodedSize(n, 8 * len) bytes
+ */
+void efEncode(const char *bits, uint64_t len, uint64_t n, uint64_t *encoded);
+
+/**
+ * \brief Sets the bits of a bitvector whose positions were encoded by efEncode
+ *
+ * The other bits of the bitvector are not changed. If the encoding does not contain
+ * exactly n positions or if a position is outside the bitvector, then false will be
+ * returned, the bitvector may then be partially filled.
+ *
+ * @param encoded a pointer to the encoding, of efEncodedSize(n, 8 * len) bytes
+ * @param n number of set bits
+ * @param bits a pointer to the bitvector
+ * @param len size of the bitvector (in bytes)
+ * @return true if the encoding is valid, otherwise false
+ */
+bool efDecode(const uint64_t *encoded, uint64_t n, char *bits, uint64_t len);
+
+#endif // ELIAS_FANO_H
@@ -0,0 +1,95 @@
+#include "fast_hash.h"
+
+#include <string.h>
+
+// Secrets of wyhash, odd numbers with half of their bits set
+static const uint64_t fastHashSecrets[4] = {
+    0x2d358dccaa6c78a5ULL,
+    0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL,
+    0x4d5a2da51de1aa47ULL
+};
+
+/**
+ * \brief Multiplies two 64 bits integers and folds the 128 bits product
+ */
+static inline uint64_t mix(uint64_t a, uint64_t b) {
+    unsigned __int128 product = (unsigned __int128) a * b;
+
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
+
+static inline uint64_t read64(const uint8_t *bytes) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+
+    return value;
+}
+
+static inline uint64_t read32(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+
+    return value;
+}
+
+uint64_t fastHash64(const void *key, size_t len, uint64_t seed) {
+    const uint8_t *bytes = key;
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    seed ^= mix(seed ^ fastHashSecrets[0], fastHashSecrets[1]);
+
+    if (len <= 16) {
+        // Short keys are read with overlapping loads
+        if (len >= 4) {
+            size_t middle = (len >> 3) << 2;
+
+            a = (read32(bytes) << 32) | read32(bytes + middle);
+            b = (read32(bytes + len - 4) << 32) | read32(bytes + len - 4 - middle);
+        }
+        else if (len > 0) {
+            a = ((uint64_t) bytes[0] << 16) | ((uint64_t) bytes[len >> 1] << 8) | bytes[len - 1];
+        }
+    }
+    else {
+        size_t remaining = len;
+
+        // Three independent lanes for long keys
+        if (remaining > 48) {
+            uint64_t seed1 = seed;
+            uint64_t seed2 = seed;
+
+            do {
+                seed = mix(read64(bytes) ^ fastHashSecrets[1], read64(bytes + 8) ^ seed);
+                seed1 = mix(read64(bytes + 16) ^ fastHashSecrets[2], read64(bytes + 24) ^ seed1);
+                seed2 = mix(read64(bytes + 32) ^ fastHashSecrets[3], read64(bytes + 40) ^ seed2);
+
+                bytes += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+
+            seed ^= seed1 ^ seed2;
+        }
+
+        while (remaining > 16) {
+            seed = mix(read64(bytes) ^ fastHashSecrets[1], read64(bytes + 8) ^ seed);
+
+            bytes += 16;
+            remaining -= 16;
+        }
+
+        // The last 16 bytes of the key, they can overlap the previous ones
+        a = read64(bytes + remaining - 16);
+        b = read64(bytes + remaining - 8);
+    }
+
+    a ^= fastHashSecrets[1];
+    b ^= seed;
+
+    unsigned __int128 product = (unsigned __int128) a * b;
+    a = (uint64_t) product;
+    b = (uint64_t) (product >> 64);
+
+    return mix(a ^ fastHashSecrets[0] ^ len, b ^ fastHashSecrets[1]);
+}
@@ -0,0 +1,40 @@
+#ifndef FAST_HASH_H
+#define FAST_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \brief Mixes the bits of a 64 bits integer
+ *
+ * This is the finalizer of SplitMix64 : each bit of the result depends on all bits
+ * of the value. The function is a bijection, so distinct values always give distinct
+ * hashes, for instance kmers of at most KMER_MAX_SIZE bases packed on 64 bits.
+ *
+ * @param value a 64 bits integer
+ * @return the hash of the value
+ */
+static inline uint64_t fastHashMix64(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+
+    return value ^ (value >> 31);
+}
+
+/**
+ * \brief Computes the 64 bits hash of an array of bytes
+ *
+ * The hash function is the one of wyhash : the bytes are read 16 at a time, and each
+ * group is mixed with a 64 x 64 bits multiplication whose two halves are xored together.
+ * It is much faster than MurmurHash3 for short keys.
+ *
+ * @param key pointer to the first byte
+ * @param len number of bytes
+ * @param seed seed of the hash function
+ * @return the hash of the bytes
+ */
+uint64_t fastHash64(const void *key, size_t len, uint64_t seed);
+
+#endif // FAST_HASH_H
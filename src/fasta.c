@@ -1,28 +1,34 @@
 #include "fasta.h"
 
-#include "bloom_filter.h"
+#include "de_bruijn_graph.h"
 #include "getline.h"
+#include "kmer.h"
+#include "kmer_hash.h"
 #include "log.h"
 #include "utils.h"
 #include "vector.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
-bool compressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
-    assert(bf);
+bool compressFile(DeBruijnGraph *graph, FILE *in, FILE *out, int k) {
+    assert(graph);
     assert(in);
     assert(out);
 
-    if (k <= 0) {
+    if (k <= 0 || k > KMER128_MAX_SIZE) {
         return false;
     }
 
     Vector *v = vectorCreate(100, 1);
+    Vector *literals = vectorCreate(10, sizeof(ReadLiteral));
 
-    if (!v) {
+    if (!v || !literals) {
         log_error("Unable to create a new vector");
+        vectorDelete(v);
+        vectorDelete(literals);
         return false;
     }
 
@@ -46,52 +52,133 @@ bool compressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
         }
 
         vectorClear(v);
-        if (!computeBranchings(bf, v, line, result, k)) {
+        vectorClear(literals);
+        if (!computeBranchings(graph, v, literals, line, result, k)) {
             log_error("branchings computation error");
             break;
         }
 
-        fprintf(out, "%.*s %.*s\n", k, line, (int) vectorSize(v), (char*) vectorRawValues(v));
+        fprintf(out, "%.*s %.*s", k, line, (int) vectorSize(v), (char*) vectorRawValues(v));
+
+        if (vectorSize(literals) > 0) {
+            ReadLiteral *values = vectorRawValues(literals);
+            fputc(' ', out);
+
+            for (size_t i = 0;i < vectorSize(literals);i++) {
+                // Starts a new run
+                if (i == 0 || values[i].position != values[i - 1].position + 1) {
+                    fprintf(out, "%d", values[i].position);
+                }
+
+                fputc(values[i].letter, out);
+            }
+        }
+
+        fputc('\n', out);
     }
 
     free(line);
     vectorDelete(v);
+    vectorDelete(literals);
 
     return true;
 }
 
-bool computeBranchings(BloomFilter *bf, Vector *branchings, char *seq, int len, int k) {
-    assert(bf);
-    assert(branchings);
-    assert(seq);
-
-    if (len <= 0 || k <= 0 || k > len) {
-        return false;
+/**
+ * \brief Computes the branchings of a sequence (see computeBranchings)
+ * 
+ * This function is always inlined, so that it is compiled with a constant k
+ * for each length of FASTA_SPECIALIZED_SIZES. The kmers are packed on 128 bits
+ * only when they are longer than KMER_MAX_SIZE.
+ */
+static inline __attribute__((always_inline)) bool branchingsKernel(DeBruijnGraph *graph,
+    Vector *branchings, Vector *literals, char *seq, int len, int k) {
+    Kmer kmer = 0;
+    Kmer128 kmer128 = 0;
+    KmerHash hash;
+
+    if (k > KMER_MAX_SIZE) {
+        kmer128Encode(seq, k, &kmer128);
+        kmerHashInit128(&hash, kmer128, k);
+    }
+    else {
+        kmerEncode(seq, k, &kmer);
+        kmerHashInit(&hash, kmer, k);
     }
 
     char neighbors[4];
 
     for (int i = 0;i < len - k - 1;i++) {
-        int nbNeighbors = findNeighbors(bf, seq + i, k, neighbors);
+        int nbNeighbors = (k > KMER_MAX_SIZE)
+            ? findKmer128Neighbors(graph, kmer128, &hash, k, neighbors)
+            : findKmerNeighbors(graph, kmer, &hash, k, neighbors);
 
         if (nbNeighbors < 0) {
             return false;
         }
 
-        if (nbNeighbors == 0) {
-            break;
+        if (!memchr(neighbors, seq[i + k], nbNeighbors)) {
+            // The next kmer is not in the graph
+            ReadLiteral literal = { .position = i, .letter = seq[i + k] };
+
+            if (!literals) {
+                log_error("Kmer %.*s is not in the graph", k, seq + i + 1);
+                return false;
+            }
+
+            if (!vectorPush(literals, &literal)) {
+                log_error("vector push error");
+                return false;
+            }
         }
         else if (nbNeighbors > 1 && !vectorPush(branchings, seq + i + k)) {
             log_error("vector push error");
             return false;
         }
+
+        uint8_t base = kmerEncodeBase(seq[i + k]);
+
+        if (k > KMER_MAX_SIZE) {
+            hash = kmerHashRoll(&hash, kmer128FirstBase(kmer128, k), base, k);
+            kmer128 = kmer128Append(kmer128, base, k);
+        }
+        else {
+            hash = kmerHashRoll(&hash, kmerFirstBase(kmer, k), base, k);
+            kmer = kmerAppend(kmer, base, k);
+        }
     }
 
     return true;
 }
 
-bool decompressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
-    assert(bf);
+#define DEFINE_BRANCHINGS(K) \
+    static bool computeBranchings##K(DeBruijnGraph *graph, Vector *branchings, Vector *literals, char *seq, int len) { \
+        return branchingsKernel(graph, branchings, literals, seq, len, K); \
+    }
+
+FASTA_SPECIALIZED_SIZES(DEFINE_BRANCHINGS)
+
+bool computeBranchings(DeBruijnGraph *graph, Vector *branchings, Vector *literals, char *seq, int len, int k) {
+    assert(graph);
+    assert(branchings);
+    assert(seq);
+
+    if (len <= 0 || k <= 0 || k > len || k > KMER128_MAX_SIZE) {
+        return false;
+    }
+
+    switch (k) {
+#define CASE_BRANCHINGS(K) case K: return computeBranchings##K(graph, branchings, literals, seq, len);
+        FASTA_SPECIALIZED_SIZES(CASE_BRANCHINGS)
+#undef CASE_BRANCHINGS
+
+        default:
+            return branchingsKernel(graph, branchings, literals, seq, len, k);
+    }
+}
+
+bool decompressFile(DeBruijnGraph *graph, FILE *in, FILE *out, int k) {
+    assert(graph);
     assert(in);
     assert(out);
 
@@ -104,6 +191,7 @@ bool decompressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
     size_t size = 0;
     char *read = NULL;
     Vector *branchings = NULL;
+    Vector *literals = NULL;
 
     ssize_t lineLength = getline(&line, &size, in);
 
@@ -128,13 +216,14 @@ bool decompressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
 
     read = malloc(readLength + 1);
     branchings = vectorCreate(readLength - k, 1);
+    literals = vectorCreate(10, sizeof(ReadLiteral));
 
     if (!read) {
         log_error("Allocation error");
         goto EXIT;
     }
 
-    if (!branchings) {
+    if (!branchings || !literals) {
         log_error("Unable to create a new vector");
         goto EXIT;
     }
@@ -144,6 +233,7 @@ bool decompressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
     size_t readIndex = 0;
     while ((lineLength = getline(&line, &size, in)) > 0) {
         vectorClear(branchings);
+        vectorClear(literals);
 
         int nbBranchings;
         if ((nbBranchings = extractBranchings(branchings, line)) < 0) {
@@ -151,9 +241,14 @@ bool decompressFile(BloomFilter *bf, FILE *in, FILE *out, int k) {
             goto EXIT;
         }
 
+        if (extractLiterals(literals, line) < 0) {
+            log_error("Unable to extract literals");
+            goto EXIT;
+        }
+
         // @TODO check that the read length equals k
 
-        if (!decompressRead(bf, branchings, read, readLength, line, k)) {
+        if (!decompressRead(graph, branchings, literals, read, readLength, line, k)) {
             log_error("Decompression error");
             goto EXIT;
         }
@@ -168,89 +263,306 @@ EXIT:
     free(line);
     free(read);
     vectorDelete(branchings);
+    vectorDelete(literals);
 
     return result;
 }
 
-bool decompressRead(BloomFilter *bf, Vector *branchings, char *read, int readLength, const char *firstKmer, int k) {
-    assert(bf);
+bool decompressRead(DeBruijnGraph *graph, Vector *branchings, Vector *literals,
+    char *read, int readLength, const char *firstKmer, int k) {
+    assert(graph);
     assert(branchings);
     assert(read);
     assert(firstKmer);
 
-    if (readLength <= 0 || k <= 0) {
+    ReadWalk walk = {
+        .branchings = branchings,
+        .literals = literals,
+        .read = read,
+        .readLength = readLength,
+        .firstKmer = firstKmer
+    };
+
+    return decompressReads(graph, &walk, 1, k);
+}
+
+/**
+ * \brief Starts the walk of a read from its first kmer
+ * 
+ * @param walk a pointer to a ReadWalk structure
+ * @param k length of each kmer
+ * @return true if the walk could start, otherwise false
+ */
+static bool walkStart(ReadWalk *walk, int k) {
+    assert(walk->branchings);
+    assert(walk->read);
+    assert(walk->firstKmer);
+
+    if (walk->readLength <= 0) {
         return false;
     }
 
-    char *kmer = malloc(k);
-    bool result = false;
+    if (k > KMER_MAX_SIZE) {
+        if (!kmer128Encode(walk->firstKmer, k, &walk->kmer128)) {
+            log_error("Invalid kmer length %d", k);
+            return false;
+        }
 
-    if (!kmer) {
-        log_error("Allocation failed");
-        return false;
+        kmerHashInit128(&walk->hash, walk->kmer128, k);
     }
+    else {
+        if (!kmerEncode(walk->firstKmer, k, &walk->kmer)) {
+            log_error("Invalid kmer length %d", k);
+            return false;
+        }
 
-    memcpy(kmer, firstKmer, k);
-    memcpy(read, kmer, k);
+        kmerHashInit(&walk->hash, walk->kmer, k);
+    }
 
-    char neighbors[4];
-    int nextBranching = 0;
+    memcpy(walk->read, walk->firstKmer, k);
+    walk->position = 0;
+    walk->nextBranching = 0;
+    walk->nextLiteral = 0;
 
-    for (int i = 0;i < readLength - k;i++) {
-        int nbNeighbors = findNeighbors(bf, kmer, k, neighbors);
-        int neighborIndex = -1;
+    return true;
+}
 
-        if (nbNeighbors > 1) {
-            char *pBranching = NULL;
+/**
+ * \brief Gets the literal of the current position of a read
+ * 
+ * @param walk a pointer to a ReadWalk structure
+ * @return the literal or NULL if the next letter is given by the graph
+ */
+static ReadLiteral *walkLiteral(ReadWalk *walk) {
+    if (!walk->literals || (size_t) walk->nextLiteral >= vectorSize(walk->literals)) {
+        return NULL;
+    }
 
-            if ((pBranching = vectorAt(branchings, nextBranching)) == NULL) {
-                log_error("Unable to get branching at index %d, vector size=%ld", nextBranching, vectorSize(branchings));
-                goto EXIT;
-            }
+    ReadLiteral *literal = vectorAt(walk->literals, walk->nextLiteral);
 
-            char branchingValue = *pBranching;
+    return (literal->position == walk->position) ? literal : NULL;
+}
 
-            // Checks if the current branching corresponds to one of the kmer neighbors
-            for (int j = 0;j < nbNeighbors && neighborIndex == -1;j++) {
-                if (branchingValue == neighbors[j]) {
-                    neighborIndex = j;
-                }
+/**
+ * \brief Appends a letter to a read and moves its current kmer forward
+ * 
+ * @param walk a pointer to a ReadWalk structure
+ * @param letter next letter of the read
+ * @param k length of each kmer
+ */
+static inline __attribute__((always_inline)) void walkAppend(ReadWalk *walk, char letter, int k) {
+    // Moves kmer to the left, its first letter will be lost
+    // and replaced by the new letter
+    uint8_t base = kmerEncodeBase(letter);
+
+    if (k > KMER_MAX_SIZE) {
+        walk->hash = kmerHashRoll(&walk->hash, kmer128FirstBase(walk->kmer128, k), base, k);
+        walk->kmer128 = kmer128Append(walk->kmer128, base, k);
+    }
+    else {
+        walk->hash = kmerHashRoll(&walk->hash, kmerFirstBase(walk->kmer, k), base, k);
+        walk->kmer = kmerAppend(walk->kmer, base, k);
+    }
+    walk->read[walk->position + k] = letter;
+    walk->position++;
+}
+
+/**
+ * \brief Moves a read forward by one letter
+ * 
+ * The next letter is the only neighbor of the current kmer,
+ * or the next branching if the kmer has several neighbors.
+ * 
+ * @param walk a pointer to a ReadWalk structure
+ * @param neighbors neighbors of the current kmer
+ * @param nbNeighbors number of neighbors
+ * @param k length of each kmer
+ * @return true if the next letter was found, otherwise false
+ */
+static inline __attribute__((always_inline)) bool walkStep(ReadWalk *walk, const char *neighbors, int nbNeighbors, int k) {
+    int neighborIndex = -1;
+
+    if (nbNeighbors > 1) {
+        char *pBranching = NULL;
+
+        if ((pBranching = vectorAt(walk->branchings, walk->nextBranching)) == NULL) {
+            log_error("Unable to get branching at index %d, vector size=%ld", walk->nextBranching, vectorSize(walk->branchings));
+            return false;
+        }
+
+        char branchingValue = *pBranching;
+
+        // Checks if the current branching corresponds to one of the kmer neighbors
+        for (int j = 0;j < nbNeighbors && neighborIndex == -1;j++) {
+            if (branchingValue == neighbors[j]) {
+                neighborIndex = j;
             }
+        }
 
-            if (neighborIndex == -1) {
-                log_error("Branching error, index=%ld\npartial read=%.*s\navailable neighbors : %.*s", i, i, read, nbNeighbors, neighbors);
-                return false;
+        if (neighborIndex == -1) {
+            log_error("Branching error, index=%d\npartial read=%.*s\navailable neighbors : %.*s",
+                walk->position, walk->position, walk->read, nbNeighbors, neighbors);
+            return false;
+        }
+
+        walk->nextBranching++;
+    }
+    else if (nbNeighbors == 1) {
+        neighborIndex = 0;
+    }
+    else {
+        log_error("Kmer without neighbors at %d, kmer=%.*s", walk->position, k, walk->firstKmer);
+        return false;
+    }
+
+    walkAppend(walk, neighbors[neighborIndex], k);
+
+    return true;
+}
+
+/**
+ * \brief Decompresses a group of at most FASTA_WALK_GROUP reads
+ * 
+ * This function is always inlined, so that it is compiled with
+ * a constant k for each length of FASTA_SPECIALIZED_SIZES.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param walks array of n started reads
+ * @param n number of reads
+ * @param k length of each kmer
+ * @return true if all reads were decompressed, otherwise false
+ */
+static inline __attribute__((always_inline)) bool walkGroup(DeBruijnGraph *graph, ReadWalk *walks, int n, int k) {
+    ReadWalk *active[FASTA_WALK_GROUP];
+    Kmer kmers[FASTA_WALK_GROUP];
+    Kmer128 kmers128[FASTA_WALK_GROUP];
+    KmerHash hashes[FASTA_WALK_GROUP];
+    bool found[FASTA_WALK_GROUP * 4];
+
+    while (true) {
+        int nbActive = 0;
+
+        for (int i = 0;i < n;i++) {
+            ReadLiteral *literal;
+
+            // Literals do not need the graph
+            while (walks[i].position < walks[i].readLength - k && (literal = walkLiteral(walks + i)) != NULL) {
+                walkAppend(walks + i, literal->letter, k);
+                walks[i].nextLiteral++;
             }
 
-            nextBranching++;
+            if (walks[i].position < walks[i].readLength - k) {
+                if (k > KMER_MAX_SIZE) {
+                    kmers128[nbActive] = walks[i].kmer128;
+                }
+                else {
+                    kmers[nbActive] = walks[i].kmer;
+                }
+
+                hashes[nbActive] = walks[i].hash;
+                active[nbActive++] = walks + i;
+            }
         }
-        else if (nbNeighbors == 1) {
-            neighborIndex = 0;
+
+        if (nbActive == 0) {
+            return true;
         }
-        else if (i == readLength - k) {
-            // It was the last kmer
-            break;
+
+        // The neighbors of all active reads are looked up at once
+        if (k > KMER_MAX_SIZE) {
+            containsSuccessors128(graph, kmers128, hashes, nbActive, k, found);
         }
         else {
-            // Error
-            log_error("Kmer without neighbors at %d, kmer=%.*s", i, k, firstKmer);
-            goto EXIT;
+            containsSuccessors(graph, kmers, hashes, nbActive, k, found);
         }
 
-        // Moves kmer to the left, its first letter will be lost
-        memcpy(kmer, kmer + 1, k - 1);
+        for (int i = 0;i < nbActive;i++) {
+            char neighbors[4];
+            int nbNeighbors = 0;
 
-        // replaces the last letter by the neighbor
-        kmer[k - 1] = neighbors[neighborIndex];
-        read[i + k] = neighbors[neighborIndex];
+            for (uint8_t base = 0;base < 4;base++) {
+                if (found[i * 4 + base]) {
+                    neighbors[nbNeighbors++] = kmerDecodeBase(base);
+                }
+            }
+
+            if (!walkStep(active[i], neighbors, nbNeighbors, k)) {
+                return false;
+            }
+        }
     }
+}
 
-    result = true;
+#define DEFINE_WALK_GROUP(K) \
+    static bool walkGroup##K(DeBruijnGraph *graph, ReadWalk *walks, int n) { \
+        return walkGroup(graph, walks, n, K); \
+    }
 
-EXIT:
-    free(kmer);
+FASTA_SPECIALIZED_SIZES(DEFINE_WALK_GROUP)
+
+/**
+ * \brief Decompresses a group of reads with the walk compiled for their kmer length
+ * 
+ * See walkGroup.
+ */
+static bool walkAnyGroup(DeBruijnGraph *graph, ReadWalk *walks, int n, int k) {
+    switch (k) {
+#define CASE_WALK_GROUP(K) case K: return walkGroup##K(graph, walks, n);
+        FASTA_SPECIALIZED_SIZES(CASE_WALK_GROUP)
+#undef CASE_WALK_GROUP
+
+        default:
+            return walkGroup(graph, walks, n, k);
+    }
+}
 
-    return result;
+bool decompressReads(DeBruijnGraph *graph, ReadWalk *walks, int n, int k) {
+    assert(graph);
+    assert(walks);
+
+    if (k <= 0) {
+        return false;
+    }
+
+    for (int i = 0;i < n;i++) {
+        if (!walkStart(walks + i, k)) {
+            return false;
+        }
+    }
+
+    for (int first = 0;first < n;first += FASTA_WALK_GROUP) {
+        int size = (n - first < FASTA_WALK_GROUP) ? n - first : FASTA_WALK_GROUP;
+
+        if (!walkAnyGroup(graph, walks + first, size, k)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ssize_t readSequence(char **line, size_t *length, FILE *fp) {
+    assert(line);
+    assert(length);
+    assert(fp);
+
+    ssize_t lineLength;
+
+    while ((lineLength = getline(line, length, fp)) > 0) {
+        // Skips headers
+        if (**line == '>') {
+            continue;
+        }
+
+        // The end of line is not a part of the read
+        while (lineLength > 0 && ((*line)[lineLength - 1] == '\n' || (*line)[lineLength - 1] == '\r')) {
+            lineLength--;
+        }
+
+        return lineLength;
+    }
+
+    return -1;
 }
 
 int extractBranchings(Vector *branchings, const char *line) {
@@ -266,7 +578,7 @@ int extractBranchings(Vector *branchings, const char *line) {
     }
 
     char *nextBranching = kmerEnd + 1;
-    while (*nextBranching != '\0' && *nextBranching != '\n') {
+    while (*nextBranching != '\0' && *nextBranching != '\n' && *nextBranching != ' ') {
         if (!vectorPush(branchings, nextBranching)) {
             log_error("Unable to push a new branching into the vector");
             return -1;
@@ -276,4 +588,54 @@ int extractBranchings(Vector *branchings, const char *line) {
     }
 
     return nextBranching - kmerEnd - 1;
-}
\ No newline at end of file
+}
+
+int extractLiterals(Vector *literals, const char *line) {
+    assert(literals);
+    assert(line);
+
+    // The literals follow the second space
+    const char *branchingsStart = strchr(line, ' ');
+    const char *literalsStart = branchingsStart ? strchr(branchingsStart + 1, ' ') : NULL;
+
+    if (!literalsStart) {
+        return 0;
+    }
+
+    int nbLiterals = 0;
+    ReadLiteral literal = { .position = -1 };
+
+    for (const char *c = literalsStart + 1;*c != '\0' && *c != '\n';c++) {
+        if (*c >= '0' && *c <= '9') {
+            // Starts a new run of literals
+            char *end;
+            long position = strtol(c, &end, 10);
+
+            if (position < 0 || position > INT_MAX || position < literal.position) {
+                log_error("Invalid literal position %ld", position);
+                return -1;
+            }
+
+            literal.position = position;
+            c = end - 1;
+            continue;
+        }
+
+        if (literal.position < 0) {
+            log_error("Missing position of the literal %c", *c);
+            return -1;
+        }
+
+        literal.letter = *c;
+
+        if (!vectorPush(literals, &literal)) {
+            log_error("Unable to push a new literal into the vector");
+            return -1;
+        }
+
+        literal.position++;
+        nbLiterals++;
+    }
+
+    return nbLiterals;
+}
@@ -4,21 +4,81 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <sys/types.h>
 
-struct BloomFilter;
+#include "kmer.h"
+#include "kmer_hash.h"
+
+struct DeBruijnGraph;
 struct Vector;
 
+/**
+ * \brief Maximum number of reads walked together by decompressReads
+ */
+#define FASTA_WALK_GROUP 16
+
+/**
+ * \brief Applies a macro to the kmer lengths whose walks are compiled with a constant length
+ * 
+ * The masks, shifts and rotations of each step of computeBranchings and
+ * decompressReads are then immediate values. The other lengths are walked
+ * by the same code with a length known at runtime.
+ */
+#define FASTA_SPECIALIZED_SIZES(X) X(21) X(25) X(31) X(63)
+
+/**
+ * \brief Letter of a read that is not given by the graph
+ * 
+ * A literal is needed when the next kmer of a read is not in the graph,
+ * for example when it contains a sequencing error that was not
+ * a solid kmer (see createSolidDBG).
+ */
+typedef struct ReadLiteral {
+    // Index of the first letter of the kmer followed by the literal
+    int position;
+    char letter;
+} ReadLiteral;
+
+/**
+ * \brief State of a read decompressed by decompressReads
+ * 
+ * The caller sets the first five fields, the other ones
+ * are updated at each step of the walk.
+ */
+typedef struct ReadWalk {
+    // Branchings of the compressed read
+    struct Vector *branchings;
+    // Literals of the compressed read in increasing positions, could be NULL
+    struct Vector *literals;
+    // Destination of the read, must be able to store readLength letters
+    char *read;
+    int readLength;
+    // The read starts with this kmer
+    const char *firstKmer;
+
+    // Current kmer, packed on 128 bits in kmer128 if k is greater than KMER_MAX_SIZE
+    Kmer kmer;
+    Kmer128 kmer128;
+    KmerHash hash;
+    // Index of the first letter of the current kmer
+    int position;
+    int nextBranching;
+    int nextLiteral;
+} ReadWalk;
+
 /**
  * \brief Compresses the sequences of the input file into the output file
  * 
- * The given Bloom filter must contain all kmers of length k of all reads
+ * The filter of the given graph must contain all kmers of length k of all reads
  * contained in the input file.
  * 
  * The input file must be opened in reading mode.
  * The output file must be opened in writing mode.
  * 
- * The length of each kmer k must be strictely positive and less or equal than
- * the length of all reads. False will be returned if it is not the case.
+ * The length of each kmer k must be strictely positive, less or equal than
+ * the length of all reads and less or equal to the maximum length of the
+ * kmers of the graph (see dbgMaxKmerSize).
+ * False will be returned if it is not the case.
  * 
  * All headers of the input file will be skipped.
  * All reads of the input file must have the same length.
@@ -28,34 +88,43 @@ struct Vector;
  * may be followed by zero or more branchings.
  * A space separates the first kmer from the branchings, even if the read
  * does not have branchings.
+ * The literals of the read, if any, follow the branchings after another space.
+ * They are written as runs of consecutive literals : the position of
+ * the first literal of the run followed by the letters of the run.
  * 
  * The user will have to close the two files.
  * 
- * @param bf a pointer to a Bloom filter structure
+ * @param graph a pointer to a DeBruijnGraph structure
  * @param in file pointer to the input file
  * @param out file pointer to the output file
  * @param k length of a kmer
  * @return true if no error occured, otherwise false
  * */
-bool compressFile(struct BloomFilter *bf, FILE *in, FILE *out, int k);
+bool compressFile(struct DeBruijnGraph *graph, FILE *in, FILE *out, int k);
 
 /**
  * \brief Computes branchings that are required to find the original
  * sequence with its first kmer of length k
  * 
- * The length of each kmer k must be strictely positive and less or equal to len.
+ * The length of each kmer k must be strictely positive, less or equal to len
+ * and less or equal to KMER128_MAX_SIZE. The kmers are packed on 128 bits
+ * only when k is greater than KMER_MAX_SIZE, and the most common lengths
+ * (see FASTA_SPECIALIZED_SIZES) are walked by code compiled for them.
  * 
- * When a kmer has several neighbors in the Bloom filter then a branching is required.
+ * When a kmer has several neighbors in the graph then a branching is required.
  * A branching is the last letter of the next kmer.
+ * When the next kmer is not one of the neighbors, its last letter is stored
+ * as a literal (see ReadLiteral). If literals is NULL, then false will be returned.
  * 
- * @param bf a pointer to a Bloom filter structure
+ * @param graph a pointer to a DeBruijnGraph structure
  * @param branchings a pointer to a Vector structure
+ * @param literals a pointer to a Vector of ReadLiteral, could be NULL
  * @param seq origin sequence
  * @param len length of the sequence
  * @param k length of each kmer
  * @return true if no error occured, otherwise false
  */
-bool computeBranchings(struct BloomFilter *bf, struct Vector *branchings, char *seq, int len, int k);
+bool computeBranchings(struct DeBruijnGraph *graph, struct Vector *branchings, struct Vector *literals, char *seq, int len, int k);
 
 /**
  * \brief Decompresses reads into the output file
@@ -63,13 +132,45 @@ bool computeBranchings(struct BloomFilter *bf, struct Vector *branchings, char *
  * The first line of the input file must be the length of each reads.
  * They must have the same length.
  * 
- * @param bf a pointer to a Bloom filter structure
+ * @param graph a pointer to a DeBruijnGraph structure
  * @param in pointer to an input file
  * @param out pointer to an output file
  * @param k length of each kmer
  */
-bool decompressFile(struct BloomFilter *bf, FILE *in, FILE *out, int k);
-bool decompressRead(struct BloomFilter *bf, struct Vector *branchings, char *read, int readLength, const char *firstKmer, int k);
+bool decompressFile(struct DeBruijnGraph *graph, FILE *in, FILE *out, int k);
+bool decompressRead(struct DeBruijnGraph *graph, struct Vector *branchings, struct Vector *literals,
+    char *read, int readLength, const char *firstKmer, int k);
+
+/**
+ * \brief Decompresses several reads at the same time
+ * 
+ * The reads are decompressed by groups of FASTA_WALK_GROUP reads that move forward
+ * together : at each step, the neighbors of the current kmers of all reads of
+ * the group are checked with one batched query (see containsSuccessors),
+ * so the memory accesses of a read overlap with the ones of the others.
+ * 
+ * The results are the same as n calls to decompressRead.
+ * False will be returned if one of the reads could not be decompressed.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param walks array of n reads (see ReadWalk)
+ * @param n number of reads
+ * @param k length of each kmer
+ * @return true if all reads were decompressed, otherwise false
+ */
+bool decompressReads(struct DeBruijnGraph *graph, ReadWalk *walks, int n, int k);
+
+/**
+ * \brief Reads the next read of a fasta file
+ * 
+ * Headers are skipped and the end of line is removed.
+ * 
+ * @param line pointer to the buffer given to getline
+ * @param length pointer to the size of the buffer
+ * @param fp fasta file
+ * @return length of the read, or -1 at the end of the file or if an error occured
+ */
+ssize_t readSequence(char **line, size_t *length, FILE *fp);
 
 /**
  * \brief Extracts branchings from a compressed read
@@ -77,7 +178,7 @@ bool decompressRead(struct BloomFilter *bf, struct Vector *branchings, char *rea
  * A compressed read is represented by its firt kmer, a space
  * and may be by some branchings.
  * This function looks for those branchings after the space and
- * adds them into the given vector.
+ * adds them into the given vector. The literals are not extracted (see extractLiterals).
  * 
  * If the compressed read is not valid or an error occured
  * then a negative value will be returned.
@@ -88,4 +189,19 @@ bool decompressRead(struct BloomFilter *bf, struct Vector *branchings, char *rea
  */
 int extractBranchings(struct Vector *branchings, const char *line);
 
+/**
+ * \brief Extracts literals from a compressed read
+ * 
+ * The literals follow the branchings after a second space (see compressFile),
+ * they are added into the given vector of ReadLiteral.
+ * 
+ * If the literals are not valid or an error occured
+ * then a negative value will be returned.
+ * 
+ * @param literals a pointer to a vector of ReadLiteral
+ * @param line compressed read
+ * @return number of literals found or a negative value in an error occured
+ */
+int extractLiterals(struct Vector *literals, const char *line);
+
 #endif // FASTA_H
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bloom_filter.h"
+#include "dbg_io.h"
+#include "de_bruijn_graph.h"
+#include "log.h"
+
+void help(const char *prog) {
+    printf("Usage : %s --output, -o file [--mapped] [--compression-level, -l n] [--threads, -t n] graph_file...\n\n", prog);
+
+    printf("Merges graphs built from several parts of a fasta file (see fasta_compress --graph-only)\n");
+    printf("into the graph of the whole file. The graphs must have the same kmer size and filter parameters :\n");
+    printf("give the same --kmer-size, --bloom-size and --bloom-hash to all parts.\n");
+    printf("The first graph can not be a mapped graph. The merged graph has no critical false positives,\n");
+    printf("use it with fasta_compress --input-graph.\n\n");
+
+    printf("--output, -o file -> path to a file for writing the merged graph\n");
+    printf("--mapped -> saves an uncompressed graph that can be mapped in memory by the decompressor\n");
+    printf("--compression-level, -l n -> compression level of the graph, between 0 and 9 (default 9)\n");
+    printf("--threads, -t n -> number of threads used to load and compress the graphs (default 1)\n");
+}
+
+int main(int argc, char **argv) {
+    struct option options[] = {
+        { "help", no_argument, NULL, '?' },
+        { "output", required_argument, NULL, 'o' },
+        { "mapped", no_argument, NULL, 'm' },
+        { "compression-level", required_argument, NULL, 'l' },
+        { "threads", required_argument, NULL, 't' },
+        { 0, 0, 0, 0 }
+    };
+
+    char outputPath[255] = { '\0' };
+    bool mapped = false;
+    int compressionLevel = 9;
+    int nbThreads = 1;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "?o:ml:t:", options, NULL)) != -1) {
+        switch(opt) {
+            case '?':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+
+            case 'o':
+                if (snprintf(outputPath, sizeof(outputPath), "%s", optarg) >= (int) sizeof(outputPath)) {
+                    fprintf(stderr, "The given path is too long\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'm':
+                mapped = true;
+                break;
+
+            case 'l': {
+                char *end;
+                long value = strtol(optarg, &end, 10);
+
+                if (*optarg == '\0' || *end != '\0' || value < 0 || value > 9) {
+                    fprintf(stderr, "Invalid compression level, it must be between 0 and 9\n");
+                    return EXIT_FAILURE;
+                }
+
+                compressionLevel = value;
+                break;
+            }
+
+            case 't':
+                nbThreads = atoi(optarg);
+
+                if (nbThreads <= 0) {
+                    fprintf(stderr, "Invalid number of threads\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            default:
+                fprintf(stderr, "Unknown option %s\n", optarg);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (outputPath[0] == '\0') {
+        fprintf(stderr, "Missing path to the merged graph\n");
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "Missing path to a graph file\n");
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *fp = NULL;
+    DeBruijnGraph *graph = NULL;
+    DeBruijnGraph *part = NULL;
+    int result = EXIT_FAILURE;
+
+    // The graphs are loaded one after the other, only two of them are in memory
+    for (int i = optind;i < argc;i++) {
+        log_info("Loading graph %s", argv[i]);
+        if ((part = openDBG(argv[i], nbThreads)) == NULL) {
+            log_error("Unable to load graph from %s", argv[i]);
+            goto EXIT;
+        }
+
+        if (!graph) {
+            graph = part;
+            part = NULL;
+            continue;
+        }
+
+        if (!mergeDBG(graph, part)) {
+            log_error("Unable to merge graph %s", argv[i]);
+            goto EXIT;
+        }
+
+        deleteDBG(part);
+        part = NULL;
+    }
+
+    if (graph->backend == DBG_BACKEND_EXACT) {
+        log_info("Merged exact graph : kmer-size=%d, %" PRIu64 " kmers", graph->k, kmerSetSize(graph->kmers));
+    }
+    else {
+        // The false positives of a single graph are also removed, like the merged ones
+        kmerSetDelete(graph->falsePositives);
+        graph->falsePositives = NULL;
+
+        log_info("Merged graph : kmer-size=%d, filter of %" PRIu64 " bits", graph->k, bfBitSize(graph->bf));
+    }
+
+    if ((fp = fopen(outputPath, "wb")) == NULL) {
+        log_error("Unable to create %s", outputPath);
+        log_error(strerror(errno));
+        goto EXIT;
+    }
+
+    log_info("Saving %sgraph to %s", mapped ? "mapped " : "", outputPath);
+    if (!(mapped ? saveMappedDBG(graph, fp) : saveBlockedDBG(graph, fp, compressionLevel, nbThreads))) {
+        log_error("save failed");
+        goto EXIT;
+    }
+
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        log_error("Unable to close %s", outputPath);
+        goto EXIT;
+    }
+
+    fp = NULL;
+
+    log_info("Done.");
+    result = EXIT_SUCCESS;
+
+EXIT:
+    if (fp) {
+        fclose(fp);
+    }
+
+    deleteDBG(graph);
+    deleteDBG(part);
+
+    return result;
+}
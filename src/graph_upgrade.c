@@ -0,0 +1,182 @@
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bloom_filter.h"
+#include "dbg_io.h"
+#include "de_bruijn_graph.h"
+#include "log.h"
+
+void help(const char *prog) {
+    printf("Usage : %s [--output, -o file] [--kmer-size, -k size] [--mapped] [--compression-level, -l n] [--threads, -t n] graph_file\n\n", prog);
+
+    printf("Saves a graph with the current format version.\n");
+    printf("Graphs saved before the version 3 only used the first eighth of their filter,\n");
+    printf("the upgraded graph only keeps those bits.\n");
+    printf("Graphs saved before the version 6 did not store the size of their kmers.\n\n");
+
+    printf("--output, -o file -> path to a file for writing the upgraded graph (replaces graph_file by default)\n");
+    printf("--kmer-size, -k size -> size of the kmers of the graph, for graphs that do not store it (default %d), the other graphs must store the same size\n", DBG_LEGACY_KMER_SIZE);
+    printf("--mapped -> saves an uncompressed graph that can be mapped in memory by the decompressor\n");
+    printf("--compression-level, -l n -> compression level of the graph, between 0 and 9 (default 9)\n");
+    printf("--threads, -t n -> number of threads used to load and compress the graph (default 1)\n");
+}
+
+int main(int argc, char **argv) {
+    struct option options[] = {
+        { "help", no_argument, NULL, '?' },
+        { "output", required_argument, NULL, 'o' },
+        { "kmer-size", required_argument, NULL, 'k' },
+        { "mapped", no_argument, NULL, 'm' },
+        { "compression-level", required_argument, NULL, 'l' },
+        { "threads", required_argument, NULL, 't' },
+        { 0, 0, 0, 0 }
+    };
+
+    char outputPath[255] = { '\0' };
+    bool mapped = false;
+    // Size of the kmers of a graph saved before the version 6, if it is given
+    int kmerSize = 0;
+    int compressionLevel = 9;
+    int nbThreads = 1;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "?o:k:ml:t:", options, NULL)) != -1) {
+        switch(opt) {
+            case '?':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+
+            case 'o':
+                if (snprintf(outputPath, sizeof(outputPath), "%s", optarg) >= (int) sizeof(outputPath)) {
+                    fprintf(stderr, "The given path is too long\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'k':
+                kmerSize = atoi(optarg);
+
+                if (kmerSize <= 0 || kmerSize > KMER_MAX_SIZE) {
+                    fprintf(stderr, "Invalid kmer size, it must be between 1 and %d\n", KMER_MAX_SIZE);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'm':
+                mapped = true;
+                break;
+
+            case 'l': {
+                char *end;
+                long value = strtol(optarg, &end, 10);
+
+                if (*optarg == '\0' || *end != '\0' || value < 0 || value > 9) {
+                    fprintf(stderr, "Invalid compression level, it must be between 0 and 9\n");
+                    return EXIT_FAILURE;
+                }
+
+                compressionLevel = value;
+                break;
+            }
+
+            case 't':
+                nbThreads = atoi(optarg);
+
+                if (nbThreads <= 0) {
+                    fprintf(stderr, "Invalid number of threads\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            default:
+                fprintf(stderr, "Unknown option %s\n", optarg);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "Missing path to a graph file\n");
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char *inputPath = argv[optind];
+
+    // The graph is replaced once the upgraded one is entirely written
+    bool inPlace = outputPath[0] == '\0';
+    if (inPlace && snprintf(outputPath, sizeof(outputPath), "%s.tmp", inputPath) >= (int) sizeof(outputPath)) {
+        fprintf(stderr, "The given path is too long\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *fp = NULL;
+    DeBruijnGraph *graph = NULL;
+    int result = EXIT_FAILURE;
+
+    log_info("Loading graph");
+    bool legacy = isLegacyDBG(inputPath);
+
+    if ((graph = openDBG(inputPath, nbThreads)) == NULL) {
+        log_error("Unable to load graph from %s", inputPath);
+        goto EXIT;
+    }
+
+    // The size stored in a graph is never replaced
+    if (kmerSize > 0 && legacy) {
+        graph->k = kmerSize;
+    }
+    else if (kmerSize > 0 && kmerSize != graph->k) {
+        log_error("The graph stores kmers of size %d, not %d", graph->k, kmerSize);
+        goto EXIT;
+    }
+
+    log_info("Done : kmer-size=%d canonical=%d", graph->k, graph->canonical);
+    if (graph->backend == DBG_BACKEND_EXACT) {
+        log_info("Exact graph : %" PRIu64 " kmers", kmerSetSize(graph->kmers));
+    }
+    else {
+        log_info("Filter : size=%" PRIu64 " bits, %ld bytes in memory", bfBitSize(graph->bf), bfSize(graph->bf));
+    }
+
+    if ((fp = fopen(outputPath, "wb")) == NULL) {
+        log_error("Unable to create %s", outputPath);
+        log_error(strerror(errno));
+        goto EXIT;
+    }
+
+    log_info("Saving %sgraph to %s", mapped ? "mapped " : "", outputPath);
+    if (!(mapped ? saveMappedDBG(graph, fp) : saveBlockedDBG(graph, fp, compressionLevel, nbThreads))) {
+        log_error("save failed");
+        goto EXIT;
+    }
+
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        log_error("Unable to close %s", outputPath);
+        goto EXIT;
+    }
+
+    fp = NULL;
+
+    if (inPlace && rename(outputPath, inputPath) != 0) {
+        log_error("Unable to replace %s", inputPath);
+        log_error(strerror(errno));
+        goto EXIT;
+    }
+
+    log_info("Done.");
+    result = EXIT_SUCCESS;
+
+EXIT:
+    if (fp) {
+        fclose(fp);
+    }
+
+    deleteDBG(graph);
+
+    return result;
+}
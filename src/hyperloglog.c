@@ -0,0 +1,83 @@
+#include "hyperloglog.h"
+
+#include "log.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+HyperLogLog *hllCreate(uint8_t precision) {
+    if (precision < HLL_MIN_PRECISION || precision > HLL_MAX_PRECISION) {
+        return NULL;
+    }
+
+    HyperLogLog *hll = malloc(sizeof(*hll));
+
+    if (!hll) {
+        log_error("Sketch allocation error");
+        return NULL;
+    }
+
+    hll->precision = precision;
+    hll->registers = calloc(hllNbRegisters(hll), 1);
+
+    if (!hll->registers) {
+        log_error("Sketch registers allocation error");
+        free(hll);
+        return NULL;
+    }
+
+    return hll;
+}
+
+void hllDelete(HyperLogLog *hll) {
+    if (hll) {
+        free(hll->registers);
+        free(hll);
+    }
+}
+
+void hllAdd(HyperLogLog *hll, uint64_t hash) {
+    assert(hll);
+
+    // Finalizer of the 64 bits MurmurHash3
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    uint64_t index = hash >> (64 - hll->precision);
+
+    // The rank of the remaining bits is at most 64 - precision + 1,
+    // a bit is set after them so that the rank is defined
+    uint64_t remaining = (hash << hll->precision) | ((uint64_t) 1 << (hll->precision - 1));
+    uint8_t rank = __builtin_clzll(remaining) + 1;
+
+    if (rank > hll->registers[index]) {
+        hll->registers[index] = rank;
+    }
+}
+
+uint64_t hllEstimate(const HyperLogLog *hll) {
+    assert(hll);
+
+    double m = hllNbRegisters(hll);
+    double sum = 0;
+    uint64_t nbZeros = 0;
+
+    for (uint64_t i = 0;i < hllNbRegisters(hll);i++) {
+        sum += ldexp(1.0, -hll->registers[i]);
+        nbZeros += hll->registers[i] == 0;
+    }
+
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    // The raw estimate is biased for small cardinalities
+    if (estimate <= 2.5 * m && nbZeros > 0) {
+        estimate = m * log(m / nbZeros);
+    }
+
+    return (uint64_t) llround(estimate);
+}
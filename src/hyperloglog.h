@@ -0,0 +1,70 @@
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <stdint.h>
+
+/**
+ * \brief Minimum and maximum precision of a HyperLogLog sketch
+ */
+#define HLL_MIN_PRECISION 4
+#define HLL_MAX_PRECISION 18
+
+/**
+ * \brief Sketch that estimates the number of distinct values of a set
+ * 
+ * A sketch with a precision p has 2^p registers of one byte. The first p bits
+ * of the hash of a value select a register, which keeps the maximum rank
+ * (position of the first set bit) of the remaining bits.
+ * The relative error of the estimate is about 1.04 / sqrt(2^p).
+ */
+typedef struct HyperLogLog {
+    uint8_t *registers;
+    uint8_t precision;
+} HyperLogLog;
+
+/**
+ * \brief Gets the number of registers of the sketch
+ */
+#define hllNbRegisters(hll) ((uint64_t) 1 << (hll)->precision)
+
+/**
+ * \brief Creates a new empty sketch
+ * 
+ * The precision must be between HLL_MIN_PRECISION and HLL_MAX_PRECISION,
+ * otherwise NULL will be returned. NULL is also returned
+ * if an allocation error occured.
+ * 
+ * @param precision number of bits that select a register
+ * @return a pointer to an allocated HyperLogLog structure
+ */
+HyperLogLog *hllCreate(uint8_t precision);
+
+/**
+ * \brief Frees the memory allocated for the given sketch
+ * 
+ * @param hll a pointer to an allocated HyperLogLog structure
+ */
+void hllDelete(HyperLogLog *hll);
+
+/**
+ * \brief Adds a value into the sketch from its hash
+ * 
+ * The hash is mixed before being used, so hashs with
+ * poorly distributed bits can be given.
+ * 
+ * @param hll a pointer to a HyperLogLog structure
+ * @param hash a 64 bits hash of the value
+ */
+void hllAdd(HyperLogLog *hll, uint64_t hash);
+
+/**
+ * \brief Estimates the number of distinct values added into the sketch
+ * 
+ * Small cardinalities are estimated with linear counting.
+ * 
+ * @param hll a pointer to a HyperLogLog structure
+ * @return the estimated number of distinct values
+ */
+uint64_t hllEstimate(const HyperLogLog *hll);
+
+#endif // HYPERLOGLOG_H
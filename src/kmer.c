@@ -0,0 +1,70 @@
+#include "kmer.h"
+
+#include <assert.h>
+
+const uint8_t kmerBaseCodes[256] = {
+    ['A'] = 0, ['C'] = 1, ['G'] = 2, ['T'] = 3,
+    ['a'] = 0, ['c'] = 1, ['g'] = 2, ['t'] = 3
+};
+
+bool kmerCanonicalMode = true;
+
+bool kmerEncode(const char *str, int k, Kmer *kmer) {
+    assert(str);
+    assert(kmer);
+
+    if (k <= 0 || k > KMER_MAX_SIZE) {
+        return false;
+    }
+
+    Kmer result = 0;
+
+    for (int i = 0;i < k;i++) {
+        result = (result << 2) | kmerEncodeBase(str[i]);
+    }
+
+    *kmer = result;
+
+    return true;
+}
+
+void kmerDecode(Kmer kmer, int k, char *str) {
+    assert(str);
+
+    for (int i = k - 1;i >= 0;i--) {
+        str[i] = kmerDecodeBase(kmer);
+        kmer >>= 2;
+    }
+}
+
+void kmerUseCanonical(bool canonical) {
+    kmerCanonicalMode = canonical;
+}
+
+bool kmer128Encode(const char *str, int k, Kmer128 *kmer) {
+    assert(str);
+    assert(kmer);
+
+    if (k <= 0 || k > KMER128_MAX_SIZE) {
+        return false;
+    }
+
+    Kmer128 result = 0;
+
+    for (int i = 0;i < k;i++) {
+        result = (result << 2) | kmerEncodeBase(str[i]);
+    }
+
+    *kmer = result;
+
+    return true;
+}
+
+void kmer128Decode(Kmer128 kmer, int k, char *str) {
+    assert(str);
+
+    for (int i = k - 1;i >= 0;i--) {
+        str[i] = kmerDecodeBase((uint8_t) kmer);
+        kmer >>= 2;
+    }
+}
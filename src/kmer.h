@@ -0,0 +1,259 @@
+#ifndef KMER_H
+#define KMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \brief A kmer packed with 2 bits per base
+ *
+ * Bases are encoded as A=0, C=1, G=2 and T=3. The first base of the kmer
+ * is stored in the most significant used bits, so comparing two packed kmers
+ * of the same length gives the same result as comparing their strings
+ * in the lexicographic order.
+ */
+typedef uint64_t Kmer;
+
+/**
+ * \brief Maximum length of a packed kmer
+ */
+#define KMER_MAX_SIZE 32
+
+/**
+ * \brief A kmer longer than KMER_MAX_SIZE packed like a Kmer on 128 bits
+ *
+ * The functions and macros of this type are the ones of Kmer prefixed by kmer128,
+ * the ones of Kmer are faster and should be selected when k is small enough.
+ */
+typedef unsigned __int128 Kmer128;
+
+/**
+ * \brief Maximum length of a kmer packed on 128 bits
+ */
+#define KMER128_MAX_SIZE 64
+
+extern const uint8_t kmerBaseCodes[256];
+
+/**
+ * \brief True if a kmer and its reverse complement are the same kmer (the default)
+ *
+ * In the strand-specific mode, the canonical form of a kmer is the kmer itself
+ * (see kmerCanonical), the reverse complements are distinct kmers.
+ * It is changed by kmerUseCanonical.
+ */
+extern bool kmerCanonicalMode;
+
+/**
+ * \brief Gets the 2 bits code of a base
+ *
+ * Lower case letters are accepted, any other character
+ * than A, C, G and T will be encoded as an A.
+ */
+#define kmerEncodeBase(c) (kmerBaseCodes[(unsigned char) (c)])
+
+/**
+ * \brief Gets the letter associated to a 2 bits code
+ */
+#define kmerDecodeBase(b) ("ACGT"[(b) & 0x3])
+
+/**
+ * \brief Gets the mask that keeps the 2 * k lowest bits of a packed kmer
+ */
+#define kmerMask(k) ((k) >= KMER_MAX_SIZE ? UINT64_MAX : (((Kmer) 1 << (2 * (k))) - 1))
+
+/**
+ * \brief Gets the 2 bits code of the first base of a kmer of length k
+ */
+#define kmerFirstBase(kmer, k) (((kmer) >> (2 * ((k) - 1))) & 0x3)
+
+/**
+ * \brief Gets the mask that keeps the 2 * k lowest bits of a kmer packed on 128 bits
+ */
+#define kmer128Mask(k) ((k) >= KMER128_MAX_SIZE ? ~(Kmer128) 0 : (((Kmer128) 1 << (2 * (k))) - 1))
+
+/**
+ * \brief Gets the 2 bits code of the first base of a kmer of length k packed on 128 bits
+ */
+#define kmer128FirstBase(kmer, k) ((uint8_t) ((kmer) >> (2 * ((k) - 1))) & 0x3)
+
+/**
+ * \brief Packs the first k letters of a string
+ *
+ * The length k must be strictely positive and less or equal to
+ * KMER_MAX_SIZE, otherwise false will be returned.
+ *
+ * @param str string that contains at least k letters
+ * @param k length of the kmer
+ * @param kmer destination of the packed kmer
+ * @return true if the kmer was correctly packed, otherwise false
+ */
+bool kmerEncode(const char *str, int k, Kmer *kmer);
+
+/**
+ * \brief Unpacks a kmer of length k into a string
+ *
+ * The destination must be able to store k letters,
+ * no null character will be added.
+ *
+ * @param kmer a packed kmer
+ * @param k length of the kmer
+ * @param str destination of the letters
+ */
+void kmerDecode(Kmer kmer, int k, char *str);
+
+/**
+ * \brief Changes the canonical mode of the kmers (see kmerCanonicalMode)
+ *
+ * All canonical forms and hashes computed with the other mode must be recomputed.
+ * This function is not thread safe.
+ *
+ * @param canonical false for the strand-specific mode
+ */
+void kmerUseCanonical(bool canonical);
+
+/**
+ * \brief Packs the first k letters of a string on 128 bits
+ *
+ * The length k must be strictely positive and less or equal to
+ * KMER128_MAX_SIZE, otherwise false will be returned.
+ *
+ * @param str string that contains at least k letters
+ * @param k length of the kmer
+ * @param kmer destination of the packed kmer
+ * @return true if the kmer was correctly packed, otherwise false
+ */
+bool kmer128Encode(const char *str, int k, Kmer128 *kmer);
+
+/**
+ * \brief Unpacks a kmer of length k packed on 128 bits into a string
+ *
+ * See kmerDecode.
+ *
+ * @param kmer a kmer packed on 128 bits
+ * @param k length of the kmer
+ * @param str destination of the letters
+ */
+void kmer128Decode(Kmer128 kmer, int k, char *str);
+
+/**
+ * \brief Appends a base at the end of a kmer
+ *
+ * The first base of the kmer is lost.
+ *
+ * @param kmer a packed kmer
+ * @param base 2 bits code of the new base
+ * @param k length of the kmer
+ * @return the next kmer
+ */
+static inline Kmer kmerAppend(Kmer kmer, uint8_t base, int k) {
+    return ((kmer << 2) | base) & kmerMask(k);
+}
+
+/**
+ * \brief Updates the reverse complement of a kmer after a call to kmerAppend
+ *
+ * The complement of the new base becomes the first base of
+ * the reverse complement, its last base is lost.
+ *
+ * @param rc reverse complement of the previous kmer
+ * @param base 2 bits code of the appended base
+ * @param k length of the kmer
+ * @return reverse complement of the next kmer
+ */
+static inline Kmer kmerAppendReverse(Kmer rc, uint8_t base, int k) {
+    return (rc >> 2) | ((Kmer) (base ^ 0x3) << (2 * (k - 1)));
+}
+
+/**
+ * \brief Reverses the order of the 32 bases of a 64 bits word
+ */
+static inline uint64_t kmerReverseBases(uint64_t bases) {
+    bases = ((bases >> 2) & 0x3333333333333333ULL) | ((bases & 0x3333333333333333ULL) << 2);
+    bases = ((bases >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((bases & 0x0F0F0F0F0F0F0F0FULL) << 4);
+
+    return __builtin_bswap64(bases);
+}
+
+/**
+ * \brief Computes the reverse complement of a packed kmer
+ *
+ * @param kmer a packed kmer
+ * @param k length of the kmer
+ * @return the reverse complement of the kmer
+ */
+static inline Kmer kmerReverseComplement(Kmer kmer, int k) {
+    // With this encoding, the complement of a base is its bitwise negation
+    return kmerReverseBases(~kmer) >> (64 - 2 * k);
+}
+
+/**
+ * \brief Computes the canonical form of a packed kmer
+ *
+ * The canonical form is the smallest value between the kmer
+ * and its reverse complement, or the kmer in the strand-specific mode.
+ *
+ * @param kmer a packed kmer
+ * @param k length of the kmer
+ * @return the canonical form of the kmer
+ */
+static inline Kmer kmerCanonical(Kmer kmer, int k) {
+    if (!kmerCanonicalMode) {
+        return kmer;
+    }
+
+    Kmer rc = kmerReverseComplement(kmer, k);
+
+    return rc < kmer ? rc : kmer;
+}
+
+/**
+ * \brief Appends a base at the end of a kmer packed on 128 bits
+ *
+ * See kmerAppend.
+ */
+static inline Kmer128 kmer128Append(Kmer128 kmer, uint8_t base, int k) {
+    return ((kmer << 2) | base) & kmer128Mask(k);
+}
+
+/**
+ * \brief Updates the reverse complement of a kmer after a call to kmer128Append
+ *
+ * See kmerAppendReverse.
+ */
+static inline Kmer128 kmer128AppendReverse(Kmer128 rc, uint8_t base, int k) {
+    return (rc >> 2) | ((Kmer128) (base ^ 0x3) << (2 * (k - 1)));
+}
+
+/**
+ * \brief Computes the reverse complement of a kmer packed on 128 bits
+ *
+ * @param kmer a kmer packed on 128 bits
+ * @param k length of the kmer
+ * @return the reverse complement of the kmer
+ */
+static inline Kmer128 kmer128ReverseComplement(Kmer128 kmer, int k) {
+    // Each half is reversed, then the halves are swapped
+    Kmer128 rc = ((Kmer128) kmerReverseBases(~(uint64_t) kmer) << 64)
+        | kmerReverseBases(~(uint64_t) (kmer >> 64));
+
+    return rc >> (128 - 2 * k);
+}
+
+/**
+ * \brief Computes the canonical form of a kmer packed on 128 bits
+ *
+ * @param kmer a kmer packed on 128 bits
+ * @param k length of the kmer
+ * @return the canonical form of the kmer
+ */
+static inline Kmer128 kmer128Canonical(Kmer128 kmer, int k) {
+    if (!kmerCanonicalMode) {
+        return kmer;
+    }
+
+    Kmer128 rc = kmer128ReverseComplement(kmer, k);
+
+    return rc < kmer ? rc : kmer;
+}
+
+#endif // KMER_H
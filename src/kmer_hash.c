@@ -0,0 +1,246 @@
+#include "kmer_hash.h"
+
+#include <assert.h>
+
+// Vectorized kernels are compiled for x86-64 processors only,
+// they are selected at runtime
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KMER_HASH_X86
+#include <immintrin.h>
+#endif
+
+// Seeds used by ntHash for the bases A, C, G and T
+const uint64_t kmerHashSeeds[4] = {
+    0x3c8bfbb395c60474ULL,
+    0x3193c18562a02b4cULL,
+    0x20323ed082572324ULL,
+    0x295549f54be24456ULL
+};
+
+KmerHashFunction kmerHashSelectedFunction = KMER_HASH_NTHASH;
+
+void kmerHashInit(KmerHash *hash, Kmer kmer, int k) {
+    assert(hash);
+
+    if (kmerHashSelectedFunction == KMER_HASH_MIX) {
+        hash->forward = kmer & kmerMask(k);
+        hash->reverse = kmerReverseComplement(kmer, k);
+        return;
+    }
+
+    hash->forward = 0;
+    hash->reverse = 0;
+
+    // The last base of the kmer is stored in the lowest bits
+    for (int i = k - 1;i >= 0;i--) {
+        uint8_t base = kmer & 0x3;
+
+        hash->forward ^= kmerHashRotl(kmerHashSeeds[base], k - 1 - i);
+        hash->reverse ^= kmerHashRotl(kmerHashSeeds[base ^ 0x3], i);
+
+        kmer >>= 2;
+    }
+}
+
+void kmerHashInit128(KmerHash *hash, Kmer128 kmer, int k) {
+    assert(hash);
+
+    if (kmerHashSelectedFunction == KMER_HASH_MIX) {
+        assert(k <= KMER_MAX_SIZE);
+
+        kmerHashInit(hash, (Kmer) kmer, k);
+        return;
+    }
+
+    hash->forward = 0;
+    hash->reverse = 0;
+
+    for (int i = k - 1;i >= 0;i--) {
+        uint8_t base = kmer & 0x3;
+
+        hash->forward ^= kmerHashRotl(kmerHashSeeds[base], k - 1 - i);
+        hash->reverse ^= kmerHashRotl(kmerHashSeeds[base ^ 0x3], i);
+
+        kmer >>= 2;
+    }
+}
+
+bool kmerHashInitString(KmerHash *hash, const char *str, int k) {
+    assert(hash);
+    assert(str);
+
+    if (k <= KMER_MAX_SIZE) {
+        Kmer kmer;
+
+        if (!kmerEncode(str, k, &kmer)) {
+            return false;
+        }
+
+        kmerHashInit(hash, kmer, k);
+    }
+    else {
+        Kmer128 kmer;
+
+        if (!kmer128Encode(str, k, &kmer)) {
+            return false;
+        }
+
+        kmerHashInit128(hash, kmer, k);
+    }
+
+    return true;
+}
+
+typedef void (*SuccessorsKernel)(const KmerHash*, const uint8_t*, int, int, uint64_t*);
+
+static void successorsScalar(const KmerHash *hashes, const uint8_t *firsts, int n, int k, uint64_t *successors) {
+    for (int i = 0;i < n;i++) {
+        for (uint8_t base = 0;base < 4;base++) {
+            KmerHash next = kmerHashRoll(hashes + i, firsts[i], base, k);
+            successors[i * 4 + base] = kmerHashCanonical(&next);
+        }
+    }
+}
+
+#ifdef KMER_HASH_X86
+
+/**
+ * \brief Computes the part of the hashes shared by the 4 successors of a kmer
+ * 
+ * See kmerHashRoll, only the seeds of the appended base are missing.
+ */
+static inline KmerHash rollCommon(const KmerHash *hash, uint8_t out, int k) {
+    KmerHash common;
+
+    common.forward = kmerHashRotl(hash->forward, 1) ^ kmerHashRotl(kmerHashSeeds[out], k);
+    common.reverse = kmerHashRotr(hash->reverse, 1) ^ kmerHashRotr(kmerHashSeeds[out ^ 0x3], 1);
+
+    return common;
+}
+
+__attribute__((target("avx2")))
+static void successorsAvx2(const KmerHash *hashes, const uint8_t *firsts, int n, int k, uint64_t *successors) {
+    // Lane b contains the seeds of the appended base b
+    __m256i forwardSeeds = _mm256_loadu_si256((const __m256i*) kmerHashSeeds);
+    __m256i reverseSeeds = _mm256_set_epi64x(
+        kmerHashRotl(kmerHashSeeds[0], k - 1), kmerHashRotl(kmerHashSeeds[1], k - 1),
+        kmerHashRotl(kmerHashSeeds[2], k - 1), kmerHashRotl(kmerHashSeeds[3], k - 1));
+
+    // The reverse hashes are cleared in the strand-specific mode
+    __m256i reverseMask = _mm256_set1_epi64x(kmerCanonicalMode ? -1 : 0);
+
+    for (int i = 0;i < n;i++) {
+        KmerHash common = rollCommon(hashes + i, firsts[i], k);
+
+        __m256i forward = _mm256_xor_si256(_mm256_set1_epi64x(common.forward), forwardSeeds);
+        __m256i reverse = _mm256_xor_si256(_mm256_set1_epi64x(common.reverse), reverseSeeds);
+        reverse = _mm256_and_si256(reverse, reverseMask);
+
+        _mm256_storeu_si256((__m256i*) (successors + i * 4), _mm256_add_epi64(forward, reverse));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void successorsAvx512(const KmerHash *hashes, const uint8_t *firsts, int n, int k, uint64_t *successors) {
+    __m512i forwardSeeds = _mm512_set_epi64(
+        kmerHashSeeds[3], kmerHashSeeds[2], kmerHashSeeds[1], kmerHashSeeds[0],
+        kmerHashSeeds[3], kmerHashSeeds[2], kmerHashSeeds[1], kmerHashSeeds[0]);
+
+    uint64_t r0 = kmerHashRotl(kmerHashSeeds[3], k - 1);
+    uint64_t r1 = kmerHashRotl(kmerHashSeeds[2], k - 1);
+    uint64_t r2 = kmerHashRotl(kmerHashSeeds[1], k - 1);
+    uint64_t r3 = kmerHashRotl(kmerHashSeeds[0], k - 1);
+    __m512i reverseSeeds = _mm512_set_epi64(r3, r2, r1, r0, r3, r2, r1, r0);
+    __m512i reverseMask = _mm512_set1_epi64(kmerCanonicalMode ? -1 : 0);
+
+    int i = 0;
+
+    // The low half contains the successors of the kmer i, the high half the ones of the kmer i + 1
+    for (;i + 1 < n;i += 2) {
+        KmerHash low = rollCommon(hashes + i, firsts[i], k);
+        KmerHash high = rollCommon(hashes + i + 1, firsts[i + 1], k);
+
+        __m512i forward = _mm512_set_epi64(
+            high.forward, high.forward, high.forward, high.forward,
+            low.forward, low.forward, low.forward, low.forward);
+        __m512i reverse = _mm512_set_epi64(
+            high.reverse, high.reverse, high.reverse, high.reverse,
+            low.reverse, low.reverse, low.reverse, low.reverse);
+
+        forward = _mm512_xor_si512(forward, forwardSeeds);
+        reverse = _mm512_and_si512(_mm512_xor_si512(reverse, reverseSeeds), reverseMask);
+
+        _mm512_storeu_si512(successors + i * 4, _mm512_add_epi64(forward, reverse));
+    }
+
+    if (i < n) {
+        successorsScalar(hashes + i, firsts + i, 1, k, successors + i * 4);
+    }
+}
+
+#endif // KMER_HASH_X86
+
+static SuccessorsKernel successorsKernel = successorsScalar;
+
+/**
+ * \brief Selects the fastest kernel supported by the processor
+ * 
+ * It is called before main.
+ */
+__attribute__((constructor))
+static void selectKernel(void) {
+    if (!kmerHashUseKernel(KMER_HASH_AVX512)) {
+        kmerHashUseKernel(KMER_HASH_AVX2);
+    }
+}
+
+bool kmerHashUseKernel(KmerHashKernel kernel) {
+    switch (kernel) {
+        case KMER_HASH_SCALAR:
+            successorsKernel = successorsScalar;
+            return true;
+
+#ifdef KMER_HASH_X86
+        case KMER_HASH_AVX2:
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx2")) {
+                successorsKernel = successorsAvx2;
+                return true;
+            }
+
+            return false;
+
+        case KMER_HASH_AVX512:
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx512f")) {
+                successorsKernel = successorsAvx512;
+                return true;
+            }
+
+            return false;
+#endif
+
+        default:
+            return false;
+    }
+}
+
+void kmerHashSuccessors(const KmerHash *hashes, const uint8_t *firsts, int n, int k, uint64_t *successors) {
+    assert(hashes);
+    assert(firsts);
+    assert(successors);
+
+    // The mixed hashes are not vectorized
+    if (kmerHashSelectedFunction == KMER_HASH_MIX) {
+        successorsScalar(hashes, firsts, n, k, successors);
+        return;
+    }
+
+    successorsKernel(hashes, firsts, n, k, successors);
+}
+
+void kmerHashUseFunction(KmerHashFunction function) {
+    kmerHashSelectedFunction = function;
+}
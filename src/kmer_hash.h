@@ -0,0 +1,187 @@
+#ifndef KMER_HASH_H
+#define KMER_HASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fast_hash.h"
+#include "kmer.h"
+
+/**
+ * \brief Rolling hash values of a kmer and of its reverse complement
+ *
+ * The hash function is the one described by ntHash : each base has a
+ * random 64 bits seed, the hash of a kmer is the xor of the seeds
+ * rotated by the position of their base.
+ * Both values can be updated in constant time when a base is
+ * appended to the kmer.
+ *
+ * With the KMER_HASH_MIX function, the values are the packed kmer
+ * and its packed reverse complement (see KmerHashFunction).
+ */
+typedef struct KmerHash {
+    uint64_t forward;
+    uint64_t reverse;
+} KmerHash;
+
+/**
+ * \brief Hash functions of the kmers
+ *
+ * The function is selected for the whole process (see kmerHashUseFunction) :
+ * the kmers of a graph must be hashed by the function used to build it.
+ */
+typedef enum KmerHashFunction {
+    // Rolling hash of ntHash, for kmers of any length
+    KMER_HASH_NTHASH = 0,
+
+    // The smallest of the packed kmer and of its reverse complement is mixed by
+    // fastHashMix64 : two distinct canonical kmers never have the same hash.
+    // Only kmers of at most KMER_MAX_SIZE bases can be hashed
+    KMER_HASH_MIX = 1
+} KmerHashFunction;
+
+/**
+ * \brief Implementations of kmerHashSuccessors
+ */
+typedef enum KmerHashKernel {
+    KMER_HASH_SCALAR = 0,
+    // The 4 successors of a kmer are hashed at once
+    KMER_HASH_AVX2 = 1,
+    // The successors of 2 kmers are hashed at once
+    KMER_HASH_AVX512 = 2
+} KmerHashKernel;
+
+extern const uint64_t kmerHashSeeds[4];
+
+// Function that hashes the kmers, changed by kmerHashUseFunction
+extern KmerHashFunction kmerHashSelectedFunction;
+
+#define kmerHashRotl(x, r) (((x) << ((r) & 63)) | ((x) >> ((64 - (r)) & 63)))
+#define kmerHashRotr(x, r) (((x) >> ((r) & 63)) | ((x) << ((64 - (r)) & 63)))
+
+/**
+ * \brief Gets the canonical hash value of a kmer
+ *
+ * A kmer and its reverse complement have the same canonical hash,
+ * except in the strand-specific mode (see kmerCanonicalMode) where
+ * only the kmer is hashed.
+ */
+static inline uint64_t kmerHashCanonical(const KmerHash *hash) {
+    if (kmerHashSelectedFunction == KMER_HASH_MIX) {
+        bool reverse = kmerCanonicalMode && hash->reverse < hash->forward;
+
+        return fastHashMix64(reverse ? hash->reverse : hash->forward);
+    }
+
+    return kmerCanonicalMode ? hash->forward + hash->reverse : hash->forward;
+}
+
+/**
+ * \brief Computes the hash values of a packed kmer
+ *
+ * @param hash destination of the hash values
+ * @param kmer a packed kmer
+ * @param k length of the kmer
+ */
+void kmerHashInit(KmerHash *hash, Kmer kmer, int k);
+
+/**
+ * \brief Computes the hash values of a kmer packed on 128 bits
+ *
+ * The hash values are the same as kmerHashInit for the same kmer. Kmers longer
+ * than KMER_MAX_SIZE can only be hashed by the KMER_HASH_NTHASH function.
+ *
+ * @param hash destination of the hash values
+ * @param kmer a kmer packed on 128 bits
+ * @param k length of the kmer
+ */
+void kmerHashInit128(KmerHash *hash, Kmer128 kmer, int k);
+
+/**
+ * \brief Computes the hash values of the first kmer of a string
+ *
+ * The kmer is packed on 64 bits when it is short enough, otherwise on 128 bits.
+ *
+ * @param hash destination of the hash values
+ * @param str string that contains at least k letters
+ * @param k length of the kmer
+ * @return true if the kmer was hashed, false if k is not between 1 and KMER128_MAX_SIZE
+ */
+bool kmerHashInitString(KmerHash *hash, const char *str, int k);
+
+/**
+ * \brief Computes the hash values of the next kmer
+ *
+ * The next kmer is the current one without its first base
+ * and followed by the given base.
+ *
+ * @param hash hash values of the current kmer
+ * @param out 2 bits code of the first base of the current kmer
+ * @param in 2 bits code of the appended base
+ * @param k length of the kmer
+ * @return hash values of the next kmer
+ */
+static inline KmerHash kmerHashRoll(const KmerHash *hash, uint8_t out, uint8_t in, int k) {
+    KmerHash next;
+
+    if (kmerHashSelectedFunction == KMER_HASH_MIX) {
+        next.forward = kmerAppend(hash->forward, in, k);
+        next.reverse = kmerAppendReverse(hash->reverse, in, k);
+
+        return next;
+    }
+
+    next.forward = kmerHashRotl(hash->forward, 1)
+        ^ kmerHashRotl(kmerHashSeeds[out], k)
+        ^ kmerHashSeeds[in];
+
+    // The reverse complement loses its last base and gets
+    // the complement of the appended one in first position
+    next.reverse = kmerHashRotr(hash->reverse, 1)
+        ^ kmerHashRotr(kmerHashSeeds[out ^ 0x3], 1)
+        ^ kmerHashRotl(kmerHashSeeds[in ^ 0x3], k - 1);
+
+    return next;
+}
+
+/**
+ * \brief Computes the canonical hashes of the successors of several kmers
+ * 
+ * The successors of a kmer are the kmers obtained by removing its first base
+ * and appending A, C, G or T. The canonical hash of the kmer i followed by the base b
+ * is written at the index i * 4 + b, so successors must store 4 * n values.
+ * 
+ * The results are the same as kmerHashRoll. The fastest kernel supported by the
+ * processor is selected at runtime (see kmerHashUseKernel).
+ * 
+ * @param hashes hash values of the n kmers
+ * @param firsts 2 bits code of the first base of each kmer
+ * @param n number of kmers
+ * @param k length of the kmers
+ * @param successors destination of the 4 * n hashes
+ */
+void kmerHashSuccessors(const KmerHash *hashes, const uint8_t *firsts, int n, int k, uint64_t *successors);
+
+/**
+ * \brief Changes the kernel used by kmerHashSuccessors
+ * 
+ * The kernel is not changed if the processor does not support it.
+ * This function is not thread safe.
+ * 
+ * @param kernel the kernel to use
+ * @return true if the kernel is used, otherwise false
+ */
+bool kmerHashUseKernel(KmerHashKernel kernel);
+
+/**
+ * \brief Changes the function that hashes the kmers
+ * 
+ * KMER_HASH_NTHASH is used by default. All hash values computed
+ * with another function must be recomputed.
+ * This function is not thread safe.
+ * 
+ * @param function the function to use
+ */
+void kmerHashUseFunction(KmerHashFunction function);
+
+#endif // KMER_HASH_H
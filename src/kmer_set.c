@@ -0,0 +1,366 @@
+#include "kmer_set.h"
+
+#include "log.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number of bits sorted by each pass of radixSort
+#define KMER_RADIX_BITS 8
+#define KMER_RADIX_SIZE (1 << KMER_RADIX_BITS)
+
+// Arrays with less kmers are sorted with qsort
+#define KMER_RADIX_MIN 256
+
+static int compareKmers(const void *a, const void *b) {
+    Kmer k1 = *(const Kmer*) a;
+    Kmer k2 = *(const Kmer*) b;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+/**
+ * \brief Sorts an array of kmers with a least significant digit radix sort
+ * 
+ * Each pass moves the kmers from one array to the other one, the passes
+ * of the bytes that are the same for all kmers are skipped.
+ * 
+ * @param kmers array of kmers
+ * @param tmp array of n kmers used by the passes
+ * @param n number of kmers in the arrays
+ * @return the array that contains the sorted kmers, kmers or tmp
+ */
+static Kmer *radixSort(Kmer *kmers, Kmer *tmp, uint64_t n) {
+    // Bits that differ between two kmers
+    Kmer first = kmers[0];
+    Kmer changed = 0;
+
+    for (uint64_t i = 1;i < n;i++) {
+        changed |= kmers[i] ^ first;
+    }
+
+    for (int shift = 0;shift < 64;shift += KMER_RADIX_BITS) {
+        if (((changed >> shift) & (KMER_RADIX_SIZE - 1)) == 0) {
+            continue;
+        }
+
+        uint64_t offsets[KMER_RADIX_SIZE] = { 0 };
+
+        for (uint64_t i = 0;i < n;i++) {
+            offsets[(kmers[i] >> shift) & (KMER_RADIX_SIZE - 1)]++;
+        }
+
+        uint64_t offset = 0;
+
+        for (int i = 0;i < KMER_RADIX_SIZE;i++) {
+            uint64_t count = offsets[i];
+            offsets[i] = offset;
+            offset += count;
+        }
+
+        for (uint64_t i = 0;i < n;i++) {
+            tmp[offsets[(kmers[i] >> shift) & (KMER_RADIX_SIZE - 1)]++] = kmers[i];
+        }
+
+        Kmer *swap = kmers;
+        kmers = tmp;
+        tmp = swap;
+    }
+
+    return kmers;
+}
+
+/**
+ * \brief Removes the duplicates of a sorted array of kmers
+ * 
+ * @param kmers sorted array of kmers
+ * @param n number of kmers, strictly positive
+ * @return number of distinct kmers, stored at the beginning of the array
+ */
+static uint64_t removeDuplicates(Kmer *kmers, uint64_t n) {
+    uint64_t size = 1;
+
+    for (uint64_t i = 1;i < n;i++) {
+        if (kmers[i] != kmers[size - 1]) {
+            kmers[size++] = kmers[i];
+        }
+    }
+
+    return size;
+}
+
+/**
+ * \brief Sorts an array of kmers and removes its duplicates into a buffer
+ * 
+ * @param kmers array of kmers, it is modified
+ * @param n number of kmers, strictly positive
+ * @param buffer array of n kmers that will store the distinct kmers
+ * @return number of distinct kmers
+ */
+static uint64_t sortUniqueInto(Kmer *kmers, uint64_t n, Kmer *buffer) {
+    Kmer *sorted;
+
+    if (n < KMER_RADIX_MIN) {
+        qsort(kmers, n, sizeof(*kmers), compareKmers);
+        sorted = kmers;
+    }
+    else {
+        sorted = radixSort(kmers, buffer, n);
+    }
+
+    uint64_t size = removeDuplicates(sorted, n);
+
+    if (sorted != buffer) {
+        memcpy(buffer, sorted, size * sizeof(*buffer));
+    }
+
+    return size;
+}
+
+uint64_t kmerSortUnique(Kmer *kmers, uint64_t n) {
+    if (n == 0) {
+        return 0;
+    }
+
+    assert(kmers);
+
+    Kmer *buffer = (n < KMER_RADIX_MIN) ? NULL : malloc(sizeof(*buffer) * n);
+
+    if (!buffer) {
+        qsort(kmers, n, sizeof(*kmers), compareKmers);
+        return removeDuplicates(kmers, n);
+    }
+
+    uint64_t size = sortUniqueInto(kmers, n, buffer);
+    memcpy(kmers, buffer, size * sizeof(*kmers));
+
+    free(buffer);
+    return size;
+}
+
+uint64_t kmerSortCount(Kmer *kmers, uint64_t n, uint64_t minCount) {
+    if (n == 0) {
+        return 0;
+    }
+
+    assert(kmers);
+
+    Kmer *buffer = (n < KMER_RADIX_MIN) ? NULL : malloc(sizeof(*buffer) * n);
+    Kmer *sorted = kmers;
+
+    if (buffer) {
+        sorted = radixSort(kmers, buffer, n);
+    }
+    else {
+        qsort(kmers, n, sizeof(*kmers), compareKmers);
+    }
+
+    // Each run of equal kmers is replaced by one kmer if it is long enough
+    uint64_t size = 0;
+
+    for (uint64_t i = 0;i < n;) {
+        uint64_t end = i + 1;
+
+        while (end < n && sorted[end] == sorted[i]) {
+            end++;
+        }
+
+        if (end - i >= minCount) {
+            kmers[size++] = sorted[i];
+        }
+
+        i = end;
+    }
+
+    free(buffer);
+    return size;
+}
+
+bool kmerMergeUnique(Kmer *kmers, uint64_t sorted, uint64_t n, uint64_t *size) {
+    assert(size);
+    assert(sorted <= n);
+
+    if (sorted == n) {
+        *size = n;
+        return true;
+    }
+
+    assert(kmers);
+
+    Kmer *added = malloc(sizeof(*added) * (n - sorted));
+
+    if (!added) {
+        log_error("Unable to allocate %" PRIu64 " kmers", n - sorted);
+        return false;
+    }
+
+    uint64_t nbAdded = sortUniqueInto(kmers + sorted, n - sorted, added);
+
+    // The arrays are merged from their end, a kmer is written after the ones
+    // that it replaces have been read
+    uint64_t i = sorted;
+    uint64_t j = nbAdded;
+    uint64_t w = sorted + nbAdded;
+
+    while (j > 0) {
+        if (i > 0 && kmers[i - 1] > added[j - 1]) {
+            kmers[--w] = kmers[--i];
+        }
+        else {
+            // A kmer of both arrays is written once
+            if (i > 0 && kmers[i - 1] == added[j - 1]) {
+                i--;
+            }
+
+            kmers[--w] = added[--j];
+        }
+    }
+
+    // The remaining sorted kmers are at the beginning of the array,
+    // the merged ones are moved after them
+    if (w > i) {
+        memmove(kmers + i, kmers + w, (sorted + nbAdded - w) * sizeof(*kmers));
+    }
+
+    *size = i + (sorted + nbAdded - w);
+
+    free(added);
+    return true;
+}
+
+/**
+ * \brief Builds the index of a set
+ * 
+ * The number of buckets is a power of 2, so that the bucket of a kmer
+ * is given by its highest bits.
+ * 
+ * @param set a pointer to a KmerSet structure with sorted kmers
+ * @return true if the index was built, otherwise false
+ */
+static bool buildIndex(KmerSet *set) {
+    // Number of bits used by the greatest kmer
+    int width = (set->size > 0 && set->kmers[set->size - 1] > 0) ? 64 - __builtin_clzll(set->kmers[set->size - 1]) : 0;
+    int bits = 0;
+
+    while (bits < width && bits < 32 && ((uint64_t) KMER_SET_BUCKET_SIZE << bits) < set->size) {
+        bits++;
+    }
+
+    uint64_t nbBuckets = (uint64_t) 1 << bits;
+
+    set->indexBits = bits;
+    set->shift = width - bits;
+    set->index = malloc(sizeof(*set->index) * (nbBuckets + 1));
+
+    if (!set->index) {
+        log_error("Set index allocation error");
+        return false;
+    }
+
+    uint64_t i = 0;
+
+    for (uint64_t bucket = 0;bucket < nbBuckets;bucket++) {
+        set->index[bucket] = i;
+
+        while (i < set->size && kmerSetBucket(set, set->kmers[i]) == bucket) {
+            i++;
+        }
+    }
+
+    set->index[nbBuckets] = set->size;
+
+    return true;
+}
+
+KmerSet *kmerSetCreate(Kmer *kmers, uint64_t n) {
+    KmerSet *set = malloc(sizeof(*set));
+
+    if (!set) {
+        log_error("Set allocation error");
+        free(kmers);
+        return NULL;
+    }
+
+    set->size = kmerSortUnique(kmers, n);
+    set->kmers = kmers;
+    set->index = NULL;
+    set->ownsKmers = true;
+
+    // The duplicates are not kept in memory
+    if (set->size > 0 && set->size < n) {
+        Kmer *shrinked = realloc(kmers, sizeof(*kmers) * set->size);
+
+        if (shrinked) {
+            set->kmers = shrinked;
+        }
+    }
+
+    if (!buildIndex(set)) {
+        kmerSetDelete(set);
+        return NULL;
+    }
+
+    return set;
+}
+
+KmerSet *kmerSetWrap(const Kmer *kmers, uint64_t n) {
+    KmerSet *set = malloc(sizeof(*set));
+
+    if (!set) {
+        log_error("Set allocation error");
+        return NULL;
+    }
+
+    // The kmers are never modified through the set
+    set->kmers = (Kmer*) kmers;
+    set->size = n;
+    set->index = NULL;
+    set->ownsKmers = false;
+
+    if (!buildIndex(set)) {
+        kmerSetDelete(set);
+        return NULL;
+    }
+
+    return set;
+}
+
+void kmerSetDelete(KmerSet *set) {
+    if (set) {
+        if (set->ownsKmers) {
+            free(set->kmers);
+        }
+
+        free(set->index);
+        free(set);
+    }
+}
+
+bool kmerSetContains(const KmerSet *set, Kmer kmer) {
+    assert(set);
+
+    uint64_t bucket = kmerSetBucket(set, kmer);
+
+    if (bucket == (uint64_t) 1 << set->indexBits) {
+        return false;
+    }
+
+    // Binary search in the range of the bucket
+    uint64_t low = set->index[bucket];
+    uint64_t high = set->index[bucket + 1];
+
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+
+        if (set->kmers[middle] < kmer) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low < set->index[bucket + 1] && set->kmers[low] == kmer;
+}
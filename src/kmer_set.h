@@ -0,0 +1,147 @@
+#ifndef KMER_SET_H
+#define KMER_SET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "kmer.h"
+
+/**
+ * \brief Exact set of packed kmers
+ * 
+ * The kmers are stored in a sorted array without duplicates.
+ * The highest bits of a kmer select a bucket of the index, which gives
+ * the range of the array that could contain it : a bucket has about
+ * KMER_SET_BUCKET_SIZE kmers, so a lookup only reads a few cache lines.
+ */
+typedef struct KmerSet {
+    Kmer *kmers;
+    uint64_t size;
+    // Offset in the array of the first kmer of each bucket, followed by the size
+    uint64_t *index;
+    uint8_t indexBits;
+    uint8_t shift;
+    // False if the kmers are not released with the set (see kmerSetWrap)
+    bool ownsKmers;
+} KmerSet;
+
+/**
+ * \brief Average number of kmers in a bucket of the index
+ */
+#define KMER_SET_BUCKET_SIZE 4
+
+/**
+ * \brief Gets the number of kmers of the set
+ */
+#define kmerSetSize(set) ((set)->size)
+
+/**
+ * \brief Creates a new set from an array of kmers
+ * 
+ * The array must have been allocated with malloc, it is owned by the set
+ * and may be reallocated. The kmers are sorted and their duplicates removed.
+ * 
+ * If an allocation error occured, then NULL will be returned
+ * and the array will be freed.
+ * 
+ * @param kmers array of kmers, can be NULL if n is 0
+ * @param n number of kmers in the array
+ * @return a pointer to an allocated KmerSet structure
+ */
+KmerSet *kmerSetCreate(Kmer *kmers, uint64_t n);
+
+/**
+ * \brief Creates a new set that uses an array of kmers without copying it
+ * 
+ * The kmers must be sorted without duplicates, for example the kmers of
+ * a set stored in a file. The array is only read and it is not released
+ * by kmerSetDelete, it must stay valid until the set is deleted.
+ * 
+ * If an allocation error occured, then NULL will be returned.
+ * 
+ * @param kmers sorted array of distinct kmers, can be NULL if n is 0
+ * @param n number of kmers in the array
+ * @return a pointer to an allocated KmerSet structure
+ */
+KmerSet *kmerSetWrap(const Kmer *kmers, uint64_t n);
+
+/**
+ * \brief Frees the memory allocated for the given set
+ * 
+ * @param set a pointer to an allocated KmerSet structure
+ */
+void kmerSetDelete(KmerSet *set);
+
+/**
+ * \brief Gets the bucket of the index that could contain a kmer
+ * 
+ * The bucket is the number of buckets if the kmer is greater than all kmers of the set.
+ */
+static inline uint64_t kmerSetBucket(const KmerSet *set, Kmer kmer) {
+    uint64_t bucket = (set->shift >= 64) ? 0 : kmer >> set->shift;
+    uint64_t nbBuckets = (uint64_t) 1 << set->indexBits;
+
+    return (bucket < nbBuckets) ? bucket : nbBuckets;
+}
+
+/**
+ * \brief Prefetches the bucket of the index that could contain a kmer
+ * 
+ * @param set a pointer to a KmerSet structure
+ * @param kmer a packed kmer
+ */
+static inline void kmerSetPrefetch(const KmerSet *set, Kmer kmer) {
+    __builtin_prefetch(set->index + kmerSetBucket(set, kmer));
+}
+
+/**
+ * \brief Sorts an array of kmers and removes its duplicates
+ * 
+ * @param kmers array of kmers
+ * @param n number of kmers in the array
+ * @return number of distinct kmers, stored at the beginning of the array
+ */
+uint64_t kmerSortUnique(Kmer *kmers, uint64_t n);
+
+/**
+ * \brief Sorts an array of kmers and only keeps the ones that appear enough times
+ * 
+ * Each kept kmer is stored once, like kmerSortUnique which is
+ * the same as this function with a minimum count of 1.
+ * 
+ * @param kmers array of kmers
+ * @param n number of kmers in the array
+ * @param minCount minimum number of occurrences of a kept kmer
+ * @return number of kept kmers, stored sorted at the beginning of the array
+ */
+uint64_t kmerSortCount(Kmer *kmers, uint64_t n, uint64_t minCount);
+
+/**
+ * \brief Adds kmers to a sorted array of distinct kmers
+ * 
+ * The first sorted kmers of the array must be sorted without duplicates. The next ones,
+ * up to n, are sorted and merged with them : the array then starts with the distinct
+ * kmers of both parts. This keeps a collection of kmers small when it is deduplicated
+ * after each chunk of kmers.
+ * 
+ * If an allocation error occured, then false will be returned and the first sorted
+ * kmers are not changed.
+ * 
+ * @param kmers array of n kmers
+ * @param sorted number of distinct sorted kmers at the beginning of the array
+ * @param n number of kmers in the array
+ * @param size destination of the number of distinct kmers
+ * @return true if the kmers were merged, otherwise false
+ */
+bool kmerMergeUnique(Kmer *kmers, uint64_t sorted, uint64_t n, uint64_t *size);
+
+/**
+ * \brief Checks if the set contains a kmer
+ * 
+ * @param set a pointer to a KmerSet structure
+ * @param kmer a packed kmer
+ * @return true if the set contains the kmer, otherwise false
+ */
+bool kmerSetContains(const KmerSet *set, Kmer kmer);
+
+#endif // KMER_SET_H
@@ -0,0 +1,189 @@
+#define _GNU_SOURCE
+
+#include "numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Online NUMA nodes, in the format of the lists of the sysfs files
+#define NUMA_ONLINE_PATH "/sys/devices/system/node/online"
+
+// Policy of mbind that places the pages on the nodes one after the other
+#define NUMA_MPOL_INTERLEAVE 3
+
+// Number of bits of an unsigned long, the unit of the node masks of mbind
+#define NUMA_MASK_BITS (8 * sizeof(unsigned long))
+
+static bool g_pinning = false;
+
+// Processors given to the pinned threads, in the order of numaPinThread
+static int g_cpus[CPU_SETSIZE];
+static int g_nbCpus = 0;
+static pthread_once_t g_cpusOnce = PTHREAD_ONCE_INIT;
+
+// Index of the processor of the next pinned thread in g_cpus
+static unsigned int g_nextCpu = 0;
+
+/**
+ * \brief Reads a list of numbers from a sysfs file, such as "0-3,8,10-11"
+ *
+ * @param path path to the file
+ * @param values destination of the numbers
+ * @param max maximum number of values
+ * @return the number of values or -1 if the file could not be opened
+ */
+static int readList(const char *path, int *values, int max) {
+    FILE *fp = fopen(path, "r");
+
+    if (!fp) {
+        return -1;
+    }
+
+    int n = 0;
+    int first;
+
+    while (fscanf(fp, "%d", &first) == 1) {
+        int last = first;
+        int c = fgetc(fp);
+
+        if (c == '-') {
+            if (fscanf(fp, "%d", &last) != 1) {
+                break;
+            }
+
+            c = fgetc(fp);
+        }
+
+        for (int value = first;value <= last && n < max;value++) {
+            values[n++] = value;
+        }
+
+        if (c != ',') {
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    return n;
+}
+
+int numaNodes(void) {
+    int nodes[NUMA_MAX_NODES];
+    int n = readList(NUMA_ONLINE_PATH, nodes, NUMA_MAX_NODES);
+
+    return (n > 0) ? n : 1;
+}
+
+bool numaInterleave(void *data, size_t len) {
+#ifdef SYS_mbind
+    int nodes[NUMA_MAX_NODES];
+    int n = readList(NUMA_ONLINE_PATH, nodes, NUMA_MAX_NODES);
+
+    if (n <= 0) {
+        return false;
+    }
+
+    unsigned long mask[NUMA_MAX_NODES / NUMA_MASK_BITS] = { 0 };
+
+    for (int i = 0;i < n;i++) {
+        if (nodes[i] >= 0 && nodes[i] < NUMA_MAX_NODES) {
+            mask[nodes[i] / NUMA_MASK_BITS] |= 1UL << (nodes[i] % NUMA_MASK_BITS);
+        }
+    }
+
+    // The kernel reads maxnode - 1 bits of the mask
+    return syscall(SYS_mbind, data, len, NUMA_MPOL_INTERLEAVE, mask, NUMA_MAX_NODES + 1, 0) == 0;
+#else
+    (void) data;
+    (void) len;
+
+    return false;
+#endif
+}
+
+void numaSetPinning(bool enabled) {
+    g_pinning = enabled;
+}
+
+/**
+ * \brief Orders the processors allowed for the process into g_cpus
+ *
+ * The first processor of each node is followed by the second one of each node,
+ * and so on. The processors that are not in a node are given last.
+ */
+static void initCpus(void) {
+    cpu_set_t allowed;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+
+    int nodes[NUMA_MAX_NODES];
+    int nbNodes = readList(NUMA_ONLINE_PATH, nodes, NUMA_MAX_NODES);
+
+    // Processors given to a thread are removed from the allowed ones
+    int taken[NUMA_MAX_NODES] = { 0 };
+    bool added = nbNodes > 0;
+
+    while (added) {
+        added = false;
+
+        for (int i = 0;i < nbNodes;i++) {
+            char path[64];
+            int cpus[CPU_SETSIZE];
+
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+            int nbCpus = readList(path, cpus, CPU_SETSIZE);
+
+            // Next allowed processor of the node
+            for (int j = 0, skipped = 0;j < nbCpus;j++) {
+                if (cpus[j] < 0 || cpus[j] >= CPU_SETSIZE || !CPU_ISSET(cpus[j], &allowed)) {
+                    continue;
+                }
+
+                if (skipped++ < taken[i]) {
+                    continue;
+                }
+
+                g_cpus[g_nbCpus++] = cpus[j];
+                taken[i]++;
+                added = true;
+                break;
+            }
+        }
+    }
+
+    for (int i = 0;i < g_nbCpus;i++) {
+        CPU_CLR(g_cpus[i], &allowed);
+    }
+
+    for (int cpu = 0;cpu < CPU_SETSIZE;cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            g_cpus[g_nbCpus++] = cpu;
+        }
+    }
+}
+
+bool numaPinThread(void) {
+    if (!g_pinning) {
+        return true;
+    }
+
+    pthread_once(&g_cpusOnce, initCpus);
+
+    if (g_nbCpus == 0) {
+        return false;
+    }
+
+    unsigned int next = __atomic_fetch_add(&g_nextCpu, 1, __ATOMIC_RELAXED);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(g_cpus[next % g_nbCpus], &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,60 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \brief Maximum number of NUMA nodes used by this module
+ */
+#define NUMA_MAX_NODES 64
+
+/**
+ * \brief Gets the number of online NUMA nodes
+ *
+ * The nodes are read from /sys/devices/system/node/online,
+ * a computer without this file has one node.
+ *
+ * @return the number of nodes, at least 1
+ */
+int numaNodes(void);
+
+/**
+ * \brief Interleaves the pages of a memory area on all online NUMA nodes
+ *
+ * The policy is applied to the pages that are not used yet : the pages of
+ * the area are then placed on the nodes one after the other, so that the
+ * accesses to the area from all nodes share the bandwidth of all nodes.
+ * The area must start on a page.
+ *
+ * If the policy could not be applied, for instance with a kernel without
+ * NUMA support, then false will be returned and the area is not changed.
+ *
+ * @param data first byte of the area
+ * @param len size of the area (in bytes)
+ * @return true if the pages are interleaved, otherwise false
+ */
+bool numaInterleave(void *data, size_t len);
+
+/**
+ * \brief Enables the pinning of the threads that call numaPinThread
+ *
+ * The pinning is disabled by default.
+ *
+ * @param enabled true if the threads are pinned
+ */
+void numaSetPinning(bool enabled);
+
+/**
+ * \brief Pins the calling thread on one processor when the pinning is enabled
+ *
+ * The processors allowed for the process are given to the threads one after
+ * the other, alternating between the NUMA nodes : the threads of a program are
+ * spread on all nodes and they are not moved by the scheduler.
+ * Nothing is done if the pinning is disabled (see numaSetPinning).
+ *
+ * @return true if the thread was pinned or if the pinning is disabled, otherwise false
+ */
+bool numaPinThread(void);
+
+#endif // NUMA_H
@@ -125,7 +125,7 @@ bool queuePush(Queue *queue, void *value) {
             pthread_mutex_unlock(&queue->lock);
             return false;
         }
-        queue->emptyWaiters--;
+        queue->fullWaiters--;
     }
 
     memcpy(queue->data + queue->elemSize * queue->head, value, queue->elemSize);
@@ -1,8 +1,6 @@
 #include "utils.h"
 
-#include "bloom_filter.h"
-#include "log.h"
-#include "string_utils.h"
+#include "de_bruijn_graph.h"
 
 #include <assert.h>
 #include <errno.h>
@@ -13,25 +11,33 @@
 char *canonicalForm(char *kmer, size_t len) {
     assert(kmer);
 
-    if (len == 0) {
+    if (len == 0 || len > KMER128_MAX_SIZE) {
         return NULL;
     }
 
-    char *rc = malloc(sizeof(*rc) * len);
-    if (!rc) {
-        return NULL;
-    }
+    // The kmer is packed on 128 bits only when it does not fit into 64 bits
+    if (len <= KMER_MAX_SIZE) {
+        Kmer packed;
+        kmerEncode(kmer, len, &packed);
 
-    memcpy(rc, kmer, len);
-    reverseComplement(rc, len);
+        Kmer rc = kmerReverseComplement(packed, len);
 
-    if (strncmp(kmer, rc, len) > 0) {
-        // The reverse-complement is before the kmer
-        // in the lexicographic order
-        memcpy(kmer, rc, len);
+        if (rc < packed) {
+            // The reverse-complement is before the kmer
+            // in the lexicographic order
+            kmerDecode(rc, len, kmer);
+        }
     }
+    else {
+        Kmer128 packed;
+        kmer128Encode(kmer, len, &packed);
 
-    free(rc);
+        Kmer128 rc = kmer128ReverseComplement(packed, len);
+
+        if (rc < packed) {
+            kmer128Decode(rc, len, kmer);
+        }
+    }
 
     return kmer;
 }
@@ -49,46 +55,80 @@ const char *gzFileError(gzFile fp) {
     return str;
 }
 
-int findNeighbors(BloomFilter *bf, const char *kmer, size_t len, char *neighbors) {
-    assert(bf);
+int findNeighbors(DeBruijnGraph *graph, const char *kmer, size_t len, char *neighbors) {
+    assert(graph);
     assert(kmer);
     assert(neighbors);
 
+    KmerHash hash;
+
     if (len < 2) {
         return -1;
     }
 
-    // Will contain the last 3 letters of the kmer + an additional letter
-    char *nextKmer = malloc(sizeof(*nextKmer) * len);
+    if (len <= KMER_MAX_SIZE) {
+        Kmer packed;
+        kmerEncode(kmer, len, &packed);
+        kmerHashInit(&hash, packed, len);
+
+        return findKmerNeighbors(graph, packed, &hash, len, neighbors);
+    }
 
-    if (!nextKmer) {
+    Kmer128 packed;
+
+    if (!kmer128Encode(kmer, len, &packed)) {
         return -1;
     }
 
-    int nbNeighbors = 0;
-    char letters[] = { 'A', 'T', 'C', 'G' };
+    kmerHashInit128(&hash, packed, len);
+
+    return findKmer128Neighbors(graph, packed, &hash, len, neighbors);
+}
 
-    for (int i = 0;i < 4;i++) {
-        // Copies the last n letters of the kmer, where n = len - 1
-        memcpy(nextKmer, kmer + 1, len - 1);
+int findKmerNeighbors(DeBruijnGraph *graph, Kmer kmer, const KmerHash *hash, int k, char *neighbors) {
+    assert(graph);
+    assert(hash);
+    assert(neighbors);
 
-        // Adds the final letter
-        nextKmer[len - 1] = letters[i];
+    if (k < 2 || k > KMER_MAX_SIZE) {
+        return -1;
+    }
 
-        // Computes the canonical form (nextKmer will be modified)
-        if (!canonicalForm(nextKmer, len)) {
-            free(nextKmer);
-            log_error("canonical form error");
-            return -1;
-        }
+    bool found[4];
+    containsSuccessors(graph, &kmer, hash, 1, k, found);
 
-        if (bfContains(bf, nextKmer, len)) {
+    int nbNeighbors = 0;
+
+    for (uint8_t base = 0;base < 4;base++) {
+        if (found[base]) {
             // Adds the letter into the container if the current next kmer
-            // is in the filter
-            neighbors[nbNeighbors++] = letters[i];
+            // is in the graph
+            neighbors[nbNeighbors++] = kmerDecodeBase(base);
         }
     }
 
-    free(nextKmer);
     return nbNeighbors;
-}
\ No newline at end of file
+}
+
+int findKmer128Neighbors(DeBruijnGraph *graph, Kmer128 kmer, const KmerHash *hash, int k, char *neighbors) {
+    assert(graph);
+    assert(hash);
+    assert(neighbors);
+
+    if (k < 2 || k > dbgMaxKmerSize(graph->backend)) {
+        return -1;
+    }
+
+    bool found[4];
+    containsSuccessors128(graph, &kmer, hash, 1, k, found);
+
+    int nbNeighbors = 0;
+
+    for (uint8_t base = 0;base < 4;base++) {
+        if (found[base]) {
+            neighbors[nbNeighbors++] = kmerDecodeBase(base);
+        }
+    }
+
+    return nbNeighbors;
+}
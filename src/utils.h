@@ -5,7 +5,10 @@
 
 #include <zlib.h>
 
-struct BloomFilter;
+#include "kmer.h"
+#include "kmer_hash.h"
+
+struct DeBruijnGraph;
 
 /**
  * \brief Computes the canonical form of a kmer
@@ -13,7 +16,11 @@ struct BloomFilter;
  * The canonical form is the first of this two following elements
  * in the lexicographic order : the kmer itself and its reverse complement.
  * 
- * The given kmer will be modified to store the canonical form
+ * The given kmer will be modified to store the canonical form.
+ * It must only contain the following letters : A, T, C, G (in upper case).
+ * 
+ * NULL will be returned if the length is 0 or greater than KMER128_MAX_SIZE.
+ * The kmer is packed on 64 bits if its length is at most KMER_MAX_SIZE, otherwise on 128 bits.
  * 
  * @param kmer a string containing the kmer, will be modified
  * @param len length of the kmer
@@ -22,21 +29,55 @@ struct BloomFilter;
 char *canonicalForm(char *kmer, size_t len);
 
 /**
- * \brief Finds neighbors of the given kmer that are in the bloom filter
+ * \brief Finds neighbors of the given kmer that are in the graph
  * 
  * The length of the kmer must be greater than 1 and contains only
  * the following letters : A, T, C, G (in upper case).
+ * It is packed on 128 bits if it is longer than KMER_MAX_SIZE (see findKmer128Neighbors).
  * 
  * The parameter "neighbors" will receive 4 chars maximum that correspond
  * to the last letter of the following kmer.
  * 
- * @param bf a pointer to a Bloom Filter structure
+ * @param graph a pointer to a DeBruijnGraph structure
  * @param kmer
  * @param len length of the kmer
  * @param neighbors array that will store neighbors, could store 4 elements max
  * @return number of neighbors found if the Bloom Filter or a negative value in case of an error
  */
-int findNeighbors(struct BloomFilter *bf, const char *kmer, size_t len, char *neighbors);
+int findNeighbors(struct DeBruijnGraph *graph, const char *kmer, size_t len, char *neighbors);
+
+/**
+ * \brief Finds neighbors of the given packed kmer that are in the graph
+ * 
+ * This function behaves like findNeighbors, without having to pack and hash the kmer.
+ * The hash of each neighbor is rolled from the hash of the kmer.
+ * Neighbors that are critical false positives of the graph are skipped.
+ * The length of the kmer must be greater than 1 and less or equal to KMER_MAX_SIZE.
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param kmer a packed kmer
+ * @param hash hash values of the kmer
+ * @param k length of the kmer
+ * @param neighbors array that will store neighbors, could store 4 elements max
+ * @return number of neighbors found if the Bloom Filter or a negative value in case of an error
+ */
+int findKmerNeighbors(struct DeBruijnGraph *graph, Kmer kmer, const KmerHash *hash, int k, char *neighbors);
+
+/**
+ * \brief Finds neighbors of the given kmer packed on 128 bits that are in the graph
+ * 
+ * This function behaves like findKmerNeighbors (see containsSuccessors128).
+ * The length of the kmer must be greater than 1 and less or equal to the
+ * maximum length of the kmers of the graph (see dbgMaxKmerSize).
+ * 
+ * @param graph a pointer to a DeBruijnGraph structure
+ * @param kmer a kmer packed on 128 bits
+ * @param hash hash values of the kmer
+ * @param k length of the kmer
+ * @param neighbors array that will store neighbors, could store 4 elements max
+ * @return number of neighbors found or a negative value in case of an error
+ */
+int findKmer128Neighbors(struct DeBruijnGraph *graph, Kmer128 kmer, const KmerHash *hash, int k, char *neighbors);
 
 /**
  * \brief Returns the error message associated to the given gzip file
@@ -0,0 +1,188 @@
+#include "unity.h"
+
+#include "block_gzip.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+static unsigned char *g_member;
+static char *g_data;
+
+/**
+ * \brief Allocates pseudo random data that can be compressed
+ */
+char *createData(uint64_t len) {
+    char *data = malloc(len > 0 ? len : 1);
+    TEST_ASSERT_NOT_NULL(data);
+
+    uint64_t state = 42;
+    for (uint64_t i = 0;i < len;i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        data[i] = "ACGT"[(state >> 60) & 0x3];
+    }
+
+    return data;
+}
+
+void setUp() {
+    g_member = NULL;
+    g_data = NULL;
+}
+
+void tearDown() {
+    free(g_member);
+    free(g_data);
+}
+
+void test_bgzCompress_bgzDecompress() {
+    g_data = createData(10000);
+
+    uint64_t size;
+    TEST_ASSERT_TRUE(bgzCompress(g_data, 10000, 6, 0, 0, NULL, 0, &g_member, &size));
+    TEST_ASSERT_LESS_THAN(10000, size);
+    TEST_ASSERT_EQUAL(10000, bgzDataSize(g_member, size));
+
+    char result[10000];
+    TEST_ASSERT_TRUE(bgzDecompress(g_member, size, result, 10000));
+    TEST_ASSERT_EQUAL_MEMORY(g_data, result, 10000);
+
+    // The whole data must be in the member
+    TEST_ASSERT_FALSE(bgzDecompress(g_member, size, result, 9999));
+    TEST_ASSERT_FALSE(bgzDecompress(g_member, size - 1, result, 10000));
+}
+
+void test_bgzCompress_bgzDecompress_Should_AcceptEmptyData() {
+    uint64_t size;
+    TEST_ASSERT_TRUE(bgzCompress(NULL, 0, 9, 0, 0, NULL, 0, &g_member, &size));
+    TEST_ASSERT_EQUAL(0, bgzDataSize(g_member, size));
+    TEST_ASSERT_TRUE(bgzDecompress(g_member, size, NULL, 0));
+}
+
+void test_bgzDecompress_Should_ReturnFalse_When_GivenInvalidChecksum() {
+    g_data = createData(1000);
+
+    uint64_t size;
+    TEST_ASSERT_TRUE(bgzCompress(g_data, 1000, 6, 0, 0, NULL, 0, &g_member, &size));
+
+    // The trailer ends with the checksum and the size of the data
+    g_member[size - 8] ^= 0x1;
+
+    char result[1000];
+    TEST_ASSERT_FALSE(bgzDecompress(g_member, size, result, 1000));
+}
+
+void test_bgzFindSubfield_Should_FindWrittenSubfield() {
+    g_data = createData(100);
+    uint64_t table[3] = { 1, 2, 3 };
+
+    uint64_t size;
+    TEST_ASSERT_TRUE(bgzCompress(g_data, 100, 6, 'F', 'G', table, sizeof(table), &g_member, &size));
+
+    const unsigned char *subfield;
+    uint16_t subfieldLen;
+
+    TEST_ASSERT_TRUE(bgzFindSubfield(g_member, size, 'F', 'G', &subfield, &subfieldLen));
+    TEST_ASSERT_EQUAL(sizeof(table), subfieldLen);
+    TEST_ASSERT_EQUAL_MEMORY(table, subfield, sizeof(table));
+
+    // The subfield data has a fixed position
+    TEST_ASSERT_TRUE(subfield == g_member + BGZ_HEADER_SIZE + 6);
+
+    TEST_ASSERT_FALSE(bgzFindSubfield(g_member, size, 'B', 'C', &subfield, &subfieldLen));
+    TEST_ASSERT_FALSE(bgzFindSubfield(g_member, BGZ_HEADER_SIZE + 4, 'F', 'G', &subfield, &subfieldLen));
+
+    // The extra field is not a part of the checksum
+    memset(g_member + BGZ_HEADER_SIZE + 6, 0, sizeof(table));
+
+    char result[100];
+    TEST_ASSERT_TRUE(bgzDecompress(g_member, size, result, 100));
+    TEST_ASSERT_EQUAL_MEMORY(g_data, result, 100);
+}
+
+void test_bgzFindSubfield_Should_ReturnFalse_When_GivenMemberWithoutExtraField() {
+    g_data = createData(100);
+
+    uint64_t size;
+    TEST_ASSERT_TRUE(bgzCompress(g_data, 100, 6, 0, 0, NULL, 0, &g_member, &size));
+
+    const unsigned char *subfield;
+    uint16_t subfieldLen;
+    TEST_ASSERT_FALSE(bgzFindSubfield(g_member, size, 'F', 'G', &subfield, &subfieldLen));
+}
+
+void test_bgzWriteBlocks_bgzReadBlocks() {
+    uint64_t len = 100000;
+    uint64_t blockSize = 4096;
+    uint64_t nbBlocks = (len + blockSize - 1) / blockSize;
+
+    g_data = createData(len);
+    uint64_t sizes[nbBlocks];
+
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    // The members do not start at the beginning of the file
+    TEST_ASSERT_EQUAL(3, fwrite("abc", 1, 3, fp));
+    TEST_ASSERT_TRUE(bgzWriteBlocks(fp, g_data, len, blockSize, 6, 4, sizes));
+    fflush(fp);
+
+    for (int nbThreads = 1;nbThreads <= 8;nbThreads *= 2) {
+        char *result = malloc(len);
+        TEST_ASSERT_NOT_NULL(result);
+
+        TEST_ASSERT_TRUE(bgzReadBlocks(fp, 3, result, len, blockSize, sizes, nbThreads));
+        TEST_ASSERT_EQUAL_MEMORY(g_data, result, len);
+
+        // The offsets of the members are given by their sizes
+        TEST_ASSERT_FALSE(bgzReadBlocks(fp, 4, result, len, blockSize, sizes, nbThreads));
+
+        free(result);
+    }
+
+    fclose(fp);
+}
+
+void test_bgzWriteBlocks_Should_WriteGzipFile() {
+    uint64_t len = 50000;
+    uint64_t sizes[5];
+
+    g_data = createData(len);
+
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+    TEST_ASSERT_TRUE(bgzWriteBlocks(fp, g_data, len, 10000, 9, 2, sizes));
+    fflush(fp);
+    rewind(fp);
+
+    // The members are read one after the other by zlib
+    gzFile gz = gzdopen(dup(fileno(fp)), "rb");
+    TEST_ASSERT_NOT_NULL(gz);
+
+    char *result = malloc(len + 1);
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL(len, gzread(gz, result, len + 1));
+    TEST_ASSERT_EQUAL_MEMORY(g_data, result, len);
+
+    free(result);
+    gzclose(gz);
+    fclose(fp);
+}
+
+int main() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bgzCompress_bgzDecompress);
+    RUN_TEST(test_bgzCompress_bgzDecompress_Should_AcceptEmptyData);
+    RUN_TEST(test_bgzDecompress_Should_ReturnFalse_When_GivenInvalidChecksum);
+    RUN_TEST(test_bgzFindSubfield_Should_FindWrittenSubfield);
+    RUN_TEST(test_bgzFindSubfield_Should_ReturnFalse_When_GivenMemberWithoutExtraField);
+    RUN_TEST(test_bgzWriteBlocks_bgzReadBlocks);
+    RUN_TEST(test_bgzWriteBlocks_Should_WriteGzipFile);
+
+    return UNITY_END();
+}
@@ -1,11 +1,13 @@
 #include "unity.h"
 
 #include "bloom_filter.h"
+#include "fast_hash.h"
 
 BloomFilter *g_bf = NULL;
 
 void setUp() {
     g_bf = NULL;
+    bfSetAllocation(BF_ALLOC_DEFAULT);
 }
 
 void tearDown() {
@@ -22,6 +24,7 @@ void test_bfCreate_Should_ReturnValidFilter() {
 
     TEST_ASSERT_EQUAL(8, bfSize(g_bf));
     TEST_ASSERT_EQUAL(3, bfNbHashs(g_bf));
+    TEST_ASSERT_EQUAL(BF_HASH_DOUBLE, bfHashScheme(g_bf));
 
     for (size_t i = 0;i < bfBitSize(g_bf);i++) {
         TEST_ASSERT_EQUAL(0, bfGetBit(g_bf, i, NULL));
@@ -103,6 +106,313 @@ void test_bfContains_Should_ReturnTrue_When_GivenExistingHash() {
     TEST_ASSERT_EQUAL(true, bfContains(g_bf, "bar", 3));
 }
 
+void test_bfContains_Should_ReturnTrue_When_GivenExistingHashWithSeededScheme() {
+    g_bf = bfCreate(8, 2);
+    g_bf->hashScheme = BF_HASH_SEEDED;
+    g_bf->addressing = BF_ADDRESSING_MODULO;
+
+    bfAdd(g_bf, "bar", 3);
+
+    TEST_ASSERT_EQUAL(true, bfContains(g_bf, "bar", 3));
+    TEST_ASSERT_EQUAL(false, bfContains(g_bf, "foo", 3));
+}
+
+void test_bfContains_Should_ReturnTrue_When_GivenExistingValueWithFastFunction() {
+    g_bf = bfCreate(64, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    g_bf->hashFunction = BF_FUNCTION_FAST;
+
+    // Values of 8 bytes are mixed, the other ones are hashed
+    uint64_t kmer = 0x1234567890ULL;
+    uint64_t other = 0x1234567891ULL;
+    char longValue[] = "a value longer than 48 bytes, hashed by several lanes";
+
+    TEST_ASSERT_TRUE(bfAdd(g_bf, &kmer, sizeof(kmer)));
+    TEST_ASSERT_TRUE(bfAdd(g_bf, "bar", 3));
+    TEST_ASSERT_TRUE(bfAdd(g_bf, longValue, sizeof(longValue)));
+
+    TEST_ASSERT_TRUE(bfContains(g_bf, &kmer, sizeof(kmer)));
+    TEST_ASSERT_TRUE(bfContains(g_bf, "bar", 3));
+    TEST_ASSERT_TRUE(bfContains(g_bf, longValue, sizeof(longValue)));
+    TEST_ASSERT_FALSE(bfContains(g_bf, &other, sizeof(other)));
+    TEST_ASSERT_FALSE(bfContains(g_bf, "foo", 3));
+
+    // A value of 8 bytes has the bits of its mixed hash
+    TEST_ASSERT_TRUE(bfContainsHash(g_bf, fastHashMix64(kmer)));
+}
+
+void test_bfContainsHash_Should_ReturnFalse_When_GivenUnknownHash() {
+    g_bf = bfCreate(8, 2);
+
+    bfAddHash(g_bf, 0x1234567890abcdefULL);
+
+    TEST_ASSERT_EQUAL(false, bfContainsHash(g_bf, 0xfedcba0987654321ULL));
+}
+
+void test_bfContainsHash_Should_ReturnTrue_When_GivenExistingHash() {
+    g_bf = bfCreate(8, 2);
+
+    TEST_ASSERT_TRUE(bfAddHash(g_bf, 0x1234567890abcdefULL));
+
+    TEST_ASSERT_EQUAL(true, bfContainsHash(g_bf, 0x1234567890abcdefULL));
+}
+
+void test_bfContainsHashBatch_Should_ReturnSameResultsAsBfContainsHash() {
+    g_bf = bfCreate(64, 3);
+
+    uint64_t hashes[8];
+
+    for (int i = 0;i < 8;i++) {
+        hashes[i] = 0x9e3779b97f4a7c15ULL * (i + 1);
+
+        // Only one value out of two is inserted
+        if (i % 2 == 0) {
+            TEST_ASSERT_TRUE(bfAddHash(g_bf, hashes[i]));
+        }
+    }
+
+    bool results[8];
+    int nbFound = bfContainsHashBatch(g_bf, hashes, 8, results);
+    int expected = 0;
+
+    for (int i = 0;i < 8;i++) {
+        TEST_ASSERT_EQUAL(bfContainsHash(g_bf, hashes[i]), results[i]);
+        expected += results[i];
+
+        if (i % 2 == 0) {
+            TEST_ASSERT_TRUE(results[i]);
+        }
+    }
+
+    TEST_ASSERT_EQUAL(expected, nbFound);
+}
+
+void test_bfAddHash_Should_UseAllBits() {
+    g_bf = bfCreate(8, 1);
+
+    // With one hash function, the position of a hash is its
+    // high bits multiplied by the number of bits
+    TEST_ASSERT_TRUE(bfAddHash(g_bf, 0xFFFFFFFFFFFFFFFFULL));
+    TEST_ASSERT_EQUAL(1, bfGetBit(g_bf, 63, NULL));
+}
+
+void test_bfAddHash_Should_UseFirstBits_When_GivenModuloAddressing() {
+    g_bf = bfCreate(8, 1);
+    g_bf->addressing = BF_ADDRESSING_MODULO;
+    g_bf->bitSize = 10;
+
+    TEST_ASSERT_TRUE(bfAddHash(g_bf, 0x0000000100000008ULL));
+    TEST_ASSERT_EQUAL(1, bfGetBit(g_bf, 9, NULL));
+    TEST_ASSERT_TRUE(bfContainsHash(g_bf, 0x0000000100000008ULL));
+}
+
+void test_bfOptimalParameters_Should_ReturnFalse_When_GivenInvalidRate() {
+    long size;
+    int8_t nbHashs;
+
+    TEST_ASSERT_FALSE(bfOptimalParameters(1000, 0, 0, &size, &nbHashs));
+    TEST_ASSERT_FALSE(bfOptimalParameters(1000, 1, 0, &size, &nbHashs));
+}
+
+void test_bfOptimalParameters_Should_GiveTargetRate() {
+    long size;
+    int8_t nbHashs;
+
+    // About 9.6 bits per value and 7 hash functions for 1%
+    TEST_ASSERT_TRUE(bfOptimalParameters(1000000, 0.01, 0, &size, &nbHashs));
+    TEST_ASSERT_EQUAL(7, nbHashs);
+    TEST_ASSERT_GREATER_OR_EQUAL(1190000, size);
+    TEST_ASSERT_LESS_OR_EQUAL(1210000, size);
+    TEST_ASSERT_LESS_OR_EQUAL(0.0101, bfFalsePositiveRate(1000000, size * 8, nbHashs));
+}
+
+void test_bfOptimalParameters_Should_LimitSize_When_GivenMaxSize() {
+    long size;
+    int8_t nbHashs;
+
+    TEST_ASSERT_TRUE(bfOptimalParameters(1000000, 0.01, 500000, &size, &nbHashs));
+    TEST_ASSERT_EQUAL(500000, size);
+    TEST_ASSERT_EQUAL(3, nbHashs);
+}
+
+void test_bfCreateBlocked_Should_ReturnNull_When_GivenSizeLessThanBlock() {
+    TEST_ASSERT_NULL(bfCreateBlocked(BF_BLOCK_SIZE - 1, 3));
+}
+
+void test_bfAddHash_Should_UpdateOneBlock_When_GivenBlockedFilter() {
+    g_bf = bfCreateBlocked(BF_BLOCK_SIZE * 4, 7);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_LAYOUT_BLOCKED, bfLayout(g_bf));
+
+    TEST_ASSERT_TRUE(bfAddHash(g_bf, 0x1234567890abcdefULL));
+
+    int updatedBlocks = 0;
+    int updatedBits = 0;
+
+    for (int block = 0;block < 4;block++) {
+        int blockBits = 0;
+
+        for (int i = 0;i < BF_BLOCK_BITS;i++) {
+            blockBits += bfGetBit(g_bf, block * BF_BLOCK_BITS + i, NULL);
+        }
+
+        updatedBlocks += blockBits > 0;
+        updatedBits += blockBits;
+    }
+
+    TEST_ASSERT_EQUAL(1, updatedBlocks);
+    TEST_ASSERT_GREATER_THAN(0, updatedBits);
+    TEST_ASSERT_LESS_OR_EQUAL(bfNbHashs(g_bf), updatedBits);
+
+    TEST_ASSERT_TRUE(bfContainsHash(g_bf, 0x1234567890abcdefULL));
+    TEST_ASSERT_FALSE(bfContainsHash(g_bf, 0xfedcba0987654321ULL));
+}
+
+void test_bfContains_Should_ReturnTrue_When_GivenExistingValueInBlockedFilter() {
+    g_bf = bfCreateBlocked(BF_BLOCK_SIZE * 4, 7);
+
+    TEST_ASSERT_TRUE(bfAdd(g_bf, "bar", 3));
+
+    TEST_ASSERT_TRUE(bfContains(g_bf, "bar", 3));
+    TEST_ASSERT_FALSE(bfContains(g_bf, "foo", 3));
+}
+
+void test_bfCreateFromData_Should_ReturnNull_When_GivenInvalidParameters() {
+    _Alignas(BF_BLOCK_SIZE) char data[BF_BLOCK_SIZE * 2];
+
+    TEST_ASSERT_NULL(bfCreateFromData(data + 1, BF_BLOCK_SIZE, 3, BF_LAYOUT_BLOCKED));
+    TEST_ASSERT_NULL(bfCreateFromData(data, BF_BLOCK_SIZE, 0, BF_LAYOUT_BLOCKED));
+}
+
+void test_bfCreateFromData_Should_UseGivenData() {
+    _Alignas(BF_BLOCK_SIZE) char data[BF_BLOCK_SIZE * 2] = { 0 };
+
+    g_bf = bfCreateFromData(data, sizeof(data), 5, BF_LAYOUT_BLOCKED);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_LAYOUT_BLOCKED, bfLayout(g_bf));
+    TEST_ASSERT_EQUAL(sizeof(data) * 8, bfBitSize(g_bf));
+
+    TEST_ASSERT_TRUE(bfAddHash(g_bf, 0x1234567890abcdefULL));
+    TEST_ASSERT_TRUE(bfContainsHash(g_bf, 0x1234567890abcdefULL));
+
+    // The bits are set in the given array, which is not released by bfDelete
+    bool changed = false;
+    for (size_t i = 0;i < sizeof(data);i++) {
+        changed |= data[i] != 0;
+    }
+    TEST_ASSERT_TRUE(changed);
+}
+
+void test_bfUnion_Should_ContainValuesOfBothFilters() {
+    g_bf = bfCreate(1000, 3);
+    BloomFilter *other = bfCreate(1000, 3);
+    BloomFilter *serial = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_NOT_NULL(other);
+    TEST_ASSERT_NOT_NULL(serial);
+
+    // Each filter gets half of the values, the serial one gets all of them
+    for (uint64_t hash = 1;hash <= 100;hash++) {
+        TEST_ASSERT_TRUE(bfAddHash((hash % 2) ? g_bf : other, hash * 0x9E3779B97F4A7C15ULL));
+        TEST_ASSERT_TRUE(bfAddHash(serial, hash * 0x9E3779B97F4A7C15ULL));
+    }
+
+    TEST_ASSERT_TRUE(bfUnion(g_bf, other));
+    TEST_ASSERT_EQUAL_MEMORY(serial->data, g_bf->data, bfSize(serial));
+
+    bfDelete(other);
+    bfDelete(serial);
+}
+
+void test_bfUnion_Should_ReturnFalse_When_GivenDifferentParameters() {
+    g_bf = bfCreate(BF_BLOCK_SIZE, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(bfAddHash(g_bf, 42));
+
+    BloomFilter *others[] = {
+        bfCreate(BF_BLOCK_SIZE * 2, 3), bfCreate(BF_BLOCK_SIZE, 4), bfCreateBlocked(BF_BLOCK_SIZE, 3),
+        bfCreate(BF_BLOCK_SIZE, 3)
+    };
+
+    TEST_ASSERT_NOT_NULL(others[3]);
+    others[3]->hashFunction = BF_FUNCTION_FAST;
+
+    for (int i = 0;i < 4;i++) {
+        TEST_ASSERT_NOT_NULL(others[i]);
+        TEST_ASSERT_TRUE(bfAddHash(others[i], 7));
+
+        TEST_ASSERT_FALSE(bfUnion(g_bf, others[i]));
+        TEST_ASSERT_FALSE(bfContainsHash(g_bf, 7));
+
+        bfDelete(others[i]);
+    }
+}
+
+void test_bfHashBits_Should_GiveBitsOfBfAddHash() {
+    for (int blocked = 0;blocked < 2;blocked++) {
+        g_bf = blocked ? bfCreateBlocked(BF_BLOCK_SIZE * 8, 5) : bfCreate(BF_BLOCK_SIZE * 8, 5);
+        BloomFilter *bf = blocked ? bfCreateBlocked(BF_BLOCK_SIZE * 8, 5) : bfCreate(BF_BLOCK_SIZE * 8, 5);
+        TEST_ASSERT_NOT_NULL(g_bf);
+        TEST_ASSERT_NOT_NULL(bf);
+
+        uint64_t bits[5];
+
+        for (uint64_t hash = 1;hash < 50;hash++) {
+            TEST_ASSERT_TRUE(bfAddHash(g_bf, hash * 0x9e3779b97f4a7c15ULL));
+            bfHashBits(bf, hash * 0x9e3779b97f4a7c15ULL, bits);
+
+            for (int i = 0;i < 5;i++) {
+                TEST_ASSERT_TRUE(bfSetBit(bf, bits[i]));
+
+                // All bits of a value are in its block
+                if (blocked) {
+                    TEST_ASSERT_EQUAL(bfHashBlock(bf, hash * 0x9e3779b97f4a7c15ULL), bits[i] / BF_BLOCK_BITS);
+                }
+            }
+        }
+
+        TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(bf));
+
+        bfDelete(bf);
+        bfDelete(g_bf);
+        g_bf = NULL;
+    }
+}
+
+void test_bfSetAllocation_Should_CreateZeroedMappedFilters() {
+    int allocations[] = {
+        BF_ALLOC_HUGE_PAGES, BF_ALLOC_HUGETLB, BF_ALLOC_INTERLEAVE, BF_ALLOC_HUGE_PAGES | BF_ALLOC_INTERLEAVE
+    };
+    long size = 3 * 1024 * 1024 + 5;
+
+    for (int i = 0;i < 4;i++) {
+        bfSetAllocation(allocations[i]);
+
+        g_bf = bfCreateBlocked(size, 3);
+        TEST_ASSERT_NOT_NULL(g_bf);
+        TEST_ASSERT_EQUAL(size, bfSize(g_bf));
+        TEST_ASSERT_EQUAL(0, (uintptr_t) g_bf->data % BF_BLOCK_SIZE);
+        TEST_ASSERT_EQUAL(0, g_bf->mappedSize % BF_HUGE_PAGE_SIZE);
+        TEST_ASSERT_TRUE(g_bf->mappedSize >= (size_t) size);
+
+        for (long j = 0;j < size;j++) {
+            TEST_ASSERT_EQUAL(0, g_bf->data[j]);
+        }
+
+        TEST_ASSERT_TRUE(bfAddHash(g_bf, 42));
+        TEST_ASSERT_TRUE(bfContainsHash(g_bf, 42));
+
+        bfDelete(g_bf);
+        g_bf = NULL;
+    }
+
+    // The filters are allocated on the heap again
+    bfSetAllocation(BF_ALLOC_DEFAULT);
+    g_bf = bfCreate(size, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(0, g_bf->mappedSize);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(test_bfCreate_Should_ReturnNull_When_GivenNegativeK);
@@ -118,5 +428,32 @@ int main() {
     RUN_TEST(test_bfContains_Should_ReturnFalse_When_GivenEmptyFilter);
     RUN_TEST(test_bfContains_Should_ReturnFalse_When_GivenUnknownHash);
     RUN_TEST(test_bfContains_Should_ReturnTrue_When_GivenExistingHash);
+    RUN_TEST(test_bfContains_Should_ReturnTrue_When_GivenExistingHashWithSeededScheme);
+    RUN_TEST(test_bfContains_Should_ReturnTrue_When_GivenExistingValueWithFastFunction);
+
+    RUN_TEST(test_bfContainsHash_Should_ReturnFalse_When_GivenUnknownHash);
+    RUN_TEST(test_bfContainsHash_Should_ReturnTrue_When_GivenExistingHash);
+    RUN_TEST(test_bfContainsHashBatch_Should_ReturnSameResultsAsBfContainsHash);
+
+    RUN_TEST(test_bfAddHash_Should_UseAllBits);
+    RUN_TEST(test_bfAddHash_Should_UseFirstBits_When_GivenModuloAddressing);
+
+    RUN_TEST(test_bfOptimalParameters_Should_ReturnFalse_When_GivenInvalidRate);
+    RUN_TEST(test_bfOptimalParameters_Should_GiveTargetRate);
+    RUN_TEST(test_bfOptimalParameters_Should_LimitSize_When_GivenMaxSize);
+
+    RUN_TEST(test_bfCreateBlocked_Should_ReturnNull_When_GivenSizeLessThanBlock);
+    RUN_TEST(test_bfAddHash_Should_UpdateOneBlock_When_GivenBlockedFilter);
+    RUN_TEST(test_bfContains_Should_ReturnTrue_When_GivenExistingValueInBlockedFilter);
+
+    RUN_TEST(test_bfCreateFromData_Should_ReturnNull_When_GivenInvalidParameters);
+    RUN_TEST(test_bfCreateFromData_Should_UseGivenData);
+
+    RUN_TEST(test_bfUnion_Should_ContainValuesOfBothFilters);
+    RUN_TEST(test_bfUnion_Should_ReturnFalse_When_GivenDifferentParameters);
+
+    RUN_TEST(test_bfHashBits_Should_GiveBitsOfBfAddHash);
+
+    RUN_TEST(test_bfSetAllocation_Should_CreateZeroedMappedFilters);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "unity.h"
+
+#include "count_min.h"
+
+static CountMinSketch *g_cms;
+
+void setUp() {
+    g_cms = NULL;
+}
+
+void tearDown() {
+    cmsDelete(g_cms);
+}
+
+void test_cmsCreate_Should_ReturnNull_When_GivenInvalidDimensions() {
+    TEST_ASSERT_NULL(cmsCreate(0, 4));
+    TEST_ASSERT_NULL(cmsCreate(100, 0));
+    TEST_ASSERT_NULL(cmsCreate(100, CMS_MAX_DEPTH + 1));
+}
+
+void test_cmsEstimate_Should_ReturnZero_When_GivenEmptySketch() {
+    g_cms = cmsCreate(100, 4);
+    TEST_ASSERT_NOT_NULL(g_cms);
+
+    TEST_ASSERT_EQUAL(0, cmsEstimate(g_cms, 42));
+}
+
+void test_cmsAdd_Should_CountOccurrences() {
+    g_cms = cmsCreate(1 << 16, 4);
+    TEST_ASSERT_NOT_NULL(g_cms);
+
+    for (uint64_t value = 0;value < 1000;value++) {
+        for (uint64_t i = 0;i <= value % 5;i++) {
+            TEST_ASSERT_EQUAL(i + 1, cmsAdd(g_cms, value));
+        }
+    }
+
+    // The sketch is large enough to avoid collisions
+    for (uint64_t value = 0;value < 1000;value++) {
+        TEST_ASSERT_EQUAL(value % 5 + 1, cmsEstimate(g_cms, value));
+    }
+}
+
+void test_cmsEstimate_Should_NeverUnderestimate_When_SketchIsFull() {
+    g_cms = cmsCreate(100, 2);
+    TEST_ASSERT_NOT_NULL(g_cms);
+
+    for (uint64_t value = 0;value < 1000;value++) {
+        cmsAdd(g_cms, value);
+        cmsAdd(g_cms, value);
+    }
+
+    for (uint64_t value = 0;value < 1000;value++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(2, cmsEstimate(g_cms, value));
+    }
+}
+
+void test_cmsAdd_Should_Saturate() {
+    g_cms = cmsCreate(10, 1);
+    TEST_ASSERT_NOT_NULL(g_cms);
+
+    for (int i = 0;i < CMS_MAX_COUNT + 10;i++) {
+        cmsAdd(g_cms, 7);
+    }
+
+    TEST_ASSERT_EQUAL(CMS_MAX_COUNT, cmsEstimate(g_cms, 7));
+}
+
+void test_cmsIsSolid_Should_CompareEstimateToMinCount() {
+    g_cms = cmsCreate(1 << 16, 4);
+    TEST_ASSERT_NOT_NULL(g_cms);
+
+    cmsAdd(g_cms, 42);
+    cmsAdd(g_cms, 42);
+
+    TEST_ASSERT_TRUE(cmsIsSolid(g_cms, 2, 42));
+    TEST_ASSERT_FALSE(cmsIsSolid(g_cms, 3, 42));
+    TEST_ASSERT_FALSE(cmsIsSolid(g_cms, 1, 43));
+
+    // All values are solid without a sketch
+    TEST_ASSERT_TRUE(cmsIsSolid(NULL, 3, 43));
+}
+
+int main() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_cmsCreate_Should_ReturnNull_When_GivenInvalidDimensions);
+    RUN_TEST(test_cmsEstimate_Should_ReturnZero_When_GivenEmptySketch);
+    RUN_TEST(test_cmsAdd_Should_CountOccurrences);
+    RUN_TEST(test_cmsEstimate_Should_NeverUnderestimate_When_SketchIsFull);
+    RUN_TEST(test_cmsAdd_Should_Saturate);
+    RUN_TEST(test_cmsIsSolid_Should_CompareEstimateToMinCount);
+
+    return UNITY_END();
+}
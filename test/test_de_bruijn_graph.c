@@ -1,14 +1,25 @@
 #include "unity.h"
 
 #include "bloom_filter.h"
+#include "count_min.h"
+#include "dbg_buckets.h"
+#include "dbg_io.h"
+#include "dbg_partition.h"
 #include "de_bruijn_graph.h"
+#include "kmer.h"
+#include "fasta.h"
+#include "kmer_hash.h"
+#include "kmer_set.h"
 #include "utils.h"
+#include "vector.h"
 
 #include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 #include <zlib.h>
 
@@ -30,6 +41,32 @@ bool openTestFile(const char *mode) {
     return true;
 }
 
+/**
+ * \brief Saves a filter into the test file, without false positives
+ */
+bool saveFilter(BloomFilter *bf) {
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = bf, .falsePositives = NULL };
+
+    return saveDBG(&graph, g_fp);
+}
+
+/**
+ * \brief Loads the filter of the graph stored in the test file
+ */
+BloomFilter *loadFilter() {
+    DeBruijnGraph *graph = loadDBG(g_fp);
+
+    if (!graph) {
+        return NULL;
+    }
+
+    BloomFilter *bf = graph->bf;
+    graph->bf = NULL;
+    deleteDBG(graph);
+
+    return bf;
+}
+
 void setUp() {
     g_bf = NULL;
     
@@ -42,6 +79,55 @@ void tearDown() {
     bfDelete(g_bf);
     gzclose(g_fp);
     remove("test_dbg.dat");
+    remove("test_dbg.map");
+    remove("test_dbg.blk");
+    kmerHashUseFunction(KMER_HASH_NTHASH);
+    kmerUseCanonical(true);
+}
+
+/**
+ * \brief Saves a graph into the block compressed test file
+ */
+bool saveBlockedFile(DeBruijnGraph *graph) {
+    FILE *fp = fopen("test_dbg.blk", "wb");
+
+    if (!fp) {
+        perror("Unable to open test file");
+        return false;
+    }
+
+    bool saved = saveBlockedDBG(graph, fp, 6, 4);
+
+    return fclose(fp) == 0 && saved;
+}
+
+/**
+ * \brief Loads the graph of the block compressed test file
+ */
+DeBruijnGraph *loadBlockedFile(int nbThreads) {
+    FILE *fp = fopen("test_dbg.blk", "rb");
+    TEST_ASSERT_NOT_NULL(fp);
+
+    DeBruijnGraph *graph = loadBlockedDBG(fp, nbThreads);
+    fclose(fp);
+
+    return graph;
+}
+
+/**
+ * \brief Saves a graph into the mapped test file
+ */
+bool saveMappedFile(DeBruijnGraph *graph) {
+    FILE *fp = fopen("test_dbg.map", "wb");
+
+    if (!fp) {
+        perror("Unable to open test file");
+        return false;
+    }
+
+    bool saved = saveMappedDBG(graph, fp);
+
+    return fclose(fp) == 0 && saved;
 }
 
 void test_loadDBG_Should_ReturnNull_When_GivenEmptyFile() {
@@ -54,7 +140,7 @@ void test_loadDBG_Should_ReturnNull_When_MissingData() {
     TEST_ASSERT_NOT_NULL(g_bf);
 
     TEST_ASSERT_TRUE(openTestFile("wb"));
-    TEST_ASSERT_TRUE(saveDBG(g_bf, g_fp));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
     bfDelete(g_bf);
     gzclose(g_fp);
 
@@ -63,7 +149,7 @@ void test_loadDBG_Should_ReturnNull_When_MissingData() {
     // The last byte of the filter will be missing
     gzseek(g_fp, 1, SEEK_SET);
 
-    g_bf = loadDBG(g_fp);
+    g_bf = loadFilter();
     TEST_ASSERT_NULL(g_bf);
 }
 
@@ -75,17 +161,20 @@ void test_loadDBG_saveDBG() {
     TEST_ASSERT_TRUE(bfSetBit(g_bf, 500));
 
     TEST_ASSERT_TRUE(openTestFile("wb"));
-    TEST_ASSERT_TRUE(saveDBG(g_bf, g_fp));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
     bfDelete(g_bf);
     gzclose(g_fp);
 
     TEST_ASSERT_TRUE(openTestFile("rb"));
-    g_bf = loadDBG(g_fp);
+    g_bf = loadFilter();
 
     TEST_ASSERT_NOT_NULL(g_bf);
 
     TEST_ASSERT_EQUAL(10000, bfSize(g_bf));
     TEST_ASSERT_EQUAL(3, bfNbHashs(g_bf));
+    TEST_ASSERT_EQUAL(BF_HASH_DOUBLE, bfHashScheme(g_bf));
+    TEST_ASSERT_EQUAL(BF_LAYOUT_STANDARD, bfLayout(g_bf));
+    TEST_ASSERT_EQUAL(BF_ADDRESSING_FASTRANGE, bfAddressing(g_bf));
 
     int error;
     for (int64_t i = 0;i < 10000;i++) {
@@ -101,31 +190,1481 @@ void test_loadDBG_saveDBG() {
     }
 }
 
-void test_insertKmer_Should_ReturnFalse_When_GivenNegativeK() {
+void test_loadDBG_saveDBG_Should_KeepBlockedLayout() {
+    g_bf = bfCreateBlocked(1024, 5);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "ACGTTGCA", 8));
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    bfDelete(g_bf);
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    g_bf = loadFilter();
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_LAYOUT_BLOCKED, bfLayout(g_bf));
+    TEST_ASSERT_EQUAL(5, bfNbHashs(g_bf));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "ACGTTGCA", 8));
+}
+
+void test_loadDBG_Should_ReturnNull_When_GivenUnsupportedVersion() {
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+
+    int32_t version = -100;
+    int32_t size = 100;
+    int8_t nbHashs = 3;
+    char content[100] = { 0 };
+
+    TEST_ASSERT_EQUAL(4, gzwrite(g_fp, &version, 4));
+    TEST_ASSERT_EQUAL(4, gzwrite(g_fp, &size, 4));
+    TEST_ASSERT_EQUAL(1, gzwrite(g_fp, &nbHashs, 1));
+    TEST_ASSERT_EQUAL(100, gzwrite(g_fp, content, 100));
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    TEST_ASSERT_NULL(loadDBG(g_fp));
+}
+
+void test_loadDBG_Should_LoadGraphWithoutVersion() {
+    // Graphs without a format version contain kmers
+    // inserted as strings, one hash per seed
+    // Only the first 1000 bits of the 1000 bytes were used
+    g_bf = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    g_bf->hashScheme = BF_HASH_SEEDED;
+    g_bf->addressing = BF_ADDRESSING_MODULO;
+    g_bf->bitSize = 1000;
+
+    TEST_ASSERT_TRUE(bfAdd(g_bf, "CCGA", 4));
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+
+    int32_t size = bfSize(g_bf);
+    int8_t nbHashs = bfNbHashs(g_bf);
+
+    TEST_ASSERT_EQUAL(4, gzwrite(g_fp, &size, 4));
+    TEST_ASSERT_EQUAL(1, gzwrite(g_fp, &nbHashs, 1));
+    TEST_ASSERT_EQUAL(size, gzwrite(g_fp, g_bf->data, size));
+    bfDelete(g_bf);
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    g_bf = loadFilter();
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_HASH_SEEDED, bfHashScheme(g_bf));
+    TEST_ASSERT_EQUAL(BF_ADDRESSING_MODULO, bfAddressing(g_bf));
+    TEST_ASSERT_EQUAL(1000, bfBitSize(g_bf));
+    TEST_ASSERT_EQUAL(125, bfSize(g_bf));
+
+    // TCGG is the reverse complement of CCGA
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "TCGG", 4));
+
+    char neighbors[5] = { '\0' };
+    DeBruijnGraph graph = { .k = 4, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_EQUAL(1, findNeighbors(&graph, "ATCG", 4, neighbors));
+    TEST_ASSERT_EQUAL_STRING("G", neighbors);
+
+    // The graph is saved with the current format
+    gzclose(g_fp);
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    bfDelete(g_bf);
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    g_bf = loadFilter();
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_HASH_SEEDED, bfHashScheme(g_bf));
+    TEST_ASSERT_EQUAL(BF_ADDRESSING_MODULO, bfAddressing(g_bf));
+    TEST_ASSERT_EQUAL(1000, bfBitSize(g_bf));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "TCGG", 4));
+}
+
+void test_loadDBG_Should_LoadVersion5_With_LegacyKmerSize() {
+    g_bf = bfCreate(100, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "ACGTTGCAAC", 10));
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+
+    int32_t version = -5;
+    uint8_t backend = DBG_BACKEND_BLOOM;
+    int64_t bitSize = bfBitSize(g_bf);
+    int8_t nbHashs = bfNbHashs(g_bf);
+    uint8_t fields[3] = { bfHashScheme(g_bf), bfLayout(g_bf), bfAddressing(g_bf) };
+    int64_t nbFalsePositives = 0;
+
+    TEST_ASSERT_EQUAL(4, gzwrite(g_fp, &version, 4));
+    TEST_ASSERT_EQUAL(1, gzwrite(g_fp, &backend, 1));
+    TEST_ASSERT_EQUAL(8, gzwrite(g_fp, &bitSize, 8));
+    TEST_ASSERT_EQUAL(1, gzwrite(g_fp, &nbHashs, 1));
+    TEST_ASSERT_EQUAL(3, gzwrite(g_fp, fields, 3));
+    TEST_ASSERT_EQUAL(100, gzwrite(g_fp, g_bf->data, 100));
+    TEST_ASSERT_EQUAL(8, gzwrite(g_fp, &nbFalsePositives, 8));
+    gzclose(g_fp);
+    TEST_ASSERT_TRUE(isLegacyDBG("test_dbg.dat"));
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    DeBruijnGraph *graph = loadDBG(g_fp);
+
+    TEST_ASSERT_NOT_NULL(graph);
+    TEST_ASSERT_EQUAL(DBG_LEGACY_KMER_SIZE, graph->k);
+    TEST_ASSERT_TRUE(graph->canonical);
+    TEST_ASSERT_TRUE(containsKmer(graph->bf, "ACGTTGCAAC", 10));
+
+    deleteDBG(graph);
+}
+
+/**
+ * \brief Gets the block of a version 2 blocked filter with n blocks that contains a kmer
+ */
+static uint64_t getVersion2Block(const char *kmer, int k, uint64_t n) {
+    Kmer packed;
+    TEST_ASSERT_TRUE(kmerEncode(kmer, k, &packed));
+
+    KmerHash hash;
+    kmerHashInit(&hash, packed, k);
+
+    return kmerHashCanonical(&hash) % n;
+}
+
+void test_loadDBG_Should_LoadVersion2BlockedGraph() {
+    // The block of a kmer was the remainder of its hash divided by the number of blocks,
+    // all bits of the block of the first kmer are set
+    int32_t size = 16 * BF_BLOCK_SIZE;
+    uint64_t block = getVersion2Block("ACGTTGCAAC", 10, 16);
+    TEST_ASSERT_NOT_EQUAL(block, getVersion2Block("TTGACCATGA", 10, 16));
+
+    char *data = calloc(size, 1);
+    TEST_ASSERT_NOT_NULL(data);
+    memset(data + block * BF_BLOCK_SIZE, 0xff, BF_BLOCK_SIZE);
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+
+    int32_t version = -2;
+    int8_t nbHashs = 3;
+    uint8_t layout = BF_LAYOUT_BLOCKED;
+
+    TEST_ASSERT_EQUAL(4, gzwrite(g_fp, &version, 4));
+    TEST_ASSERT_EQUAL(4, gzwrite(g_fp, &size, 4));
+    TEST_ASSERT_EQUAL(1, gzwrite(g_fp, &nbHashs, 1));
+    TEST_ASSERT_EQUAL(1, gzwrite(g_fp, &layout, 1));
+    TEST_ASSERT_EQUAL(size, gzwrite(g_fp, data, size));
+    gzclose(g_fp);
+    free(data);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    g_bf = loadFilter();
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_LAYOUT_BLOCKED, bfLayout(g_bf));
+    TEST_ASSERT_EQUAL(BF_ADDRESSING_MODULO, bfAddressing(g_bf));
+    TEST_ASSERT_EQUAL(size, bfSize(g_bf));
+
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "ACGTTGCAAC", 10));
+    TEST_ASSERT_FALSE(containsKmer(g_bf, "TTGACCATGA", 10));
+
+    // The graph is saved with the current format
+    gzclose(g_fp);
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    bfDelete(g_bf);
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    g_bf = loadFilter();
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_EQUAL(BF_ADDRESSING_MODULO, bfAddressing(g_bf));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "ACGTTGCAAC", 10));
+    TEST_ASSERT_FALSE(containsKmer(g_bf, "TTGACCATGA", 10));
+}
+
+void test_loadDBG_saveDBG_Should_KeepKmerSize() {
+    g_bf = bfCreate(100, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    DeBruijnGraph graph = { .k = 31, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(&graph, g_fp));
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    DeBruijnGraph *loaded = loadDBG(g_fp);
+
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(31, loaded->k);
+    TEST_ASSERT_TRUE(loaded->canonical);
+
+    deleteDBG(loaded);
+}
+
+void test_saveDBG_Should_ReturnFalse_When_GivenInvalidKmerSize() {
+    g_bf = bfCreate(100, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    DeBruijnGraph graph = { .k = KMER128_MAX_SIZE + 1, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_FALSE(saveDBG(&graph, g_fp));
+
+    // The kmers of an exact graph are packed on 64 bits
+    KmerSet *kmers = kmerSetCreate(NULL, 0);
+    TEST_ASSERT_NOT_NULL(kmers);
+
+    DeBruijnGraph exact = { .backend = DBG_BACKEND_EXACT, .k = KMER_MAX_SIZE + 1, .canonical = true, .kmers = kmers };
+    TEST_ASSERT_FALSE(saveDBG(&exact, g_fp));
+
+    kmerSetDelete(kmers);
+}
+
+/**
+ * \brief Saves a graph into the test file without compression and changes one of its bytes
+ */
+void saveCorruptedGraph(DeBruijnGraph *graph, long offset) {
+    TEST_ASSERT_TRUE(openTestFile("wbT"));
+    TEST_ASSERT_TRUE(saveDBG(graph, g_fp));
+    gzclose(g_fp);
+    g_fp = NULL;
+
+    FILE *fp = fopen("test_dbg.dat", "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+
+    TEST_ASSERT_EQUAL(0, fseek(fp, offset, SEEK_SET));
+    int c = fgetc(fp);
+    TEST_ASSERT_EQUAL(0, fseek(fp, offset, SEEK_SET));
+    TEST_ASSERT_EQUAL(c ^ 0x1, fputc(c ^ 0x1, fp));
+    fclose(fp);
+}
+
+void test_loadDBG_Should_ReturnNull_When_GivenInvalidHeader() {
+    g_bf = bfCreate(100, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+
+    // The magic bytes, the version, the byte order and the size of the kmers
+    long offsets[] = { 5, 8, 12, 17 };
+
+    for (int i = 0;i < 4;i++) {
+        saveCorruptedGraph(&graph, offsets[i]);
+
+        TEST_ASSERT_TRUE(openTestFile("rb"));
+        TEST_ASSERT_NULL(loadDBG(g_fp));
+        gzclose(g_fp);
+        g_fp = NULL;
+    }
+}
+
+void test_loadDBG_Should_ReturnNull_When_GivenInvalidContent() {
+    g_bf = bfCreate(100, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(&graph, g_fp));
+    gzclose(g_fp);
+
+    // Changes the CRC-32 at the end of the gzip stream
+    FILE *fp = fopen("test_dbg.dat", "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    TEST_ASSERT_EQUAL(0, fseek(fp, -8, SEEK_END));
+    int c = fgetc(fp);
+    TEST_ASSERT_EQUAL(0, fseek(fp, -8, SEEK_END));
+    fputc(c ^ 0x1, fp);
+    fclose(fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    TEST_ASSERT_NULL(loadDBG(g_fp));
+}
+
+void test_loadDBG_Should_ReturnNull_When_GivenInvalidNumberOfKmers() {
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    fprintf(fp, ">1\nCCGTAATGCCTTTCCCTAAC\n>2\nAGAGTTTTTCGAACTCGTGT\n");
+    rewind(fp);
+
+    DeBruijnGraph *graph = createExactDBG(fp, 10, NULL, 0);
+    TEST_ASSERT_NOT_NULL(graph);
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(graph, g_fp));
+    gzclose(g_fp);
+
+    char data[4096];
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    int len = gzread(g_fp, data, sizeof(data));
+    gzclose(g_fp);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_LESS_THAN((int) sizeof(data), len);
+
+    // The number of kmers of the set times their size overflows
+    int64_t nbKmers = kmerSetSize(graph->kmers);
+    int64_t invalid = ((int64_t) 1 << 61) + 1;
+    int field = 0;
+    while (field + 8 <= len && memcmp(data + field, &nbKmers, sizeof(nbKmers)) != 0) {
+        field++;
+    }
+    TEST_ASSERT_TRUE(field + 8 <= len);
+    memcpy(data + field, &invalid, sizeof(invalid));
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_EQUAL(len, gzwrite(g_fp, data, len));
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    TEST_ASSERT_NULL(loadDBG(g_fp));
+
+    deleteDBG(graph);
+    fclose(fp);
+}
+
+/**
+ * \brief Writes a part of the pseudo random reads of createFastaFile into a temporary fasta file
+ */
+FILE *createFastaShard(int first, int nbReads, int readLength) {
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    uint64_t state = 42;
+
+    for (int i = 0;i < first + nbReads;i++) {
+        if (i >= first) {
+            fprintf(fp, ">read %d\n", i);
+        }
+
+        for (int j = 0;j < readLength;j++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+            if (i >= first) {
+                fputc(kmerDecodeBase(state >> 62), fp);
+            }
+        }
+
+        if (i >= first) {
+            fputc('\n', fp);
+        }
+    }
+
+    rewind(fp);
+
+    return fp;
+}
+
+/**
+ * \brief Writes pseudo random reads into a temporary fasta file
+ */
+FILE *createFastaFile(int nbReads, int readLength) {
+    return createFastaShard(0, nbReads, readLength);
+}
+
+void test_createDBGThreads_Should_CreateSameFilterAsCreateDBG() {
+    // The input is bigger than one chunk of reads
+    FILE *fp = createFastaFile(60000, 100);
+
+    g_bf = bfCreate(1000000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 20));
+
+    rewind(fp);
+
+    BloomFilter *bf = bfCreate(1000000, 3);
+    TEST_ASSERT_NOT_NULL(bf);
+    TEST_ASSERT_TRUE(createDBGThreads(bf, fp, 20, 4));
+
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+
+    bfDelete(bf);
+    fclose(fp);
+}
+
+void test_createPartitionedDBG_Should_CreateSameFilterAsCreateDBG() {
+    // The input has several batches of kmers
+    FILE *fp = createFastaFile(60000, 100);
+
+    for (int blocked = 0;blocked < 2;blocked++) {
+        // The filter has several partitions
+        g_bf = blocked ? bfCreateBlocked(1000000, 3) : bfCreate(1000000, 3);
+        TEST_ASSERT_NOT_NULL(g_bf);
+        TEST_ASSERT_TRUE(createDBG(g_bf, fp, 20));
+
+        int threads[] = { 1, 4 };
+
+        for (int i = 0;i < 2;i++) {
+            rewind(fp);
+
+            BloomFilter *bf = blocked ? bfCreateBlocked(1000000, 3) : bfCreate(1000000, 3);
+            TEST_ASSERT_NOT_NULL(bf);
+            TEST_ASSERT_TRUE(createPartitionedDBG(bf, fp, 20, threads[i], NULL, 0));
+
+            TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+
+            bfDelete(bf);
+        }
+
+        bfDelete(g_bf);
+        g_bf = NULL;
+        rewind(fp);
+    }
+
+    fclose(fp);
+}
+
+void test_createPartitionedDBG_Should_OnlyInsertSolidKmers() {
+    FILE *fp = createFastaFile(2000, 100);
+
+    uint64_t nbSolid = 0;
+    CountMinSketch *counts = countDBGKmers(fp, 12, 10000, 2, &nbSolid);
+    TEST_ASSERT_NOT_NULL(counts);
+
+    rewind(fp);
+    g_bf = bfCreate(20000, 4);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createSolidDBG(g_bf, fp, 12, 1, counts, 2));
+
+    rewind(fp);
+    BloomFilter *bf = bfCreate(20000, 4);
+    TEST_ASSERT_NOT_NULL(bf);
+    TEST_ASSERT_TRUE(createPartitionedDBG(bf, fp, 12, 3, counts, 2));
+
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+
+    bfDelete(bf);
+    cmsDelete(counts);
+    fclose(fp);
+}
+
+void test_createPartitionedDBG_Should_ReturnFalse_When_ReadIsShorterThanK() {
+    FILE *fp = createFastaFile(100, 10);
+
     g_bf = bfCreate(10000, 3);
     TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_FALSE(createPartitionedDBG(g_bf, fp, 20, 4, NULL, 0));
 
-    char kmer[] = "ATCG";
-    TEST_ASSERT_FALSE(insertKmer(g_bf, kmer, 0));
-    TEST_ASSERT_FALSE(insertKmer(g_bf, kmer, -1));
+    fclose(fp);
 }
 
-void test_insertKmer_Should_ReturnTrue_And_UpdateBfWithCorrectKmer() {
+void test_insertDBGKmers_Should_CreateSameFilterAsCreateDBG() {
+    FILE *fp = createFastaFile(5000, 100);
+
+    g_bf = bfCreate(100000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 20));
+
+    rewind(fp);
+    KmerSet *kmers = collectDBGKmers(fp, 20, NULL, 0);
+    TEST_ASSERT_NOT_NULL(kmers);
+
+    // The collected kmers are the ones of the exact graph
+    rewind(fp);
+    DeBruijnGraph *exact = createExactDBG(fp, 20, NULL, 0);
+    TEST_ASSERT_NOT_NULL(exact);
+    TEST_ASSERT_EQUAL(kmerSetSize(exact->kmers), kmerSetSize(kmers));
+    TEST_ASSERT_EQUAL_MEMORY(exact->kmers->kmers, kmers->kmers, kmerSetSize(kmers) * sizeof(Kmer));
+    deleteDBG(exact);
+
+    int threads[] = { 1, 4 };
+
+    for (int i = 0;i < 2;i++) {
+        BloomFilter *bf = bfCreate(100000, 3);
+        TEST_ASSERT_NOT_NULL(bf);
+        TEST_ASSERT_TRUE(insertDBGKmers(bf, kmers, 20, threads[i]));
+
+        TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+
+        bfDelete(bf);
+    }
+
+    kmerSetDelete(kmers);
+    fclose(fp);
+}
+
+void test_createDBGThreads_Should_ReturnFalse_When_ReadIsShorterThanK() {
+    FILE *fp = createFastaFile(100, 10);
+
     g_bf = bfCreate(10000, 3);
     TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_FALSE(createDBGThreads(g_bf, fp, 20, 4));
+
+    fclose(fp);
+}
+
+void test_estimateDBGKmers_Should_EstimateNumberOfDistinctKmers() {
+    // Random reads have almost only distinct kmers, each read is given twice
+    FILE *fp = createFastaFile(1000, 100);
+    FILE *twice = tmpfile();
+    TEST_ASSERT_NOT_NULL(twice);
+
+    for (int i = 0;i < 2;i++) {
+        int c;
+        while ((c = fgetc(fp)) != EOF) {
+            fputc(c, twice);
+        }
+
+        rewind(fp);
+    }
+
+    rewind(twice);
 
-    char kmer[] = "CGTACGT";
-    TEST_ASSERT_TRUE(insertKmer(g_bf, kmer, 7));
+    uint64_t nbKmers = 0;
+    TEST_ASSERT_TRUE(estimateDBGKmers(twice, 20, &nbKmers));
 
-    TEST_ASSERT_FALSE(bfContains(g_bf, "CGTACGT", 7));
-    TEST_ASSERT_TRUE(bfContains(g_bf, "ACGTACG", 7));
+    TEST_ASSERT_GREATER_OR_EQUAL(81000 * 0.97, nbKmers);
+    TEST_ASSERT_LESS_OR_EQUAL(81000 * 1.03, nbKmers);
+
+    fclose(fp);
+    fclose(twice);
 }
 
-int main() {
-    UNITY_BEGIN();
-    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenEmptyFile);
-    RUN_TEST(test_loadDBG_Should_ReturnNull_When_MissingData);
-    RUN_TEST(test_loadDBG_saveDBG);
+/**
+ * \brief Compresses and decompresses the reads of a fasta file
+ * 
+ * @return total number of branchings
+ */
+size_t roundTrip(DeBruijnGraph *graph, FILE *fp, int k) {
+    Vector *branchings = vectorCreate(10, 1);
+    Vector *literals = vectorCreate(10, sizeof(ReadLiteral));
+    TEST_ASSERT_NOT_NULL(branchings);
+    TEST_ASSERT_NOT_NULL(literals);
+
+    char line[256];
+    char read[256];
+    size_t nbBranchings = 0;
+
+    rewind(fp);
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (*line == '>') {
+            continue;
+        }
+
+        int len = strcspn(line, "\n");
+
+        // Like compressFile, the length given to computeBranchings includes the end of line
+        vectorClear(branchings);
+        vectorClear(literals);
+        TEST_ASSERT_TRUE(computeBranchings(graph, branchings, literals, line, len + 1, k));
+        line[len] = '\0';
+        nbBranchings += vectorSize(branchings);
+
+        memset(read, '\0', sizeof(read));
+        TEST_ASSERT_TRUE(decompressRead(graph, branchings, literals, read, len, line, k));
+        TEST_ASSERT_EQUAL_STRING(line, read);
+    }
+
+    vectorDelete(branchings);
+    vectorDelete(literals);
+
+    return nbBranchings;
+}
+
+void test_createDBG_Should_CreateGraph_When_GivenKmersLongerThanPackedKmer() {
+    FILE *fp = createFastaFile(200, 100);
+
+    for (int k = KMER_MAX_SIZE + 1;k <= KMER128_MAX_SIZE;k += KMER128_MAX_SIZE - KMER_MAX_SIZE - 1) {
+        g_bf = bfCreate(1000000, 3);
+        TEST_ASSERT_NOT_NULL(g_bf);
+        TEST_ASSERT_TRUE(createDBG(g_bf, fp, k));
+
+        rewind(fp);
+
+        BloomFilter *bf = bfCreate(1000000, 3);
+        TEST_ASSERT_NOT_NULL(bf);
+        TEST_ASSERT_TRUE(createDBGThreads(bf, fp, k, 4));
+        TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+        bfDelete(bf);
+
+        // The random reads share no kmer, so the filter gives no branching
+        DeBruijnGraph graph = { .k = k, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+        TEST_ASSERT_EQUAL(0, roundTrip(&graph, fp, k));
+
+        TEST_ASSERT_TRUE(openTestFile("wb"));
+        TEST_ASSERT_TRUE(saveDBG(&graph, g_fp));
+        gzclose(g_fp);
+
+        TEST_ASSERT_TRUE(openTestFile("rb"));
+        DeBruijnGraph *loaded = loadDBG(g_fp);
+        TEST_ASSERT_NOT_NULL(loaded);
+        TEST_ASSERT_EQUAL(k, loaded->k);
+        TEST_ASSERT_EQUAL(0, roundTrip(loaded, fp, k));
+        deleteDBG(loaded);
+
+        bfDelete(g_bf);
+        g_bf = NULL;
+        rewind(fp);
+    }
+
+    // Only the hashes of the kmers are stored by a filter
+    TEST_ASSERT_NULL(createExactDBG(fp, KMER_MAX_SIZE + 1, NULL, 0));
+    fclose(fp);
+}
+
+void test_computeFalsePositives_Should_RemoveSpuriousBranchings() {
+    FILE *fp = createFastaFile(200, 50);
+
+    // The filter is too small for the kmers of the reads
+    g_bf = bfCreate(2000, 2);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 15));
+
+    DeBruijnGraph graph = { .k = 15, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    size_t withoutSet = roundTrip(&graph, fp, 15);
+
+    TEST_ASSERT_TRUE(computeFalsePositives(&graph, fp, 15, NULL, 0));
+    TEST_ASSERT_NOT_NULL(graph.falsePositives);
+    TEST_ASSERT_GREATER_THAN(0, kmerSetSize(graph.falsePositives));
+
+    // Remaining branchings come from kmers shared by several reads
+    size_t withSet = roundTrip(&graph, fp, 15);
+    TEST_ASSERT_LESS_THAN(withoutSet, withSet);
+
+    // The false positives are kept by the serialized graph
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(&graph, g_fp));
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    DeBruijnGraph *loaded = loadDBG(g_fp);
+
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_NOT_NULL(loaded->falsePositives);
+    TEST_ASSERT_EQUAL(kmerSetSize(graph.falsePositives), kmerSetSize(loaded->falsePositives));
+    TEST_ASSERT_EQUAL_MEMORY(graph.falsePositives->kmers, loaded->falsePositives->kmers,
+        sizeof(Kmer) * kmerSetSize(graph.falsePositives));
+    TEST_ASSERT_EQUAL(withSet, roundTrip(loaded, fp, 15));
+
+    deleteDBG(loaded);
+    kmerSetDelete(graph.falsePositives);
+    fclose(fp);
+}
+
+void test_createExactDBG_Should_OnlyKeepTrueBranchings() {
+    FILE *fp = createFastaFile(200, 50);
+
+    g_bf = bfCreate(2000, 2);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 15));
+
+    DeBruijnGraph graph = { .k = 15, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(computeFalsePositives(&graph, fp, 15, NULL, 0));
+
+    rewind(fp);
+    DeBruijnGraph *exact = createExactDBG(fp, 15, NULL, 0);
+
+    TEST_ASSERT_NOT_NULL(exact);
+    TEST_ASSERT_EQUAL(DBG_BACKEND_EXACT, exact->backend);
+    TEST_ASSERT_NULL(exact->bf);
+    TEST_ASSERT_EQUAL(200 * 36, kmerSetSize(exact->kmers));
+
+    // Without its critical false positives, the filter gives the same neighbors
+    TEST_ASSERT_EQUAL(roundTrip(&graph, fp, 15), roundTrip(exact, fp, 15));
+
+    // An exact graph has no false positives
+    TEST_ASSERT_TRUE(computeFalsePositives(exact, fp, 15, NULL, 0));
+    TEST_ASSERT_NULL(exact->falsePositives);
+
+    deleteDBG(exact);
+    kmerSetDelete(graph.falsePositives);
+    fclose(fp);
+}
+
+void test_createDBG_Should_KeepStrands_When_StrandSpecific() {
+    FILE *fp = createFastaFile(200, 50);
+
+    kmerUseCanonical(false);
+
+    g_bf = bfCreate(20000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 15));
+
+    // The reverse complement of a kmer is not inserted with it
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "ACGGTTACCAGTTAC", 15));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "ACGGTTACCAGTTAC", 15));
+    TEST_ASSERT_FALSE(containsKmer(g_bf, "GTAACTGGTAACCGT", 15));
+
+    rewind(fp);
+    DeBruijnGraph *exact = createExactDBG(fp, 15, NULL, 0);
+    TEST_ASSERT_NOT_NULL(exact);
+    TEST_ASSERT_FALSE(exact->canonical);
+
+    DeBruijnGraph graph = { .k = 15, .canonical = false, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(computeFalsePositives(&graph, fp, 15, NULL, 0));
+    size_t nbBranchings = roundTrip(exact, fp, 15);
+    TEST_ASSERT_EQUAL(nbBranchings, roundTrip(&graph, fp, 15));
+
+    // The canonical mode is stored with the graph
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(&graph, g_fp));
+    gzclose(g_fp);
+
+    kmerUseCanonical(true);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    DeBruijnGraph *loaded = loadDBG(g_fp);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_FALSE(loaded->canonical);
+
+    useDBGKmerMode(loaded);
+    TEST_ASSERT_FALSE(kmerCanonicalMode);
+    TEST_ASSERT_EQUAL(nbBranchings, roundTrip(loaded, fp, 15));
+
+    // The graphs of both modes can not be merged
+    kmerUseCanonical(true);
+    DeBruijnGraph *canonical = createExactDBG(fp, 15, NULL, 0);
+    TEST_ASSERT_NOT_NULL(canonical);
+    TEST_ASSERT_FALSE(mergeDBG(canonical, exact));
+
+    deleteDBG(canonical);
+    deleteDBG(loaded);
+    deleteDBG(exact);
+    kmerSetDelete(graph.falsePositives);
+    fclose(fp);
+}
+
+void test_loadDBG_saveDBG_Should_KeepExactGraph() {
+    FILE *fp = createFastaFile(100, 40);
+    DeBruijnGraph *graph = createExactDBG(fp, 20, NULL, 0);
+    TEST_ASSERT_NOT_NULL(graph);
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(graph, g_fp));
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    DeBruijnGraph *loaded = loadDBG(g_fp);
+
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(DBG_BACKEND_EXACT, loaded->backend);
+    TEST_ASSERT_EQUAL(kmerSetSize(graph->kmers), kmerSetSize(loaded->kmers));
+    TEST_ASSERT_EQUAL_MEMORY(graph->kmers->kmers, loaded->kmers->kmers,
+        sizeof(Kmer) * kmerSetSize(graph->kmers));
+
+    roundTrip(loaded, fp, 20);
+
+    deleteDBG(graph);
+    deleteDBG(loaded);
+    fclose(fp);
+}
+
+void test_mapDBG_saveMappedDBG_Should_KeepBloomGraph() {
+    FILE *fp = createFastaFile(200, 50);
+
+    g_bf = bfCreateBlocked(BF_BLOCK_SIZE * 40, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 15));
+
+    DeBruijnGraph graph = { .k = 15, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(computeFalsePositives(&graph, fp, 15, NULL, 0));
+    TEST_ASSERT_GREATER_THAN(0, kmerSetSize(graph.falsePositives));
+
+    TEST_ASSERT_TRUE(saveMappedFile(&graph));
+    DeBruijnGraph *mapped = mapDBG("test_dbg.map");
+
+    TEST_ASSERT_NOT_NULL(mapped);
+    TEST_ASSERT_NOT_NULL(mapped->mapping);
+    TEST_ASSERT_EQUAL(DBG_BACKEND_BLOOM, mapped->backend);
+
+    // The filter and the false positives are read from the mapped file
+    BloomFilter *bf = mapped->bf;
+    TEST_ASSERT_EQUAL(0, ((uintptr_t) bf->data) % DBG_PAGE_SIZE);
+    TEST_ASSERT_EQUAL(0, ((uintptr_t) mapped->falsePositives->kmers) % DBG_PAGE_SIZE);
+
+    TEST_ASSERT_EQUAL(bfSize(g_bf), bfSize(bf));
+    TEST_ASSERT_EQUAL(bfBitSize(g_bf), bfBitSize(bf));
+    TEST_ASSERT_EQUAL(bfNbHashs(g_bf), bfNbHashs(bf));
+    TEST_ASSERT_EQUAL(bfHashScheme(g_bf), bfHashScheme(bf));
+    TEST_ASSERT_EQUAL(bfLayout(g_bf), bfLayout(bf));
+    TEST_ASSERT_EQUAL(bfAddressing(g_bf), bfAddressing(bf));
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+
+    TEST_ASSERT_EQUAL(kmerSetSize(graph.falsePositives), kmerSetSize(mapped->falsePositives));
+    TEST_ASSERT_EQUAL_MEMORY(graph.falsePositives->kmers, mapped->falsePositives->kmers,
+        sizeof(Kmer) * kmerSetSize(graph.falsePositives));
+
+    TEST_ASSERT_EQUAL(roundTrip(&graph, fp, 15), roundTrip(mapped, fp, 15));
+
+    deleteDBG(mapped);
+    kmerSetDelete(graph.falsePositives);
+    fclose(fp);
+}
+
+void test_mapDBG_saveMappedDBG_Should_KeepExactGraph() {
+    FILE *fp = createFastaFile(100, 40);
+    DeBruijnGraph *graph = createExactDBG(fp, 20, NULL, 0);
+    TEST_ASSERT_NOT_NULL(graph);
+
+    TEST_ASSERT_TRUE(saveMappedFile(graph));
+    DeBruijnGraph *mapped = mapDBG("test_dbg.map");
+
+    TEST_ASSERT_NOT_NULL(mapped);
+    TEST_ASSERT_EQUAL(DBG_BACKEND_EXACT, mapped->backend);
+    TEST_ASSERT_EQUAL(20, mapped->k);
+    TEST_ASSERT_NULL(mapped->bf);
+    TEST_ASSERT_NULL(mapped->falsePositives);
+    TEST_ASSERT_EQUAL(kmerSetSize(graph->kmers), kmerSetSize(mapped->kmers));
+    TEST_ASSERT_EQUAL_MEMORY(graph->kmers->kmers, mapped->kmers->kmers,
+        sizeof(Kmer) * kmerSetSize(graph->kmers));
+
+    TEST_ASSERT_EQUAL(roundTrip(graph, fp, 20), roundTrip(mapped, fp, 20));
+
+    deleteDBG(graph);
+    deleteDBG(mapped);
+    fclose(fp);
+}
+
+void test_mapDBG_Should_ReturnNull_When_GivenCompressedGraph() {
+    g_bf = bfCreate(100, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    gzclose(g_fp);
+    g_fp = NULL;
+
+    TEST_ASSERT_NULL(mapDBG("test_dbg.dat"));
+    TEST_ASSERT_NULL(mapDBG("missing_test_dbg.map"));
+}
+
+void test_mapDBG_Should_ReturnNull_When_MissingData() {
+    g_bf = bfCreate(10000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(saveMappedFile(&graph));
+
+    // The last page of the filter will be missing
+    TEST_ASSERT_EQUAL(0, truncate("test_dbg.map", DBG_PAGE_SIZE * 2));
+    TEST_ASSERT_NULL(mapDBG("test_dbg.map"));
+}
+
+void test_openDBG_Should_LoadAllGraphFormats() {
+    g_bf = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(bfSetBit(g_bf, 42));
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    gzclose(g_fp);
+    g_fp = NULL;
+
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(saveMappedFile(&graph));
+    TEST_ASSERT_TRUE(saveBlockedFile(&graph));
+
+    const char *paths[] = { "test_dbg.dat", "test_dbg.map", "test_dbg.blk" };
+
+    for (int i = 0;i < 3;i++) {
+        DeBruijnGraph *opened = openDBG(paths[i], 2);
+
+        TEST_ASSERT_NOT_NULL(opened);
+        TEST_ASSERT_FALSE(isLegacyDBG(paths[i]));
+        TEST_ASSERT_EQUAL(i == 1, opened->mapping != NULL);
+        TEST_ASSERT_EQUAL(bfSize(g_bf), bfSize(opened->bf));
+        TEST_ASSERT_EQUAL_MEMORY(g_bf->data, opened->bf->data, bfSize(g_bf));
+
+        deleteDBG(opened);
+    }
+}
+
+void test_openDBG_Should_KeepFastHashFunction() {
+    FILE *fp = createFastaFile(200, 50);
+
+    // The kmers are inserted with the hash function of the filter
+    kmerHashUseFunction(KMER_HASH_MIX);
+
+    g_bf = bfCreate(20000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    g_bf->hashFunction = BF_FUNCTION_FAST;
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 21));
+
+    DeBruijnGraph graph = { .k = 21, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(computeFalsePositives(&graph, fp, 21, NULL, 0));
+    size_t nbBranchings = roundTrip(&graph, fp, 21);
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveDBG(&graph, g_fp));
+    gzclose(g_fp);
+    g_fp = NULL;
+
+    TEST_ASSERT_TRUE(saveMappedFile(&graph));
+    TEST_ASSERT_TRUE(saveBlockedFile(&graph));
+
+    const char *paths[] = { "test_dbg.dat", "test_dbg.map", "test_dbg.blk" };
+
+    for (int i = 0;i < 3;i++) {
+        kmerHashUseFunction(KMER_HASH_NTHASH);
+
+        DeBruijnGraph *opened = openDBG(paths[i], 2);
+        TEST_ASSERT_NOT_NULL(opened);
+        TEST_ASSERT_EQUAL(BF_FUNCTION_FAST, bfHashFunction(opened->bf));
+
+        useDBGKmerMode(opened);
+        TEST_ASSERT_EQUAL(KMER_HASH_MIX, kmerHashSelectedFunction);
+        TEST_ASSERT_EQUAL(nbBranchings, roundTrip(opened, fp, 21));
+
+        deleteDBG(opened);
+    }
+
+    // The mixed kmers are packed on 64 bits
+    graph.k = KMER_MAX_SIZE + 1;
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_FALSE(saveDBG(&graph, g_fp));
+
+    kmerSetDelete(graph.falsePositives);
+    fclose(fp);
+}
+
+void test_mergeDBG_Should_CreateSameFilterAsWholeFile() {
+    FILE *fp = createFastaFile(300, 60);
+    FILE *shards[] = { createFastaShard(0, 100, 60), createFastaShard(100, 200, 60) };
+
+    g_bf = bfCreate(100000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 20));
+
+    DeBruijnGraph *graphs[2];
+
+    for (int i = 0;i < 2;i++) {
+        BloomFilter *bf = bfCreate(100000, 3);
+        TEST_ASSERT_NOT_NULL(bf);
+        TEST_ASSERT_TRUE(createDBG(bf, shards[i], 20));
+        TEST_ASSERT_NOT_NULL(graphs[i] = wrapDBG(bf, 20));
+    }
+
+    // The false positives of a part are not valid for the whole file
+    TEST_ASSERT_TRUE(computeFalsePositives(graphs[0], shards[0], 20, NULL, 1));
+
+    TEST_ASSERT_TRUE(mergeDBG(graphs[0], graphs[1]));
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, graphs[0]->bf->data, bfSize(g_bf));
+    TEST_ASSERT_NULL(graphs[0]->falsePositives);
+
+    for (int i = 0;i < 2;i++) {
+        deleteDBG(graphs[i]);
+        fclose(shards[i]);
+    }
+
+    fclose(fp);
+}
+
+void test_mergeDBG_Should_MergeExactGraphs() {
+    FILE *fp = createFastaFile(300, 60);
+    FILE *shards[] = { createFastaShard(0, 150, 60), createFastaShard(150, 150, 60) };
+
+    DeBruijnGraph *whole = createExactDBG(fp, 20, NULL, 0);
+    DeBruijnGraph *graphs[] = { createExactDBG(shards[0], 20, NULL, 0), createExactDBG(shards[1], 20, NULL, 0) };
+    TEST_ASSERT_NOT_NULL(whole);
+    TEST_ASSERT_NOT_NULL(graphs[0]);
+    TEST_ASSERT_NOT_NULL(graphs[1]);
+
+    TEST_ASSERT_TRUE(mergeDBG(graphs[0], graphs[1]));
+    TEST_ASSERT_EQUAL(kmerSetSize(whole->kmers), kmerSetSize(graphs[0]->kmers));
+    TEST_ASSERT_EQUAL_MEMORY(whole->kmers->kmers, graphs[0]->kmers->kmers,
+        sizeof(Kmer) * kmerSetSize(whole->kmers));
+
+    deleteDBG(whole);
+
+    for (int i = 0;i < 2;i++) {
+        deleteDBG(graphs[i]);
+        fclose(shards[i]);
+    }
+
+    fclose(fp);
+}
+
+void test_mergeDBG_Should_ReturnFalse_When_GivenDifferentGraphs() {
+    g_bf = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+
+    BloomFilter *bf = bfCreate(2000, 3);
+    TEST_ASSERT_NOT_NULL(bf);
+
+    DeBruijnGraph others[] = {
+        { .k = 20, .canonical = true, .bf = bf, .falsePositives = NULL },
+        { .k = 21, .canonical = true, .bf = g_bf, .falsePositives = NULL },
+        { .k = 20, .canonical = false, .bf = g_bf, .falsePositives = NULL },
+        { .backend = DBG_BACKEND_EXACT, .k = 20, .canonical = true, .bf = NULL, .falsePositives = NULL }
+    };
+
+    for (int i = 0;i < 4;i++) {
+        TEST_ASSERT_FALSE(mergeDBG(&graph, &others[i]));
+    }
+
+    bfDelete(bf);
+}
+
+void test_loadDBG_saveDBG_Should_KeepSparseFilter() {
+    FILE *fp = createFastaFile(20, 50);
+
+    g_bf = bfCreate(1 << 20, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 20));
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    gzclose(g_fp);
+
+    // Few bits are set : the positions are smaller than the content of the filter
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    char *stored = malloc(bfSize(g_bf));
+    TEST_ASSERT_NOT_NULL(stored);
+    TEST_ASSERT_LESS_THAN(bfSize(g_bf) / 10, gzread(g_fp, stored, bfSize(g_bf)));
+    free(stored);
+    gzclose(g_fp);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    BloomFilter *bf = loadFilter();
+
+    TEST_ASSERT_NOT_NULL(bf);
+    TEST_ASSERT_EQUAL(bfSize(g_bf), bfSize(bf));
+    TEST_ASSERT_EQUAL(bfNbHashs(g_bf), bfNbHashs(bf));
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+    bfDelete(bf);
+
+    // Block compressed graphs use the same encoding
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(saveBlockedFile(&graph));
+
+    DeBruijnGraph *loaded = loadBlockedFile(2);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, loaded->bf->data, bfSize(g_bf));
+    TEST_ASSERT_EQUAL(0, kmerSetSize(loaded->falsePositives));
+
+    deleteDBG(loaded);
+    fclose(fp);
+}
+
+void test_loadDBG_Should_ReturnNull_When_GivenInvalidSparseContent() {
+    g_bf = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "ACGTACGTACGTACGTACGT", 20));
+
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+
+    // The last byte of the number of set bits, after the header
+    saveCorruptedGraph(&graph, 47);
+
+    TEST_ASSERT_TRUE(openTestFile("rb"));
+    TEST_ASSERT_NULL(loadDBG(g_fp));
+}
+
+void test_loadBlockedDBG_saveBlockedDBG_Should_KeepBloomGraph() {
+    FILE *fp = createFastaFile(200, 50);
+
+    // The filter is split into 3 blocks
+    g_bf = bfCreateBlocked((5 << 20) / 2, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 15));
+
+    Kmer falsePositives[] = { 3, 7, 42 };
+    Kmer *kmers = malloc(sizeof(falsePositives));
+    TEST_ASSERT_NOT_NULL(kmers);
+    memcpy(kmers, falsePositives, sizeof(falsePositives));
+
+    DeBruijnGraph graph = { .k = 15, .canonical = true, .bf = g_bf, .falsePositives = kmerSetCreate(kmers, 3) };
+    TEST_ASSERT_NOT_NULL(graph.falsePositives);
+    TEST_ASSERT_TRUE(saveBlockedFile(&graph));
+
+    for (int nbThreads = 1;nbThreads <= 4;nbThreads *= 2) {
+        DeBruijnGraph *loaded = loadBlockedFile(nbThreads);
+
+        TEST_ASSERT_NOT_NULL(loaded);
+        TEST_ASSERT_EQUAL(DBG_BACKEND_BLOOM, loaded->backend);
+        TEST_ASSERT_EQUAL(15, loaded->k);
+        TEST_ASSERT_TRUE(loaded->canonical);
+
+        BloomFilter *bf = loaded->bf;
+        TEST_ASSERT_EQUAL(bfSize(g_bf), bfSize(bf));
+        TEST_ASSERT_EQUAL(bfBitSize(g_bf), bfBitSize(bf));
+        TEST_ASSERT_EQUAL(bfNbHashs(g_bf), bfNbHashs(bf));
+        TEST_ASSERT_EQUAL(bfLayout(g_bf), bfLayout(bf));
+        TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+
+        TEST_ASSERT_EQUAL(3, kmerSetSize(loaded->falsePositives));
+        TEST_ASSERT_EQUAL_MEMORY(falsePositives, loaded->falsePositives->kmers, sizeof(falsePositives));
+
+        deleteDBG(loaded);
+    }
+
+    // The file is also a gzip file that contains a graph
+    TEST_ASSERT_NOT_NULL(g_fp = gzopen("test_dbg.blk", "rb"));
+    DeBruijnGraph *loaded = loadDBG(g_fp);
+
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, loaded->bf->data, bfSize(g_bf));
+    TEST_ASSERT_EQUAL(3, kmerSetSize(loaded->falsePositives));
+
+    deleteDBG(loaded);
+    kmerSetDelete(graph.falsePositives);
+    fclose(fp);
+}
+
+void test_loadBlockedDBG_saveBlockedDBG_Should_KeepExactGraph() {
+    FILE *fp = createFastaFile(100, 40);
+    DeBruijnGraph *graph = createExactDBG(fp, 20, NULL, 0);
+    TEST_ASSERT_NOT_NULL(graph);
+
+    TEST_ASSERT_TRUE(saveBlockedFile(graph));
+    DeBruijnGraph *loaded = loadBlockedFile(2);
+
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL(DBG_BACKEND_EXACT, loaded->backend);
+    TEST_ASSERT_EQUAL(20, loaded->k);
+    TEST_ASSERT_NULL(loaded->falsePositives);
+    TEST_ASSERT_EQUAL(kmerSetSize(graph->kmers), kmerSetSize(loaded->kmers));
+    TEST_ASSERT_EQUAL_MEMORY(graph->kmers->kmers, loaded->kmers->kmers,
+        sizeof(Kmer) * kmerSetSize(graph->kmers));
+
+    deleteDBG(graph);
+    deleteDBG(loaded);
+    fclose(fp);
+}
+
+void test_loadBlockedDBG_Should_ReturnNull_When_GivenGzipGraph() {
+    g_bf = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    TEST_ASSERT_TRUE(openTestFile("wb"));
+    TEST_ASSERT_TRUE(saveFilter(g_bf));
+    gzclose(g_fp);
+    g_fp = NULL;
+
+    FILE *fp = fopen("test_dbg.dat", "rb");
+    TEST_ASSERT_NOT_NULL(fp);
+    TEST_ASSERT_NULL(loadBlockedDBG(fp, 2));
+    fclose(fp);
+}
+
+void test_loadBlockedDBG_Should_ReturnNull_When_GivenInvalidNumberOfFalsePositives() {
+    g_bf = bfCreate(1000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    // Without compression, the last member stores the number of false positives
+    // just before the CRC-32 and the size of its data
+    DeBruijnGraph graph = { .k = 20, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    FILE *fp = fopen("test_dbg.blk", "w+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    TEST_ASSERT_TRUE(saveBlockedDBG(&graph, fp, 0, 1));
+
+    unsigned char trailer[16];
+    TEST_ASSERT_EQUAL(0, fseek(fp, -16, SEEK_END));
+    TEST_ASSERT_EQUAL(16, fread(trailer, 1, 16, fp));
+
+    int64_t nbKmers = 0;
+    uint32_t crc = crc32(0, (const Bytef*) &nbKmers, sizeof(nbKmers));
+    TEST_ASSERT_EQUAL_MEMORY(&nbKmers, trailer, sizeof(nbKmers));
+    TEST_ASSERT_EQUAL_MEMORY(&crc, trailer + 8, sizeof(crc));
+
+    // The size of the false positives overflows
+    nbKmers = (int64_t) 1 << 61;
+    crc = crc32(0, (const Bytef*) &nbKmers, sizeof(nbKmers));
+    memcpy(trailer, &nbKmers, sizeof(nbKmers));
+    memcpy(trailer + 8, &crc, sizeof(crc));
+
+    TEST_ASSERT_EQUAL(0, fseek(fp, -16, SEEK_END));
+    TEST_ASSERT_EQUAL(16, fwrite(trailer, 1, 16, fp));
+    rewind(fp);
+
+    TEST_ASSERT_NULL(loadBlockedDBG(fp, 1));
+    fclose(fp);
+}
+
+void test_insertDBGBuckets_Should_CreateSameFilterAsCreateDBG() {
+    FILE *fp = createFastaFile(5000, 100);
+
+    g_bf = bfCreate(100000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createDBG(g_bf, fp, 20));
+
+    // About 1 MB of kmers split into buckets of 64 KB
+    rewind(fp);
+    DBGBuckets *buckets = bucketDBGKmers(fp, 20, 64 * 1024, NULL);
+    TEST_ASSERT_NOT_NULL(buckets);
+    TEST_ASSERT_GREATER_THAN(1, buckets->nbBuckets);
+
+    uint64_t total = 0;
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        total += buckets->buckets[i].size;
+    }
+    TEST_ASSERT_EQUAL(5000 * 81, total);
+
+    BloomFilter *bf = bfCreate(100000, 3);
+    TEST_ASSERT_NOT_NULL(bf);
+    TEST_ASSERT_TRUE(insertDBGBuckets(buckets, bf, 1, 2));
+    TEST_ASSERT_EQUAL_MEMORY(g_bf->data, bf->data, bfSize(g_bf));
+    bfDelete(bf);
+
+    // The distinct kmers are the ones of the exact graph
+    rewind(fp);
+    DeBruijnGraph *exact = createExactDBG(fp, 20, NULL, 0);
+    KmerSet *kmers = collectDBGBuckets(buckets, 1);
+    uint64_t nbKmers = 0;
+
+    TEST_ASSERT_NOT_NULL(exact);
+    TEST_ASSERT_NOT_NULL(kmers);
+    TEST_ASSERT_TRUE(countDBGBuckets(buckets, 1, &nbKmers));
+    TEST_ASSERT_EQUAL(kmerSetSize(exact->kmers), nbKmers);
+    TEST_ASSERT_EQUAL(nbKmers, kmerSetSize(kmers));
+    TEST_ASSERT_EQUAL_MEMORY(exact->kmers->kmers, kmers->kmers, nbKmers * sizeof(Kmer));
+
+    kmerSetDelete(kmers);
+    deleteDBG(exact);
+    deleteDBGBuckets(buckets);
+    fclose(fp);
+}
+
+void test_bucketDBGKmers_Should_SplitBuckets_When_FewFilesCanBeOpened() {
+    FILE *fp = createFastaFile(5000, 100);
+
+    // 16 temporary files can be opened, about 100 buckets are needed
+    struct rlimit limit;
+    TEST_ASSERT_EQUAL(0, getrlimit(RLIMIT_NOFILE, &limit));
+    struct rlimit lowered = { .rlim_cur = 48, .rlim_max = limit.rlim_max };
+    TEST_ASSERT_EQUAL(0, setrlimit(RLIMIT_NOFILE, &lowered));
+
+    DBGBuckets *buckets = bucketDBGKmers(fp, 20, 64 * 1024, NULL);
+    TEST_ASSERT_EQUAL(0, setrlimit(RLIMIT_NOFILE, &limit));
+    TEST_ASSERT_NOT_NULL(buckets);
+    TEST_ASSERT_GREATER_THAN(16, buckets->nbBuckets);
+    TEST_ASSERT_TRUE(buckets->nbOpenFiles <= 16);
+
+    // Each bucket can be sorted with 64 KB
+    uint64_t total = 0;
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        TEST_ASSERT_TRUE(buckets->buckets[i].size <= 64 * 1024 / (2 * sizeof(Kmer)));
+        total += buckets->buckets[i].size;
+    }
+    TEST_ASSERT_EQUAL(5000 * 81, total);
+
+    // The distinct kmers are the ones of the exact graph
+    rewind(fp);
+    DeBruijnGraph *exact = createExactDBG(fp, 20, NULL, 0);
+    KmerSet *kmers = collectDBGBuckets(buckets, 1);
+
+    TEST_ASSERT_NOT_NULL(exact);
+    TEST_ASSERT_NOT_NULL(kmers);
+    TEST_ASSERT_EQUAL(kmerSetSize(exact->kmers), kmerSetSize(kmers));
+    TEST_ASSERT_EQUAL_MEMORY(exact->kmers->kmers, kmers->kmers, kmerSetSize(kmers) * sizeof(Kmer));
+
+    kmerSetDelete(kmers);
+    deleteDBG(exact);
+    deleteDBGBuckets(buckets);
+    fclose(fp);
+}
+
+void test_countDBGBuckets_Should_OnlyCountSolidKmers() {
+    // Each read is repeated, except the last one
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    fprintf(fp, ">1\nCCGTAATGCCTTTCCCTAAC\n>2\nCCGTAATGCCTTTCCCTAAC\n>3\nAGAGTTTTTCGAACTCGTGT\n");
+    rewind(fp);
+
+    DBGBuckets *buckets = bucketDBGKmers(fp, 10, 1024, NULL);
+    TEST_ASSERT_NOT_NULL(buckets);
+
+    // The counts of the buckets are exact
+    uint64_t nbSolid = 0;
+    TEST_ASSERT_TRUE(countDBGBuckets(buckets, 2, &nbSolid));
+    TEST_ASSERT_EQUAL(11, nbSolid);
+
+    g_bf = bfCreate(10000, 5);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(insertDBGBuckets(buckets, g_bf, 2, 1));
+
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "CCGTAATGCC", 10));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "TTTCCCTAAC", 10));
+    TEST_ASSERT_FALSE(containsKmer(g_bf, "AGAGTTTTTC", 10));
+
+    // The reads of the weak kmers are written with literals
+    DeBruijnGraph graph = { .k = 10, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(computeBucketFalsePositives(&graph, fp, buckets, 2));
+    roundTrip(&graph, fp, 10);
+
+    kmerSetDelete(graph.falsePositives);
+    deleteDBGBuckets(buckets);
+    fclose(fp);
+}
+
+void test_readDBGBucket_Should_GiveSortedSolidKmers() {
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    fprintf(fp, ">1\nCCGTAATGCCTTTCCCTAAC\n>2\nCCGTAATGCCTTTCCCTAAC\n>3\nAGAGTTTTTCGAACTCGTGT\n");
+    rewind(fp);
+
+    DBGBuckets *buckets = bucketDBGKmers(fp, 10, 1024, NULL);
+    TEST_ASSERT_NOT_NULL(buckets);
+
+    Kmer *kmers = allocateDBGBucket(buckets);
+    TEST_ASSERT_NOT_NULL(kmers);
+
+    // The solid kmers of all buckets are the ones of the repeated read
+    uint64_t nbSolid = 0;
+
+    for (int i = 0;i < buckets->nbBuckets;i++) {
+        uint64_t n;
+        TEST_ASSERT_TRUE(readDBGBucket(buckets, i, kmers, 2, &n));
+
+        for (uint64_t j = 1;j < n;j++) {
+            TEST_ASSERT_TRUE(kmers[j - 1] < kmers[j]);
+        }
+
+        nbSolid += n;
+    }
+
+    TEST_ASSERT_EQUAL(11, nbSolid);
+
+    free(kmers);
+    deleteDBGBuckets(buckets);
+    fclose(fp);
+}
+
+void test_bucketDBGKmers_Should_ReturnNull_When_GivenInvalidParameters() {
+    FILE *fp = createFastaFile(100, 10);
+
+    TEST_ASSERT_NULL(bucketDBGKmers(fp, 20, 1024, NULL));
+
+    rewind(fp);
+    TEST_ASSERT_NULL(bucketDBGKmers(fp, 5, 0, NULL));
+
+    rewind(fp);
+    TEST_ASSERT_NULL(bucketDBGKmers(fp, 5, 1024, "/nonexistent/directory"));
+
+    fclose(fp);
+}
+
+void test_createSolidDBG_Should_OnlyInsertSolidKmers() {
+    // Each read is repeated, except the last one
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    fprintf(fp, ">1\nCCGTAATGCCTTTCCCTAAC\n>2\nCCGTAATGCCTTTCCCTAAC\n>3\nAGAGTTTTTCGAACTCGTGT\n");
+    rewind(fp);
+
+    uint64_t nbSolid = 0;
+    CountMinSketch *counts = countDBGKmers(fp, 10, 100, 2, &nbSolid);
+
+    TEST_ASSERT_NOT_NULL(counts);
+    // The estimate of a sketch is approximate
+    TEST_ASSERT_GREATER_OR_EQUAL(10, nbSolid);
+    TEST_ASSERT_LESS_OR_EQUAL(12, nbSolid);
+
+    rewind(fp);
+    g_bf = bfCreate(10000, 5);
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_TRUE(createSolidDBG(g_bf, fp, 10, 1, counts, 2));
+
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "CCGTAATGCC", 10));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "TTTCCCTAAC", 10));
+    TEST_ASSERT_FALSE(containsKmer(g_bf, "AGAGTTTTTC", 10));
+
+    // The reads of the weak kmers are written with literals
+    DeBruijnGraph graph = { .k = 10, .canonical = true, .bf = g_bf, .falsePositives = NULL };
+    TEST_ASSERT_TRUE(computeFalsePositives(&graph, fp, 10, counts, 2));
+    roundTrip(&graph, fp, 10);
+
+    rewind(fp);
+    DeBruijnGraph *exact = createExactDBG(fp, 10, counts, 2);
+
+    TEST_ASSERT_NOT_NULL(exact);
+    TEST_ASSERT_EQUAL(11, kmerSetSize(exact->kmers));
+    roundTrip(exact, fp, 10);
+
+    deleteDBG(exact);
+    kmerSetDelete(graph.falsePositives);
+    cmsDelete(counts);
+    fclose(fp);
+}
+
+void test_insertKmer_Should_ReturnFalse_When_GivenNegativeK() {
+    g_bf = bfCreate(10000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    char kmer[] = "ATCG";
+    TEST_ASSERT_FALSE(insertKmer(g_bf, kmer, 0));
+    TEST_ASSERT_FALSE(insertKmer(g_bf, kmer, -1));
+    TEST_ASSERT_FALSE(insertKmer(g_bf, kmer, KMER128_MAX_SIZE + 1));
+}
+
+void test_insertKmer_Should_ReturnTrue_And_UpdateBfWithCorrectKmer() {
+    g_bf = bfCreate(10000, 3);
+    TEST_ASSERT_NOT_NULL(g_bf);
+
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "CGTACGT", 7));
+
+    // Both forms share the same canonical hash
+    Kmer kmer;
+    KmerHash hash;
+    TEST_ASSERT_TRUE(kmerEncode("ACGTACG", 7, &kmer));
+    kmerHashInit(&hash, kmer, 7);
+
+    TEST_ASSERT_TRUE(bfContainsHash(g_bf, kmerHashCanonical(&hash)));
+
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "CGTACGT", 7));
+    TEST_ASSERT_TRUE(containsKmer(g_bf, "ACGTACG", 7));
+    TEST_ASSERT_FALSE(containsKmer(g_bf, "ACGTACC", 7));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenEmptyFile);
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_MissingData);
+    RUN_TEST(test_loadDBG_saveDBG);
+    RUN_TEST(test_loadDBG_saveDBG_Should_KeepBlockedLayout);
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenUnsupportedVersion);
+    RUN_TEST(test_loadDBG_Should_LoadGraphWithoutVersion);
+    RUN_TEST(test_loadDBG_Should_LoadVersion2BlockedGraph);
+    RUN_TEST(test_loadDBG_Should_LoadVersion5_With_LegacyKmerSize);
+    RUN_TEST(test_loadDBG_saveDBG_Should_KeepKmerSize);
+    RUN_TEST(test_saveDBG_Should_ReturnFalse_When_GivenInvalidKmerSize);
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenInvalidHeader);
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenInvalidContent);
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenInvalidNumberOfKmers);
+
+    RUN_TEST(test_createDBGThreads_Should_CreateSameFilterAsCreateDBG);
+    RUN_TEST(test_createDBGThreads_Should_ReturnFalse_When_ReadIsShorterThanK);
+    RUN_TEST(test_createPartitionedDBG_Should_CreateSameFilterAsCreateDBG);
+    RUN_TEST(test_insertDBGKmers_Should_CreateSameFilterAsCreateDBG);
+    RUN_TEST(test_insertDBGBuckets_Should_CreateSameFilterAsCreateDBG);
+    RUN_TEST(test_bucketDBGKmers_Should_SplitBuckets_When_FewFilesCanBeOpened);
+    RUN_TEST(test_countDBGBuckets_Should_OnlyCountSolidKmers);
+    RUN_TEST(test_readDBGBucket_Should_GiveSortedSolidKmers);
+    RUN_TEST(test_bucketDBGKmers_Should_ReturnNull_When_GivenInvalidParameters);
+    RUN_TEST(test_createPartitionedDBG_Should_OnlyInsertSolidKmers);
+    RUN_TEST(test_createPartitionedDBG_Should_ReturnFalse_When_ReadIsShorterThanK);
+
+    RUN_TEST(test_estimateDBGKmers_Should_EstimateNumberOfDistinctKmers);
+    RUN_TEST(test_createDBG_Should_CreateGraph_When_GivenKmersLongerThanPackedKmer);
+    RUN_TEST(test_computeFalsePositives_Should_RemoveSpuriousBranchings);
+    RUN_TEST(test_createExactDBG_Should_OnlyKeepTrueBranchings);
+    RUN_TEST(test_createDBG_Should_KeepStrands_When_StrandSpecific);
+    RUN_TEST(test_loadDBG_saveDBG_Should_KeepExactGraph);
+    RUN_TEST(test_mapDBG_saveMappedDBG_Should_KeepBloomGraph);
+    RUN_TEST(test_mapDBG_saveMappedDBG_Should_KeepExactGraph);
+    RUN_TEST(test_mapDBG_Should_ReturnNull_When_GivenCompressedGraph);
+    RUN_TEST(test_mapDBG_Should_ReturnNull_When_MissingData);
+    RUN_TEST(test_openDBG_Should_LoadAllGraphFormats);
+    RUN_TEST(test_openDBG_Should_KeepFastHashFunction);
+    RUN_TEST(test_mergeDBG_Should_CreateSameFilterAsWholeFile);
+    RUN_TEST(test_mergeDBG_Should_MergeExactGraphs);
+    RUN_TEST(test_mergeDBG_Should_ReturnFalse_When_GivenDifferentGraphs);
+    RUN_TEST(test_loadDBG_saveDBG_Should_KeepSparseFilter);
+    RUN_TEST(test_loadDBG_Should_ReturnNull_When_GivenInvalidSparseContent);
+    RUN_TEST(test_loadBlockedDBG_saveBlockedDBG_Should_KeepBloomGraph);
+    RUN_TEST(test_loadBlockedDBG_saveBlockedDBG_Should_KeepExactGraph);
+    RUN_TEST(test_loadBlockedDBG_Should_ReturnNull_When_GivenGzipGraph);
+    RUN_TEST(test_loadBlockedDBG_Should_ReturnNull_When_GivenInvalidNumberOfFalsePositives);
+    RUN_TEST(test_createSolidDBG_Should_OnlyInsertSolidKmers);
 
     RUN_TEST(test_insertKmer_Should_ReturnFalse_When_GivenNegativeK);
     RUN_TEST(test_insertKmer_Should_ReturnTrue_And_UpdateBfWithCorrectKmer);
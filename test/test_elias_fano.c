@@ -0,0 +1,151 @@
+#include "unity.h"
+
+#include "elias_fano.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t *g_encoded;
+
+/**
+ * \brief Encodes a bitvector into g_encoded
+ */
+uint64_t encodeBits(const char *bits, uint64_t len) {
+    uint64_t n = efCountBits(bits, len);
+    uint64_t size = efEncodedSize(n, 8 * len);
+
+    g_encoded = malloc(size > 0 ? size : 1);
+    TEST_ASSERT_NOT_NULL(g_encoded);
+
+    efEncode(bits, len, n, g_encoded);
+
+    return n;
+}
+
+void setUp() {
+    g_encoded = NULL;
+}
+
+void tearDown() {
+    free(g_encoded);
+}
+
+void test_efLowBits() {
+    TEST_ASSERT_EQUAL(0, efLowBits(0, 1000));
+    TEST_ASSERT_EQUAL(0, efLowBits(1000, 1000));
+    TEST_ASSERT_EQUAL(0, efLowBits(1000, 1999));
+    TEST_ASSERT_EQUAL(1, efLowBits(1000, 2000));
+    TEST_ASSERT_EQUAL(6, efLowBits(1, 127));
+    TEST_ASSERT_EQUAL(63, efLowBits(1, UINT64_MAX));
+}
+
+void test_efEncodedSize_Should_BeSmallerThanBitvector_When_GivenFewBits() {
+    // About 2 + log2(64) = 8 bits per set bit
+    TEST_ASSERT_LESS_OR_EQUAL(1000 * 8 / 8 + 16, efEncodedSize(1000, 64000));
+    TEST_ASSERT_EQUAL(0, efEncodedSize(0, 64000));
+    TEST_ASSERT_EQUAL(0, efEncodedSize(10, 64000) % 8);
+}
+
+void test_efCountBits() {
+    char bits[11] = { 0 };
+    bits[0] = 0x1;
+    bits[7] = (char) 0xFF;
+    bits[10] = 0x12;
+
+    TEST_ASSERT_EQUAL(11, efCountBits(bits, 11));
+    TEST_ASSERT_EQUAL(9, efCountBits(bits, 10));
+    TEST_ASSERT_EQUAL(0, efCountBits(bits, 0));
+}
+
+void test_efEncode_efDecode() {
+    uint64_t len = 10003;
+    char *bits = calloc(len, 1);
+    char *result = calloc(len, 1);
+    TEST_ASSERT_NOT_NULL(bits);
+    TEST_ASSERT_NOT_NULL(result);
+
+    // Sparse bits, with the first and last ones of the bitvector
+    uint64_t state = 42;
+    for (int i = 0;i < 2000;i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t position = (state >> 16) % (8 * len);
+        bits[position / 8] |= 1 << (position % 8);
+    }
+    bits[0] |= 0x1;
+    bits[len - 1] |= (char) 0x80;
+
+    uint64_t n = encodeBits(bits, len);
+    TEST_ASSERT_LESS_THAN(len, efEncodedSize(n, 8 * len));
+
+    TEST_ASSERT_TRUE(efDecode(g_encoded, n, result, len));
+    TEST_ASSERT_EQUAL_MEMORY(bits, result, len);
+
+    free(bits);
+    free(result);
+}
+
+void test_efEncode_efDecode_Should_AcceptEmptyAndFullBitvectors() {
+    char bits[100] = { 0 };
+    char result[100] = { 0 };
+
+    uint64_t n = encodeBits(bits, 100);
+    TEST_ASSERT_EQUAL(0, n);
+    TEST_ASSERT_TRUE(efDecode(g_encoded, n, result, 100));
+    TEST_ASSERT_EQUAL_MEMORY(bits, result, 100);
+
+    free(g_encoded);
+    memset(bits, 0xFF, 100);
+
+    n = encodeBits(bits, 100);
+    TEST_ASSERT_EQUAL(800, n);
+    TEST_ASSERT_TRUE(efDecode(g_encoded, n, result, 100));
+    TEST_ASSERT_EQUAL_MEMORY(bits, result, 100);
+}
+
+void test_efDecode_Should_ReturnFalse_When_GivenInvalidNumberOfBits() {
+    char bits[64] = { 0 };
+    char result[64] = { 0 };
+    bits[3] = 0x5;
+    bits[40] = 0x1;
+
+    uint64_t n = encodeBits(bits, 64);
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_TRUE(efDecode(g_encoded, n, result, 64));
+
+    // The encoding has one position less than expected
+    uint64_t *larger = calloc(efEncodedSize(n + 1, 8 * 64) / 8, sizeof(uint64_t));
+    TEST_ASSERT_NOT_NULL(larger);
+    memcpy(larger, g_encoded, efEncodedSize(n, 8 * 64));
+    TEST_ASSERT_FALSE(efDecode(larger, n + 1, result, 64));
+    free(larger);
+}
+
+void test_efDecode_Should_ReturnFalse_When_GivenPositionOutsideBitvector() {
+    char result[8] = { 0 };
+
+    // A position of 64 bits : 6 low bits equal to 0 and a high value of 1
+    TEST_ASSERT_EQUAL(6, efLowBits(1, 64));
+    uint64_t encoded[2] = { 0, 0x2 };
+    TEST_ASSERT_FALSE(efDecode(encoded, 1, result, 8));
+
+    // The same position minus one is the last bit of the bitvector
+    encoded[0] = 63;
+    encoded[1] = 0x1;
+    TEST_ASSERT_TRUE(efDecode(encoded, 1, result, 8));
+    TEST_ASSERT_EQUAL(0x80, (unsigned char) result[7]);
+}
+
+int main() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_efLowBits);
+    RUN_TEST(test_efEncodedSize_Should_BeSmallerThanBitvector_When_GivenFewBits);
+    RUN_TEST(test_efCountBits);
+    RUN_TEST(test_efEncode_efDecode);
+    RUN_TEST(test_efEncode_efDecode_Should_AcceptEmptyAndFullBitvectors);
+    RUN_TEST(test_efDecode_Should_ReturnFalse_When_GivenInvalidNumberOfBits);
+    RUN_TEST(test_efDecode_Should_ReturnFalse_When_GivenPositionOutsideBitvector);
+
+    return UNITY_END();
+}
@@ -5,23 +5,31 @@
 #include "fasta.h"
 #include "vector.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 static BloomFilter *g_bf;
+static DeBruijnGraph g_graph;
 static Vector *g_vec;
+static Vector *g_literals;
 
 void setUp() {
     g_bf = NULL;
+    g_graph.bf = NULL;
+    g_graph.falsePositives = NULL;
     g_vec = NULL;
+    g_literals = NULL;
 }
 
 void tearDown() {
     bfDelete(g_bf);
     vectorDelete(g_vec);
+    vectorDelete(g_literals);
 }
 
 void test_computeBranchings() {
     g_bf = bfCreate(10000, 7);
+    g_graph.bf = g_bf;
     g_vec = vectorCreate(10, 1);
 
     char k1[] = "CTGACG";
@@ -39,13 +47,52 @@ void test_computeBranchings() {
     TEST_ASSERT_TRUE(insertKmer(g_bf, k6, 6));
 
     char seq[] = "CTGACGTGGA";
-    TEST_ASSERT_TRUE(computeBranchings(g_bf, g_vec, seq, 10, 6));
+    TEST_ASSERT_TRUE(computeBranchings(&g_graph, g_vec, NULL, seq, 10, 6));
 
     TEST_ASSERT_EQUAL(1, vectorSize(g_vec));
 }
 
+void test_computeBranchings_Should_AddLiterals_When_KmerIsNotInGraph() {
+    g_bf = bfCreate(10000, 7);
+    g_graph.bf = g_bf;
+    g_vec = vectorCreate(10, 1);
+    g_literals = vectorCreate(10, sizeof(ReadLiteral));
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_NOT_NULL(g_vec);
+    TEST_ASSERT_NOT_NULL(g_literals);
+
+    // The kmers that contain the error T are not in the graph
+    char solid[] = "ATTTCGGGAAAAAATCGAGCCCTAATT";
+    char seq[] = "ATTTCGGGAAAATATCGAGCCCTAATT";
+    int len = strlen(seq);
+
+    for (int i = 0;i <= len - 8;i++) {
+        TEST_ASSERT_TRUE(insertKmer(g_bf, solid + i, 8));
+    }
+
+    // The length includes the end of line, like compressFile
+    TEST_ASSERT_FALSE(computeBranchings(&g_graph, g_vec, NULL, seq, len + 1, 8));
+
+    vectorClear(g_vec);
+    TEST_ASSERT_TRUE(computeBranchings(&g_graph, g_vec, g_literals, seq, len + 1, 8));
+
+    // The error and the letters after it until the walk is back in the graph
+    TEST_ASSERT_EQUAL(8, vectorSize(g_literals));
+
+    ReadLiteral *first = vectorAt(g_literals, 0);
+    TEST_ASSERT_EQUAL(4, first->position);
+    TEST_ASSERT_EQUAL('T', first->letter);
+
+    char result[28] = { '\0' };
+
+    TEST_ASSERT_TRUE(decompressRead(&g_graph, g_vec, g_literals, result, len, seq, 8));
+    TEST_ASSERT_EQUAL_STRING(seq, result);
+}
+
 void test_decompressRead_Should_ReturnTrue_When_GivenValidCompressedRead() {
     g_bf = bfCreate(10000, 7);
+    g_graph.bf = g_bf;
     g_vec = vectorCreate(10, 1);
 
     TEST_ASSERT_NOT_NULL(g_bf);
@@ -69,10 +116,96 @@ void test_decompressRead_Should_ReturnTrue_When_GivenValidCompressedRead() {
 
     char result[28] = { '\0' };
 
-    TEST_ASSERT_TRUE(decompressRead(g_bf, g_vec, result, 27, "ATTTCGGG", 8));
+    TEST_ASSERT_TRUE(decompressRead(&g_graph, g_vec, NULL, result, 27, "ATTTCGGG", 8));
     TEST_ASSERT_EQUAL_STRING(seq1, result);
 }
 
+void test_decompressReads_Should_ReturnSameReadsAsDecompressRead() {
+    g_bf = bfCreate(10000, 7);
+    g_graph.bf = g_bf;
+    g_vec = vectorCreate(10, 1);
+
+    TEST_ASSERT_NOT_NULL(g_bf);
+    TEST_ASSERT_NOT_NULL(g_vec);
+
+    char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGCA";
+    int len = strlen(seq);
+
+    for (int i = 0;i <= len - 8;i++) {
+        TEST_ASSERT_TRUE(insertKmer(g_bf, seq + i, 8));
+    }
+
+    // Branchings of a prefix of the sequence are the first ones of the sequence
+    TEST_ASSERT_TRUE(computeBranchings(&g_graph, g_vec, NULL, seq, len, 8));
+
+    // Reads of a group have different lengths, more reads
+    // than FASTA_WALK_GROUP are given to use several groups
+    int nbReads = FASTA_WALK_GROUP + 3;
+    ReadWalk walks[FASTA_WALK_GROUP + 3];
+    char reads[FASTA_WALK_GROUP + 3][32];
+
+    for (int i = 0;i < nbReads;i++) {
+        memset(reads[i], '\0', 32);
+
+        walks[i].branchings = g_vec;
+        walks[i].literals = NULL;
+        walks[i].read = reads[i];
+        walks[i].readLength = 8 + i % (len - 7);
+        walks[i].firstKmer = seq;
+    }
+
+    TEST_ASSERT_TRUE(decompressReads(&g_graph, walks, nbReads, 8));
+
+    for (int i = 0;i < nbReads;i++) {
+        char expected[32] = { '\0' };
+
+        TEST_ASSERT_TRUE(decompressRead(&g_graph, g_vec, NULL, expected, walks[i].readLength, seq, 8));
+        TEST_ASSERT_EQUAL_STRING(expected, reads[i]);
+        TEST_ASSERT_EQUAL(0, strncmp(seq, reads[i], walks[i].readLength));
+    }
+}
+
+void test_decompressReads_Should_GiveOriginalRead_When_GivenSpecializedOrLongKmers() {
+    // The sequence repeats a part of itself, so that some kmers have several successors
+    char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTTACGTTGCAACGGATCCATGCAAGT"
+        "TCGATCGGATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTTACGTTGCAACGGAGCCTTTAA";
+    int len = strlen(seq);
+    int sizes[] = { 20, 21, 25, 31, 32, 33, 63, 64 };
+
+    for (size_t s = 0;s < sizeof(sizes) / sizeof(*sizes);s++) {
+        int k = sizes[s];
+
+        g_bf = bfCreate(100000, 7);
+        g_graph.bf = g_bf;
+        g_vec = vectorCreate(10, 1);
+        g_literals = vectorCreate(10, sizeof(ReadLiteral));
+
+        TEST_ASSERT_NOT_NULL(g_bf);
+        TEST_ASSERT_NOT_NULL(g_vec);
+        TEST_ASSERT_NOT_NULL(g_literals);
+
+        // The last kmer is missing, its letter is a literal
+        for (int i = 0;i < len - k;i++) {
+            TEST_ASSERT_TRUE(insertKmer(g_bf, seq + i, k));
+        }
+
+        // Like compressFile, the length given to computeBranchings includes the end of line
+        TEST_ASSERT_TRUE(computeBranchings(&g_graph, g_vec, g_literals, seq, len + 1, k));
+        TEST_ASSERT_EQUAL(1, vectorSize(g_literals));
+
+        char read[sizeof(seq)] = { '\0' };
+        ReadWalk walk = { .branchings = g_vec, .literals = g_literals, .read = read, .readLength = len, .firstKmer = seq };
+
+        TEST_ASSERT_TRUE(decompressReads(&g_graph, &walk, 1, k));
+        TEST_ASSERT_EQUAL_STRING(seq, read);
+
+        bfDelete(g_bf);
+        vectorDelete(g_vec);
+        vectorDelete(g_literals);
+        setUp();
+    }
+}
+
 void test_extractBranchings_Should_ReturnZero_When_GivenLineWithoutBranchings() {
     g_vec = vectorCreate(10, 1);
     TEST_ASSERT_NOT_NULL(g_vec);
@@ -116,14 +249,79 @@ void test_extractBranchings_Should_ReturnTwo_And_UpdateVector_When_GivenLineWith
     TEST_ASSERT_EQUAL('b', *v2);
 }
 
+void test_extractLiterals_Should_ExpandRuns() {
+    g_literals = vectorCreate(10, sizeof(ReadLiteral));
+    TEST_ASSERT_NOT_NULL(g_literals);
+
+    char l1[] = "ACGT AC 3GT10A\n";
+    TEST_ASSERT_EQUAL(3, extractLiterals(g_literals, l1));
+
+    int positions[] = { 3, 4, 10 };
+    char letters[] = { 'G', 'T', 'A' };
+
+    for (int i = 0;i < 3;i++) {
+        ReadLiteral *literal = vectorAt(g_literals, i);
+
+        TEST_ASSERT_EQUAL(positions[i], literal->position);
+        TEST_ASSERT_EQUAL(letters[i], literal->letter);
+    }
+
+    // The branchings stop before the literals
+    g_vec = vectorCreate(10, 1);
+    TEST_ASSERT_NOT_NULL(g_vec);
+    TEST_ASSERT_EQUAL(2, extractBranchings(g_vec, l1));
+}
+
+void test_extractLiterals_Should_ReturnNegativeValue_When_GivenInvalidLiterals() {
+    g_literals = vectorCreate(10, sizeof(ReadLiteral));
+    TEST_ASSERT_NOT_NULL(g_literals);
+
+    char l1[] = "ACGT AC T";
+    TEST_ASSERT_LESS_THAN(0, extractLiterals(g_literals, l1));
+
+    char l2[] = "ACGT AC 5AA2C";
+    TEST_ASSERT_LESS_THAN(0, extractLiterals(g_literals, l2));
+
+    char l3[] = "ACGT AC";
+    TEST_ASSERT_EQUAL(0, extractLiterals(g_literals, l3));
+}
+
+void test_readSequence_Should_SkipHeadersAndEndsOfLine() {
+    FILE *fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    fputs(">read1\nACGT\r\n>read2\n\nTTGCA", fp);
+    rewind(fp);
+
+    char *line = NULL;
+    size_t length = 0;
+
+    TEST_ASSERT_EQUAL(4, readSequence(&line, &length, fp));
+    TEST_ASSERT_EQUAL_MEMORY("ACGT", line, 4);
+    TEST_ASSERT_EQUAL(0, readSequence(&line, &length, fp));
+    TEST_ASSERT_EQUAL(5, readSequence(&line, &length, fp));
+    TEST_ASSERT_EQUAL_MEMORY("TTGCA", line, 5);
+    TEST_ASSERT_EQUAL(-1, readSequence(&line, &length, fp));
+
+    free(line);
+    fclose(fp);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(test_computeBranchings);
+    RUN_TEST(test_computeBranchings_Should_AddLiterals_When_KmerIsNotInGraph);
 
     RUN_TEST(test_decompressRead_Should_ReturnTrue_When_GivenValidCompressedRead);
+    RUN_TEST(test_decompressReads_Should_ReturnSameReadsAsDecompressRead);
+    RUN_TEST(test_decompressReads_Should_GiveOriginalRead_When_GivenSpecializedOrLongKmers);
 
     RUN_TEST(test_extractBranchings_Should_ReturnZero_When_GivenLineWithoutBranchings);
     RUN_TEST(test_extractBranchings_Should_NotModifyVector_When_GivenLineWithoutBranchings);
     RUN_TEST(test_extractBranchings_Should_ReturnTwo_And_UpdateVector_When_GivenLineWithTwoBranchings);
+
+    RUN_TEST(test_extractLiterals_Should_ExpandRuns);
+    RUN_TEST(test_extractLiterals_Should_ReturnNegativeValue_When_GivenInvalidLiterals);
+    RUN_TEST(test_readSequence_Should_SkipHeadersAndEndsOfLine);
     return UNITY_END();
 }
\ No newline at end of file
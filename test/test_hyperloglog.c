@@ -0,0 +1,65 @@
+#include "unity.h"
+
+#include "hyperloglog.h"
+
+static HyperLogLog *g_hll;
+
+void setUp() {
+    g_hll = NULL;
+}
+
+void tearDown() {
+    hllDelete(g_hll);
+}
+
+void test_hllCreate_Should_ReturnNull_When_GivenInvalidPrecision() {
+    TEST_ASSERT_NULL(hllCreate(HLL_MIN_PRECISION - 1));
+    TEST_ASSERT_NULL(hllCreate(HLL_MAX_PRECISION + 1));
+}
+
+void test_hllEstimate_Should_ReturnZero_When_GivenEmptySketch() {
+    g_hll = hllCreate(10);
+    TEST_ASSERT_NOT_NULL(g_hll);
+
+    TEST_ASSERT_EQUAL(0, hllEstimate(g_hll));
+}
+
+void test_hllEstimate_Should_IgnoreDuplicates() {
+    g_hll = hllCreate(14);
+    TEST_ASSERT_NOT_NULL(g_hll);
+
+    for (int i = 0;i < 10;i++) {
+        for (uint64_t value = 0;value < 1000;value++) {
+            hllAdd(g_hll, value);
+        }
+    }
+
+    uint64_t estimate = hllEstimate(g_hll);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(980, estimate);
+    TEST_ASSERT_LESS_OR_EQUAL(1020, estimate);
+}
+
+void test_hllEstimate_Should_BeClose_When_GivenManyValues() {
+    g_hll = hllCreate(14);
+    TEST_ASSERT_NOT_NULL(g_hll);
+
+    for (uint64_t value = 0;value < 1000000;value++) {
+        hllAdd(g_hll, value);
+    }
+
+    // The relative error is about 0.8%
+    uint64_t estimate = hllEstimate(g_hll);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(970000, estimate);
+    TEST_ASSERT_LESS_OR_EQUAL(1030000, estimate);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hllCreate_Should_ReturnNull_When_GivenInvalidPrecision);
+    RUN_TEST(test_hllEstimate_Should_ReturnZero_When_GivenEmptySketch);
+    RUN_TEST(test_hllEstimate_Should_IgnoreDuplicates);
+    RUN_TEST(test_hllEstimate_Should_BeClose_When_GivenManyValues);
+    return UNITY_END();
+}
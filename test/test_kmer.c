@@ -0,0 +1,175 @@
+#include "kmer.h"
+
+#include "unity.h"
+
+void setUp() { }
+
+void tearDown() {
+    kmerUseCanonical(true);
+}
+
+void test_kmerEncode_Should_ReturnFalse_When_GivenInvalidLength() {
+    Kmer kmer;
+
+    TEST_ASSERT_FALSE(kmerEncode("ACGT", 0, &kmer));
+    TEST_ASSERT_FALSE(kmerEncode("ACGT", -1, &kmer));
+    TEST_ASSERT_FALSE(kmerEncode("ACGTACGTACGTACGTACGTACGTACGTACGTA", KMER_MAX_SIZE + 1, &kmer));
+}
+
+void test_kmerEncode_Should_PackTwoBitsPerBase() {
+    Kmer kmer;
+
+    TEST_ASSERT_TRUE(kmerEncode("ACGT", 4, &kmer));
+    TEST_ASSERT_EQUAL(0x1B, kmer);
+
+    TEST_ASSERT_TRUE(kmerEncode("acgt", 4, &kmer));
+    TEST_ASSERT_EQUAL(0x1B, kmer);
+}
+
+void test_kmerEncode_kmerDecode() {
+    char str[] = "TTGACCGTAAGCTTGACCGTAAGCTTGACCGT";
+    char result[33] = { '\0' };
+    Kmer kmer;
+
+    TEST_ASSERT_TRUE(kmerEncode(str, 32, &kmer));
+    kmerDecode(kmer, 32, result);
+
+    TEST_ASSERT_EQUAL_STRING(str, result);
+}
+
+void test_kmerAppend_Should_DropFirstBase() {
+    Kmer kmer;
+    Kmer expected;
+
+    TEST_ASSERT_TRUE(kmerEncode("ATCG", 4, &kmer));
+    TEST_ASSERT_TRUE(kmerEncode("TCGA", 4, &expected));
+
+    TEST_ASSERT_EQUAL(expected, kmerAppend(kmer, kmerEncodeBase('A'), 4));
+}
+
+void test_kmerReverseComplement() {
+    Kmer kmer;
+    Kmer expected;
+
+    TEST_ASSERT_TRUE(kmerEncode("CGTACGT", 7, &kmer));
+    TEST_ASSERT_TRUE(kmerEncode("ACGTACG", 7, &expected));
+    TEST_ASSERT_EQUAL(expected, kmerReverseComplement(kmer, 7));
+
+    TEST_ASSERT_TRUE(kmerEncode("AAAACCCCGGGGTTTTAAAACCCCGGGGTTTC", 32, &kmer));
+    TEST_ASSERT_TRUE(kmerEncode("GAAACCCCGGGGTTTTAAAACCCCGGGGTTTT", 32, &expected));
+    TEST_ASSERT_EQUAL(expected, kmerReverseComplement(kmer, 32));
+}
+
+void test_kmerAppendReverse_Should_FollowKmerAppend() {
+    Kmer kmer;
+    TEST_ASSERT_TRUE(kmerEncode("ATCGGA", 6, &kmer));
+
+    Kmer rc = kmerReverseComplement(kmer, 6);
+
+    for (uint8_t base = 0;base < 4;base++) {
+        Kmer next = kmerAppend(kmer, base, 6);
+
+        TEST_ASSERT_EQUAL(kmerReverseComplement(next, 6), kmerAppendReverse(rc, base, 6));
+    }
+}
+
+void test_kmerCanonical_Should_ReturnSmallestForm() {
+    Kmer kmer;
+    Kmer rc;
+
+    TEST_ASSERT_TRUE(kmerEncode("CGTACGT", 7, &kmer));
+    TEST_ASSERT_TRUE(kmerEncode("ACGTACG", 7, &rc));
+
+    TEST_ASSERT_EQUAL(rc, kmerCanonical(kmer, 7));
+    TEST_ASSERT_EQUAL(rc, kmerCanonical(rc, 7));
+}
+
+void test_kmerCanonical_Should_ReturnKmer_When_StrandSpecific() {
+    Kmer kmer;
+    Kmer128 kmer128;
+
+    TEST_ASSERT_TRUE(kmerEncode("CGTACGT", 7, &kmer));
+    TEST_ASSERT_TRUE(kmer128Encode("CGTACGT", 7, &kmer128));
+
+    kmerUseCanonical(false);
+
+    TEST_ASSERT_EQUAL(kmer, kmerCanonical(kmer, 7));
+    TEST_ASSERT_TRUE(kmer128 == kmer128Canonical(kmer128, 7));
+}
+
+void test_kmer128Encode_kmer128Decode() {
+    char str[] = "TTGACCGTAAGCTTGACCGTAAGCTTGACCGTACGTTGCAACGGATCCATGCAAGTTCGATCGG";
+    char result[65] = { '\0' };
+    Kmer128 kmer;
+
+    TEST_ASSERT_TRUE(kmer128Encode(str, 64, &kmer));
+    kmer128Decode(kmer, 64, result);
+    TEST_ASSERT_EQUAL_STRING(str, result);
+
+    TEST_ASSERT_FALSE(kmer128Encode(str, 0, &kmer));
+    TEST_ASSERT_FALSE(kmer128Encode(str, KMER128_MAX_SIZE + 1, &kmer));
+}
+
+void test_kmer128_Should_GiveSameKmersAsKmer_When_GivenShortKmers() {
+    const char str[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCT";
+
+    for (int k = 1;k <= KMER_MAX_SIZE;k++) {
+        Kmer kmer;
+        Kmer128 kmer128;
+
+        TEST_ASSERT_TRUE(kmerEncode(str, k, &kmer));
+        TEST_ASSERT_TRUE(kmer128Encode(str, k, &kmer128));
+
+        TEST_ASSERT_TRUE(kmer128 == kmer);
+        TEST_ASSERT_TRUE(kmer128ReverseComplement(kmer128, k) == kmerReverseComplement(kmer, k));
+        TEST_ASSERT_TRUE(kmer128Canonical(kmer128, k) == kmerCanonical(kmer, k));
+        TEST_ASSERT_TRUE(kmer128Append(kmer128, 2, k) == kmerAppend(kmer, 2, k));
+        TEST_ASSERT_EQUAL(kmerFirstBase(kmer, k), kmer128FirstBase(kmer128, k));
+    }
+}
+
+void test_kmer128ReverseComplement_Should_ReverseAndComplementBases() {
+    const char str[] = "AAAACCCCGGGGTTTTAAAACCCCGGGGTTTCACGTTGCAACGGATCCATGCAAGTTCGATCGG";
+
+    for (int k = KMER_MAX_SIZE + 1;k <= KMER128_MAX_SIZE;k++) {
+        char expected[KMER128_MAX_SIZE];
+        char result[KMER128_MAX_SIZE];
+        Kmer128 kmer;
+
+        for (int i = 0;i < k;i++) {
+            expected[i] = kmerDecodeBase(kmerEncodeBase(str[k - 1 - i]) ^ 0x3);
+        }
+
+        TEST_ASSERT_TRUE(kmer128Encode(str, k, &kmer));
+        kmer128Decode(kmer128ReverseComplement(kmer, k), k, result);
+        TEST_ASSERT_EQUAL_MEMORY(expected, result, k);
+
+        // The reverse complement follows the appended bases
+        Kmer128 rc = kmer128ReverseComplement(kmer, k);
+
+        for (uint8_t base = 0;base < 4;base++) {
+            Kmer128 next = kmer128Append(kmer, base, k);
+
+            TEST_ASSERT_TRUE(kmer128ReverseComplement(next, k) == kmer128AppendReverse(rc, base, k));
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_kmerEncode_Should_ReturnFalse_When_GivenInvalidLength);
+    RUN_TEST(test_kmerEncode_Should_PackTwoBitsPerBase);
+    RUN_TEST(test_kmerEncode_kmerDecode);
+
+    RUN_TEST(test_kmerAppend_Should_DropFirstBase);
+    RUN_TEST(test_kmerReverseComplement);
+    RUN_TEST(test_kmerAppendReverse_Should_FollowKmerAppend);
+
+    RUN_TEST(test_kmerCanonical_Should_ReturnSmallestForm);
+    RUN_TEST(test_kmerCanonical_Should_ReturnKmer_When_StrandSpecific);
+
+    RUN_TEST(test_kmer128Encode_kmer128Decode);
+    RUN_TEST(test_kmer128_Should_GiveSameKmersAsKmer_When_GivenShortKmers);
+    RUN_TEST(test_kmer128ReverseComplement_Should_ReverseAndComplementBases);
+    return UNITY_END();
+}
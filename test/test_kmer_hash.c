@@ -0,0 +1,295 @@
+#include "kmer_hash.h"
+
+#include "unity.h"
+
+#include <string.h>
+
+void setUp() { }
+
+void tearDown() {
+    kmerHashUseFunction(KMER_HASH_NTHASH);
+    kmerUseCanonical(true);
+}
+
+void test_kmerHashInit_Should_GiveSameCanonicalHash_When_GivenReverseComplement() {
+    Kmer kmer;
+    KmerHash h1;
+    KmerHash h2;
+
+    TEST_ASSERT_TRUE(kmerEncode("CGTACGTT", 8, &kmer));
+    kmerHashInit(&h1, kmer, 8);
+    kmerHashInit(&h2, kmerReverseComplement(kmer, 8), 8);
+
+    TEST_ASSERT_EQUAL(h1.forward, h2.reverse);
+    TEST_ASSERT_EQUAL(h1.reverse, h2.forward);
+    TEST_ASSERT_EQUAL(kmerHashCanonical(&h1), kmerHashCanonical(&h2));
+}
+
+void test_kmerHashInit_Should_GiveDifferentHashs_When_GivenDifferentKmers() {
+    Kmer k1;
+    Kmer k2;
+    KmerHash h1;
+    KmerHash h2;
+
+    TEST_ASSERT_TRUE(kmerEncode("CGTACGTT", 8, &k1));
+    TEST_ASSERT_TRUE(kmerEncode("CGTACGTA", 8, &k2));
+    kmerHashInit(&h1, k1, 8);
+    kmerHashInit(&h2, k2, 8);
+
+    TEST_ASSERT_NOT_EQUAL(kmerHashCanonical(&h1), kmerHashCanonical(&h2));
+}
+
+void test_kmerHashRoll_Should_GiveSameHashAsInit() {
+    const char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTT";
+    int k = 31;
+    Kmer kmer;
+    KmerHash rolled;
+
+    TEST_ASSERT_TRUE(kmerEncode(seq, k, &kmer));
+    kmerHashInit(&rolled, kmer, k);
+
+    for (size_t i = k;i < strlen(seq);i++) {
+        uint8_t base = kmerEncodeBase(seq[i]);
+        rolled = kmerHashRoll(&rolled, kmerFirstBase(kmer, k), base, k);
+        kmer = kmerAppend(kmer, base, k);
+
+        KmerHash expected;
+        kmerHashInit(&expected, kmer, k);
+
+        TEST_ASSERT_EQUAL(expected.forward, rolled.forward);
+        TEST_ASSERT_EQUAL(expected.reverse, rolled.reverse);
+    }
+}
+
+void test_kmerHashSuccessors_Should_GiveSameHashsAsRoll_When_GivenAnyKernel() {
+    const char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTT";
+    int k = 21;
+
+    // An odd number of kmers, the last one is hashed alone by the AVX-512 kernel
+    KmerHash hashes[5];
+    uint8_t firsts[5];
+
+    for (int i = 0;i < 5;i++) {
+        Kmer kmer;
+        TEST_ASSERT_TRUE(kmerEncode(seq + i * 3, k, &kmer));
+
+        kmerHashInit(hashes + i, kmer, k);
+        firsts[i] = kmerFirstBase(kmer, k);
+    }
+
+    KmerHashKernel kernels[] = { KMER_HASH_SCALAR, KMER_HASH_AVX2, KMER_HASH_AVX512 };
+
+    for (size_t j = 0;j < sizeof(kernels) / sizeof(*kernels);j++) {
+        // Kernels that are not supported by the processor are skipped
+        if (!kmerHashUseKernel(kernels[j])) {
+            continue;
+        }
+
+        uint64_t successors[20];
+        kmerHashSuccessors(hashes, firsts, 5, k, successors);
+
+        for (int i = 0;i < 5;i++) {
+            for (uint8_t base = 0;base < 4;base++) {
+                KmerHash next = kmerHashRoll(hashes + i, firsts[i], base, k);
+
+                TEST_ASSERT_EQUAL(kmerHashCanonical(&next), successors[i * 4 + base]);
+            }
+        }
+    }
+
+    TEST_ASSERT_TRUE(kmerHashUseKernel(KMER_HASH_SCALAR));
+}
+
+void test_kmerHashInit128_Should_GiveSameHashsAsInit_When_GivenShortKmer() {
+    Kmer kmer;
+    Kmer128 kmer128;
+    KmerHash expected;
+    KmerHash hash;
+
+    TEST_ASSERT_TRUE(kmerEncode("ATTTCGGGAAAAAATCGAGCCCTAATTGACC", 31, &kmer));
+    TEST_ASSERT_TRUE(kmer128Encode("ATTTCGGGAAAAAATCGAGCCCTAATTGACC", 31, &kmer128));
+    kmerHashInit(&expected, kmer, 31);
+    kmerHashInit128(&hash, kmer128, 31);
+
+    TEST_ASSERT_EQUAL(expected.forward, hash.forward);
+    TEST_ASSERT_EQUAL(expected.reverse, hash.reverse);
+}
+
+void test_kmerHashRoll_Should_GiveSameHashAsInit128_When_GivenLongKmers() {
+    const char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTTACGTTGCAACGGATCCATGCAAGTTCGATCGG";
+
+    for (int k = 33;k <= KMER128_MAX_SIZE;k += 15) {
+        Kmer128 kmer;
+        KmerHash rolled;
+
+        TEST_ASSERT_TRUE(kmer128Encode(seq, k, &kmer));
+        kmerHashInit128(&rolled, kmer, k);
+
+        for (size_t i = k;i < strlen(seq);i++) {
+            uint8_t base = kmerEncodeBase(seq[i]);
+            rolled = kmerHashRoll(&rolled, kmer128FirstBase(kmer, k), base, k);
+            kmer = kmer128Append(kmer, base, k);
+
+            KmerHash expected;
+            kmerHashInit128(&expected, kmer, k);
+
+            TEST_ASSERT_EQUAL(expected.forward, rolled.forward);
+            TEST_ASSERT_EQUAL(expected.reverse, rolled.reverse);
+
+            // A kmer and its reverse complement have the same canonical hash
+            KmerHash rc;
+            kmerHashInit128(&rc, kmer128ReverseComplement(kmer, k), k);
+            TEST_ASSERT_EQUAL(kmerHashCanonical(&expected), kmerHashCanonical(&rc));
+        }
+    }
+}
+
+void test_kmerHashRoll_Should_GiveSameHashAsInit_When_GivenMixFunction() {
+    const char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTT";
+    int k = 31;
+    Kmer kmer;
+    KmerHash rolled;
+
+    kmerHashUseFunction(KMER_HASH_MIX);
+
+    TEST_ASSERT_TRUE(kmerEncode(seq, k, &kmer));
+    kmerHashInit(&rolled, kmer, k);
+
+    for (size_t i = k;i < strlen(seq);i++) {
+        uint8_t base = kmerEncodeBase(seq[i]);
+        rolled = kmerHashRoll(&rolled, kmerFirstBase(kmer, k), base, k);
+        kmer = kmerAppend(kmer, base, k);
+
+        KmerHash expected;
+        KmerHash reverse;
+        kmerHashInit(&expected, kmer, k);
+        kmerHashInit(&reverse, kmerReverseComplement(kmer, k), k);
+
+        TEST_ASSERT_EQUAL(expected.forward, rolled.forward);
+        TEST_ASSERT_EQUAL(expected.reverse, rolled.reverse);
+        TEST_ASSERT_EQUAL(fastHashMix64(kmerCanonical(kmer, k)), kmerHashCanonical(&rolled));
+        TEST_ASSERT_EQUAL(kmerHashCanonical(&reverse), kmerHashCanonical(&rolled));
+    }
+}
+
+void test_kmerHashSuccessors_Should_GiveSameHashsAsRoll_When_GivenMixFunction() {
+    const char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTT";
+    int k = 21;
+    KmerHash hashes[3];
+    uint8_t firsts[3];
+
+    kmerHashUseFunction(KMER_HASH_MIX);
+
+    for (int i = 0;i < 3;i++) {
+        Kmer kmer;
+        TEST_ASSERT_TRUE(kmerEncode(seq + i * 5, k, &kmer));
+
+        kmerHashInit(hashes + i, kmer, k);
+        firsts[i] = kmerFirstBase(kmer, k);
+    }
+
+    uint64_t successors[12];
+    kmerHashSuccessors(hashes, firsts, 3, k, successors);
+
+    for (int i = 0;i < 3;i++) {
+        for (uint8_t base = 0;base < 4;base++) {
+            KmerHash next = kmerHashRoll(hashes + i, firsts[i], base, k);
+
+            TEST_ASSERT_EQUAL(kmerHashCanonical(&next), successors[i * 4 + base]);
+        }
+    }
+}
+
+void test_kmerHashSuccessors_Should_GiveForwardHashs_When_StrandSpecific() {
+    const char seq[] = "ATTTCGGGAAAAAATCGAGCCCTAATTGACCTAGGCATTACGCGATAGCATTT";
+    int k = 25;
+    KmerHash hashes[3];
+    uint8_t firsts[3];
+
+    kmerUseCanonical(false);
+
+    for (int i = 0;i < 3;i++) {
+        Kmer kmer;
+        TEST_ASSERT_TRUE(kmerEncode(seq + i * 7, k, &kmer));
+
+        kmerHashInit(hashes + i, kmer, k);
+        firsts[i] = kmerFirstBase(kmer, k);
+
+        // The reverse complement is another kmer
+        KmerHash reverse;
+        kmerHashInit(&reverse, kmerReverseComplement(kmer, k), k);
+        TEST_ASSERT_NOT_EQUAL(kmerHashCanonical(hashes + i), kmerHashCanonical(&reverse));
+    }
+
+    KmerHashKernel kernels[] = { KMER_HASH_SCALAR, KMER_HASH_AVX2, KMER_HASH_AVX512 };
+    KmerHashFunction functions[] = { KMER_HASH_NTHASH, KMER_HASH_MIX };
+
+    for (size_t f = 0;f < 2;f++) {
+        kmerHashUseFunction(functions[f]);
+
+        for (int i = 0;i < 3;i++) {
+            Kmer kmer;
+            TEST_ASSERT_TRUE(kmerEncode(seq + i * 7, k, &kmer));
+            kmerHashInit(hashes + i, kmer, k);
+        }
+
+        for (size_t j = 0;j < sizeof(kernels) / sizeof(*kernels);j++) {
+            if (!kmerHashUseKernel(kernels[j])) {
+                continue;
+            }
+
+            uint64_t successors[12];
+            kmerHashSuccessors(hashes, firsts, 3, k, successors);
+
+            for (int i = 0;i < 3;i++) {
+                for (uint8_t base = 0;base < 4;base++) {
+                    KmerHash next = kmerHashRoll(hashes + i, firsts[i], base, k);
+
+                    TEST_ASSERT_EQUAL(kmerHashCanonical(&next), successors[i * 4 + base]);
+                }
+            }
+        }
+    }
+
+    TEST_ASSERT_TRUE(kmerHashUseKernel(KMER_HASH_SCALAR));
+}
+
+void test_kmerHashInitString_Should_GiveSameHashsAsInit() {
+    const char *str = "ACGTTGCAACGGTACCATGATTGACCATGAACGTTGCAACGGTACCATGATTGACCATGAACGT";
+    KmerHash hash;
+    KmerHash expected;
+
+    Kmer kmer;
+    TEST_ASSERT_TRUE(kmerEncode(str, 31, &kmer));
+    kmerHashInit(&expected, kmer, 31);
+
+    TEST_ASSERT_TRUE(kmerHashInitString(&hash, str, 31));
+    TEST_ASSERT_EQUAL(expected.forward, hash.forward);
+    TEST_ASSERT_EQUAL(expected.reverse, hash.reverse);
+
+    // Longer kmers are packed on 128 bits
+    Kmer128 kmer128;
+    TEST_ASSERT_TRUE(kmer128Encode(str, 45, &kmer128));
+    kmerHashInit128(&expected, kmer128, 45);
+
+    TEST_ASSERT_TRUE(kmerHashInitString(&hash, str, 45));
+    TEST_ASSERT_EQUAL(expected.forward, hash.forward);
+    TEST_ASSERT_EQUAL(expected.reverse, hash.reverse);
+
+    TEST_ASSERT_FALSE(kmerHashInitString(&hash, str, KMER128_MAX_SIZE + 1));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_kmerHashInit_Should_GiveSameCanonicalHash_When_GivenReverseComplement);
+    RUN_TEST(test_kmerHashInit_Should_GiveDifferentHashs_When_GivenDifferentKmers);
+    RUN_TEST(test_kmerHashRoll_Should_GiveSameHashAsInit);
+    RUN_TEST(test_kmerHashSuccessors_Should_GiveSameHashsAsRoll_When_GivenAnyKernel);
+    RUN_TEST(test_kmerHashInit128_Should_GiveSameHashsAsInit_When_GivenShortKmer);
+    RUN_TEST(test_kmerHashRoll_Should_GiveSameHashAsInit128_When_GivenLongKmers);
+    RUN_TEST(test_kmerHashInitString_Should_GiveSameHashsAsInit);
+    RUN_TEST(test_kmerHashRoll_Should_GiveSameHashAsInit_When_GivenMixFunction);
+    RUN_TEST(test_kmerHashSuccessors_Should_GiveSameHashsAsRoll_When_GivenMixFunction);
+    RUN_TEST(test_kmerHashSuccessors_Should_GiveForwardHashs_When_StrandSpecific);
+    return UNITY_END();
+}
@@ -0,0 +1,214 @@
+#include "unity.h"
+
+#include "kmer.h"
+#include "kmer_set.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static KmerSet *g_set;
+
+/**
+ * \brief Copies kmers into an array allocated with malloc
+ */
+Kmer *copyKmers(const Kmer *kmers, uint64_t n) {
+    Kmer *copy = malloc(sizeof(*copy) * (n > 0 ? n : 1));
+    TEST_ASSERT_NOT_NULL(copy);
+
+    for (uint64_t i = 0;i < n;i++) {
+        copy[i] = kmers[i];
+    }
+
+    return copy;
+}
+
+void setUp() {
+    g_set = NULL;
+}
+
+void tearDown() {
+    kmerSetDelete(g_set);
+}
+
+void test_kmerSetCreate_Should_SortAndRemoveDuplicates() {
+    Kmer kmers[] = { 42, 7, 42, 0, 1000, 7 };
+
+    g_set = kmerSetCreate(copyKmers(kmers, 6), 6);
+    TEST_ASSERT_NOT_NULL(g_set);
+
+    Kmer expected[] = { 0, 7, 42, 1000 };
+    TEST_ASSERT_EQUAL(4, kmerSetSize(g_set));
+    TEST_ASSERT_EQUAL_MEMORY(expected, g_set->kmers, sizeof(expected));
+}
+
+void test_kmerSetContains_Should_ReturnFalse_When_GivenEmptySet() {
+    g_set = kmerSetCreate(NULL, 0);
+    TEST_ASSERT_NOT_NULL(g_set);
+
+    TEST_ASSERT_FALSE(kmerSetContains(g_set, 0));
+    TEST_ASSERT_FALSE(kmerSetContains(g_set, 12));
+}
+
+void test_kmerSetContains_Should_FindKmers_When_GivenZeroOrLargestKmer() {
+    Kmer kmers[] = { 0, UINT64_MAX };
+
+    g_set = kmerSetCreate(copyKmers(kmers, 2), 2);
+    TEST_ASSERT_NOT_NULL(g_set);
+
+    TEST_ASSERT_TRUE(kmerSetContains(g_set, 0));
+    TEST_ASSERT_TRUE(kmerSetContains(g_set, UINT64_MAX));
+    TEST_ASSERT_FALSE(kmerSetContains(g_set, 1));
+    TEST_ASSERT_FALSE(kmerSetContains(g_set, UINT64_MAX - 1));
+}
+
+void test_kmerSetContains_Should_FindAllKmers_When_GivenManyKmers() {
+    uint64_t n = 10000;
+    Kmer *kmers = malloc(sizeof(*kmers) * n);
+    TEST_ASSERT_NOT_NULL(kmers);
+
+    // Odd 20-mers, so that the even ones are not in the set
+    uint64_t state = 42;
+    for (uint64_t i = 0;i < n;i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        kmers[i] = ((state >> 24) & kmerMask(20)) | 1;
+    }
+
+    Kmer *copy = copyKmers(kmers, n);
+    g_set = kmerSetCreate(kmers, n);
+    TEST_ASSERT_NOT_NULL(g_set);
+
+    // The index has about KMER_SET_BUCKET_SIZE kmers per bucket
+    TEST_ASSERT_GREATER_OR_EQUAL(n / KMER_SET_BUCKET_SIZE, (uint64_t) 1 << g_set->indexBits);
+
+    for (uint64_t i = 0;i < n;i++) {
+        TEST_ASSERT_TRUE(kmerSetContains(g_set, copy[i]));
+        TEST_ASSERT_FALSE(kmerSetContains(g_set, copy[i] - 1));
+    }
+
+    // Greater than all kmers of the set
+    TEST_ASSERT_FALSE(kmerSetContains(g_set, kmerMask(20) + 1));
+
+    free(copy);
+}
+
+void test_kmerSetWrap_Should_FindKmers_Without_CopyingThem() {
+    Kmer kmers[] = { 0, 7, 42, 1000, 1001 };
+
+    g_set = kmerSetWrap(kmers, 5);
+    TEST_ASSERT_NOT_NULL(g_set);
+
+    TEST_ASSERT_TRUE(g_set->kmers == kmers);
+    TEST_ASSERT_EQUAL(5, kmerSetSize(g_set));
+
+    for (int i = 0;i < 5;i++) {
+        TEST_ASSERT_TRUE(kmerSetContains(g_set, kmers[i]));
+    }
+    TEST_ASSERT_FALSE(kmerSetContains(g_set, 8));
+
+    // The array is on the stack, tearDown must not release it
+}
+
+/**
+ * \brief Fills an array with pseudo random kmers, with about one duplicate per kmer
+ */
+void randomKmers(Kmer *kmers, uint64_t n, uint64_t seed) {
+    uint64_t state = seed;
+
+    for (uint64_t i = 0;i < n;i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        kmers[i] = (state >> 11) % n;
+    }
+}
+
+int compareTestKmers(const void *a, const void *b) {
+    Kmer k1 = *(const Kmer*) a;
+    Kmer k2 = *(const Kmer*) b;
+
+    return (k1 > k2) - (k1 < k2);
+}
+
+void test_kmerSortUnique_Should_SortAndRemoveDuplicates_When_GivenManyKmers() {
+    uint64_t n = 100000;
+    Kmer *kmers = malloc(sizeof(*kmers) * n);
+    TEST_ASSERT_NOT_NULL(kmers);
+
+    randomKmers(kmers, n, 42);
+    // Kmers with high bits, sorted by all passes of the radix sort
+    kmers[0] = UINT64_MAX;
+    kmers[1] = (Kmer) 1 << 63;
+
+    Kmer *expected = copyKmers(kmers, n);
+    qsort(expected, n, sizeof(*expected), compareTestKmers);
+
+    uint64_t size = 1;
+    for (uint64_t i = 1;i < n;i++) {
+        if (expected[i] != expected[size - 1]) {
+            expected[size++] = expected[i];
+        }
+    }
+
+    TEST_ASSERT_EQUAL(size, kmerSortUnique(kmers, n));
+    TEST_ASSERT_EQUAL_MEMORY(expected, kmers, size * sizeof(*kmers));
+
+    free(expected);
+    free(kmers);
+}
+
+void test_kmerMergeUnique_Should_MergeDistinctKmers() {
+    Kmer kmers[] = { 3, 7, 42, 1000, 42, 8, 0, 2000, 8, 3 };
+    Kmer expected[] = { 0, 3, 7, 8, 42, 1000, 2000 };
+    uint64_t size = 0;
+
+    TEST_ASSERT_TRUE(kmerMergeUnique(kmers, 4, 10, &size));
+    TEST_ASSERT_EQUAL(7, size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, kmers, sizeof(expected));
+
+    // Nothing to merge
+    TEST_ASSERT_TRUE(kmerMergeUnique(kmers, 7, 7, &size));
+    TEST_ASSERT_EQUAL(7, size);
+}
+
+void test_kmerMergeUnique_Should_GiveSameKmersAsKmerSortUnique() {
+    uint64_t n = 50000;
+    uint64_t chunkSize = 7000;
+    Kmer *kmers = malloc(sizeof(*kmers) * n);
+    Kmer *merged = malloc(sizeof(*merged) * n);
+    TEST_ASSERT_NOT_NULL(kmers);
+    TEST_ASSERT_NOT_NULL(merged);
+
+    randomKmers(kmers, n, 7);
+    Kmer *expected = copyKmers(kmers, n);
+    uint64_t expectedSize = kmerSortUnique(expected, n);
+
+    // The kmers are merged by chunks, like the kmers collected from a file
+    uint64_t size = 0;
+    for (uint64_t first = 0;first < n;first += chunkSize) {
+        uint64_t len = (first + chunkSize < n) ? chunkSize : n - first;
+
+        memcpy(merged + size, kmers + first, len * sizeof(*kmers));
+        TEST_ASSERT_TRUE(kmerMergeUnique(merged, size, size + len, &size));
+    }
+
+    TEST_ASSERT_EQUAL(expectedSize, size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, merged, size * sizeof(*merged));
+
+    free(expected);
+    free(merged);
+    free(kmers);
+}
+
+int main() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_kmerSetCreate_Should_SortAndRemoveDuplicates);
+    RUN_TEST(test_kmerSetContains_Should_ReturnFalse_When_GivenEmptySet);
+    RUN_TEST(test_kmerSetContains_Should_FindKmers_When_GivenZeroOrLargestKmer);
+    RUN_TEST(test_kmerSetContains_Should_FindAllKmers_When_GivenManyKmers);
+    RUN_TEST(test_kmerSetWrap_Should_FindKmers_Without_CopyingThem);
+
+    RUN_TEST(test_kmerSortUnique_Should_SortAndRemoveDuplicates_When_GivenManyKmers);
+    RUN_TEST(test_kmerMergeUnique_Should_MergeDistinctKmers);
+    RUN_TEST(test_kmerMergeUnique_Should_GiveSameKmersAsKmerSortUnique);
+
+    return UNITY_END();
+}
@@ -0,0 +1,87 @@
+#define _GNU_SOURCE
+
+#include "unity.h"
+
+#include "numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+void setUp() {
+    numaSetPinning(false);
+}
+
+void tearDown() {
+    numaSetPinning(false);
+}
+
+/**
+ * \brief Pins the thread and stores the number of processors of its affinity
+ */
+static void *pinnedThread(void *voidCount) {
+    int *count = voidCount;
+    cpu_set_t set;
+
+    *count = -1;
+
+    if (numaPinThread() && pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        *count = CPU_COUNT(&set);
+    }
+
+    return NULL;
+}
+
+void test_numaNodes_Should_ReturnAtLeastOneNode() {
+    int nodes = numaNodes();
+
+    TEST_ASSERT_TRUE(nodes >= 1);
+    TEST_ASSERT_TRUE(nodes <= NUMA_MAX_NODES);
+}
+
+void test_numaPinThread_Should_NotChangeAffinity_When_PinningIsDisabled() {
+    cpu_set_t before;
+    cpu_set_t after;
+
+    TEST_ASSERT_EQUAL(0, pthread_getaffinity_np(pthread_self(), sizeof(before), &before));
+    TEST_ASSERT_TRUE(numaPinThread());
+    TEST_ASSERT_EQUAL(0, pthread_getaffinity_np(pthread_self(), sizeof(after), &after));
+
+    TEST_ASSERT_TRUE(CPU_EQUAL(&before, &after));
+}
+
+void test_numaPinThread_Should_PinOnOneProcessor_When_PinningIsEnabled() {
+    numaSetPinning(true);
+
+    for (int i = 0;i < 3;i++) {
+        pthread_t thread;
+        int count = 0;
+
+        TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, pinnedThread, &count));
+        TEST_ASSERT_EQUAL(0, pthread_join(thread, NULL));
+
+        TEST_ASSERT_EQUAL(1, count);
+    }
+}
+
+void test_numaInterleave_Should_ReturnFalse_When_GivenUnalignedArea() {
+    size_t size = 4 * 4096;
+    char *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    TEST_ASSERT_TRUE(data != MAP_FAILED);
+
+    TEST_ASSERT_FALSE(numaInterleave(data + 1, 4096));
+
+    munmap(data, size);
+}
+
+int main() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_numaNodes_Should_ReturnAtLeastOneNode);
+    RUN_TEST(test_numaPinThread_Should_NotChangeAffinity_When_PinningIsDisabled);
+    RUN_TEST(test_numaPinThread_Should_PinOnOneProcessor_When_PinningIsEnabled);
+    RUN_TEST(test_numaInterleave_Should_ReturnFalse_When_GivenUnalignedArea);
+
+    return UNITY_END();
+}
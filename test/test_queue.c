@@ -2,6 +2,8 @@
 
 #include "queue.h"
 
+#include <sched.h>
+
 static Queue *g_queue;
 
 void setUp() {
@@ -87,12 +89,53 @@ void test_queue() {
     TEST_ASSERT_EQUAL('C', results[2]);
 }
 
+static void *pushValue(void *value) {
+    return queuePush(g_queue, value) ? value : NULL;
+}
+
+void test_queuePush_Should_Resume_When_ValuePoppedFromFullQueue() {
+    g_queue = queueCreate(1, 1);
+    TEST_ASSERT_NOT_NULL(g_queue);
+
+    char vals[] = { 'A', 'B' };
+    TEST_ASSERT_TRUE(queuePush(g_queue, vals));
+
+    pthread_t producer;
+    TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, pushValue, vals + 1));
+
+    // Waits until the producer is blocked on the full queue
+    int fullWaiters = 0;
+    while (fullWaiters == 0) {
+        sched_yield();
+        pthread_mutex_lock(&g_queue->lock);
+        fullWaiters = g_queue->fullWaiters;
+        pthread_mutex_unlock(&g_queue->lock);
+    }
+    TEST_ASSERT_EQUAL(1, fullWaiters);
+
+    char result = 0;
+    TEST_ASSERT_TRUE(queuePop(g_queue, &result));
+    TEST_ASSERT_EQUAL('A', result);
+
+    void *pushed = NULL;
+    TEST_ASSERT_EQUAL(0, pthread_join(producer, &pushed));
+    TEST_ASSERT_TRUE(pushed == vals + 1);
+
+    TEST_ASSERT_EQUAL(0, g_queue->fullWaiters);
+    TEST_ASSERT_EQUAL(0, g_queue->emptyWaiters);
+    TEST_ASSERT_TRUE(queueFull(g_queue));
+
+    TEST_ASSERT_TRUE(queuePop(g_queue, &result));
+    TEST_ASSERT_EQUAL('B', result);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(test_queueCreate_Should_ReturnValidPointer);
 
     RUN_TEST(test_queuePush_Should_MakeQueueNonEmpty);
     RUN_TEST(test_queuePush_Should_MakeQueueFullAndEmpty_When_GivenOneSizeQueue);
+    RUN_TEST(test_queuePush_Should_Resume_When_ValuePoppedFromFullQueue);
 
     RUN_TEST(test_queuePop_Should_MakeQueueEmpty_When_GivenQueueWithOneElement);
 
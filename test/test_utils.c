@@ -3,14 +3,23 @@
 #include "unity.h"
 
 #include "bloom_filter.h"
+#include "de_bruijn_graph.h"
+#include "kmer_set.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 static BloomFilter *g_bf;
+static DeBruijnGraph g_graph;
 
 void setUp() {
     g_bf = NULL;
+    g_graph.bf = NULL;
+    g_graph.falsePositives = NULL;
 }
 void tearDown() {
     bfDelete(g_bf);
+    kmerSetDelete(g_graph.falsePositives);
 }
 
 void test_canonicalForm_Should_ReturnNull_When_GivenZeroLengthString() {
@@ -27,29 +36,87 @@ void test_canonicalForm_Should_ReturnPointerToKmerOrRC() {
     TEST_ASSERT_EQUAL_STRING("ACGTACG", result);
 }
 
+void test_canonicalForm_Should_ReturnReverseComplement_When_GivenKmerLongerThanPackedKmer() {
+    char kmer[] = "TTTTTCCCCCGGGGGAAAAATTTTTCCCCCGGGGGAAAAAG";
+    char rc[] = "CTTTTTCCCCCGGGGGAAAAATTTTTCCCCCGGGGGAAAAA";
+
+    TEST_ASSERT_EQUAL_STRING(rc, canonicalForm(kmer, 41));
+    TEST_ASSERT_EQUAL_STRING(rc, canonicalForm(kmer, 41));
+}
+
+void test_findNeighbors_Should_FindNeighbors_When_GivenKmerLongerThanPackedKmer() {
+    g_bf = bfCreate(10000, 7);
+    g_graph.bf = g_bf;
+    g_graph.k = 40;
+
+    // The successors of the first kmer end with C and T
+    const char seq[] = "ACGTTGCAACGGATCCATGCAAGTTCGATCGGCATGCAACT";
+    TEST_ASSERT_TRUE(insertKmer(g_bf, seq + 1, 40));
+    char other[41];
+    memcpy(other, seq + 1, 40);
+    other[39] = 'C';
+    TEST_ASSERT_TRUE(insertKmer(g_bf, other, 40));
+
+    char neighbors[4];
+    TEST_ASSERT_EQUAL(2, findNeighbors(&g_graph, seq, 40, neighbors));
+    TEST_ASSERT_EQUAL('C', neighbors[0]);
+    TEST_ASSERT_EQUAL('T', neighbors[1]);
+}
+
 void test_findNeighbors_Should_ReturnNegativeValue_When_GivenLengthLessThanTwo() {
     g_bf = bfCreate(100, 7);
+    g_graph.bf = g_bf;
+    char neighbors[4];
+    TEST_ASSERT_LESS_THAN(0, findNeighbors(&g_graph, "A", 1, neighbors));
+}
+
+void test_findNeighbors_Should_ReturnNegativeValue_When_GivenLengthGreaterThanMax() {
+    g_bf = bfCreate(100, 7);
+    g_graph.bf = g_bf;
     char neighbors[4];
-    TEST_ASSERT_LESS_THAN(0, findNeighbors(g_bf, "A", 1, neighbors));
+    TEST_ASSERT_LESS_THAN(0, findNeighbors(&g_graph,
+        "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTA", KMER128_MAX_SIZE + 1, neighbors));
 }
 
 void test_findNeighbors_Should_ReturnZero_When_GivenEmptyFilter() {
     g_bf = bfCreate(100, 7);
+    g_graph.bf = g_bf;
     char neighbors[5] = { '\0' };
 
-    TEST_ASSERT_EQUAL(0, findNeighbors(g_bf, "ATCG", 4, neighbors));
+    TEST_ASSERT_EQUAL(0, findNeighbors(&g_graph, "ATCG", 4, neighbors));
 
     TEST_ASSERT_EQUAL_STRING("", neighbors);
 }
 
 void test_findNeighbors_Should_ReturnOne_When_GivenFilterWithOneElement() {
     g_bf = bfCreate(100, 7);
+    g_graph.bf = g_bf;
     char neighbors[5] = { '\0' };
 
-    bfAdd(g_bf, "CCGA", 4);
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "CCGA", 4));
+
+    TEST_ASSERT_EQUAL(1, findNeighbors(&g_graph, "ATCG", 4, neighbors));
+
+    TEST_ASSERT_EQUAL_STRING("G", neighbors);
+}
+
+void test_findNeighbors_Should_SkipFalsePositives() {
+    g_bf = bfCreate(100, 7);
+    g_graph.bf = g_bf;
+    char neighbors[5] = { '\0' };
+
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "TCGA", 4));
+    TEST_ASSERT_TRUE(insertKmer(g_bf, "TCGG", 4));
+
+    // TCGA is marked as a false positive of the filter
+    Kmer *falsePositives = malloc(sizeof(*falsePositives));
+    TEST_ASSERT_NOT_NULL(falsePositives);
+    TEST_ASSERT_TRUE(kmerEncode("TCGA", 4, falsePositives));
 
-    TEST_ASSERT_EQUAL(1, findNeighbors(g_bf, "ATCG", 4, neighbors));
+    g_graph.falsePositives = kmerSetCreate(falsePositives, 1);
+    TEST_ASSERT_NOT_NULL(g_graph.falsePositives);
 
+    TEST_ASSERT_EQUAL(1, findNeighbors(&g_graph, "ATCG", 4, neighbors));
     TEST_ASSERT_EQUAL_STRING("G", neighbors);
 }
 
@@ -57,8 +124,12 @@ int main() {
     UNITY_BEGIN();
     RUN_TEST(test_canonicalForm_Should_ReturnNull_When_GivenZeroLengthString);
     RUN_TEST(test_canonicalForm_Should_ReturnPointerToKmerOrRC);
+    RUN_TEST(test_canonicalForm_Should_ReturnReverseComplement_When_GivenKmerLongerThanPackedKmer);
     RUN_TEST(test_findNeighbors_Should_ReturnNegativeValue_When_GivenLengthLessThanTwo);
+    RUN_TEST(test_findNeighbors_Should_ReturnNegativeValue_When_GivenLengthGreaterThanMax);
+    RUN_TEST(test_findNeighbors_Should_FindNeighbors_When_GivenKmerLongerThanPackedKmer);
     RUN_TEST(test_findNeighbors_Should_ReturnZero_When_GivenEmptyFilter);
     RUN_TEST(test_findNeighbors_Should_ReturnOne_When_GivenFilterWithOneElement);
+    RUN_TEST(test_findNeighbors_Should_SkipFalsePositives);
     return UNITY_END();
 }
\ No newline at end of file